@@ -10,3 +10,9 @@ def test_init_term(cijoe, device, be_opts, cli_args):
             f"--count {count} --qdepth {qdepth}"
         )
         assert not err
+
+
+@xnvme_parametrize(["dev"], opts=["be", "admin", "async"])
+def test_completion_fd(cijoe, device, be_opts, cli_args):
+    err, _ = cijoe.run(f"xnvme_tests_async_intf completion_fd {cli_args}")
+    assert not err
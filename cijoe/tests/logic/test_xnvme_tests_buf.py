@@ -1,6 +1,21 @@
+import pytest
+
 from ..conftest import xnvme_parametrize
 
 
+def mem_env(cijoe, be_opts):
+    """Environment of the memory-backend, skipping when it is not configured"""
+
+    if be_opts["mem"] != "hugepage":
+        return {}
+
+    hugepage_path = cijoe.config.options.get("hugetlbfs", {}).get("mount_point", "")
+    if not hugepage_path:
+        pytest.skip(reason="[mem=hugepage] hugetlbfs is not configured")
+
+    return {"XNVME_HUGETLB_PATH": hugepage_path}
+
+
 @xnvme_parametrize(["dev"], opts=["be"])
 def test_buf_alloc_free(cijoe, device, be_opts, cli_args):
     err, _ = cijoe.run(f"xnvme_tests_buf buf_alloc_free {cli_args} --count 28")
@@ -11,3 +26,40 @@ def test_buf_alloc_free(cijoe, device, be_opts, cli_args):
 def test_buf_virt_alloc_free(cijoe, device, be_opts, cli_args):
     err, _ = cijoe.run(f"xnvme_tests_buf buf_virt_alloc_free {cli_args} --count 28")
     assert not err
+
+
+@xnvme_parametrize(["dev"], opts=["be", "admin", "async"])
+def test_buf_registry(cijoe, device, be_opts, cli_args):
+    err, _ = cijoe.run(
+        f"xnvme_tests_buf buf_registry {cli_args} --count 96 --register_buffers 1"
+    )
+    assert not err
+
+
+@xnvme_parametrize(["dev"], opts=["be", "mem"])
+def test_buf_sizes(cijoe, device, be_opts, cli_args):
+    env = mem_env(cijoe, be_opts)
+
+    err, _ = cijoe.run(f"xnvme_tests_buf buf_sizes {cli_args} --count 2", env=env)
+    assert not err
+
+
+@xnvme_parametrize(["dev"], opts=["be", "mem"])
+def test_buf_realloc(cijoe, device, be_opts, cli_args):
+    if be_opts["mem"] == "posix":
+        pytest.skip(reason="[mem=posix] does not implement realloc")
+    env = mem_env(cijoe, be_opts)
+
+    err, _ = cijoe.run(f"xnvme_tests_buf buf_realloc {cli_args} --count 4", env=env)
+    assert not err
+
+
+@xnvme_parametrize(["dev"], opts=["be", "mem"])
+def test_buf_exhaust(cijoe, device, be_opts, cli_args):
+    env = mem_env(cijoe, be_opts)
+
+    # A slab size-class, a run of two hugepages, and a run of three
+    for data_nbytes in [4096, 2097153, 6291456]:
+        args = f"--count 4096 --data-nbytes {data_nbytes}"
+        err, _ = cijoe.run(f"xnvme_tests_buf buf_exhaust {cli_args} {args}", env=env)
+        assert not err
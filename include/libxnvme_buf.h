@@ -120,6 +120,140 @@ xnvme_buf_phys_realloc(const struct xnvme_dev *dev, void *buf, size_t nbytes, ui
 int
 xnvme_buf_vtophys(const struct xnvme_dev *dev, void *buf, uint64_t *phys);
 
+/**
+ * Opaque pool of fixed-size buffers for IO with a given device, see xnvme_buf_pool_create()
+ *
+ * @struct xnvme_buf_pool
+ */
+struct xnvme_buf_pool;
+
+/**
+ * Opaque cache of buffers from a ::xnvme_buf_pool, see xnvme_buf_pool_cache_create()
+ *
+ * @struct xnvme_buf_pool_cache
+ */
+struct xnvme_buf_pool_cache;
+
+/**
+ * Create a pool of 'nbufs' buffers of 'buf_nbytes' each, for IO with the given device
+ *
+ * The buffers are preallocated, as a single allocation, with xnvme_buf_alloc(), thus, when the
+ * device is opened with the 'register_buffers' option, then every buffer of the pool is eligible
+ * for fixed-buffer IO. Buffers are handed out with xnvme_buf_pool_get() and returned with
+ * xnvme_buf_pool_put(), both of which are lock-free and safe to call from multiple threads.
+ *
+ * @note
+ * Being a single allocation, the pool is registered as a whole or not at all; it is not when its
+ * size, 'nbufs' times 'buf_nbytes' rounded up to the alignment, exceeds 1GiB, the limit of
+ * io_uring, or when all 64 slots of the buffer-registry of the device are taken. The buffers are
+ * then still usable for IO, just not as fixed buffers; create several smaller pools instead.
+ * @note
+ * Buffers of less than 4KiB are aligned to their size rounded up to a power of two, of at least
+ * 512 bytes, larger buffers are aligned to 4KiB
+ * @note
+ * De-allocate the pool using xnvme_buf_pool_destroy()
+ *
+ * @param dev Device handle obtained with xnvme_dev_open()
+ * @param buf_nbytes The size of each buffer in bytes
+ * @param nbufs The number of buffers in the pool
+ *
+ * @return On success, a pointer to the pool is returned. On error, NULL is returned and `errno`
+ * set to indicate the error.
+ */
+struct xnvme_buf_pool *
+xnvme_buf_pool_create(const struct xnvme_dev *dev, size_t buf_nbytes, uint32_t nbufs);
+
+/**
+ * Destroy the given pool, de-allocating all of its buffers
+ *
+ * @note
+ * Any cache of the pool must be destroyed before the pool
+ *
+ * @param pool Pointer to a pool created with xnvme_buf_pool_create()
+ */
+void
+xnvme_buf_pool_destroy(struct xnvme_buf_pool *pool);
+
+/**
+ * Returns the size, in bytes, of the buffers of the given pool
+ *
+ * @param pool Pointer to a pool created with xnvme_buf_pool_create()
+ *
+ * @return The 'buf_nbytes' given to xnvme_buf_pool_create()
+ */
+size_t
+xnvme_buf_pool_buf_nbytes(const struct xnvme_buf_pool *pool);
+
+/**
+ * Take a buffer from the given pool
+ *
+ * @param pool Pointer to a pool created with xnvme_buf_pool_create()
+ *
+ * @return On success, a pointer to the buffer is returned. When the pool is exhausted, NULL is
+ * returned and `errno` set to ENOMEM.
+ */
+void *
+xnvme_buf_pool_get(struct xnvme_buf_pool *pool);
+
+/**
+ * Return a buffer, obtained with xnvme_buf_pool_get(), to the given pool
+ *
+ * @param pool Pointer to a pool created with xnvme_buf_pool_create()
+ * @param buf Pointer to a buffer obtained from the pool
+ */
+void
+xnvme_buf_pool_put(struct xnvme_buf_pool *pool, void *buf);
+
+/**
+ * Create a cache of up to 'capacity' buffers of the given pool
+ *
+ * A cache is meant for a single thread, it is not thread-safe, in exchange, buffers are taken and
+ * returned without atomics, and the cache moves half its capacity of buffers to and from the pool
+ * at a time.
+ *
+ * @note
+ * De-allocate the cache using xnvme_buf_pool_cache_destroy(), which returns its buffers to the
+ * pool
+ *
+ * @param pool Pointer to a pool created with xnvme_buf_pool_create()
+ * @param capacity The maximum number of buffers held by the cache, at least 2
+ *
+ * @return On success, a pointer to the cache is returned. On error, NULL is returned and `errno`
+ * set to indicate the error.
+ */
+struct xnvme_buf_pool_cache *
+xnvme_buf_pool_cache_create(struct xnvme_buf_pool *pool, uint32_t capacity);
+
+/**
+ * Destroy the given cache, returning the buffers it holds to the pool
+ *
+ * @param cache Pointer to a cache created with xnvme_buf_pool_cache_create()
+ */
+void
+xnvme_buf_pool_cache_destroy(struct xnvme_buf_pool_cache *cache);
+
+/**
+ * Take a buffer from the given cache, refilling it from the pool when empty
+ *
+ * @param cache Pointer to a cache created with xnvme_buf_pool_cache_create()
+ *
+ * @return On success, a pointer to the buffer is returned. When the pool is exhausted, NULL is
+ * returned and `errno` set to ENOMEM.
+ */
+void *
+xnvme_buf_pool_cache_get(struct xnvme_buf_pool_cache *cache);
+
+/**
+ * Return a buffer of the pool to the given cache, spilling to the pool when full
+ *
+ * A buffer can be returned to any cache of the pool it was taken from, or directly to the pool.
+ *
+ * @param cache Pointer to a cache created with xnvme_buf_pool_cache_create()
+ * @param buf Pointer to a buffer obtained from the pool
+ */
+void
+xnvme_buf_pool_cache_put(struct xnvme_buf_pool_cache *cache, void *buf);
+
 /**
  * Allocate a buffer of virtual memory of the given `alignment` and `nbytes`
  *
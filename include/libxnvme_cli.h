@@ -16,6 +16,7 @@
 #define XNVME_CLI_ADMIN_OPTS                                                                \
 	XNVME_CLI_CORE_OPTS, {XNVME_CLI_OPT_DEV_NSID, XNVME_CLI_LOPT},                      \
 		{XNVME_CLI_OPT_ADMIN, XNVME_CLI_LOPT}, {XNVME_CLI_OPT_MEM, XNVME_CLI_LOPT}, \
+		{XNVME_CLI_OPT_NUMA_NODE, XNVME_CLI_LOPT},                                  \
 	{                                                                                   \
 		XNVME_CLI_OPT_DIRECT, XNVME_CLI_LOPT                                        \
 	}
@@ -166,6 +167,13 @@ struct xnvme_cli_args {
 	uint32_t apptag_mask;
 
 	uint64_t sdlba;
+
+	uint32_t numa_node;
+
+	uint32_t defer_taskrun;
+	uint32_t coop_taskrun;
+	uint32_t submit_all;
+	uint32_t register_ring_fd;
 };
 
 void
@@ -334,7 +342,15 @@ enum xnvme_cli_opt {
 	XNVME_CLI_OPT_APPTAG_MASK = 123, ///< XNVME_CLI_OPT_APPTAG_MASK
 
 	XNVME_CLI_OPT_SDLBA = 124,
-	XNVME_CLI_OPT_END   = 125, ///< XNVME_CLI_OPT_END
+
+	XNVME_CLI_OPT_NUMA_NODE = 125, ///< XNVME_CLI_OPT_NUMA_NODE
+
+	XNVME_CLI_OPT_DEFER_TASKRUN    = 126, ///< XNVME_CLI_OPT_DEFER_TASKRUN
+	XNVME_CLI_OPT_COOP_TASKRUN     = 127, ///< XNVME_CLI_OPT_COOP_TASKRUN
+	XNVME_CLI_OPT_SUBMIT_ALL       = 128, ///< XNVME_CLI_OPT_SUBMIT_ALL
+	XNVME_CLI_OPT_REGISTER_RING_FD = 129, ///< XNVME_CLI_OPT_REGISTER_RING_FD
+
+	XNVME_CLI_OPT_END = 130, ///< XNVME_CLI_OPT_END
 };
 
 /**
@@ -142,6 +142,36 @@ int
 xnvme_cmd_pass_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, size_t dvec_cnt,
 		   size_t dvec_nbytes, void *mbuf, size_t mbuf_nbytes);
 
+/**
+ * Set the timeout of the next submission of the given ::xnvme_cmd_ctx, overriding the default
+ * given to xnvme_queue_set_timeout()
+ *
+ * @param ctx Pointer to command context (::xnvme_cmd_ctx) obtained from a queue with timeouts
+ * enabled
+ * @param timeout_ns The timeout, in nanoseconds, 0 for none
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned.
+ */
+int
+xnvme_cmd_ctx_set_timeout(struct xnvme_cmd_ctx *ctx, uint64_t timeout_ns);
+
+/**
+ * Request cancellation of the given outstanding asynchronous command
+ *
+ * Upon success, the command completes, via its callback, with the status-code-type
+ * XNVME_STATUS_CODE_TYPE_VENDOR and the status-code ECANCELED, when processing the queue as
+ * usual. Cancellation is best effort, a command which the backend no longer can cancel completes
+ * as it would have otherwise, or, on a queue with timeouts enabled, with the ECANCELED status.
+ *
+ * @param ctx Pointer to command context (::xnvme_cmd_ctx) of a command submitted to the backend
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned, -ENOSYS when the
+ * backend does not support cancellation, -EALREADY or -ENOENT when the command cannot be found
+ * among those the backend can still cancel.
+ */
+int
+xnvme_cmd_cancel(struct xnvme_cmd_ctx *ctx);
+
 /**
  * Pass a NVMe Admin Command through to the device with minimal intervention
  *
@@ -160,6 +160,19 @@ xnvme_dev_get_ident(const struct xnvme_dev *dev);
 const struct xnvme_opts *
 xnvme_dev_get_opts(const struct xnvme_dev *dev);
 
+/**
+ * Returns the NUMA node on which buffers and threads for the given `dev` are placed
+ *
+ * This is the node of the device, as reported by the operating system, unless another node is
+ * given via the 'numa_node' option of xnvme_dev_open()
+ *
+ * @param dev Device handle obtained with xnvme_dev_open()
+ *
+ * @return The NUMA node, or -1 when the device has no NUMA affinity or it is unknown
+ */
+int
+xnvme_dev_get_numa_node(const struct xnvme_dev *dev);
+
 /**
  * Returns the internal backend state of the given `dev`
  *
@@ -0,0 +1,125 @@
+/**
+ * SPDX-FileCopyrightText: Samsung Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ * @headerfile libxnvme_executor.h
+ */
+
+/**
+ * Opaque work-stealing I/O executor, see xnvme_executor_create()
+ *
+ * @struct xnvme_executor
+ */
+struct xnvme_executor;
+
+/**
+ * Signature of a closure run by an executor-worker, on the ::xnvme_queue of the worker
+ *
+ * The closure may submit commands on the given queue, the worker processes their completions,
+ * that is, invokes their callbacks, on the worker thread.
+ */
+typedef void (*xnvme_executor_fn)(struct xnvme_queue *queue, void *arg);
+
+/**
+ * Signature of the callback invoked, on a worker thread, upon completion of an I/O job
+ *
+ * @param err 0 when every command of the job succeeded, otherwise the negative `errno` of the
+ * first failure, -EIO for a command completing with an error status
+ * @param cb_arg The 'cb_arg' given to xnvme_executor_submit_io()
+ */
+typedef void (*xnvme_executor_cb)(int err, void *cb_arg);
+
+/**
+ * Create an executor of 'nworkers' threads, each owning an ::xnvme_queue of 'qdepth' entries on
+ * the given device
+ *
+ * Work submitted to the executor, closures and LBA-range jobs, is divided into tasks and spread
+ * over the workers. A worker takes tasks from its own deque while its queue has room, and when its
+ * deque is empty, it steals tasks from those of the other workers, thus, workers finishing early
+ * pick up the work of busy ones.
+ *
+ * @note
+ * The queues are initialized by the worker threads, thus, they are usable with the io_uring
+ * options requiring a single issuer, e.g. XNVME_QUEUE_DEFER_TASKRUN
+ * @note
+ * De-allocate the executor using xnvme_executor_destroy()
+ *
+ * @param dev Device handle obtained with xnvme_dev_open()
+ * @param nworkers The number of worker threads
+ * @param qdepth The capacity of the queue of each worker, see xnvme_queue_init()
+ *
+ * @return On success, a pointer to the executor is returned. On error, NULL is returned and
+ * `errno` set to indicate the error.
+ */
+struct xnvme_executor *
+xnvme_executor_create(struct xnvme_dev *dev, uint32_t nworkers, uint32_t qdepth);
+
+/**
+ * Wait for all submitted work to complete, then stop the workers and de-allocate the executor
+ *
+ * @note A worker which keeps failing to reap completions abandons its queue, the commands in
+ * flight on it are never completed, and the tasks left in the deques fail with the error
+ *
+ * @param exec Pointer to an executor created with xnvme_executor_create()
+ */
+void
+xnvme_executor_destroy(struct xnvme_executor *exec);
+
+/**
+ * Submit a closure, to be run once, by whichever worker gets to it first
+ *
+ * @note This function is thread-safe
+ *
+ * @param exec Pointer to an executor created with xnvme_executor_create()
+ * @param fn The closure to run
+ * @param arg The argument passed to the closure
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned.
+ */
+int
+xnvme_executor_submit(struct xnvme_executor *exec, xnvme_executor_fn fn, void *arg);
+
+/**
+ * Submit a read or write of 'nblocks' logical blocks, starting at 'slba', to or from 'dbuf'
+ *
+ * The range is split into commands of at most the maximum data-transfer size of the device, which
+ * are spread over, and stolen among, the workers. Upon completion of all of them, 'cb' is invoked
+ * on the worker thread processing the last completion.
+ *
+ * @note This function is thread-safe
+ * @note The buffer must be allocated with xnvme_buf_alloc(), and remain valid until 'cb' is
+ * invoked
+ *
+ * @param exec Pointer to an executor created with xnvme_executor_create()
+ * @param opcode XNVME_SPEC_NVM_OPC_READ or XNVME_SPEC_NVM_OPC_WRITE
+ * @param nsid Namespace identifier
+ * @param slba The first logical block of the range
+ * @param nblocks The number of logical blocks of the range, this is not a zero-based value
+ * @param dbuf Pointer to the data-payload of 'nblocks' logical blocks
+ * @param cb The callback invoked upon completion of the job
+ * @param cb_arg The argument passed to the callback
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned.
+ */
+int
+xnvme_executor_submit_io(struct xnvme_executor *exec, uint8_t opcode, uint32_t nsid, uint64_t slba,
+			 uint64_t nblocks, void *dbuf, xnvme_executor_cb cb, void *cb_arg);
+
+/**
+ * Wait until all submitted work has completed
+ *
+ * Completed means that every closure has returned, every I/O job has invoked its callback, and
+ * every command submitted on the queues of the workers, including by closures, has completed.
+ *
+ * A worker failing to reap completions on its queue stops taking tasks, leaving them to the other
+ * workers, and retries with an exponential back-off. The first such failure ends the wait, and is
+ * returned, even though work may still be in flight; the wait can then be repeated.
+ *
+ * @param exec Pointer to an executor created with xnvme_executor_create()
+ *
+ * @return On success, 0 is returned. On error, the negative `errno` of the first failure to reap
+ * completions since the previous call is returned.
+ */
+int
+xnvme_executor_drain(struct xnvme_executor *exec);
@@ -11,6 +11,11 @@ struct xnvme_opts_css {
 	uint32_t given;
 };
 
+struct xnvme_opts_numa {
+	uint32_t value;
+	uint32_t given;
+};
+
 /**
  * xNVMe options
  *
@@ -35,7 +40,7 @@ struct xnvme_opts {
 	uint32_t create_mode;      ///< OS file creation-mode
 	uint8_t poll_io;           ///< io_uring: enable io-polling
 	uint8_t poll_sq;           ///< io_uring: enable sqthread-polling
-	uint8_t register_files;    ///< io_uring: enable file-regirations
+	uint8_t register_files;    ///< io_uring: enable file-registration, implied by poll_sq
 	uint8_t register_buffers;  ///< io_uring: enable buffer-registration
 	struct xnvme_opts_css css; ///< SPDK controller-setup: do command-set-selection
 	uint32_t use_cmb_sqs;      ///< SPDK controller-setup: use controller-memory-buffer for sq
@@ -49,6 +54,11 @@ struct xnvme_opts {
 	uint32_t command_timeout;  ///< SPDK fabrics: enable io command timeout
 	uint32_t spdk_fabrics;     ///< Is assigned a value by backend if SPDK uses fabrics
 	uint32_t keep_alive_timeout_ms; ///< SPDK fabrics: set keep alive timeout
+	struct xnvme_opts_numa numa_node; ///< NUMA node of buffers and threads; default: of device
+	uint8_t defer_taskrun;    ///< io_uring: defer task-work to the submitting thread
+	uint8_t coop_taskrun;     ///< io_uring: run task-work cooperatively, without IPIs
+	uint8_t submit_all;       ///< io_uring: keep submitting a batch past a failing SQE
+	uint8_t register_ring_fd; ///< io_uring: register the ring-fd, saving its lookups
 };
 
 /**
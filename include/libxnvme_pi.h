@@ -41,6 +41,18 @@ struct xnvme_pi_ctx {
 	uint16_t apptag_mask;
 };
 
+/**
+ * The first block failing Protection Information verification
+ *
+ * @struct xnvme_pi_err
+ */
+struct xnvme_pi_err {
+	uint32_t block;    ///< Index of the block, relative to the first block verified
+	uint32_t field;    ///< The ::xnvme_pi_check_type of the field failing the check
+	uint64_t expected; ///< Value expected in the field
+	uint64_t actual;   ///< Value of the field
+};
+
 /**
  * Return the protection information size
  *
@@ -93,9 +105,56 @@ xnvme_pi_generate(struct xnvme_pi_ctx *ctx, uint8_t *data_buf, uint8_t *md_buf,
  * @param md_buf Pointer to meta-payload
  * @param num_blocks Number of logical blocks
  *
- * @return On success, 0 is returned. On error, negative `errno` is returned.
+ * @return On success, 0 is returned. On error, negative `errno` is returned, -EIO when a block
+ * fails verification.
  */
 int
 xnvme_pi_verify(struct xnvme_pi_ctx *ctx, uint8_t *data_buf, uint8_t *md_buf, uint32_t num_blocks);
 
+/**
+ * Verify the protection information content of metadata, as xnvme_pi_verify(), and on failure,
+ * describe the first failing block in 'err'
+ *
+ * @param ctx Pointer to ::xnvme_pi_ctx
+ * @param data_buf Pointer to data-payload
+ * @param md_buf Pointer to meta-payload
+ * @param num_blocks Number of logical blocks
+ * @param err Pointer to ::xnvme_pi_err, filled in when verification fails
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned, -EIO when a block
+ * fails verification.
+ */
+int
+xnvme_pi_verify_report(struct xnvme_pi_ctx *ctx, uint8_t *data_buf, uint8_t *md_buf,
+		       uint32_t num_blocks, struct xnvme_pi_err *err);
+
+/**
+ * Enable, or disable, software Protection Information on the given queue
+ *
+ * With PI enabled, the protection information of NVM WRITE commands submitted on the queue is
+ * generated before the command is passed to the backend, and that of NVM READ commands is
+ * verified before the completion-callback is invoked. A READ failing verification completes with
+ * status-code-type ::XNVME_STATUS_CODE_TYPE_MEDIA and one of the XNVME_STATUS_CODE_E2E_* status
+ * codes. Commands with PRACT set in 'prinfo' are passed on as is, as the controller handles PI.
+ *
+ * The Reference Tag of each command is derived from the command itself, that is, the SLBA for
+ * Type 1, and the ILBRT for Type 2, 'init_ref_tag' of the given context is thus only used for Type
+ * 3. The buffers given to xnvme_cmd_pass() must hold 'nlb + 1' blocks.
+ *
+ * When 'nthreads' is non-zero, then generation and verification are done by a pool of helper
+ * threads, off the thread driving the queue, and the commands are handed back to the backend, and
+ * the completion-callbacks invoked, by xnvme_queue_poke(). Otherwise, they are done inline.
+ *
+ * @note The queue must have no outstanding commands
+ * @note Commands submitted with xnvme_cmd_pass_iov() must use a single data-vector
+ *
+ * @param queue Pointer to the ::xnvme_queue
+ * @param ctx Pointer to an initialized ::xnvme_pi_ctx, or NULL to disable PI on the queue
+ * @param nthreads Number of helper threads, 0 for inline
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned.
+ */
+int
+xnvme_queue_set_pi(struct xnvme_queue *queue, const struct xnvme_pi_ctx *ctx, uint32_t nthreads);
+
 #endif /* __INTERNAL_XNVME_PI_H */
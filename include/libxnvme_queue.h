@@ -24,21 +24,52 @@ struct xnvme_queue;
 enum xnvme_queue_opts {
 	XNVME_QUEUE_IOPOLL = 0x1,      ///< XNVME_QUEUE_IOPOLL: queue. is polled for completions
 	XNVME_QUEUE_SQPOLL = 0x1 << 1, ///< XNVME_QUEUE_SQPOLL: queue. is polled for submissions
+
+	XNVME_QUEUE_DEFER_TASKRUN    = 0x1 << 3, ///< io_uring: task-work deferred to the submitter
+	XNVME_QUEUE_COOP_TASKRUN     = 0x1 << 4, ///< io_uring: task-work run cooperatively
+	XNVME_QUEUE_SUBMIT_ALL       = 0x1 << 5, ///< io_uring: batches submitted past failing SQEs
+	XNVME_QUEUE_REGISTER_RING_FD = 0x1 << 6, ///< io_uring: the ring-fd is registered
+	XNVME_QUEUE_REGISTER_FILES   = 0x1 << 7, ///< io_uring: the device-fd is registered
 };
 
+/**
+ * Maximum capacity of a Command Queue, see xnvme_queue_init()
+ */
+#define XNVME_QUEUE_CAPACITY_MAX 65536
+
 /**
  * Allocate a Command Queue for asynchronous command submission and completion
  *
+ * The command-contexts of the queue are initialized on first use by xnvme_queue_get_cmd_ctx(),
+ * thus, the memory backing them is only touched as the queue-depth in use grows.
+ *
+ * @note Backends can support less than XNVME_QUEUE_CAPACITY_MAX, in which case the initialization
+ * fails
+ *
  * @param dev Device handle (::xnvme_dev) obtained with xnvme_dev_open()
  * @param capacity Maximum number of outstanding commands on the initialized queue, note that it
- * must be a power of 2 within the range [1,4096]
+ * must be a power of 2 within the range [1,XNVME_QUEUE_CAPACITY_MAX]
  * @param opts Queue options
  * @param queue Pointer-pointer to the ::xnvme_queue to initialize
  *
  * @return On success, 0 is returned. On error, negative `errno` is returned.
  */
 int
-xnvme_queue_init(struct xnvme_dev *dev, uint16_t capacity, int opts, struct xnvme_queue **queue);
+xnvme_queue_init(struct xnvme_dev *dev, uint32_t capacity, int opts, struct xnvme_queue **queue);
+
+/**
+ * Get the options in effect on the given ::xnvme_queue
+ *
+ * Options requested via xnvme_queue_init(), or via the ::xnvme_opts of the device, are only in
+ * effect when supported by the backend and the running kernel; the 'io_uring' backend falls back,
+ * option by option, to what the kernel accepts. Thus, this reports what the queue actually uses.
+ *
+ * @param queue Pointer to the ::xnvme_queue to query for options
+ *
+ * @return A bitmask of ::xnvme_queue_opts
+ */
+int
+xnvme_queue_get_opts(struct xnvme_queue *queue);
 
 /**
  * Get the capacity of the given ::xnvme_queue
@@ -108,6 +139,27 @@ xnvme_queue_drain(struct xnvme_queue *queue);
 int
 xnvme_queue_wait(struct xnvme_queue *queue);
 
+/**
+ * Block until at least 'min_completions' commands have completed on the given ::xnvme_queue, or
+ * until 'timeout_ns' nanoseconds have elapsed, processing the completions
+ *
+ * Unlike ::xnvme_queue_drain, this lets the calling thread sleep in the backend, e.g. in
+ * io_uring_enter(), io_getevents() or on a condition variable, instead of busy-polling.
+ *
+ * @note When 'min_completions' is 0 or exceeds the number of outstanding commands, then it is
+ * capped at the number of outstanding commands
+ * @note When 'timeout_ns' is 0, then the call waits without a timeout
+ *
+ * @param queue Pointer to the ::xnvme_queue to wait/process commands on
+ * @param min_completions The minimum number of completions to wait for
+ * @param timeout_ns The maximum amount of time, in nanoseconds, to wait
+ *
+ * @return On success, number of commands processed, may be fewer than 'min_completions' when the
+ * timeout expired. On error, negative `errno` is returned.
+ */
+int
+xnvme_queue_wait_timeout(struct xnvme_queue *queue, uint32_t min_completions, uint64_t timeout_ns);
+
 /**
  * Retrieve a command-context from the given queue for async. command execution with the queue
  *
@@ -154,9 +206,99 @@ typedef void (*xnvme_queue_cb)(struct xnvme_cmd_ctx *ctx, void *opaque);
 int
 xnvme_queue_set_cb(struct xnvme_queue *queue, xnvme_queue_cb cb, void *cb_arg);
 
+/**
+ * Enable a software submission backlog of 'nentries' commands on the given ::xnvme_queue
+ *
+ * Without a backlog, submitting a command to a full queue fails with -EBUSY, leaving it to the
+ * caller to poke and retry. With a backlog, such commands are instead appended to the backlog, in
+ * order, and moved to the queue by xnvme_queue_poke(), xnvme_queue_drain() and
+ * xnvme_queue_wait_timeout() as completions free up room. The backlog adds 'nentries'
+ * command-contexts to the queue, thus, xnvme_queue_get_cmd_ctx() hands out up to
+ * 'capacity + nentries' command-contexts, and submission only fails with -EBUSY when they are all
+ * in use.
+ *
+ * A backlogged command completes like any other, via its callback; when it fails submission upon
+ * being moved to the queue, then its callback is invoked with the errno as status-code. Commands
+ * in the backlog are not counted by xnvme_queue_get_outstanding().
+ *
+ * @note The queue must have no outstanding commands, and the backlog must be enabled before the
+ * software PI stage, see xnvme_queue_set_pi()
+ * @note The payload, including the iovec-array given to xnvme_cmd_pass_iov(), must remain valid
+ * until the command completes
+ * @note The backlog remains enabled until xnvme_queue_term()
+ *
+ * @param queue Pointer to the ::xnvme_queue
+ * @param nentries The maximum number of commands held in the backlog
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned.
+ */
+int
+xnvme_queue_set_backlog(struct xnvme_queue *queue, uint32_t nentries);
+
+/**
+ * Enable submission to the given ::xnvme_queue from multiple threads
+ *
+ * A queue is otherwise driven by a single thread. In the shared mode, any thread may take and hand
+ * back command-contexts with xnvme_queue_get_cmd_ctx() and xnvme_queue_put_cmd_ctx(), which then
+ * use a lock-free free-list, and submit them with xnvme_cmd_pass(), xnvme_cmd_pass_iov(), and the
+ * command-helpers such as xnvme_nvm_read(). Submitted commands are staged on a lock-free
+ * multi-producer ring, and handed to the backend, in order, by the thread owning the queue, upon
+ * xnvme_queue_poke(), xnvme_queue_drain() and xnvme_queue_wait_timeout(). Thus, the backend is
+ * only ever entered by the owner, e.g. an io_uring set up for a single issuer.
+ *
+ * Callbacks are invoked by the owner. The remaining functions, e.g. xnvme_queue_get_outstanding()
+ * and xnvme_queue_term(), are for the owner only. When the queue has no room, then staged
+ * commands remain staged until completions make room, or, with a backlog, move to the backlog.
+ *
+ * @note The queue must have no outstanding commands and every command-context must be in the
+ * queue; the submission backlog, see xnvme_queue_set_backlog(), must be enabled before the shared
+ * mode
+ * @note The shared mode remains enabled until xnvme_queue_term()
+ *
+ * @param queue Pointer to the ::xnvme_queue
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned.
+ */
+int
+xnvme_queue_set_shared(struct xnvme_queue *queue);
+
+/**
+ * Enable command timeouts on the given ::xnvme_queue, with a default of 'timeout_ns' nanoseconds
+ *
+ * A command not completed within its timeout, counted from its submission to the backend, is
+ * cancelled and completes with the status-code-type XNVME_STATUS_CODE_TYPE_VENDOR and the
+ * status-code ETIMEDOUT; a command cancelled via xnvme_cmd_cancel() completes with ECANCELED.
+ * Time spent in the submission backlog or on the staging ring of a shared queue does not count.
+ * The timeout of a single command is overridden with xnvme_cmd_ctx_set_timeout().
+ *
+ * The 'io_uring' and 'io_uring_cmd' interfaces enforce the timeout in the kernel, via a linked
+ * timeout, provided that the completion queue of the ring can hold its completion, other
+ * interfaces rely on a watchdog checking the deadlines upon xnvme_queue_poke(),
+ * xnvme_queue_drain() and xnvme_queue_wait_timeout(), thus, in time as long as the queue is being
+ * processed. Cancellation is supported by the 'io_uring', 'io_uring_cmd', 'libaio', 'posix',
+ * 'emu' and 'thrpool' interfaces, though a command already being processed by the device might
+ * not be cancellable; such a command completes, with the ETIMEDOUT status, once the backend
+ * completes it.
+ *
+ * @note The submission backlog, see xnvme_queue_set_backlog(), must be enabled before timeouts
+ * @note The default can be changed by calling this function again, a 'timeout_ns' of 0 disables
+ * the default timeout, commands submitted thereafter are only timed when overridden
+ *
+ * @param queue Pointer to the ::xnvme_queue
+ * @param timeout_ns The default timeout, in nanoseconds, 0 for none
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned.
+ */
+int
+xnvme_queue_set_timeout(struct xnvme_queue *queue, uint64_t timeout_ns);
+
 /**
  * Get the completion event fd on the given ::xnvme_queue
  *
+ * The eventfd becomes readable when there are completions to process via xnvme_queue_poke(). It
+ * is created on first request and closed by xnvme_queue_term(). Supported by the 'io_uring',
+ * 'io_uring_cmd', 'thrpool', 'emu', and the libvfn 'nvme' async. interfaces.
+ *
  * @param queue Pointer to the ::xnvme_queue to query for outstanding commands
  *
  * @return On success, an eventfd() file descriptor is returned. On error, negative `errno`
@@ -164,3 +306,98 @@ xnvme_queue_set_cb(struct xnvme_queue *queue, xnvme_queue_cb cb, void *cb_arg);
  */
 int
 xnvme_queue_get_completion_fd(struct xnvme_queue *queue);
+
+/**
+ * Opaque set of queues, across devices and backends, polled as one, see xnvme_poll_group_create()
+ *
+ * @struct xnvme_poll_group
+ */
+struct xnvme_poll_group;
+
+/**
+ * Create a poll-group holding up to 'capacity' queues
+ *
+ * A poll-group lets a single thread serve the queues of several devices, polling them with
+ * xnvme_poll_group_poke() and blocking on all of them at once with xnvme_poll_group_wait().
+ * Queues without commands, outstanding or backlogged, are skipped without being poked.
+ *
+ * @note The poll-group does not own its queues; the queues must be removed or the poll-group
+ * destroyed before the queues are terminated with xnvme_queue_term()
+ * @note This function, and the other poll-group functions, are not thread-safe
+ *
+ * @param capacity The maximum number of queues in the poll-group
+ *
+ * @return On success, a pointer to the poll-group is returned. On error, NULL is returned and
+ * `errno` set to indicate the error.
+ */
+struct xnvme_poll_group *
+xnvme_poll_group_create(uint32_t capacity);
+
+/**
+ * Destroy the given poll-group, leaving its queues as they are
+ *
+ * @param group Pointer to a poll-group created with xnvme_poll_group_create()
+ */
+void
+xnvme_poll_group_destroy(struct xnvme_poll_group *group);
+
+/**
+ * Add the given ::xnvme_queue to the poll-group
+ *
+ * @param group Pointer to a poll-group created with xnvme_poll_group_create()
+ * @param queue Pointer to the ::xnvme_queue to add
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned; -EEXIST when the
+ * queue is already in the poll-group and -ENOSPC when the poll-group is full.
+ */
+int
+xnvme_poll_group_add(struct xnvme_poll_group *group, struct xnvme_queue *queue);
+
+/**
+ * Remove the given ::xnvme_queue from the poll-group
+ *
+ * @param group Pointer to a poll-group created with xnvme_poll_group_create()
+ * @param queue Pointer to the ::xnvme_queue to remove
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned; -ENOENT when the
+ * queue is not in the poll-group.
+ */
+int
+xnvme_poll_group_remove(struct xnvme_poll_group *group, struct xnvme_queue *queue);
+
+/**
+ * Poke the queues of the poll-group, round-robin, processing at most 'budget' completions
+ *
+ * Each call starts with the queue following the one which exhausted the budget of the previous
+ * call, thus, a busy queue does not starve the others.
+ *
+ * @param group Pointer to a poll-group created with xnvme_poll_group_create()
+ * @param budget The maximum number of completions to process, 0 means no limit
+ *
+ * @return On success, the number of completions processed is returned. On error, negative
+ * `errno` is returned.
+ */
+int
+xnvme_poll_group_poke(struct xnvme_poll_group *group, uint32_t budget);
+
+/**
+ * Process completions until 'min_completions' are processed, nothing is outstanding, or
+ * 'timeout_ns' nanoseconds have passed
+ *
+ * With commands outstanding on a single queue, the wait is that of xnvme_queue_wait_timeout().
+ * Otherwise, the calling thread sleeps in poll() on the completion fds of the busy queues, see
+ * xnvme_queue_get_completion_fd(). When a busy queue has no completion fd, then the thread waits
+ * on that queue, with xnvme_queue_wait_timeout(), for at most 100 microseconds at a time, and the
+ * poll-group is poked in between, thus, completions on the other queues are processed with up to
+ * that much delay.
+ *
+ * @param group Pointer to a poll-group created with xnvme_poll_group_create()
+ * @param min_completions The number of completions to wait for, 0 means all outstanding
+ * @param timeout_ns The maximum time to wait in nanoseconds, 0 means no timeout
+ *
+ * @return On success, the number of completions processed is returned. On error, negative
+ * `errno` is returned.
+ */
+int
+xnvme_poll_group_wait(struct xnvme_poll_group *group, uint32_t min_completions,
+		      uint64_t timeout_ns);
@@ -92,6 +92,10 @@ enum xnvme_spec_status_code_type {
 enum xnvme_spec_status_code {
 	// TODO: Add remaining status codes from spec
 	XNVME_STATUS_CODE_INVALID_FIELD = 0x02, ///< Invalid Field
+
+	XNVME_STATUS_CODE_E2E_GUARD  = 0x82, ///< End-to-end Guard Check Error (media)
+	XNVME_STATUS_CODE_E2E_APPTAG = 0x83, ///< End-to-end Application Tag Check Error (media)
+	XNVME_STATUS_CODE_E2E_REFTAG = 0x84, ///< End-to-end Reference Tag Check Error (media)
 };
 
 /**
@@ -175,6 +175,11 @@ XNVME_MAX(int x, int y)
 	return x > y ? x : y;
 }
 
+/**
+ * Sample the monotonic clock
+ *
+ * @return clock sample in nano seconds
+ */
 static inline uint64_t
 _xnvme_timer_clock_sample(void)
 {
@@ -182,7 +187,7 @@ _xnvme_timer_clock_sample(void)
 
 	clock_gettime(CLOCK_MONOTONIC, &ts);
 
-	return ts.tv_nsec + ts.tv_sec * 1e9;
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
 }
 
 /**
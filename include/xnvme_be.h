@@ -10,9 +10,9 @@
 #include <libxnvme.h>
 #include <xnvme_be_registry.h>
 
-#define XNVME_BE_QUEUE_STATE_NBYTES 256
+#define XNVME_BE_QUEUE_STATE_NBYTES 296
 
-#define XNVME_BE_ASYNC_NBYTES  64
+#define XNVME_BE_ASYNC_NBYTES  72
 #define XNVME_BE_SYNC_NBYTES   24
 #define XNVME_BE_ADMIN_NBYTES  24
 #define XNVME_BE_DEV_NBYTES    24
@@ -37,8 +37,8 @@ struct xnvme_be_async {
 	// Non-blocking reaping of up to `max` io completions
 	int (*poke)(struct xnvme_queue *, uint32_t);
 
-	// Blocking reaping of all outstanding io completions
-	int (*wait)(struct xnvme_queue *);
+	// Blocking reaping of at least `min` io completions, or until `timeout_ns` has elapsed
+	int (*wait)(struct xnvme_queue *, uint32_t, uint64_t);
 
 	// Do initialization of the underlying backend's io path
 	int (*init)(struct xnvme_queue *, int);
@@ -49,6 +49,9 @@ struct xnvme_be_async {
 	// Provide the completion event FD for the queue
 	int (*get_completion_fd)(struct xnvme_queue *);
 
+	// Request cancellation of an outstanding command, completed with ECANCELED by poke/wait
+	int (*cancel)(struct xnvme_cmd_ctx *);
+
 	// Check if the backend is supported in the current environment
 	const char *id;
 };
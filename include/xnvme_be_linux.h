@@ -27,8 +27,13 @@ struct xnvme_be_linux_state {
 	uint8_t pseudo;
 	uint8_t poll_io;
 	uint8_t poll_sq;
+	uint8_t defer_taskrun;
+	uint8_t coop_taskrun;
+	uint8_t submit_all;
+	uint8_t register_ring_fd;
+	uint8_t register_files;
 
-	uint8_t _rsvd[121];
+	uint8_t _rsvd[116];
 };
 XNVME_STATIC_ASSERT(sizeof(struct xnvme_be_linux_state) == XNVME_BE_STATE_NBYTES, "Incorrect size")
 
@@ -11,9 +11,15 @@ struct xnvme_queue_libaio {
 
 	io_context_t aio_ctx;
 	struct io_event *aio_events;
+	struct io_event *canceled; ///< Events of cancelled commands, for the next poke/wait
+
+	struct iocb **iocbs; ///< Staged iocbs, submitted by the next poke/wait when batching
+	uint32_t nstaged;
+	uint32_t ncanceled;
 
 	uint8_t poll_io;
-	uint8_t rsvd[212];
+	uint8_t batching;
+	uint8_t rsvd[190];
 };
 XNVME_STATIC_ASSERT(sizeof(struct xnvme_queue_libaio) == XNVME_BE_QUEUE_STATE_NBYTES,
 		    "Incorrect size")
@@ -5,10 +5,24 @@
 #ifndef __INTERNAL_XNVME_BE_LINUX_LIBURING_H
 #define __INTERNAL_XNVME_BE_LINUX_LIBURING_H
 #include <liburing.h>
+#include <xnvme_buf.h>
 
 #define XNVME_QUEUE_IOU_CQE_BATCH_MAX 8
+#define XNVME_QUEUE_IOU_SQ_ENTRIES_MAX 4096 ///< The CQ is sized separately, via CQSIZE
+#define XNVME_QUEUE_IOU_CQ_ENTRIES_MAX 65536 ///< The kernel limit, IORING_MAX_CQ_ENTRIES
+#define XNVME_QUEUE_IOU_CQES_PER_CMD 3 ///< The command, its linked timeout and a cancel
 #define XNVME_QUEUE_IOU_BIGSQE        (0x1 << 2)
 
+/**
+ * Per-queue mirror of the device buffer-registry, the slots are registered with the ring as fixed
+ * buffers, and the slot-index is used as 'buf_index' for IORING_OP_{READ,WRITE}_FIXED
+ */
+struct xnvme_queue_liburing_bufs {
+	uint64_t gen;  ///< Generation of the buffer-registry which the slots mirror
+	uint32_t hint; ///< Slot of the most recent lookup-hit
+	struct iovec slots[XNVME_BUF_REGISTRY_NSLOTS];
+};
+
 struct xnvme_queue_liburing {
 	struct xnvme_queue_base base;
 
@@ -17,8 +31,11 @@ struct xnvme_queue_liburing {
 	uint8_t poll_io;
 	uint8_t poll_sq;
 	uint8_t batching;
+	uint8_t fixed_file; ///< The device-fd is registered as fixed file 0
+
+	int efd; ///< Completion eventfd, registered on demand, -1 when not
 
-	uint8_t _rsvd[13];
+	struct xnvme_queue_liburing_bufs *bufs;
 };
 XNVME_STATIC_ASSERT(sizeof(struct xnvme_queue_liburing) == XNVME_BE_QUEUE_STATE_NBYTES,
 		    "Incorrect size")
@@ -33,8 +50,52 @@ xnvme_be_linux_liburing_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbu
 int
 xnvme_be_linux_liburing_poke(struct xnvme_queue *queue, uint32_t max);
 
+/**
+ * Get an SQE from the ring of the given queue for the given command, NULL for an internal request;
+ * when the SQ is full of batched SQEs, then these are submitted to make room, as the SQ can be
+ * smaller than the capacity of the queue. For a command with a deadline, room is reserved for
+ * its linked timeout, see xnvme_be_linux_liburing_link_timeout().
+ *
+ * @return On success, an SQE is returned. NULL when the SQ remains full.
+ */
+struct io_uring_sqe *
+xnvme_be_linux_liburing_get_sqe(struct xnvme_queue_liburing *queue, struct xnvme_cmd_ctx *ctx);
+
+/**
+ * Link a timeout, expiring at the deadline of the given command, to its prepared SQE, such that
+ * the kernel cancels the command once its deadline has passed; the timeout completes without a
+ * command-context, thus, it is skipped upon reaping
+ *
+ * The timeout is only linked when the CQ holds a second CQE for every command, or the kernel
+ * keeps CQEs overflowing the CQ (IORING_FEAT_NODROP), otherwise the command is left to the
+ * watchdog
+ */
+void
+xnvme_be_linux_liburing_link_timeout(struct xnvme_queue_liburing *queue, struct io_uring_sqe *sqe,
+				     struct xnvme_cmd_ctx *ctx);
+
+/**
+ * Request cancellation of the given command via IORING_OP_ASYNC_CANCEL, submitted right away
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned, -ENOTSUP when the CQ
+ * holds less than XNVME_QUEUE_IOU_CQES_PER_CMD CQEs per command and the kernel drops CQEs
+ * overflowing it.
+ */
 int
-xnvme_be_linux_liburing_wait(struct xnvme_queue *queue);
+xnvme_be_linux_liburing_cancel(struct xnvme_cmd_ctx *ctx);
+
+/**
+ * Block until at least 'min' CQEs are available on the ring, or 'timeout_ns' has elapsed, without
+ * reaping them
+ *
+ * @return On success, 0 is returned, also when the timeout expired. On error, negative `errno`
+ * is returned.
+ */
+int
+xnvme_be_linux_liburing_wait_cqes(struct xnvme_queue *queue, uint32_t min, uint64_t timeout_ns);
+
+int
+xnvme_be_linux_liburing_wait(struct xnvme_queue *queue, uint32_t min, uint64_t timeout_ns);
 
 int
 xnvme_be_linux_liburing_init(struct xnvme_queue *queue, int opts);
@@ -42,4 +103,7 @@ xnvme_be_linux_liburing_init(struct xnvme_queue *queue, int opts);
 int
 xnvme_be_linux_liburing_term(struct xnvme_queue *queue);
 
+int
+xnvme_be_linux_liburing_get_completion_fd(struct xnvme_queue *queue);
+
 #endif /* __INTERNAL_XNVME_BE_LINUX_LIBURING_H */
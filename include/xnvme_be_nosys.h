@@ -38,7 +38,7 @@ int
 xnvme_be_nosys_queue_poke(struct xnvme_queue *queue, uint32_t max);
 
 int
-xnvme_be_nosys_queue_wait(struct xnvme_queue *queue);
+xnvme_be_nosys_queue_wait(struct xnvme_queue *queue, uint32_t min, uint64_t timeout_ns);
 
 int
 xnvme_be_nosys_queue_init(struct xnvme_queue *queue, int opts);
@@ -49,6 +49,9 @@ xnvme_be_nosys_queue_term(struct xnvme_queue *queue);
 int
 xnvme_be_nosys_queue_get_completion_fd(struct xnvme_queue *queue);
 
+int
+xnvme_be_nosys_queue_cancel(struct xnvme_cmd_ctx *ctx);
+
 int
 xnvme_be_nosys_queue_supported(struct xnvme_dev *dev, uint32_t opts);
 
@@ -102,6 +105,7 @@ xnvme_be_nosys_dev_close(struct xnvme_dev *dev);
 		.init              = xnvme_be_nosys_queue_init,              \
 		.term              = xnvme_be_nosys_queue_term,              \
 		.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd, \
+		.cancel            = xnvme_be_nosys_queue_cancel,            \
 		.id                = "ENOSYS",                               \
 	}
 
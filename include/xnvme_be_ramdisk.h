@@ -4,10 +4,35 @@
 
 #ifndef __INTERNAL_XNVME_BE_RAMDISK_H
 #define __INTERNAL_XNVME_BE_RAMDISK_H
+#include <pthread.h>
+
+#define XNVME_BE_RAMDISK_LBA_NBYTES 512
+
+/**
+ * Zones of a ramdisk opened in zoned mode; the zones are shared by all queues of the device,
+ * and async. implementations such as thrpool execute commands concurrently, thus access to
+ * them is guarded by 'mutex'
+ */
+struct xnvme_be_ramdisk_znd {
+	pthread_mutex_t mutex;
+	uint64_t zsze;    ///< Zone size, in LBAs
+	uint64_t zcap;    ///< Zone capacity, in LBAs
+	uint32_t nzones;  ///< Number of zones
+	uint32_t mor;     ///< Maximum number of open zones, 0 means no limit
+	uint32_t mar;     ///< Maximum number of active zones, 0 means no limit
+	uint32_t nopen;   ///< Number of zones in the implicitly or explicitly opened state
+	uint32_t nactive; ///< Number of zones in an opened or the closed state
+	struct xnvme_spec_znd_descr zones[];
+};
+
 struct xnvme_be_ramdisk_state {
 	void *ramdisk;
+	size_t nbytes;                    ///< Size given by the URI, rounded down to whole zones
+	size_t map_nbytes;                ///< Size of the mapping when memfd-backed, otherwise 0
+	struct xnvme_be_ramdisk_znd *znd; ///< Zones when opened in zoned mode, otherwise NULL
+	int fd;                           ///< The memfd backing the ramdisk, -1 when on the heap
 
-	uint8_t _rsvd[120];
+	uint8_t _rsvd[92];
 };
 XNVME_STATIC_ASSERT(sizeof(struct xnvme_be_ramdisk_state) == XNVME_BE_STATE_NBYTES,
 		    "Incorrect size");
@@ -18,8 +43,45 @@ xnvme_be_ramdisk_supported(struct xnvme_dev *dev, uint32_t opts);
 size_t
 xnvme_be_ramdisk_dev_get_size(struct xnvme_dev *dev);
 
+int
+xnvme_be_ramdisk_sync_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes, void *mbuf,
+			     size_t mbuf_nbytes);
+
+int
+xnvme_be_ramdisk_sync_cmd_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, size_t dvec_cnt,
+			      size_t dvec_nbytes, void *mbuf, size_t mbuf_nbytes);
+
+/**
+ * Setup zoned mode given the options of the URI following the size, e.g. 'zoned:zsze=4096'
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned.
+ */
+int
+xnvme_be_ramdisk_znd_init(struct xnvme_be_ramdisk_state *state, const char *opts);
+
+void
+xnvme_be_ramdisk_znd_term(struct xnvme_be_ramdisk_state *state);
+
+/**
+ * Check a write of 'nlb' LBAs at 'slba' against the write pointer of the zone and advance it;
+ * for append, then 'slba' is the start of the zone and the command result is set. The LBA at
+ * which the data is to be written is assigned to 'wslba'
+ *
+ * @return On success, 0 is returned. On error, the command status is set and -EIO returned.
+ */
+int
+xnvme_be_ramdisk_znd_write(struct xnvme_cmd_ctx *ctx, uint64_t slba, uint64_t nlb, bool append,
+			   uint64_t *wslba);
+
+int
+xnvme_be_ramdisk_znd_mgmt_send(struct xnvme_cmd_ctx *ctx);
+
+int
+xnvme_be_ramdisk_znd_mgmt_recv(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes);
+
 extern struct xnvme_be_admin g_xnvme_be_ramdisk_admin;
 extern struct xnvme_be_sync g_xnvme_be_ramdisk_sync;
+extern struct xnvme_be_async g_xnvme_be_ramdisk_async;
 extern struct xnvme_be_mem g_xnvme_be_ramdisk_mem;
 extern struct xnvme_be_dev g_xnvme_be_ramdisk_dev;
 
@@ -0,0 +1,66 @@
+// SPDX-FileCopyrightText: Samsung Electronics Co., Ltd
+//
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef __INTERNAL_XNVME_BUF_H
+#define __INTERNAL_XNVME_BUF_H
+#include <pthread.h>
+#include <stdbool.h>
+#include <sys/uio.h>
+
+#define XNVME_BUF_REGISTRY_NSLOTS 64
+
+/**
+ * Limit on the size of a single registered buffer, mirroring the limit of io_uring
+ */
+#define XNVME_BUF_REGISTRY_SLOT_NBYTES_MAX (1ULL << 30)
+
+/**
+ * Registry of the buffers allocated with xnvme_buf_alloc() on a device opened with the
+ * 'register_buffers' option. Async. backends supporting fixed buffers, e.g. io_uring, mirror the
+ * slots into a per-queue buffer-table.
+ *
+ * 'gen' is incremented whenever a slot changes, such that a queue can cheaply determine whether
+ * its buffer-table is stale by comparing it with the generation it last synchronized with.
+ */
+struct xnvme_buf_registry {
+	pthread_mutex_t mutex;
+	uint64_t gen;
+	struct iovec slots[XNVME_BUF_REGISTRY_NSLOTS];
+};
+
+/**
+ * Setup the buffer-registry of the given device
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned.
+ */
+int
+xnvme_buf_registry_init(struct xnvme_dev *dev);
+
+/**
+ * Tear down the buffer-registry of the given device, if any
+ */
+void
+xnvme_buf_registry_term(struct xnvme_dev *dev);
+
+/**
+ * Copy the slots of the given registry into 'slots'
+ *
+ * @return The generation of the registry at the time of the copy
+ */
+uint64_t
+xnvme_buf_registry_snapshot(struct xnvme_buf_registry *reg, struct iovec *slots);
+
+/**
+ * Check whether the given buffer occupies a slot of the given registry
+ */
+bool
+xnvme_buf_registry_contains(struct xnvme_buf_registry *reg, const void *buf);
+
+static inline uint64_t
+xnvme_buf_registry_gen(struct xnvme_buf_registry *reg)
+{
+	return __atomic_load_n(&reg->gen, __ATOMIC_ACQUIRE);
+}
+
+#endif /* __INTERNAL_XNVME_BUF_H */
@@ -11,4 +11,15 @@ xnvme_crc64_nvme(const void *buf, size_t len, uint64_t crc);
 uint16_t
 xnvme_crc16_t10dif(uint16_t init_crc, const void *buf, size_t len);
 
+/**
+ * Compute the CRC of each of the 'nbufs' buffers of 'len' bytes in 'bufs', with the streams
+ * interleaved when supported by the implementation. On entry, 'crcs' holds the initial CRC of
+ * each buffer, on return, the resulting CRC of each buffer.
+ */
+void
+xnvme_crc64_nvme_mb(uint64_t *crcs, const void *const *bufs, size_t len, uint32_t nbufs);
+
+void
+xnvme_crc16_t10dif_mb(uint16_t *crcs, const void *const *bufs, size_t len, uint32_t nbufs);
+
 #endif /* __INTERNAL_XNVME_CRC_H */
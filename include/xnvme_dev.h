@@ -38,6 +38,10 @@ struct xnvme_dev {
 	} idcss;                                    ///< Command Set Specific
 
 	struct xnvme_opts opts; ///< Options
+
+	struct xnvme_buf_registry *bufreg; ///< Buffers registered for fixed-buffer I/O
+
+	int numa_node; ///< NUMA node of buffers and threads, negative when unknown
 };
 // XNVME_STATIC_ASSERT(sizeof(struct xnvme_ident) == 768, "Incorrect size")
 
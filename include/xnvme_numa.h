@@ -0,0 +1,38 @@
+// SPDX-FileCopyrightText: Samsung Electronics Co., Ltd
+//
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef __INTERNAL_XNVME_NUMA_H
+#define __INTERNAL_XNVME_NUMA_H
+#include <pthread.h>
+
+#define XNVME_NUMA_NODES_MAX 1024
+
+/**
+ * Set the memory-policy of the pages within [addr, addr + nbytes[ to prefer the given NUMA node
+ *
+ * Only pages wholly within the range are affected; pages not yet faulted in are placed by the
+ * policy, and pages already faulted in are migrated, when mapped by this process only. The policy
+ * stays with the mapping, thus, the range must be a private mapping owned by the caller, e.g. from
+ * mmap(), not heap memory, and is best bound before it is touched, sparing the migration.
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned.
+ */
+int
+xnvme_numa_bind_mem(void *addr, size_t nbytes, int node);
+
+/**
+ * Restrict the CPU-affinity of the given thread to the CPUs of the given NUMA node
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned.
+ */
+int
+xnvme_numa_bind_thread(pthread_t thread, int node);
+
+/**
+ * Returns the highest numbered CPU of the given NUMA node, or negative `errno` on error
+ */
+int
+xnvme_numa_node_cpu(int node);
+
+#endif /* __INTERNAL_XNVME_NUMA_H */
@@ -32,13 +32,24 @@ struct xnvme_cmd_ctx_entry {
 };
 XNVME_STATIC_ASSERT(sizeof(struct xnvme_cmd_ctx_entry) == 128, "Incorrect size")
 
+struct xnvme_queue_pi;
+struct xnvme_queue_backlog;
+struct xnvme_queue_shared;
+struct xnvme_queue_timeout;
+
 struct xnvme_queue_base {
 	struct xnvme_dev *dev; ///< Device on which the queue operates
 	uint32_t capacity;     ///< Maximum number of outstanding commands
 	uint32_t outstanding;  ///< Number of currently outstanding commands
 	SLIST_HEAD(, xnvme_cmd_ctx_entry) pool;
+	struct xnvme_queue_pi *pi; ///< Software PI stage, see xnvme_queue_set_pi()
+	struct xnvme_queue_backlog *backlog; ///< Submission backlog, see xnvme_queue_set_backlog()
+	struct xnvme_queue_shared *shared;   ///< Shared submission, see xnvme_queue_set_shared()
+	struct xnvme_queue_timeout *timeout; ///< Command timeouts, see xnvme_queue_set_timeout()
+	uint32_t pool_ninit; ///< Number of pool-storage entries initialized so far
+	uint32_t opts;       ///< Options in effect, see xnvme_queue_get_opts()
 };
-XNVME_STATIC_ASSERT(sizeof(struct xnvme_queue_base) == 24, "Incorrect size")
+XNVME_STATIC_ASSERT(sizeof(struct xnvme_queue_base) == 64, "Incorrect size")
 
 struct xnvme_queue {
 	struct xnvme_queue_base base;
@@ -49,4 +60,269 @@ struct xnvme_queue {
 };
 XNVME_STATIC_ASSERT(sizeof(struct xnvme_queue) == XNVME_BE_QUEUE_STATE_NBYTES, "Incorrect size")
 
+/**
+ * A command passed to a queue along with its payload, as held by the submission backlog and the
+ * multi-producer staging ring, until handed to the backend
+ */
+struct xnvme_queue_cmd {
+	struct xnvme_cmd_ctx *ctx;
+
+	void *dbuf;         ///< Payload of xnvme_cmd_pass(), NULL for xnvme_cmd_pass_iov()
+	struct iovec *dvec; ///< Payload of xnvme_cmd_pass_iov()
+	size_t dvec_cnt;
+	size_t dbuf_nbytes;
+	void *mbuf;
+	size_t mbuf_nbytes;
+};
+
+/**
+ * An absolute point in time on CLOCK_MONOTONIC, laid out as 'struct __kernel_timespec', such that
+ * it can be handed to io_uring as is
+ */
+struct xnvme_queue_deadline {
+	int64_t tv_sec;
+	long long tv_nsec;
+};
+
+/**
+ * Submit the given command to the backend, via the software PI stage when enabled, arming its
+ * timeout when the queue has timeouts enabled
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned.
+ */
+int
+xnvme_queue_submit_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes, void *mbuf,
+		      size_t mbuf_nbytes);
+
+/**
+ * Submit the given command to the backend, see xnvme_queue_submit_io()
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned.
+ */
+int
+xnvme_queue_submit_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, size_t dvec_cnt,
+		       size_t dvec_nbytes, void *mbuf, size_t mbuf_nbytes);
+
+/**
+ * Complete the given command, which failed to reach the backend with the negative `errno` 'err',
+ * by assigning the error as a vendor-specific status and invoking its callback
+ *
+ * Whatever holds the command, e.g. a backlog or staging slot, must be released beforehand, as the
+ * callback might submit again.
+ */
+void
+xnvme_queue_complete_err(struct xnvme_cmd_ctx *ctx, int err);
+
+/**
+ * Submit the given command via the software PI stage of its queue; WRITE commands get their
+ * protection information generated and READ commands get theirs verified upon completion, other
+ * commands, and commands with PRACT set, are passed on to the backend as is
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned.
+ */
+int
+xnvme_queue_pi_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes, void *mbuf,
+		      size_t mbuf_nbytes);
+
+/**
+ * Submit the given command via the software PI stage of its queue, see xnvme_queue_pi_cmd_io(),
+ * the stage requires a single data-vector
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned.
+ */
+int
+xnvme_queue_pi_cmd_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, size_t dvec_cnt,
+		       size_t dvec_nbytes, void *mbuf, size_t mbuf_nbytes);
+
+/**
+ * Process completions of the software PI stage and of the backend
+ *
+ * @return On success, number of completions processed. On error, negative `errno` is returned.
+ */
+int
+xnvme_queue_pi_poke(struct xnvme_queue *queue, uint32_t max);
+
+/**
+ * Tear down the software PI stage of the given queue, if any
+ */
+void
+xnvme_queue_pi_term(struct xnvme_queue *queue);
+
+/**
+ * Returns the number of command-contexts of the given queue, those of its pool-storage plus those
+ * added by its submission backlog; command-context identifiers are less than this
+ */
+uint32_t
+xnvme_queue_nctx(struct xnvme_queue *queue);
+
+/**
+ * Returns the number of commands in the submission backlog of the given queue
+ */
+uint32_t
+xnvme_queue_backlog_len(struct xnvme_queue *queue);
+
+/**
+ * Submit the given command, or when the queue is full, append it to the submission backlog
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned, -EBUSY when both the
+ * queue and the backlog are full.
+ */
+int
+xnvme_queue_backlog_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes, void *mbuf,
+			   size_t mbuf_nbytes);
+
+/**
+ * Submit the given command, or when the queue is full, append it to the submission backlog, see
+ * xnvme_queue_backlog_cmd_io()
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned.
+ */
+int
+xnvme_queue_backlog_cmd_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, size_t dvec_cnt,
+			    size_t dvec_nbytes, void *mbuf, size_t mbuf_nbytes);
+
+/**
+ * Move commands from the submission backlog to the backend, in order, while the queue has room;
+ * commands failing submission are completed with the error via their callback
+ *
+ * @return The number of commands submitted
+ */
+uint32_t
+xnvme_queue_backlog_refill(struct xnvme_queue *queue);
+
+/**
+ * Process completions, then refill the queue from the submission backlog
+ *
+ * @return On success, number of completions processed. On error, negative `errno` is returned.
+ */
+int
+xnvme_queue_backlog_poke(struct xnvme_queue *queue, uint32_t max);
+
+/**
+ * Assign the given callback to the command-contexts added by the submission backlog, if any
+ */
+void
+xnvme_queue_backlog_set_cb(struct xnvme_queue *queue, xnvme_queue_cb cb, void *cb_arg);
+
+/**
+ * Tear down the submission backlog of the given queue, if any
+ */
+void
+xnvme_queue_backlog_term(struct xnvme_queue *queue);
+
+/**
+ * Stage the given command on the multi-producer staging ring of its queue, to be handed to the
+ * backend by the poller, see xnvme_queue_shared_refill()
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned.
+ */
+int
+xnvme_queue_shared_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes, void *mbuf,
+			  size_t mbuf_nbytes);
+
+/**
+ * Stage the given command on the multi-producer staging ring of its queue, see
+ * xnvme_queue_shared_cmd_io()
+ *
+ * @return On success, 0 is returned. On error, negative `errno` is returned.
+ */
+int
+xnvme_queue_shared_cmd_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, size_t dvec_cnt,
+			   size_t dvec_nbytes, void *mbuf, size_t mbuf_nbytes);
+
+/**
+ * Move commands from the staging ring to the backend, or to the submission backlog when enabled,
+ * in order, while there is room; commands failing submission are completed with the error via
+ * their callback
+ *
+ * @return The number of commands moved
+ */
+uint32_t
+xnvme_queue_shared_refill(struct xnvme_queue *queue);
+
+/**
+ * Returns the number of commands on the staging ring of the given queue
+ */
+uint32_t
+xnvme_queue_shared_len(struct xnvme_queue *queue);
+
+/**
+ * Take a command-context off the lock-free free-list of the given queue
+ *
+ * @return On success, a command-context is returned. On error, NULL is returned and `errno` is
+ * set to indicate the error.
+ */
+struct xnvme_cmd_ctx *
+xnvme_queue_shared_get_cmd_ctx(struct xnvme_queue *queue);
+
+/**
+ * Put a command-context onto the lock-free free-list of the given queue
+ */
+void
+xnvme_queue_shared_put_cmd_ctx(struct xnvme_queue *queue, struct xnvme_cmd_ctx *ctx);
+
+/**
+ * Tear down the shared submission mode of the given queue, if any
+ */
+void
+xnvme_queue_shared_term(struct xnvme_queue *queue);
+
+/**
+ * Start the clock on the given command, when its queue has timeouts enabled and a timeout applies
+ * to the command; its callback is interposed until completion
+ *
+ * @return true when the command is armed, false otherwise
+ */
+bool
+xnvme_queue_timeout_arm(struct xnvme_cmd_ctx *ctx);
+
+/**
+ * Undo xnvme_queue_timeout_arm() for a command which failed submission
+ */
+void
+xnvme_queue_timeout_disarm(struct xnvme_cmd_ctx *ctx);
+
+/**
+ * Returns the deadline of the given command, or NULL when it is not armed; used by backends
+ * enforcing the timeout natively
+ */
+struct xnvme_queue_deadline *
+xnvme_queue_timeout_deadline(struct xnvme_cmd_ctx *ctx);
+
+/**
+ * Flag the given command, when armed, to complete with the given status, e.g. ETIMEDOUT or
+ * ECANCELED, regardless of the status reported by the backend; the first flag sticks
+ *
+ * @return true when this call flagged the command, false otherwise
+ */
+bool
+xnvme_queue_timeout_expire(struct xnvme_cmd_ctx *ctx, int status);
+
+/**
+ * Withdraw the flag set by xnvme_queue_timeout_expire(), e.g. when the cancellation it was set
+ * for failed, such that the command completes with the status reported by the backend
+ */
+void
+xnvme_queue_timeout_unexpire(struct xnvme_cmd_ctx *ctx);
+
+/**
+ * Flag the armed commands whose deadline has passed as timed out and request their cancellation
+ * from the backend; cheap when no deadline has passed
+ */
+void
+xnvme_queue_timeout_scan(struct xnvme_queue *queue);
+
+/**
+ * Returns the earliest deadline, in nanoseconds on CLOCK_MONOTONIC, of the armed commands of the
+ * given queue, 0 when none are armed
+ */
+uint64_t
+xnvme_queue_timeout_next(struct xnvme_queue *queue);
+
+/**
+ * Tear down the command timeouts of the given queue, if any
+ */
+void
+xnvme_queue_timeout_term(struct xnvme_queue *queue);
+
 #endif /* __INTERNAL_XNVME_QUEUE_H */
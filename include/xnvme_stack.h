@@ -0,0 +1,72 @@
+// SPDX-FileCopyrightText: Samsung Electronics Co., Ltd
+//
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef __INTERNAL_XNVME_STACK_H
+#define __INTERNAL_XNVME_STACK_H
+#include <stdint.h>
+
+#define XNVME_STACK_EMPTY UINT32_MAX
+
+/**
+ * Lock-free stack of 32-bit indices, linked via a 'next' array provided by the user, e.g. of free
+ * buffers or command-contexts
+ *
+ * The index of the top is packed, along with a tag incremented on every update, into 'top', such
+ * that push and pop are a single compare-and-swap, without suffering from ABA. The tag is in the
+ * upper and the index in the lower 32 bits; a 'top' of 0 thus holds index 0, and a stack is made
+ * empty by setting it to XNVME_STACK_EMPTY.
+ */
+static inline uint64_t
+_xnvme_stack_top(uint64_t top, uint32_t idx)
+{
+	return (((top >> 32) + 1) << 32) | idx;
+}
+
+/**
+ * Push the 'first' to 'last' indices, which are already linked via 'next', onto the stack
+ */
+static inline void
+xnvme_stack_push(uint64_t *top, uint32_t *next, uint32_t first, uint32_t last)
+{
+	uint64_t cur = __atomic_load_n(top, __ATOMIC_RELAXED);
+
+	do {
+		__atomic_store_n(&next[last], (uint32_t)cur, __ATOMIC_RELAXED);
+	} while (!__atomic_compare_exchange_n(top, &cur, _xnvme_stack_top(cur, first), true,
+					      __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/**
+ * Pop up to 'max' indices off the stack into 'idx'
+ *
+ * Walking the stack is safe without holding it, as an index only leaves the stack by an update of
+ * 'top', which fails the compare-and-swap and thus retries the walk.
+ *
+ * @return The number of indices popped, 0 when the stack is empty
+ */
+static inline uint32_t
+xnvme_stack_pop(uint64_t *top, uint32_t *next, uint32_t *idx, uint32_t max)
+{
+	uint64_t cur = __atomic_load_n(top, __ATOMIC_ACQUIRE);
+	uint32_t npopped;
+
+	do {
+		uint32_t rest = (uint32_t)cur;
+
+		for (npopped = 0; (npopped < max) && (rest != XNVME_STACK_EMPTY); ++npopped) {
+			idx[npopped] = rest;
+			rest = __atomic_load_n(&next[rest], __ATOMIC_RELAXED);
+		}
+		if (!npopped) {
+			return 0;
+		}
+
+		if (__atomic_compare_exchange_n(top, &cur, _xnvme_stack_top(cur, rest), true,
+						__ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+			return npopped;
+		}
+	} while (1);
+}
+
+#endif /* __INTERNAL_XNVME_STACK_H */
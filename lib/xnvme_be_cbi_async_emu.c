@@ -11,6 +11,10 @@
 #include <errno.h>
 #include <xnvme_queue.h>
 #include <xnvme_dev.h>
+#ifdef XNVME_BE_LINUX_ENABLED
+#include <unistd.h>
+#include <sys/eventfd.h>
+#endif
 
 /**
  * NOTE: this should be possible to do within a single cache-line... refactor pointers for re-use
@@ -26,6 +30,7 @@ struct qpair_entry {
 	uint32_t data_vec_cnt;
 	uint32_t meta_nbytes;
 	uint32_t is_vectored;
+	uint32_t is_canceled; ///< Completed with ECANCELED, instead of processed, upon poke
 
 	STAILQ_ENTRY(qpair_entry) link;
 };
@@ -42,7 +47,9 @@ struct xnvme_queue_emu {
 
 	struct qpair *qp;
 
-	uint8_t _rsvd[224];
+	int efd; ///< Completion eventfd, created on demand
+
+	uint8_t _rsvd[220];
 };
 XNVME_STATIC_ASSERT(sizeof(struct xnvme_queue_emu) == XNVME_BE_QUEUE_STATE_NBYTES,
 		    "Incorrect size")
@@ -85,6 +92,13 @@ emu_term(struct xnvme_queue *q)
 
 	qpair_term(queue->qp);
 
+#ifdef XNVME_BE_LINUX_ENABLED
+	if (queue->efd >= 0) {
+		close(queue->efd);
+		queue->efd = -1;
+	}
+#endif
+
 	return 0;
 }
 
@@ -93,6 +107,8 @@ emu_init(struct xnvme_queue *q, int XNVME_UNUSED(opts))
 {
 	struct xnvme_queue_emu *queue = (void *)q;
 
+	queue->efd = -1;
+
 	if (qpair_alloc(&(queue->qp), queue->base.capacity)) {
 		XNVME_DEBUG("FAILED: qpair_alloc()");
 		goto failed;
@@ -122,6 +138,15 @@ emu_poke(struct xnvme_queue *q, uint32_t max)
 
 		STAILQ_REMOVE_HEAD(&qp->sq, link);
 
+		if (entry->is_canceled) {
+			entry->ctx->cpl.status.sc = ECANCELED;
+			entry->ctx->cpl.status.sct = XNVME_STATUS_CODE_TYPE_VENDOR;
+			entry->ctx->async.cb(entry->ctx, entry->ctx->async.cb_arg);
+			STAILQ_INSERT_TAIL(&qp->rp, entry, link);
+			++completed;
+			continue;
+		}
+
 		err = entry->is_vectored
 			      ? queue->base.dev->be.sync.cmd_iov(
 					entry->ctx, entry->data, entry->data_vec_cnt,
@@ -147,6 +172,24 @@ emu_poke(struct xnvme_queue *q, uint32_t max)
 	return completed;
 }
 
+/**
+ * Commands are processed when the queue is poked, thus, with regards to the completion eventfd, a
+ * submitted command is a pending completion
+ */
+static inline void
+emu_signal(struct xnvme_queue_emu *queue)
+{
+#ifdef XNVME_BE_LINUX_ENABLED
+	uint64_t val = 1;
+
+	if ((queue->efd >= 0) && (write(queue->efd, &val, sizeof(val)) < 0)) {
+		XNVME_DEBUG("FAILED: write(efd), errno: %d", errno);
+	}
+#else
+	(void)queue;
+#endif
+}
+
 static inline int
 emu_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes, void *mbuf,
 	   size_t mbuf_nbytes)
@@ -172,11 +215,14 @@ emu_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes, void *mbuf
 	entry->meta = mbuf;
 	entry->meta_nbytes = mbuf_nbytes;
 	entry->is_vectored = false;
+	entry->is_canceled = false;
 
 	STAILQ_INSERT_TAIL(&qp->sq, entry, link);
 
 	ctx->async.queue->base.outstanding += 1;
 
+	emu_signal(queue);
+
 	return 0;
 }
 
@@ -205,14 +251,62 @@ emu_cmd_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, size_t dvec_cnt, size
 	entry->meta = mbuf;
 	entry->meta_nbytes = mbuf_nbytes;
 	entry->is_vectored = true;
+	entry->is_canceled = false;
 
 	STAILQ_INSERT_TAIL(&qp->sq, entry, link);
 
 	ctx->async.queue->base.outstanding += 1;
 
+	emu_signal(queue);
+
 	return 0;
 }
 
+/**
+ * Commands are processed when the queue is poked, thus, any command not yet processed can be
+ * cancelled
+ */
+static int
+emu_cancel(struct xnvme_cmd_ctx *ctx)
+{
+	struct xnvme_queue_emu *queue = (void *)ctx->async.queue;
+	struct qpair_entry *entry;
+
+	STAILQ_FOREACH(entry, &queue->qp->sq, link) {
+		if ((entry->ctx == ctx) && !entry->is_canceled) {
+			entry->is_canceled = true;
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
+
+#ifdef XNVME_BE_LINUX_ENABLED
+static int
+emu_get_completion_fd(struct xnvme_queue *q)
+{
+	struct xnvme_queue_emu *queue = (void *)q;
+	uint64_t val = q->base.outstanding;
+
+	if (queue->efd >= 0) {
+		return queue->efd;
+	}
+
+	queue->efd = eventfd(0, EFD_CLOEXEC);
+	if (queue->efd < 0) {
+		XNVME_DEBUG("FAILED: eventfd(), errno: %d", errno);
+		return -errno;
+	}
+
+	if (val && (write(queue->efd, &val, sizeof(val)) < 0)) {
+		XNVME_DEBUG("FAILED: write(efd), errno: %d", errno);
+	}
+
+	return queue->efd;
+}
+#endif
+
 #endif
 
 struct xnvme_be_async g_xnvme_be_cbi_async_emu = {
@@ -224,7 +318,12 @@ struct xnvme_be_async g_xnvme_be_cbi_async_emu = {
 	.wait = xnvme_be_nosys_queue_wait,
 	.init = emu_init,
 	.term = emu_term,
+#ifdef XNVME_BE_LINUX_ENABLED
+	.get_completion_fd = emu_get_completion_fd,
+#else
 	.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd,
+#endif
+	.cancel = emu_cancel,
 #else
 	.cmd_io = xnvme_be_nosys_queue_cmd_io,
 	.cmd_iov = xnvme_be_nosys_queue_cmd_iov,
@@ -233,5 +332,6 @@ struct xnvme_be_async g_xnvme_be_cbi_async_emu = {
 	.init = xnvme_be_nosys_queue_init,
 	.term = xnvme_be_nosys_queue_term,
 	.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd,
+	.cancel = xnvme_be_nosys_queue_cancel,
 #endif
 };
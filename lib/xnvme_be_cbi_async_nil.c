@@ -93,6 +93,7 @@ struct xnvme_be_async g_xnvme_be_cbi_async_nil = {
 	.init = nil_init,
 	.term = nil_term,
 	.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd,
+	.cancel = xnvme_be_nosys_queue_cancel,
 #else
 	.cmd_io = xnvme_be_nosys_queue_cmd_io,
 	.cmd_iov = xnvme_be_nosys_queue_cmd_iov,
@@ -101,5 +102,6 @@ struct xnvme_be_async g_xnvme_be_cbi_async_nil = {
 	.init = xnvme_be_nosys_queue_init,
 	.term = xnvme_be_nosys_queue_term,
 	.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd,
+	.cancel = xnvme_be_nosys_queue_cancel,
 #endif
 };
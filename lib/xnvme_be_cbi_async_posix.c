@@ -11,10 +11,17 @@
 #include <inttypes.h>
 #include <errno.h>
 #include <aio.h>
+#include <time.h>
+#include <unistd.h>
 #include <xnvme_queue.h>
 #include <xnvme_dev.h>
 #include <xnvme_be_cbi.h>
 
+/**
+ * Commands are staged and issued with lio_listio(), one call per batch, by the next poke or wait.
+ * Requests are kept on 'reqs_outstanding' in submission order, and a poke walks that list once,
+ * skipping requests in progress, such that a completion is not held back behind a slower request.
+ */
 struct posix_queue {
 	struct xnvme_queue_base base;
 
@@ -22,7 +29,12 @@ struct posix_queue {
 	TAILQ_HEAD(, posix_request) reqs_outstanding;
 	struct posix_request *reqs_storage;
 
-	uint8_t rsvd[188];
+	struct aiocb **staged; ///< Requests awaiting lio_listio(), also on 'reqs_outstanding'
+	uint32_t nstaged;
+	uint32_t listio_max; ///< Maximum number of requests per lio_listio()
+
+	uint8_t batching;
+	uint8_t rsvd[175];
 };
 XNVME_STATIC_ASSERT(sizeof(struct posix_queue) == XNVME_BE_QUEUE_STATE_NBYTES, "Incorrect size")
 
@@ -38,6 +50,7 @@ posix_term(struct xnvme_queue *q)
 	struct posix_queue *queue = (void *)q;
 
 	free(queue->reqs_storage);
+	free(queue->staged);
 
 	return 0;
 }
@@ -47,12 +60,19 @@ posix_init(struct xnvme_queue *q, int XNVME_UNUSED(opts))
 {
 	struct posix_queue *queue = (void *)q;
 	size_t queue_nbytes = queue->base.capacity * sizeof(struct posix_request);
+	long listio_max = sysconf(_SC_AIO_LISTIO_MAX);
 
 	queue->reqs_storage = calloc(1, queue_nbytes);
 	if (!queue->reqs_storage) {
 		XNVME_DEBUG("FAILED: calloc(reqs_ready), err: %s", strerror(errno));
 		return -errno;
 	}
+	queue->staged = calloc(queue->base.capacity, sizeof(*queue->staged));
+	if (!queue->staged) {
+		XNVME_DEBUG("FAILED: calloc(staged), err: %s", strerror(errno));
+		free(queue->reqs_storage);
+		return -ENOMEM;
+	}
 	TAILQ_INIT(&queue->reqs_ready);
 	for (uint32_t i = 0; i < queue->base.capacity; i++) {
 		TAILQ_INSERT_HEAD(&queue->reqs_ready, &queue->reqs_storage[i], link);
@@ -60,9 +80,41 @@ posix_init(struct xnvme_queue *q, int XNVME_UNUSED(opts))
 
 	TAILQ_INIT(&queue->reqs_outstanding);
 
+	// A non-positive value means that there is no limit
+	queue->listio_max = queue->base.capacity;
+	if ((listio_max > 0) && (listio_max < queue->listio_max)) {
+		queue->listio_max = listio_max;
+	}
+
+	queue->batching = 1;
+	if (getenv("XNVME_QUEUE_BATCHING_OFF")) {
+		queue->batching = 0;
+	}
+
 	return 0;
 }
 
+/**
+ * Issue the staged requests, in batches of at most 'listio_max'
+ *
+ * When lio_listio() fails, then some of the requests might not have been queued; as per POSIX,
+ * aio_error() then reports the error of each such request, thus, they are completed, with that
+ * error, like any other request by posix_poke().
+ */
+static void
+posix_flush(struct posix_queue *queue)
+{
+	for (uint32_t i = 0; i < queue->nstaged; i += queue->listio_max) {
+		int nreqs = XNVME_MIN(queue->nstaged - i, queue->listio_max);
+
+		if (lio_listio(LIO_NOWAIT, &queue->staged[i], nreqs, NULL)) {
+			XNVME_DEBUG("FAILED: lio_listio(), errno: %d", errno);
+		}
+	}
+
+	queue->nstaged = 0;
+}
+
 static int
 posix_poke(struct xnvme_queue *q, uint32_t max)
 {
@@ -77,11 +129,15 @@ posix_poke(struct xnvme_queue *q, uint32_t max)
 	if (!queue->base.outstanding) {
 		return 0;
 	}
+	if (queue->nstaged) {
+		posix_flush(queue);
+	}
 
 	req = TAILQ_FIRST(&queue->reqs_outstanding);
 	assert(req != NULL);
 
 	while (req != NULL && completed < max) {
+		struct posix_request *next = TAILQ_NEXT(req, link);
 		ssize_t res = 0;
 		int err;
 
@@ -92,7 +148,7 @@ posix_poke(struct xnvme_queue *q, uint32_t max)
 			break;
 
 		case EINPROGRESS:
-			req = TAILQ_NEXT(req, link);
+			req = next;
 			continue;
 
 		case ECANCELED: // Canceled or error, do not grab return-value
@@ -110,24 +166,68 @@ posix_poke(struct xnvme_queue *q, uint32_t max)
 			ctx->cpl.status.sct = XNVME_STATUS_CODE_TYPE_VENDOR;
 		}
 
-		ctx->async.cb(ctx, ctx->async.cb_arg);
-
-		completed += 1;
-		queue->base.outstanding -= 1;
-
-		// Prepare req for reuse
+		// Prepare req for reuse, before the callback, as it might submit again
 		memset(&req->aiocb, 0, sizeof(struct aiocb));
 		req->ctx = NULL;
 
 		TAILQ_REMOVE(&queue->reqs_outstanding, req, link);
 		TAILQ_INSERT_TAIL(&queue->reqs_ready, req, link);
 
-		req = TAILQ_FIRST(&queue->reqs_outstanding);
+		completed += 1;
+		queue->base.outstanding -= 1;
+
+		ctx->async.cb(ctx, ctx->async.cb_arg);
+
+		// Submissions by the callback are appended, thus, 'next' is still outstanding
+		req = next;
 	}
 
 	return completed;
 }
 
+/**
+ * Reap completions, sleeping in aio_suspend() on the oldest request while it is in progress
+ */
+static int
+posix_wait(struct xnvme_queue *q, uint32_t min, uint64_t timeout_ns)
+{
+	struct posix_queue *queue = (void *)q;
+	uint64_t deadline = timeout_ns ? _xnvme_timer_clock_sample() + timeout_ns : 0;
+	uint32_t acc = 0;
+
+	while (queue->base.outstanding) {
+		const struct aiocb *list[1];
+		struct timespec ts;
+		uint64_t now;
+		int ret;
+
+		ret = posix_poke(q, 0);
+		if (ret < 0) {
+			return ret;
+		}
+		acc += ret;
+		if ((acc >= min) || !queue->base.outstanding) {
+			break;
+		}
+
+		now = deadline ? _xnvme_timer_clock_sample() : 0;
+		if (deadline && (now >= deadline)) {
+			break;
+		}
+		ts.tv_sec = (deadline - now) / 1000000000ULL;
+		ts.tv_nsec = (deadline - now) % 1000000000ULL;
+
+		list[0] = &TAILQ_FIRST(&queue->reqs_outstanding)->aiocb;
+		if (aio_suspend(list, 1, deadline ? &ts : NULL) && (errno != EAGAIN) &&
+		    (errno != EINTR)) {
+			XNVME_DEBUG("FAILED: aio_suspend(), errno: %d", errno);
+			return -errno;
+		}
+	}
+
+	return acc;
+}
+
 static int
 posix_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes, void *mbuf,
 	     size_t mbuf_nbytes)
@@ -138,13 +238,18 @@ posix_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes, void *mb
 	const uint64_t ssw = queue->base.dev->geo.ssw;
 	struct posix_request *req;
 	struct aiocb *aiocb;
-	int err;
+	int err = 0;
 
 	if (mbuf || mbuf_nbytes) {
 		XNVME_DEBUG("FAILED: mbuf or mbuf_nbytes provided");
 		return -ENOSYS;
 	}
 
+	if (queue->base.outstanding == queue->base.capacity) {
+		XNVME_DEBUG("FAILED: queue is full");
+		return -EBUSY;
+	}
+
 	req = TAILQ_FIRST(&queue->reqs_ready);
 	assert(req != NULL);
 
@@ -160,22 +265,22 @@ posix_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes, void *mb
 	switch (ctx->cmd.common.opcode) {
 	case XNVME_SPEC_NVM_OPC_WRITE:
 		aiocb->aio_offset = ctx->cmd.nvm.slba << ssw;
-		err = aio_write(aiocb);
+		aiocb->aio_lio_opcode = LIO_WRITE;
 		break;
 
 	case XNVME_SPEC_NVM_OPC_READ:
 		aiocb->aio_offset = ctx->cmd.nvm.slba << ssw;
-		err = aio_read(aiocb);
+		aiocb->aio_lio_opcode = LIO_READ;
 		break;
 
 	case XNVME_SPEC_FS_OPC_WRITE:
 		aiocb->aio_offset = ctx->cmd.nvm.slba;
-		err = aio_write(aiocb);
+		aiocb->aio_lio_opcode = LIO_WRITE;
 		break;
 
 	case XNVME_SPEC_FS_OPC_READ:
 		aiocb->aio_offset = ctx->cmd.nvm.slba;
-		err = aio_read(aiocb);
+		aiocb->aio_lio_opcode = LIO_READ;
 		break;
 
 	case XNVME_SPEC_NVM_OPC_FLUSH:
@@ -185,11 +290,20 @@ posix_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes, void *mb
 
 	default:
 		XNVME_DEBUG("FAILED: unsupported opcode: %d", ctx->cmd.common.opcode);
+		req->ctx = NULL;
+		memset(aiocb, 0, sizeof(*aiocb));
 		return -ENOSYS;
 	}
 
+	if (queue->batching) {
+		queue->staged[queue->nstaged++] = aiocb;
+	} else {
+		err = (aiocb->aio_lio_opcode == LIO_WRITE) ? aio_write(aiocb) : aio_read(aiocb);
+	}
 	if (err) {
 		XNVME_DEBUG("FAILED: {aio_write(),aio_read()}: err: %d", errno)
+		req->ctx = NULL;
+		memset(aiocb, 0, sizeof(*aiocb));
 		return -errno;
 	}
 
@@ -198,7 +312,46 @@ posix_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes, void *mb
 
 	queue->base.outstanding += 1;
 
-	return err;
+	return 0;
+}
+
+/**
+ * Cancel the request with aio_cancel(); a cancelled request is completed, with ECANCELED, by
+ * posix_poke(), in submission order
+ */
+static int
+posix_cancel(struct xnvme_cmd_ctx *ctx)
+{
+	struct posix_queue *queue = (void *)ctx->async.queue;
+	struct posix_request *req;
+
+	// A staged request is not yet known to aio_cancel()
+	if (queue->nstaged) {
+		posix_flush(queue);
+	}
+
+	TAILQ_FOREACH(req, &queue->reqs_outstanding, link) {
+		if (req->ctx == ctx) {
+			break;
+		}
+	}
+	if (!req) {
+		XNVME_DEBUG("FAILED: no outstanding request for the command");
+		return -ENOENT;
+	}
+
+	switch (aio_cancel(req->aiocb.aio_fildes, &req->aiocb)) {
+	case AIO_CANCELED:
+		return 0;
+
+	case AIO_NOTCANCELED:
+	case AIO_ALLDONE:
+		return -EALREADY;
+
+	default:
+		XNVME_DEBUG("FAILED: aio_cancel(), errno: %d", errno);
+		return -errno;
+	}
 }
 #endif
 
@@ -208,10 +361,11 @@ struct xnvme_be_async g_xnvme_be_cbi_async_posix = {
 	.cmd_io = posix_cmd_io,
 	.cmd_iov = xnvme_be_nosys_queue_cmd_iov,
 	.poke = posix_poke,
-	.wait = xnvme_be_nosys_queue_wait,
+	.wait = posix_wait,
 	.init = posix_init,
 	.term = posix_term,
 	.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd,
+	.cancel = posix_cancel,
 #else
 	.cmd_io = xnvme_be_nosys_queue_cmd_io,
 	.cmd_iov = xnvme_be_nosys_queue_cmd_iov,
@@ -220,5 +374,6 @@ struct xnvme_be_async g_xnvme_be_cbi_async_posix = {
 	.init = xnvme_be_nosys_queue_init,
 	.term = xnvme_be_nosys_queue_term,
 	.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd,
+	.cancel = xnvme_be_nosys_queue_cancel,
 #endif
 };
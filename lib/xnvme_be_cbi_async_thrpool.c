@@ -7,13 +7,35 @@
 #ifdef XNVME_BE_CBI_ASYNC_THRPOOL_ENABLED
 #include <errno.h>
 #include <pthread.h>
+#include <time.h>
+#include <unistd.h>
 #include <xnvme_queue.h>
 #include <xnvme_dev.h>
+#include <xnvme_numa.h>
+#ifdef XNVME_BE_LINUX_ENABLED
+#include <linux/futex.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#endif
 
 // Environment variable used to configure the number of threads in thrpool
 static const char *g_nthreads_env = "XNVME_BE_CBI_ASYNC_THRPOOL_NTHREADS";
 static const int g_nthreads_def = 4;
 
+// Number of times an idle worker re-checks its submission-ring before parking, unless the
+// system has a single online CPU, where spinning only delays the thread that would submit
+static const int g_nspins_def = 2048;
+
+// Number of completions popped off the completion-ring before invoking their callbacks, bounds
+// the stack-usage of poke() independently of the queue-capacity
+#define XNVME_QUEUE_THRPOOL_CQE_BATCH_MAX 64
+
+enum _thrpool_entry_state {
+	_THRPOOL_ENTRY_QUEUED = 0x1,   ///< On a submission-ring, set by the queue-owner
+	_THRPOOL_ENTRY_RUNNING = 0x2,  ///< Taken by a worker, no longer cancellable
+	_THRPOOL_ENTRY_CANCELED = 0x3, ///< Completed with ECANCELED, instead of run, by the worker
+};
+
 struct _thrpool_entry {
 	struct xnvme_dev *dev;
 	struct xnvme_cmd_ctx *ctx;
@@ -24,21 +46,72 @@ struct _thrpool_entry {
 	uint32_t data_vec_cnt;
 	uint32_t meta_nbytes;
 	uint32_t is_vectored;
+	uint32_t state; ///< See enum _thrpool_entry_state, moved on by compare-and-swap
 
 	STAILQ_ENTRY(_thrpool_entry) link;
 };
 
-struct _thrpool_qp {
-	STAILQ_HEAD(, _thrpool_entry) rp; ///< Request pool
+/**
+ * A thread parks by setting 'parked' and re-checking its ring before going to sleep, the other
+ * side publishes to the ring before checking 'parked', thus, a wakeup cannot be missed. On Linux
+ * the sleep is a futex-wait on 'parked', elsewhere a condition-variable is used.
+ */
+struct _thrpool_park {
+	uint32_t parked;
+#ifndef XNVME_BE_LINUX_ENABLED
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+#endif
+};
+
+/**
+ * Single-producer / multi-consumer submission-ring, the queue-owner is the producer and the
+ * worker is the consumer, along with idle workers stealing from it; a consumer claims an entry by
+ * a compare-and-swap of 'head'. The ring is sized to hold every entry of the queue, thus never
+ * full.
+ */
+struct _thrpool_worker {
+	struct xnvme_queue_thrpool *queue;
+	pthread_t thread;
+	struct _thrpool_entry **slots;
 
-	pthread_mutex_t sq_mutex;
-	STAILQ_HEAD(, _thrpool_entry) sq; ///< Submission queue
-	pthread_cond_t sq_cond;
+	uint8_t _pad0[40];
 
-	pthread_mutex_t cq_mutex;
-	STAILQ_HEAD(, _thrpool_entry) cq; ///< Completion queue
+	uint32_t tail; ///< Written by the queue-owner
+
+	uint8_t _pad1[60];
+
+	uint32_t head; ///< Claimed by the worker and by stealing workers
+	uint32_t busy; ///< Whether the worker is running an entry, written by the worker
+	struct _thrpool_park park;
+};
+
+/**
+ * Multi-producer / single-consumer completion-ring, the workers claim a slot by incrementing
+ * 'cq_tail' and publish the entry by storing it in the slot; the queue-owner consumes from
+ * 'cq_head' and clears the slot. Since the ring holds every entry of the queue, a claimed slot
+ * has always been cleared by the consumer.
+ */
+struct _thrpool_qp {
+	STAILQ_HEAD(, _thrpool_entry) rp; ///< Request pool, only touched by the queue-owner
 
 	uint32_t capacity;
+	uint32_t mask;     ///< Ring-size minus one, the ring-size is a power of two >= capacity
+	uint32_t next;     ///< Worker to consider first when dispatching the next submission
+	uint32_t nworkers; ///< Number of workers with an initialized submission-ring
+
+	struct _thrpool_worker *workers;
+	struct _thrpool_entry **cq; ///< Completion-ring
+
+	uint8_t _pad0[24];
+
+	uint32_t cq_tail; ///< Claimed by the workers
+
+	uint8_t _pad1[60];
+
+	uint32_t cq_head;              ///< Consumed by the queue-owner
+	struct _thrpool_park cq_park; ///< Where the queue-owner sleeps in wait()
+
 	struct _thrpool_entry elm[];
 };
 
@@ -49,19 +122,262 @@ struct xnvme_queue_thrpool {
 
 	bool threads_stop;
 	int nthreads;
-	pthread_t *threads;
+	int nspins;
+
+	int efd; ///< Completion eventfd, signaled by the workers, created on demand
 
 	uint8_t _rsvd[204];
 };
 XNVME_STATIC_ASSERT(sizeof(struct xnvme_queue_thrpool) == XNVME_BE_QUEUE_STATE_NBYTES,
 		    "Incorrect size")
 
+static inline void
+_thrpool_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	__asm__ volatile("yield");
+#endif
+}
+
+static int
+_thrpool_park_init(struct _thrpool_park *park)
+{
+	int err = 0;
+
+	park->parked = 0;
+
+#ifndef XNVME_BE_LINUX_ENABLED
+	err = pthread_mutex_init(&park->mutex, NULL);
+	if (err) {
+		XNVME_DEBUG("FAILED: pthread_mutex_init(), err: %d", err);
+		return -err;
+	}
+	err = pthread_cond_init(&park->cond, NULL);
+	if (err) {
+		XNVME_DEBUG("FAILED: pthread_cond_init(), err: %d", err);
+		pthread_mutex_destroy(&park->mutex);
+		return -err;
+	}
+#endif
+
+	return err;
+}
+
+#ifdef XNVME_BE_LINUX_ENABLED
+static void
+_thrpool_park_term(struct _thrpool_park *XNVME_UNUSED(park))
+{
+}
+#else
+static void
+_thrpool_park_term(struct _thrpool_park *park)
+{
+	pthread_cond_destroy(&park->cond);
+	pthread_mutex_destroy(&park->mutex);
+}
+#endif
+
+static inline void
+_thrpool_park_prepare(struct _thrpool_park *park)
+{
+	__atomic_store_n(&park->parked, 1, __ATOMIC_SEQ_CST);
+}
+
+static inline void
+_thrpool_park_cancel(struct _thrpool_park *park)
+{
+	__atomic_store_n(&park->parked, 0, __ATOMIC_RELAXED);
+}
+
+/**
+ * Sleep until woken, or until 'timeout_ns' has elapsed, when given; spurious wakeups are possible
+ */
+static void
+_thrpool_park_sleep(struct _thrpool_park *park, uint64_t timeout_ns)
+{
+#ifdef XNVME_BE_LINUX_ENABLED
+	struct timespec ts = {
+		.tv_sec = timeout_ns / 1000000000ULL,
+		.tv_nsec = timeout_ns % 1000000000ULL,
+	};
+
+	syscall(SYS_futex, &park->parked, FUTEX_WAIT_PRIVATE, 1, timeout_ns ? &ts : NULL, NULL, 0);
+#else
+	struct timespec deadline;
+	int err = 0;
+
+	if (timeout_ns) {
+		clock_gettime(CLOCK_REALTIME, &deadline);
+		deadline.tv_sec += timeout_ns / 1000000000ULL;
+		deadline.tv_nsec += timeout_ns % 1000000000ULL;
+		if (deadline.tv_nsec >= 1000000000L) {
+			deadline.tv_sec += 1;
+			deadline.tv_nsec -= 1000000000L;
+		}
+	}
+
+	pthread_mutex_lock(&park->mutex);
+	while (__atomic_load_n(&park->parked, __ATOMIC_ACQUIRE) && !err) {
+		err = timeout_ns ? pthread_cond_timedwait(&park->cond, &park->mutex, &deadline)
+				 : pthread_cond_wait(&park->cond, &park->mutex);
+	}
+	pthread_mutex_unlock(&park->mutex);
+#endif
+
+	__atomic_store_n(&park->parked, 0, __ATOMIC_RELAXED);
+}
+
+/**
+ * Wake the thread parked on 'park', if any; must be called after publishing to the ring
+ */
+static inline void
+_thrpool_park_wake(struct _thrpool_park *park)
+{
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (!__atomic_load_n(&park->parked, __ATOMIC_RELAXED)) {
+		return;
+	}
+
+#ifdef XNVME_BE_LINUX_ENABLED
+	if (__atomic_exchange_n(&park->parked, 0, __ATOMIC_SEQ_CST)) {
+		syscall(SYS_futex, &park->parked, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+	}
+#else
+	pthread_mutex_lock(&park->mutex);
+	__atomic_store_n(&park->parked, 0, __ATOMIC_RELEASE);
+	pthread_cond_signal(&park->cond);
+	pthread_mutex_unlock(&park->mutex);
+#endif
+}
+
+/**
+ * The number of entries queued on, and being run by, the given worker; a snapshot, as the worker
+ * and stealing workers move on concurrently
+ */
+static inline uint32_t
+_thrpool_worker_load(struct _thrpool_worker *worker)
+{
+	return worker->tail - __atomic_load_n(&worker->head, __ATOMIC_RELAXED) +
+	       __atomic_load_n(&worker->busy, __ATOMIC_RELAXED);
+}
+
+/**
+ * Dispatch the entry to the least-loaded worker, such that a worker running a long command is not
+ * handed more while others are idle; ties go round-robin, starting with the worker following the
+ * previous pick
+ */
+static inline void
+_thrpool_sq_push(struct _thrpool_qp *qp, struct _thrpool_entry *entry)
+{
+	struct _thrpool_worker *worker = NULL;
+	uint32_t load = UINT32_MAX;
+
+	for (uint32_t i = 0; (i < qp->nworkers) && load; ++i) {
+		struct _thrpool_worker *candidate = &qp->workers[(qp->next + i) % qp->nworkers];
+		uint32_t candidate_load = _thrpool_worker_load(candidate);
+
+		if (candidate_load < load) {
+			worker = candidate;
+			load = candidate_load;
+		}
+	}
+	qp->next = (uint32_t)(worker - qp->workers + 1) % qp->nworkers;
+
+	__atomic_store_n(&worker->slots[worker->tail & qp->mask], entry, __ATOMIC_RELAXED);
+	__atomic_store_n(&worker->tail, worker->tail + 1, __ATOMIC_RELEASE);
+
+	_thrpool_park_wake(&worker->park);
+}
+
+/**
+ * Claim the oldest entry on the submission-ring of the given worker, called by the worker itself
+ * as well as by workers stealing from it
+ */
+static inline struct _thrpool_entry *
+_thrpool_sq_pop(struct _thrpool_qp *qp, struct _thrpool_worker *worker)
+{
+	uint32_t head = __atomic_load_n(&worker->head, __ATOMIC_RELAXED);
+	struct _thrpool_entry *entry;
+
+	do {
+		if (head == __atomic_load_n(&worker->tail, __ATOMIC_ACQUIRE)) {
+			return NULL;
+		}
+		entry = __atomic_load_n(&worker->slots[head & qp->mask], __ATOMIC_RELAXED);
+	} while (!__atomic_compare_exchange_n(&worker->head, &head, head + 1, true,
+					      __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+	return entry;
+}
+
+/**
+ * Claim an entry from the submission-ring of another worker, such that entries queued behind a
+ * long-running command are run by an idle worker
+ */
+static inline struct _thrpool_entry *
+_thrpool_sq_steal(struct _thrpool_qp *qp, struct _thrpool_worker *worker)
+{
+	uint32_t self = (uint32_t)(worker - qp->workers);
+
+	for (uint32_t i = 1; i < qp->nworkers; ++i) {
+		struct _thrpool_entry *entry;
+
+		entry = _thrpool_sq_pop(qp, &qp->workers[(self + i) % qp->nworkers]);
+		if (entry) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+static inline void
+_thrpool_cq_push(struct _thrpool_qp *qp, struct _thrpool_entry *entry)
+{
+	uint32_t pos = __atomic_fetch_add(&qp->cq_tail, 1, __ATOMIC_RELAXED);
+
+	__atomic_store_n(&qp->cq[pos & qp->mask], entry, __ATOMIC_RELEASE);
+
+	_thrpool_park_wake(&qp->cq_park);
+}
+
+static inline struct _thrpool_entry *
+_thrpool_cq_peek(struct _thrpool_qp *qp)
+{
+	return __atomic_load_n(&qp->cq[qp->cq_head & qp->mask], __ATOMIC_ACQUIRE);
+}
+
+static inline struct _thrpool_entry *
+_thrpool_cq_pop(struct _thrpool_qp *qp)
+{
+	struct _thrpool_entry *entry = _thrpool_cq_peek(qp);
+
+	if (entry) {
+		qp->cq[qp->cq_head & qp->mask] = NULL;
+		qp->cq_head += 1;
+	}
+
+	return entry;
+}
+
 static int
 _thrpool_qp_term(struct _thrpool_qp *qp)
 {
-	// NOTE: assumes that no thread holds any of the locks
-	pthread_mutex_destroy(&qp->sq_mutex);
-	pthread_mutex_destroy(&qp->cq_mutex);
+	if (!qp) {
+		return 0;
+	}
+
+	// NOTE: assumes that all the workers have been joined
+	for (uint32_t i = 0; i < qp->nworkers; ++i) {
+		_thrpool_park_term(&qp->workers[i].park);
+		free(qp->workers[i].slots);
+	}
+	free(qp->workers);
+
+	_thrpool_park_term(&qp->cq_park);
+	free(qp->cq);
 
 	free(qp);
 
@@ -69,79 +385,160 @@ _thrpool_qp_term(struct _thrpool_qp *qp)
 }
 
 static int
-_thrpool_qp_alloc(struct _thrpool_qp **qp, uint32_t capacity)
+_thrpool_qp_alloc(struct _thrpool_qp **qp, uint32_t capacity, int nworkers)
 {
 	const size_t nbytes = sizeof(**qp) + capacity * sizeof(*(*qp)->elm);
+	uint32_t nslots = 1;
 	int err;
 
+	while (nslots < capacity) {
+		nslots <<= 1;
+	}
+
 	(*qp) = malloc(nbytes);
 	if (!(*qp)) {
 		return -errno;
 	}
 	memset((*qp), 0, nbytes);
 
-	STAILQ_INIT(&(*qp)->sq);
-	STAILQ_INIT(&(*qp)->cq);
 	STAILQ_INIT(&(*qp)->rp);
 
-	err = pthread_cond_init(&(*qp)->sq_cond, NULL);
+	(*qp)->capacity = capacity;
+	(*qp)->mask = nslots - 1;
+
+	err = _thrpool_park_init(&(*qp)->cq_park);
 	if (err) {
-		XNVME_DEBUG("FAILED: pthread_cond_init(sq_cond), err: %d", err);
-		return -err;
+		XNVME_DEBUG("FAILED: _thrpool_park_init(cq_park), err: %d", err);
+		free(*qp);
+		*qp = NULL;
+		return err;
 	}
 
-	err = pthread_mutex_init(&(*qp)->sq_mutex, NULL);
-	if (err) {
-		XNVME_DEBUG("FAILED: pthread_mutex_init(sq_mutex), err: %d", err);
-		return -err;
+	// From here on, _thrpool_qp_term() unwinds whatever is allocated, and the workers counted
+	(*qp)->cq = calloc(nslots, sizeof(*(*qp)->cq));
+	if (!(*qp)->cq) {
+		XNVME_DEBUG("FAILED: calloc(cq)");
+		err = -ENOMEM;
+		goto failed;
 	}
-	err = pthread_mutex_init(&(*qp)->cq_mutex, NULL);
-	if (err) {
-		XNVME_DEBUG("FAILED: pthread_mutex_init(cq_mutex), err: %d", err);
-		return -err;
+
+	(*qp)->workers = calloc(nworkers, sizeof(*(*qp)->workers));
+	if (!(*qp)->workers) {
+		XNVME_DEBUG("FAILED: calloc(workers)");
+		err = -ENOMEM;
+		goto failed;
 	}
+	for (int i = 0; i < nworkers; ++i) {
+		struct _thrpool_worker *worker = &(*qp)->workers[i];
 
-	(*qp)->capacity = capacity;
+		worker->slots = calloc(nslots, sizeof(*worker->slots));
+		if (!worker->slots) {
+			XNVME_DEBUG("FAILED: calloc(slots)");
+			err = -ENOMEM;
+			goto failed;
+		}
+
+		err = _thrpool_park_init(&worker->park);
+		if (err) {
+			XNVME_DEBUG("FAILED: _thrpool_park_init(), err: %d", err);
+			free(worker->slots);
+			goto failed;
+		}
+
+		(*qp)->nworkers += 1;
+	}
 
 	for (uint32_t i = 0; i < (*qp)->capacity; ++i) {
 		STAILQ_INSERT_HEAD(&(*qp)->rp, &(*qp)->elm[i], link);
 	}
 
 	return 0;
+
+failed:
+	_thrpool_qp_term(*qp);
+	*qp = NULL;
+
+	return err;
+}
+
+/**
+ * Claim the given entry for running; fails when the queue-owner cancelled it, see
+ * cbi_async_thrpool_cancel()
+ */
+static inline bool
+_thrpool_entry_take(struct _thrpool_entry *entry)
+{
+	uint32_t expected = _THRPOOL_ENTRY_QUEUED;
+
+	return __atomic_compare_exchange_n(&entry->state, &expected, _THRPOOL_ENTRY_RUNNING,
+					   false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Signal the completion eventfd, when created, see cbi_async_thrpool_get_completion_fd()
+ */
+static inline void
+_thrpool_signal(struct xnvme_queue_thrpool *queue)
+{
+#ifdef XNVME_BE_LINUX_ENABLED
+	int efd = __atomic_load_n(&queue->efd, __ATOMIC_ACQUIRE);
+	uint64_t val = 1;
+
+	if ((efd >= 0) && (write(efd, &val, sizeof(val)) < 0)) {
+		XNVME_DEBUG("FAILED: write(efd), errno: %d", errno);
+	}
+#else
+	(void)queue;
+#endif
 }
 
 static int
 _thrpool_thread_loop(void *arg)
 {
-	struct xnvme_queue_thrpool *queue = arg;
+	struct _thrpool_worker *worker = arg;
+	struct xnvme_queue_thrpool *queue = worker->queue;
 	struct _thrpool_qp *qp = queue->qp;
+	int nspins = 0;
 
 	while (true) {
 		struct _thrpool_entry *entry;
 		int err;
 
-		err = pthread_mutex_lock(&qp->sq_mutex);
-		if (err) {
-			XNVME_DEBUG("FAILED: pthread_mutex_lock(), err: %d", err);
-			return -err;
-		}
-
-		entry = STAILQ_FIRST(&qp->sq);
-		while (!entry && !queue->threads_stop) {
-			pthread_cond_wait(&qp->sq_cond, &qp->sq_mutex);
-			entry = STAILQ_FIRST(&qp->sq);
+		entry = _thrpool_sq_pop(qp, worker);
+		if (!entry) {
+			entry = _thrpool_sq_steal(qp, worker);
 		}
+		if (!entry) {
+			if (__atomic_load_n(&queue->threads_stop, __ATOMIC_ACQUIRE)) {
+				return 0;
+			}
+			if (nspins++ < queue->nspins) {
+				_thrpool_relax();
+				continue;
+			}
 
-		if (queue->threads_stop) {
-			if (pthread_mutex_unlock(&qp->sq_mutex)) {
-				XNVME_DEBUG("FAILED: pthread_mutex_unlock()");
+			_thrpool_park_prepare(&worker->park);
+			if ((__atomic_load_n(&worker->head, __ATOMIC_SEQ_CST) !=
+			     __atomic_load_n(&worker->tail, __ATOMIC_SEQ_CST)) ||
+			    __atomic_load_n(&queue->threads_stop, __ATOMIC_SEQ_CST)) {
+				_thrpool_park_cancel(&worker->park);
+				continue;
 			}
-			return 0;
+			_thrpool_park_sleep(&worker->park, 0);
+			nspins = 0;
+			continue;
 		}
+		nspins = 0;
 
-		STAILQ_REMOVE_HEAD(&qp->sq, link);
-		if (pthread_mutex_unlock(&qp->sq_mutex)) {
-			XNVME_DEBUG("FAILED: pthread_mutex_unlock()");
+		__atomic_store_n(&worker->busy, 1, __ATOMIC_RELAXED);
+
+		if (!_thrpool_entry_take(entry)) {
+			entry->ctx->cpl.status.sc = ECANCELED;
+			entry->ctx->cpl.status.sct = XNVME_STATUS_CODE_TYPE_VENDOR;
+			_thrpool_cq_push(qp, entry);
+			_thrpool_signal(queue);
+			__atomic_store_n(&worker->busy, 0, __ATOMIC_RELAXED);
+			continue;
 		}
 
 		err = entry->is_vectored
@@ -158,17 +555,9 @@ _thrpool_thread_loop(void *arg)
 			XNVME_DEBUG("FAILED: sync.cmd_io{v}(), err: %d", err);
 		}
 
-		err = pthread_mutex_lock(&qp->cq_mutex);
-		if (err) {
-			XNVME_DEBUG("FAILED: pthread_mutex_lock(), err: %d", err);
-			return -err;
-		}
-
-		STAILQ_INSERT_TAIL(&qp->cq, entry, link);
-
-		if (pthread_mutex_unlock(&qp->cq_mutex)) {
-			XNVME_DEBUG("FAILED: pthread_mutex_unlock()");
-		}
+		_thrpool_cq_push(qp, entry);
+		_thrpool_signal(queue);
+		__atomic_store_n(&worker->busy, 0, __ATOMIC_RELAXED);
 	}
 
 	return 0;
@@ -179,41 +568,30 @@ cbi_async_thrpool_term(struct xnvme_queue *q)
 {
 	struct xnvme_queue_thrpool *queue = (void *)q;
 	struct _thrpool_qp *qp = queue->qp;
-	int err, err_lock;
-
-	err_lock = pthread_mutex_lock(&qp->sq_mutex);
-	if (err_lock) {
-		XNVME_DEBUG("FAILED: pthread_mutex_lock(), err_lock: %d", err_lock);
-		return -err_lock;
-	}
-
-	queue->threads_stop = true;
-
-	err = pthread_cond_broadcast(&qp->sq_cond);
-	if (err) {
-		XNVME_DEBUG("FAILED: pthread_cond_broadcast(), err: %d", err);
+	int err;
 
-		err_lock = pthread_mutex_unlock(&qp->sq_mutex);
-		if (err_lock) {
-			XNVME_DEBUG("FAILED: pthread_mutex_unlock(), err_lock: %d", err_lock);
-		}
+	__atomic_store_n(&queue->threads_stop, true, __ATOMIC_SEQ_CST);
 
-		return -err;
+	for (int i = 0; i < queue->nthreads; i++) {
+		_thrpool_park_wake(&qp->workers[i].park);
 	}
-	err_lock = pthread_mutex_unlock(&qp->sq_mutex);
-	if (err_lock) {
-		XNVME_DEBUG("FAILED: pthread_mutex_unlock(), err_lock: %d", err_lock);
+	for (int i = 0; i < queue->nthreads; i++) {
+		pthread_join(qp->workers[i].thread, NULL);
 	}
+	queue->nthreads = 0;
 
-	for (int i = 0; queue->threads && i < queue->nthreads; i++) {
-		pthread_join(queue->threads[i], NULL);
+#ifdef XNVME_BE_LINUX_ENABLED
+	if (queue->efd >= 0) {
+		close(queue->efd);
+		queue->efd = -1;
 	}
-	free(queue->threads);
+#endif
 
 	err = _thrpool_qp_term(queue->qp);
 	if (err) {
 		XNVME_DEBUG("FAILED: _thrpool_qp_term(queue->qp), err: %d", err);
 	}
+	queue->qp = NULL;
 
 	return err;
 }
@@ -226,33 +604,38 @@ cbi_async_thrpool_init(struct xnvme_queue *q, int XNVME_UNUSED(opts))
 	int nthreads;
 	int err;
 
-	err = _thrpool_qp_alloc(&queue->qp, queue->base.capacity);
-	if (err) {
-		XNVME_DEBUG("FAILED: _thrpool_qp_alloc(); err: %d", err);
-		goto failed;
-	}
+	queue->efd = -1;
+	queue->nthreads = 0;
+	queue->qp = NULL;
 
 	nthreads = (env = getenv(g_nthreads_env)) ? atoi(env) : g_nthreads_def;
 	if (nthreads <= 0 || nthreads >= 1024) {
 		XNVME_DEBUG("FAILED: invalid nthreads: %d", nthreads);
-		err = EINVAL;
-		goto failed;
+		return -EINVAL;
 	}
 	XNVME_DEBUG("INFO: nthreads: %d", nthreads);
 
-	queue->threads = calloc(nthreads, sizeof(pthread_t));
-	if (!queue->threads) {
-		XNVME_DEBUG("FAILED: calloc(nthreads)");
-		err = -errno;
+	queue->nspins = g_nspins_def;
+#ifdef _SC_NPROCESSORS_ONLN
+	if (sysconf(_SC_NPROCESSORS_ONLN) <= 1) {
+		queue->nspins = 0;
+	}
+#endif
+
+	err = _thrpool_qp_alloc(&queue->qp, queue->base.capacity, nthreads);
+	if (err) {
+		XNVME_DEBUG("FAILED: _thrpool_qp_alloc(); err: %d", err);
 		goto failed;
 	}
 
 	queue->threads_stop = false;
 	for (int i = 0; i < nthreads; i++) {
+		struct _thrpool_worker *worker = &queue->qp->workers[i];
+
 		XNVME_DEBUG("Starting thread %d", i);
 
-		err = pthread_create(&queue->threads[i], NULL, (void *)_thrpool_thread_loop,
-				     queue);
+		worker->queue = queue;
+		err = pthread_create(&worker->thread, NULL, (void *)_thrpool_thread_loop, worker);
 		if (err) {
 			XNVME_DEBUG("pthread_create() %d", err);
 			err = -err;
@@ -260,6 +643,10 @@ cbi_async_thrpool_init(struct xnvme_queue *q, int XNVME_UNUSED(opts))
 		}
 
 		++(queue->nthreads);
+
+		if (queue->base.dev->numa_node >= 0) {
+			xnvme_numa_bind_thread(worker->thread, queue->base.dev->numa_node);
+		}
 	}
 
 	return 0;
@@ -275,45 +662,84 @@ cbi_async_thrpool_poke(struct xnvme_queue *q, uint32_t max)
 	struct xnvme_queue_thrpool *queue = (void *)q;
 	struct _thrpool_qp *qp = queue->qp;
 	unsigned completed = 0;
-	int err;
 
 	max = max ? max : queue->base.outstanding;
 	max = max > queue->base.outstanding ? queue->base.outstanding : max;
 
-	struct _thrpool_entry *entries[max];
+	while (completed < max) {
+		struct _thrpool_entry *entries[XNVME_QUEUE_THRPOOL_CQE_BATCH_MAX];
+		unsigned nreap = XNVME_MIN(max - completed, XNVME_QUEUE_THRPOOL_CQE_BATCH_MAX);
+		unsigned npopped = 0;
 
-	err = pthread_mutex_lock(&qp->cq_mutex);
-	if (err) {
-		XNVME_DEBUG("FAILED: pthread_mutex_lock(), err: %d", err);
-		return -err;
+		while (npopped < nreap) {
+			struct _thrpool_entry *entry;
+
+			entry = _thrpool_cq_pop(qp);
+			if (entry == NULL) {
+				break;
+			}
+			entries[npopped] = entry;
+			npopped++;
+		}
+
+		for (unsigned i = 0; i < npopped; i++) {
+			struct _thrpool_entry *entry = entries[i];
+			entry->ctx->async.cb(entry->ctx, entry->ctx->async.cb_arg);
+			STAILQ_INSERT_TAIL(&qp->rp, entry, link);
+		}
+
+		queue->base.outstanding -= npopped;
+		completed += npopped;
+
+		if (npopped < nreap) {
+			break;
+		}
 	}
 
-	while (completed < max) {
-		struct _thrpool_entry *entry;
+	return completed;
+}
+
+static int
+cbi_async_thrpool_wait(struct xnvme_queue *q, uint32_t min, uint64_t timeout_ns)
+{
+	struct xnvme_queue_thrpool *queue = (void *)q;
+	struct _thrpool_qp *qp = queue->qp;
+	uint64_t deadline = timeout_ns ? _xnvme_timer_clock_sample() + timeout_ns : 0;
+	int acc = 0;
+
+	while (true) {
+		uint64_t remaining = 0;
+		int err;
 
-		entry = STAILQ_FIRST(&qp->cq);
-		if (entry == NULL) {
+		err = cbi_async_thrpool_poke(q, min - acc);
+		if (err < 0) {
+			XNVME_DEBUG("FAILED: cbi_async_thrpool_poke(), err: %d", err);
+			return err;
+		}
+		acc += err;
+
+		if ((uint32_t)acc >= min) {
 			break;
 		}
-		STAILQ_REMOVE_HEAD(&qp->cq, link);
-		entries[completed] = entry;
-		completed++;
-	};
 
-	err = pthread_mutex_unlock(&qp->cq_mutex);
-	if (err) {
-		XNVME_DEBUG("FAILED: pthread_mutex_unlock(), err: %d", err);
-	}
+		if (deadline) {
+			uint64_t now = _xnvme_timer_clock_sample();
 
-	for (unsigned i = 0; i < completed; i++) {
-		struct _thrpool_entry *entry = entries[i];
-		entry->ctx->async.cb(entry->ctx, entry->ctx->async.cb_arg);
-		STAILQ_INSERT_TAIL(&qp->rp, entry, link);
-	}
+			if (now >= deadline) {
+				break;
+			}
+			remaining = deadline - now;
+		}
 
-	queue->base.outstanding -= completed;
+		_thrpool_park_prepare(&qp->cq_park);
+		if (_thrpool_cq_peek(qp)) {
+			_thrpool_park_cancel(&qp->cq_park);
+			continue;
+		}
+		_thrpool_park_sleep(&qp->cq_park, remaining);
+	}
 
-	return completed;
+	return acc;
 }
 
 static inline int
@@ -323,7 +749,6 @@ cbi_async_thrpool_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbyt
 	struct xnvme_queue_thrpool *queue = (void *)ctx->async.queue;
 	struct _thrpool_qp *qp = queue->qp;
 	struct _thrpool_entry *entry = NULL;
-	int err;
 
 	entry = STAILQ_FIRST(&qp->rp);
 	if (!entry) {
@@ -340,26 +765,10 @@ cbi_async_thrpool_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbyt
 	entry->meta = mbuf;
 	entry->meta_nbytes = mbuf_nbytes;
 	entry->is_vectored = false;
+	entry->state = _THRPOOL_ENTRY_QUEUED;
 
-	err = pthread_mutex_lock(&qp->sq_mutex);
-	if (err) {
-		STAILQ_INSERT_TAIL(&qp->rp, entry, link);
-		XNVME_DEBUG("FAILED: pthread_mutex_lock(), err: %d", err);
-		return -err;
-	}
-
-	STAILQ_INSERT_TAIL(&qp->sq, entry, link);
 	ctx->async.queue->base.outstanding += 1;
-
-	err = pthread_mutex_unlock(&qp->sq_mutex);
-	if (err) {
-		XNVME_DEBUG("FAILED: pthread_mutex_unlock(), err: %d", err);
-	}
-	err = pthread_cond_signal(&qp->sq_cond);
-	if (err) {
-		XNVME_DEBUG("FAILED: pthread_cond_signal(), err: %d", err);
-		return -err;
-	}
+	_thrpool_sq_push(qp, entry);
 
 	return 0;
 }
@@ -371,7 +780,6 @@ cbi_async_thrpool_cmd_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, size_t
 	struct xnvme_queue_thrpool *queue = (void *)ctx->async.queue;
 	struct _thrpool_qp *qp = queue->qp;
 	struct _thrpool_entry *entry = NULL;
-	int err;
 
 	entry = STAILQ_FIRST(&qp->rp);
 	if (!entry) {
@@ -388,29 +796,68 @@ cbi_async_thrpool_cmd_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, size_t
 	entry->meta = mbuf;
 	entry->meta_nbytes = mbuf_nbytes;
 	entry->is_vectored = true;
+	entry->state = _THRPOOL_ENTRY_QUEUED;
 
-	err = pthread_mutex_lock(&qp->sq_mutex);
-	if (err) {
-		STAILQ_INSERT_TAIL(&qp->rp, entry, link);
-		XNVME_DEBUG("FAILED: pthread_mutex_lock(), err: %d", err);
-		return -err;
+	ctx->async.queue->base.outstanding += 1;
+	_thrpool_sq_push(qp, entry);
+
+	return 0;
+}
+
+/**
+ * A command can be cancelled until a worker takes it off its submission-ring; the worker then
+ * completes it with ECANCELED instead of running it
+ */
+static int
+cbi_async_thrpool_cancel(struct xnvme_cmd_ctx *ctx)
+{
+	struct xnvme_queue_thrpool *queue = (void *)ctx->async.queue;
+	struct _thrpool_qp *qp = queue->qp;
+
+	for (uint32_t i = 0; i < qp->capacity; ++i) {
+		struct _thrpool_entry *entry = &qp->elm[i];
+		uint32_t expected = _THRPOOL_ENTRY_QUEUED;
+
+		if (entry->ctx != ctx) {
+			continue;
+		}
+		if (__atomic_compare_exchange_n(&entry->state, &expected, _THRPOOL_ENTRY_CANCELED,
+						false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+			return 0;
+		}
 	}
 
-	STAILQ_INSERT_TAIL(&qp->sq, entry, link);
-	ctx->async.queue->base.outstanding += 1;
+	return -EALREADY;
+}
 
-	err = pthread_mutex_unlock(&qp->sq_mutex);
-	if (err) {
-		XNVME_DEBUG("FAILED: pthread_mutex_unlock(), err: %d", err);
+#ifdef XNVME_BE_LINUX_ENABLED
+static int
+cbi_async_thrpool_get_completion_fd(struct xnvme_queue *q)
+{
+	struct xnvme_queue_thrpool *queue = (void *)q;
+	uint64_t val = 1;
+	int efd;
+
+	if (queue->efd >= 0) {
+		return queue->efd;
 	}
-	err = pthread_cond_signal(&qp->sq_cond);
-	if (err) {
-		XNVME_DEBUG("FAILED: pthread_cond_signal(), err: %d", err);
-		return -err;
+
+	efd = eventfd(0, EFD_CLOEXEC);
+	if (efd < 0) {
+		XNVME_DEBUG("FAILED: eventfd(), errno: %d", errno);
+		return -errno;
 	}
 
-	return 0;
+	__atomic_store_n(&queue->efd, efd, __ATOMIC_SEQ_CST);
+
+	// Completions queued by the workers prior to the eventfd are not signaled, thus done here
+	if (_thrpool_cq_peek(queue->qp) && (write(efd, &val, sizeof(val)) < 0)) {
+		XNVME_DEBUG("FAILED: write(efd), errno: %d", errno);
+	}
+
+	return efd;
 }
+#endif
 
 #endif // XNVME_BE_CBI_ASYNC_THRPOOL_ENABLED
 
@@ -420,10 +867,15 @@ struct xnvme_be_async g_xnvme_be_cbi_async_thrpool = {
 	.cmd_io = cbi_async_thrpool_cmd_io,
 	.cmd_iov = cbi_async_thrpool_cmd_iov,
 	.poke = cbi_async_thrpool_poke,
-	.wait = xnvme_be_nosys_queue_wait,
+	.wait = cbi_async_thrpool_wait,
 	.init = cbi_async_thrpool_init,
 	.term = cbi_async_thrpool_term,
+#ifdef XNVME_BE_LINUX_ENABLED
+	.get_completion_fd = cbi_async_thrpool_get_completion_fd,
+#else
 	.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd,
+#endif
+	.cancel = cbi_async_thrpool_cancel,
 #else
 	.cmd_io = xnvme_be_nosys_queue_cmd_io,
 	.cmd_iov = xnvme_be_nosys_queue_cmd_iov,
@@ -432,5 +884,6 @@ struct xnvme_be_async g_xnvme_be_cbi_async_thrpool = {
 	.init = xnvme_be_nosys_queue_init,
 	.term = xnvme_be_nosys_queue_term,
 	.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd,
+	.cancel = xnvme_be_nosys_queue_cancel,
 #endif
 };
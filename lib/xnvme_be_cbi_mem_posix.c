@@ -5,14 +5,44 @@
 #ifndef _XOPEN_SOURCE
 #define _XOPEN_SOURCE 700
 #endif
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
 #include <xnvme_be.h>
 #include <xnvme_be_nosys.h>
 #ifdef XNVME_BE_CBI_MEM_POSIX_ENABLED
 #include <unistd.h>
 #include <errno.h>
+#include <sys/mman.h>
+#include <xnvme_dev.h>
+#include <xnvme_numa.h>
 
+/**
+ * On a device with a known NUMA node, then buffers are private anonymous mappings, bound to the
+ * node before they are first touched; binding heap memory would place only the pages not yet
+ * touched, and the policy would outlive the buffer, applying to whatever the heap puts there next.
+ * The mapping starts with a page recording its size, the buffer follows it.
+ */
 static void *
-buf_alloc(const struct xnvme_dev *XNVME_UNUSED(dev), size_t nbytes, uint64_t *XNVME_UNUSED(phys))
+buf_alloc_numa(size_t pagesize, size_t nbytes, int node)
+{
+	size_t map_nbytes = pagesize + ((nbytes + pagesize - 1) & ~(pagesize - 1));
+	uint8_t *map;
+
+	map = mmap(NULL, map_nbytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (map == MAP_FAILED) {
+		XNVME_DEBUG("FAILED: mmap(), errno: %d", errno);
+		return NULL;
+	}
+	xnvme_numa_bind_mem(map + pagesize, map_nbytes - pagesize, node);
+
+	*(size_t *)map = map_nbytes;
+
+	return map + pagesize;
+}
+
+static void *
+buf_alloc(const struct xnvme_dev *dev, size_t nbytes, uint64_t *XNVME_UNUSED(phys))
 {
 	long sz = sysconf(_SC_PAGESIZE);
 
@@ -20,6 +50,15 @@ buf_alloc(const struct xnvme_dev *XNVME_UNUSED(dev), size_t nbytes, uint64_t *XN
 		XNVME_DEBUG("FAILED: sysconf(), errno: %d", errno);
 		return NULL;
 	}
+	if (!nbytes) {
+		XNVME_DEBUG("FAILED: invalid value for nbytes: '%zu')", nbytes);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	if (dev && (dev->numa_node >= 0)) {
+		return buf_alloc_numa(sz, nbytes, dev->numa_node);
+	}
 
 	return xnvme_buf_virt_alloc(sz, nbytes);
 }
@@ -34,8 +73,15 @@ buf_realloc(const struct xnvme_dev *XNVME_UNUSED(dev), void *XNVME_UNUSED(buf),
 }
 
 static void
-buf_free(const struct xnvme_dev *XNVME_UNUSED(dev), void *buf)
+buf_free(const struct xnvme_dev *dev, void *buf)
 {
+	if (buf && dev && (dev->numa_node >= 0)) {
+		uint8_t *map = (uint8_t *)buf - sysconf(_SC_PAGESIZE);
+
+		munmap(map, *(size_t *)map);
+		return;
+	}
+
 	xnvme_buf_virt_free(buf);
 }
 
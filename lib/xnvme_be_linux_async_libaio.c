@@ -45,6 +45,8 @@ _linux_libaio_term(struct xnvme_queue *q)
 
 	io_destroy(queue->aio_ctx);
 	free(queue->aio_events);
+	free(queue->canceled);
+	free(queue->iocbs);
 
 	return 0;
 }
@@ -58,18 +60,162 @@ _linux_libaio_init(struct xnvme_queue *q, int opts)
 
 	queue->poll_io = (opts & XNVME_QUEUE_IOPOLL) || state->poll_io;
 
+	queue->batching = 1;
+	if (getenv("XNVME_QUEUE_BATCHING_OFF")) {
+		queue->batching = 0;
+	}
+
 	queue->aio_ctx = 0;
 	queue->aio_events = calloc(queue->base.capacity, sizeof(struct io_event));
+	queue->canceled = calloc(queue->base.capacity, sizeof(struct io_event));
+	queue->iocbs = calloc(queue->base.capacity, sizeof(*queue->iocbs));
+	if (!queue->aio_events || !queue->canceled || !queue->iocbs) {
+		XNVME_DEBUG("FAILED: calloc(aio_events/canceled/iocbs)");
+		free(queue->aio_events);
+		free(queue->canceled);
+		free(queue->iocbs);
+		return -ENOMEM;
+	}
 
 	err = io_queue_init(queue->base.capacity, &queue->aio_ctx);
 	if (err) {
 		XNVME_DEBUG("FAILED: io_queue_init(), err: %d", err);
+		free(queue->aio_events);
+		free(queue->canceled);
+		free(queue->iocbs);
 		return err;
 	}
 
 	return 0;
 }
 
+/**
+ * Remove the first 'n' iocbs from the staged iocbs
+ */
+static inline void
+_linux_libaio_unstage(struct xnvme_queue_libaio *queue, uint32_t n)
+{
+	queue->nstaged -= n;
+	if (queue->nstaged) {
+		memmove(queue->iocbs, &queue->iocbs[n], queue->nstaged * sizeof(*queue->iocbs));
+	}
+}
+
+/**
+ * Submit the staged iocbs with as few io_submit() calls as the kernel allows
+ *
+ * An iocb rejected by the kernel is completed with the error; when the kernel is out of
+ * resources, then the remaining iocbs stay staged for the next attempt. As staged commands count
+ * as outstanding, the array cannot overflow, and when it is full, then so is the queue, and the
+ * poke needed to make room submits them.
+ */
+static void
+_linux_libaio_flush(struct xnvme_queue_libaio *queue)
+{
+	while (queue->nstaged) {
+		struct xnvme_cmd_ctx *ctx;
+		int ret;
+
+		ret = io_submit(queue->aio_ctx, queue->nstaged, queue->iocbs);
+		if (ret > 0) {
+			_linux_libaio_unstage(queue, ret);
+			continue;
+		}
+		if (ret == -EAGAIN || ret == -EINTR || !ret) {
+			break;
+		}
+
+		XNVME_DEBUG("FAILED: io_submit(), err: %d", ret);
+		ctx = (void *)queue->iocbs[0]->data;
+
+		// Unstage before the callback, as the callback might submit again
+		_linux_libaio_unstage(queue, 1);
+
+		ctx->cpl.result = 0;
+		ctx->cpl.status.sc = -ret;
+		ctx->cpl.status.sct = XNVME_STATUS_CODE_TYPE_VENDOR;
+		queue->base.outstanding -= 1;
+		ctx->async.cb(ctx, ctx->async.cb_arg);
+	}
+}
+
+/**
+ * Stage the iocb when batching, otherwise submit it right away
+ */
+static int
+_linux_libaio_submit(struct xnvme_queue_libaio *queue, struct iocb *iocb)
+{
+	int err;
+
+	if (queue->batching) {
+		queue->iocbs[queue->nstaged++] = iocb;
+		queue->base.outstanding += 1;
+		return 0;
+	}
+
+	err = io_submit(queue->aio_ctx, 1, &iocb);
+	if (err == 1) {
+		queue->base.outstanding += 1;
+		return 0;
+	}
+
+	XNVME_DEBUG("FAILED: io_submit(), err: %d", err);
+
+	return err;
+}
+
+static int
+_linux_libaio_complete(struct xnvme_queue_libaio *queue, struct io_event *events, int completed)
+{
+	for (int event = 0; event < completed; event++) {
+		struct io_event *ev = &events[event];
+		struct xnvme_cmd_ctx *ctx = (struct xnvme_cmd_ctx *)(uintptr_t)ev->data;
+
+		if (!ctx) {
+			XNVME_DEBUG("-{[THIS SHOULD NOT HAPPEN]}-");
+			XNVME_DEBUG("event->data is NULL! => NO REQ!");
+			XNVME_DEBUG("event->res: %ld", ev->res);
+			XNVME_DEBUG("unprocessed events might remain");
+
+			queue->base.outstanding -= 1;
+
+			return -EIO;
+		}
+
+		ctx->cpl.result = ev->res;
+		if (((int64_t)ev->res) < 0) {
+			XNVME_DEBUG("FAILED: res: %lu, res2: %lu", ev->res, ev->res2);
+			ctx->cpl.result = 0;
+			ctx->cpl.status.sc = -ev->res;
+			ctx->cpl.status.sct = XNVME_STATUS_CODE_TYPE_VENDOR;
+		}
+
+		ctx->async.cb(ctx, ctx->async.cb_arg);
+	}
+
+	queue->base.outstanding -= completed;
+	return completed;
+}
+
+/**
+ * Complete up to 'max' of the cancelled commands, oldest first; the events are moved to
+ * 'aio_events' beforehand, as the callbacks might cancel other commands
+ */
+static int
+_linux_libaio_complete_canceled(struct xnvme_queue_libaio *queue, uint32_t max)
+{
+	uint32_t n = XNVME_MIN(queue->ncanceled, max);
+
+	memcpy(queue->aio_events, queue->canceled, n * sizeof(*queue->canceled));
+	queue->ncanceled -= n;
+	if (queue->ncanceled) {
+		memmove(queue->canceled, &queue->canceled[n],
+			queue->ncanceled * sizeof(*queue->canceled));
+	}
+
+	return _linux_libaio_complete(queue, queue->aio_events, n);
+}
+
 static int
 _linux_libaio_poke(struct xnvme_queue *q, uint32_t max)
 {
@@ -81,6 +227,13 @@ _linux_libaio_poke(struct xnvme_queue *q, uint32_t max)
 
 	struct xnvme_aio_ring *ring = (struct xnvme_aio_ring *)queue->aio_ctx;
 
+	if (queue->nstaged) {
+		_linux_libaio_flush(queue);
+	}
+	if (queue->ncanceled) {
+		return _linux_libaio_complete_canceled(queue, max);
+	}
+
 	/* If ring is incompatible use io_getevents */
 	if (ring->magic != XNVME_AIO_RING_MAGIC || ring->incompat_features != 0) {
 		timeout.tv_sec = 0;
@@ -97,7 +250,7 @@ _linux_libaio_poke(struct xnvme_queue *q, uint32_t max)
 		uint32_t current = ring->head;
 
 		// Casting max to int is safe here because
-		// max <= queue->base.outstanding < 4096
+		// max <= queue->base.outstanding <= XNVME_QUEUE_CAPACITY_MAX (65536)
 		for (completed = 0; completed < (int)max; completed++) {
 			if (current == ring->tail) {
 				break;
@@ -113,34 +266,39 @@ _linux_libaio_poke(struct xnvme_queue *q, uint32_t max)
 				      memory_order_release);
 	}
 
-	for (int event = 0; event < completed; event++) {
-		struct io_event *ev = &queue->aio_events[event];
-		struct xnvme_cmd_ctx *ctx = (struct xnvme_cmd_ctx *)(uintptr_t)ev->data;
-
-		if (!ctx) {
-			XNVME_DEBUG("-{[THIS SHOULD NOT HAPPEN]}-");
-			XNVME_DEBUG("event->data is NULL! => NO REQ!");
-			XNVME_DEBUG("event->res: %ld", ev->res);
-			XNVME_DEBUG("unprocessed events might remain");
-
-			queue->base.outstanding -= 1;
-
-			return -EIO;
-		}
+	return _linux_libaio_complete(queue, queue->aio_events, completed);
+}
 
-		ctx->cpl.result = ev->res;
-		if (((int64_t)ev->res) < 0) {
-			XNVME_DEBUG("FAILED: res: %lu, res2: %lu", ev->res, ev->res2);
-			ctx->cpl.result = 0;
-			ctx->cpl.status.sc = -ev->res;
-			ctx->cpl.status.sct = XNVME_STATUS_CODE_TYPE_VENDOR;
-		}
+static int
+_linux_libaio_wait(struct xnvme_queue *q, uint32_t min, uint64_t timeout_ns)
+{
+	struct xnvme_queue_libaio *queue = (void *)q;
+	struct timespec timeout = {
+		.tv_sec = timeout_ns / 1000000000ULL,
+		.tv_nsec = timeout_ns % 1000000000ULL,
+	};
+	int completed;
+
+	// Do not wait for more than what reached the kernel
+	if (queue->nstaged) {
+		_linux_libaio_flush(queue);
+		min = XNVME_MIN(min, queue->base.outstanding - queue->nstaged);
+	}
+	if (queue->ncanceled) {
+		return _linux_libaio_complete_canceled(queue, queue->base.outstanding);
+	}
 
-		ctx->async.cb(ctx, ctx->async.cb_arg);
+	completed = io_getevents(queue->aio_ctx, min, queue->base.outstanding, queue->aio_events,
+				 timeout_ns ? &timeout : NULL);
+	if (completed == -EINTR) {
+		return 0;
+	}
+	if (completed < 0) {
+		XNVME_DEBUG("FAILED: completed: %d, errno: %d", completed, errno);
+		return completed;
 	}
 
-	queue->base.outstanding -= completed;
-	return completed;
+	return _linux_libaio_complete(queue, queue->aio_events, completed);
 }
 
 static int
@@ -152,8 +310,11 @@ _linux_libaio_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes,
 	const uint64_t ssw = queue->base.dev->geo.ssw;
 
 	struct iocb *iocb = (void *)&ctx->cmd;
-	int err;
 
+	if (queue->base.outstanding == queue->base.capacity) {
+		XNVME_DEBUG("FAILED: queue is full");
+		return -EBUSY;
+	}
 	if (mbuf || mbuf_nbytes) {
 		XNVME_DEBUG("FAILED: mbuf or mbuf_nbytes provided");
 		return -ENOTSUP;
@@ -187,15 +348,7 @@ _linux_libaio_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes,
 
 	iocb->data = (unsigned long *)ctx;
 
-	err = io_submit(queue->aio_ctx, 1, &iocb);
-	if (err == 1) {
-		ctx->async.queue->base.outstanding += 1;
-		return 0;
-	}
-
-	XNVME_DEBUG("FAILED: io_submit(), err: %d", err);
-
-	return err;
+	return _linux_libaio_submit(queue, iocb);
 }
 
 static int
@@ -207,7 +360,6 @@ _linux_libaio_cmd_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, size_t dvec
 	const uint64_t ssw = queue->base.dev->geo.ssw;
 
 	struct iocb *iocb = (void *)&ctx->cmd;
-	int err;
 
 	if (queue->base.outstanding == queue->base.capacity) {
 		XNVME_DEBUG("FAILED: queue is full");
@@ -246,15 +398,53 @@ _linux_libaio_cmd_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, size_t dvec
 
 	iocb->data = (unsigned long *)ctx;
 
-	err = io_submit(queue->aio_ctx, 1, &iocb);
-	if (err == 1) {
-		ctx->async.queue->base.outstanding += 1;
+	return _linux_libaio_submit(queue, iocb);
+}
+
+/**
+ * A staged iocb is dropped and its command queued for completion with ECANCELED, otherwise
+ * cancellation is up to io_cancel(), which most files, e.g. block devices, do not support; when
+ * the kernel hands back the event, then it is queued likewise, otherwise, the event is reaped from
+ * the ring. Either way, the callback is invoked by the next poke or wait, not by the caller
+ */
+static int
+_linux_libaio_cancel(struct xnvme_cmd_ctx *ctx)
+{
+	struct xnvme_queue_libaio *queue = (void *)ctx->async.queue;
+	struct iocb *iocb = (void *)&ctx->cmd;
+	struct io_event ev;
+	int err;
+
+	memset(&ev, 0, sizeof(ev));
+
+	for (uint32_t i = 0; i < queue->nstaged; ++i) {
+		if (queue->iocbs[i] != iocb) {
+			continue;
+		}
+
+		queue->nstaged -= 1;
+		memmove(&queue->iocbs[i], &queue->iocbs[i + 1],
+			(queue->nstaged - i) * sizeof(*queue->iocbs));
+
+		ev.data = ctx;
+		ev.res = -ECANCELED;
+		queue->canceled[queue->ncanceled++] = ev;
+
 		return 0;
 	}
 
-	XNVME_DEBUG("FAILED: io_submit(), err: %d", err);
+	err = io_cancel(queue->aio_ctx, iocb, &ev);
+	if (err == -EINPROGRESS) {
+		return 0;
+	}
+	if (err) {
+		XNVME_DEBUG("FAILED: io_cancel(), err: %d", err);
+		return err;
+	}
 
-	return err;
+	queue->canceled[queue->ncanceled++] = ev;
+
+	return 0;
 }
 #endif
 
@@ -264,10 +454,11 @@ struct xnvme_be_async g_xnvme_be_linux_async_libaio = {
 	.cmd_io = _linux_libaio_cmd_io,
 	.cmd_iov = _linux_libaio_cmd_iov,
 	.poke = _linux_libaio_poke,
-	.wait = xnvme_be_nosys_queue_wait,
+	.wait = _linux_libaio_wait,
 	.init = _linux_libaio_init,
 	.term = _linux_libaio_term,
 	.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd,
+	.cancel = _linux_libaio_cancel,
 #else
 	.cmd_io = xnvme_be_nosys_queue_cmd_io,
 	.cmd_iov = xnvme_be_nosys_queue_cmd_iov,
@@ -276,5 +467,6 @@ struct xnvme_be_async g_xnvme_be_linux_async_libaio = {
 	.init = xnvme_be_nosys_queue_init,
 	.term = xnvme_be_nosys_queue_term,
 	.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd,
+	.cancel = xnvme_be_nosys_queue_cancel,
 #endif
 };
@@ -11,15 +11,30 @@
 #ifdef XNVME_BE_LINUX_LIBURING_ENABLED
 #include <pthread.h>
 #include <errno.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
 #include <liburing.h>
 #include <xnvme_queue.h>
 #include <xnvme_dev.h>
+#include <xnvme_numa.h>
 #include <xnvme_be_linux_liburing.h>
 #include <xnvme_be_linux.h>
 
+#ifndef IORING_SETUP_SUBMIT_ALL
+#define IORING_SETUP_SUBMIT_ALL (1U << 7)
+#endif
+#ifndef IORING_SETUP_COOP_TASKRUN
+#define IORING_SETUP_COOP_TASKRUN (1U << 8)
+#endif
+#ifndef IORING_SETUP_TASKRUN_FLAG
+#define IORING_SETUP_TASKRUN_FLAG (1U << 9)
+#endif
 #ifndef IORING_SETUP_SINGLE_ISSUER
 #define IORING_SETUP_SINGLE_ISSUER (1U << 12)
 #endif
+#ifndef IORING_SETUP_DEFER_TASKRUN
+#define IORING_SETUP_DEFER_TASKRUN (1U << 13)
+#endif
 
 static struct sqpoll_wq {
 	pthread_mutex_t mutex;
@@ -33,6 +48,23 @@ static struct sqpoll_wq {
 	.refcount = 0,
 };
 
+/**
+ * Optional setup-flags, in the order they are dropped when the kernel rejects them; newest first.
+ * DEFER_TASKRUN goes before SINGLE_ISSUER, which it requires, and TASKRUN_FLAG goes along with the
+ * last of the task-run modes
+ */
+static const struct {
+	unsigned flags;
+	const char *name;
+} g_init_fallback[] = {
+	{IORING_SETUP_DEFER_TASKRUN, "DEFER_TASKRUN"},
+	{IORING_SETUP_SINGLE_ISSUER, "SINGLE_ISSUER"},
+	{IORING_SETUP_COOP_TASKRUN, "COOP_TASKRUN"},
+	{IORING_SETUP_SUBMIT_ALL, "SUBMIT_ALL"},
+};
+
+static const unsigned g_taskrun_modes = IORING_SETUP_COOP_TASKRUN | IORING_SETUP_DEFER_TASKRUN;
+
 static int
 _init_retry(unsigned entries, struct io_uring *ring, struct io_uring_params *p)
 {
@@ -41,9 +73,19 @@ _init_retry(unsigned entries, struct io_uring *ring, struct io_uring_params *p)
 retry:
 	err = io_uring_queue_init_params(entries, ring, p);
 	if (err) {
-		if (err == -EINVAL && p->flags & IORING_SETUP_SINGLE_ISSUER) {
-			p->flags &= ~IORING_SETUP_SINGLE_ISSUER;
-			XNVME_DEBUG("FAILED: io_uring_queue_init_params(), retry(!SINGLE_ISSUER)");
+		const unsigned nfallbacks = sizeof g_init_fallback / sizeof(*g_init_fallback);
+
+		for (unsigned i = 0; (err == -EINVAL) && (i < nfallbacks); ++i) {
+			if (!(p->flags & g_init_fallback[i].flags)) {
+				continue;
+			}
+
+			p->flags &= ~g_init_fallback[i].flags;
+			if (!(p->flags & g_taskrun_modes)) {
+				p->flags &= ~IORING_SETUP_TASKRUN_FLAG;
+			}
+			XNVME_DEBUG("FAILED: io_uring_queue_init_params(), retry(!%s)",
+				    g_init_fallback[i].name);
 			goto retry;
 		}
 
@@ -54,6 +96,148 @@ retry:
 	return 0;
 }
 
+/**
+ * Register the slots of the device buffer-registry with the ring
+ *
+ * Failing to register is not treated as an error, commands are then just submitted without the use
+ * of fixed buffers, as is the case when the kernel lacks support for sparse buffer-tables.
+ */
+static int
+_bufs_init(struct xnvme_queue_liburing *queue)
+{
+	struct xnvme_buf_registry *reg = queue->base.dev->bufreg;
+	struct xnvme_queue_liburing_bufs *bufs;
+	int err;
+
+	if (!reg) {
+		return 0;
+	}
+
+	bufs = calloc(1, sizeof(*bufs));
+	if (!bufs) {
+		XNVME_DEBUG("FAILED: calloc(bufs), err: %s", strerror(errno));
+		return -errno;
+	}
+
+	bufs->gen = xnvme_buf_registry_snapshot(reg, bufs->slots);
+
+	err = io_uring_register_buffers(&queue->ring, bufs->slots, XNVME_BUF_REGISTRY_NSLOTS);
+	if (err) {
+		XNVME_DEBUG("INFO: io_uring_register_buffers(), err: %d; no fixed-buffers", err);
+		free(bufs);
+		return 0;
+	}
+
+	queue->bufs = bufs;
+
+	return 0;
+}
+
+/**
+ * Update the slots of the buffer-table which differ from the device buffer-registry
+ *
+ * On error, the queue stops using fixed buffers, the stale registrations are released along with
+ * the ring.
+ */
+static int
+_bufs_sync(struct xnvme_queue_liburing *queue)
+{
+	struct xnvme_queue_liburing_bufs *bufs = queue->bufs;
+	struct iovec slots[XNVME_BUF_REGISTRY_NSLOTS];
+	uint64_t gen;
+
+	gen = xnvme_buf_registry_snapshot(queue->base.dev->bufreg, slots);
+
+	for (int i = 0; i < XNVME_BUF_REGISTRY_NSLOTS; ++i) {
+		int err;
+
+		if ((slots[i].iov_base == bufs->slots[i].iov_base) &&
+		    (slots[i].iov_len == bufs->slots[i].iov_len)) {
+			continue;
+		}
+
+		err = io_uring_register_buffers_update_tag(&queue->ring, i, &slots[i], NULL, 1);
+		if (err < 0) {
+			XNVME_DEBUG("FAILED: io_uring_register_buffers_update_tag(): %d", err);
+			free(queue->bufs);
+			queue->bufs = NULL;
+			return err;
+		}
+
+		bufs->slots[i] = slots[i];
+	}
+
+	bufs->gen = gen;
+
+	return 0;
+}
+
+/**
+ * Returns the index of the registered buffer containing [dbuf, dbuf + dbuf_nbytes[ or -1 when the
+ * payload is not within a registered buffer
+ */
+static inline int
+_bufs_lookup(struct xnvme_queue_liburing *queue, void *dbuf, size_t dbuf_nbytes)
+{
+	struct xnvme_queue_liburing_bufs *bufs = queue->bufs;
+	uintptr_t start = (uintptr_t)dbuf;
+
+	if ((!dbuf) || (xnvme_buf_registry_gen(queue->base.dev->bufreg) != bufs->gen &&
+			_bufs_sync(queue))) {
+		return -1;
+	}
+
+	for (uint32_t i = 0; i < XNVME_BUF_REGISTRY_NSLOTS; ++i) {
+		uint32_t slot = (bufs->hint + i) % XNVME_BUF_REGISTRY_NSLOTS;
+		uintptr_t base = (uintptr_t)bufs->slots[slot].iov_base;
+
+		if (base && (start >= base) &&
+		    (start + dbuf_nbytes <= base + bufs->slots[slot].iov_len)) {
+			bufs->hint = slot;
+			return slot;
+		}
+	}
+
+	return -1;
+}
+
+static inline unsigned
+_ring_sq_entries(struct xnvme_queue_liburing *queue)
+{
+	return XNVME_MIN(queue->base.capacity, XNVME_QUEUE_IOU_SQ_ENTRIES_MAX);
+}
+
+static inline unsigned
+_ring_cq_entries(struct xnvme_queue_liburing *queue)
+{
+	return XNVME_MIN(XNVME_QUEUE_IOU_CQES_PER_CMD * queue->base.capacity,
+			 XNVME_QUEUE_IOU_CQ_ENTRIES_MAX);
+}
+
+/**
+ * Whether the CQ holds 'ncqes' CQEs for every command, or the kernel keeps the CQEs overflowing it
+ */
+static inline bool
+_ring_has_cqes(struct xnvme_queue_liburing *queue, unsigned ncqes)
+{
+	return (queue->ring.features & IORING_FEAT_NODROP) ||
+	       (queue->ring.cq.ring_entries >= ncqes * queue->base.capacity);
+}
+
+/**
+ * The deadline of the given command when its timeout is to be linked, otherwise NULL, leaving the
+ * command to the watchdog; a queue of a single entry might have an SQ of a single entry
+ */
+static inline struct xnvme_queue_deadline *
+_ring_deadline(struct xnvme_queue_liburing *queue, struct xnvme_cmd_ctx *ctx)
+{
+	if (!ctx || (queue->base.capacity < 2) || !_ring_has_cqes(queue, 2)) {
+		return NULL;
+	}
+
+	return xnvme_queue_timeout_deadline(ctx);
+}
+
 int
 xnvme_be_linux_liburing_init(struct xnvme_queue *q, int opts)
 {
@@ -72,6 +256,8 @@ xnvme_be_linux_liburing_init(struct xnvme_queue *q, int opts)
 	XNVME_DEBUG("queue->poll_sq: %d", queue->poll_sq);
 	XNVME_DEBUG("queue->poll_io: %d", queue->poll_io);
 
+	queue->efd = -1;
+
 	err = pthread_mutex_lock(&g_sqpoll_wq.mutex);
 	if (err) {
 		XNVME_DEBUG("FAILED: lock(g_sqpoll_wq.mutex), err: %d", err);
@@ -87,21 +273,29 @@ xnvme_be_linux_liburing_init(struct xnvme_queue *q, int opts)
 	// Ring-initialization
 	//
 	if (queue->poll_sq) {
+		int sq_cpu = -1;
 		char *env;
 
+		// Unless given, place the sqthread on a CPU of the NUMA node of the device
+		env = getenv("XNVME_QUEUE_SQPOLL_CPU");
+		if (env) {
+			sq_cpu = atoi(env);
+		} else if (queue->base.dev->numa_node >= 0) {
+			sq_cpu = xnvme_numa_node_cpu(queue->base.dev->numa_node);
+		}
+
 		if (!((env = getenv("XNVME_QUEUE_SQPOLL_AWQ")) && atoi(env) == 0)) {
 			if (!g_sqpoll_wq.is_initialized) {
 				struct io_uring_params sqpoll_wq_params = {0};
 
-				env = getenv("XNVME_QUEUE_SQPOLL_CPU");
-				if (env) {
+				if (sq_cpu >= 0) {
 					sqpoll_wq_params.flags |= IORING_SETUP_SQ_AFF;
-					sqpoll_wq_params.sq_thread_cpu = atoi(env);
+					sqpoll_wq_params.sq_thread_cpu = sq_cpu;
 				}
 				sqpoll_wq_params.flags |= IORING_SETUP_SQPOLL;
 				sqpoll_wq_params.flags |= IORING_SETUP_SINGLE_ISSUER;
 
-				err = _init_retry(queue->base.capacity, &g_sqpoll_wq.ring,
+				err = _init_retry(_ring_sq_entries(queue), &g_sqpoll_wq.ring,
 						  &sqpoll_wq_params);
 				if (err) {
 					XNVME_DEBUG(
@@ -118,6 +312,9 @@ xnvme_be_linux_liburing_init(struct xnvme_queue *q, int opts)
 			g_sqpoll_wq.refcount += 1;
 			ring_params.wq_fd = g_sqpoll_wq.ring.ring_fd;
 			ring_params.flags |= IORING_SETUP_ATTACH_WQ;
+		} else if (sq_cpu >= 0) {
+			ring_params.flags |= IORING_SETUP_SQ_AFF;
+			ring_params.sq_thread_cpu = sq_cpu;
 		}
 		ring_params.flags |= IORING_SETUP_SQPOLL;
 		ring_params.flags |= IORING_SETUP_SINGLE_ISSUER;
@@ -126,21 +323,84 @@ xnvme_be_linux_liburing_init(struct xnvme_queue *q, int opts)
 		ring_params.flags |= IORING_SETUP_IOPOLL;
 	}
 
+	// The task-run modes are about IPIs, which do not apply with SQPOLL; the TASKRUN_FLAG lets
+	// liburing know when to enter the kernel for completions pending as task-work
+	if (((opts & XNVME_QUEUE_DEFER_TASKRUN) || state->defer_taskrun) && !queue->poll_sq) {
+		ring_params.flags |= IORING_SETUP_DEFER_TASKRUN;
+		ring_params.flags |= IORING_SETUP_SINGLE_ISSUER;
+		ring_params.flags |= IORING_SETUP_TASKRUN_FLAG;
+	}
+	if (((opts & XNVME_QUEUE_COOP_TASKRUN) || state->coop_taskrun) && !queue->poll_sq) {
+		ring_params.flags |= IORING_SETUP_COOP_TASKRUN;
+		ring_params.flags |= IORING_SETUP_TASKRUN_FLAG;
+	}
+	if ((opts & XNVME_QUEUE_SUBMIT_ALL) || state->submit_all) {
+		ring_params.flags |= IORING_SETUP_SUBMIT_ALL;
+	}
+
+	// Every CQE of the outstanding commands must fit in the CQ, that is, with timeouts, up to
+	// XNVME_QUEUE_IOU_CQES_PER_CMD per command, the SQ only needs to hold a batch
+	ring_params.flags |= IORING_SETUP_CQSIZE;
+	ring_params.cq_entries = _ring_cq_entries(queue);
+
 	if (opts & XNVME_QUEUE_IOU_BIGSQE) {
 		ring_params.flags |= IORING_SETUP_SQE128;
 		ring_params.flags |= IORING_SETUP_CQE32;
 	}
 
-	err = _init_retry(queue->base.capacity, &queue->ring, &ring_params);
+	err = _init_retry(_ring_sq_entries(queue), &queue->ring, &ring_params);
 	if (err) {
 		XNVME_DEBUG("FAILED: _init_retry, err: %d", err);
 		goto exit;
 	}
 
-	if (queue->poll_sq) {
+	// Failing to register the ring-fd is not an error, io_uring_enter() then just looks it up
+	if ((opts & XNVME_QUEUE_REGISTER_RING_FD) || state->register_ring_fd) {
+		err = io_uring_register_ring_fd(&queue->ring);
+		if (err == 1) {
+			queue->base.opts |= XNVME_QUEUE_REGISTER_RING_FD;
+		} else {
+			XNVME_DEBUG("INFO: io_uring_register_ring_fd(), err: %d", err);
+		}
+		err = 0;
+	}
+
+	queue->base.opts |= queue->poll_sq ? XNVME_QUEUE_SQPOLL : 0;
+	queue->base.opts |= queue->poll_io ? XNVME_QUEUE_IOPOLL : 0;
+	if (queue->ring.flags & IORING_SETUP_DEFER_TASKRUN) {
+		queue->base.opts |= XNVME_QUEUE_DEFER_TASKRUN;
+	}
+	if (queue->ring.flags & IORING_SETUP_COOP_TASKRUN) {
+		queue->base.opts |= XNVME_QUEUE_COOP_TASKRUN;
+	}
+	if (queue->ring.flags & IORING_SETUP_SUBMIT_ALL) {
+		queue->base.opts |= XNVME_QUEUE_SUBMIT_ALL;
+	}
+
+	// SQPOLL requires the registration on kernels before 5.11, otherwise it only saves the
+	// file-lookup of every SQE, and failing it is not an error
+	if (queue->poll_sq || (opts & XNVME_QUEUE_REGISTER_FILES) || state->register_files) {
 		err = io_uring_register_files(&queue->ring, &(state->fd), 1);
-		if (err) {
+		if (err && queue->poll_sq) {
 			XNVME_DEBUG("FAILED: io_uring_register_files, err: %d", err);
+			io_uring_queue_exit(&queue->ring);
+			goto exit;
+		}
+		if (err) {
+			XNVME_DEBUG("INFO: io_uring_register_files, err: %d", err);
+			err = 0;
+		} else {
+			queue->fixed_file = 1;
+			queue->base.opts |= XNVME_QUEUE_REGISTER_FILES;
+		}
+	}
+
+	// NOTE: uring-cmd passthru does not make use of the buffer-table
+	if (!(opts & XNVME_QUEUE_IOU_BIGSQE)) {
+		err = _bufs_init(queue);
+		if (err) {
+			XNVME_DEBUG("FAILED: _bufs_init(), err: %d", err);
+			io_uring_queue_exit(&queue->ring);
 			goto exit;
 		}
 	}
@@ -174,9 +434,19 @@ xnvme_be_linux_liburing_term(struct xnvme_queue *q)
 		err = -EINVAL;
 		goto exit;
 	}
-	if (queue->poll_sq) {
+	if (queue->fixed_file) {
 		io_uring_unregister_files(&queue->ring);
 	}
+	if (queue->bufs) {
+		io_uring_unregister_buffers(&queue->ring);
+		free(queue->bufs);
+		queue->bufs = NULL;
+	}
+	if (queue->efd >= 0) {
+		io_uring_unregister_eventfd(&queue->ring);
+		close(queue->efd);
+		queue->efd = -1;
+	}
 	io_uring_queue_exit(&queue->ring);
 
 	if (queue->poll_sq && g_sqpoll_wq.is_initialized && (!(--g_sqpoll_wq.refcount))) {
@@ -192,14 +462,46 @@ exit:
 	return err;
 }
 
+int
+xnvme_be_linux_liburing_get_completion_fd(struct xnvme_queue *q)
+{
+	struct xnvme_queue_liburing *queue = (void *)q;
+	int efd, err;
+
+	if (queue->efd >= 0) {
+		return queue->efd;
+	}
+	// Completions are only posted, and the eventfd signaled, when the queue enters the kernel
+	if (queue->base.opts & XNVME_QUEUE_DEFER_TASKRUN) {
+		XNVME_DEBUG("FAILED: completion-fd is not supported with DEFER_TASKRUN");
+		return -ENOTSUP;
+	}
+
+	efd = eventfd(0, EFD_CLOEXEC);
+	if (efd < 0) {
+		XNVME_DEBUG("FAILED: eventfd(), errno: %d", errno);
+		return -errno;
+	}
+
+	err = io_uring_register_eventfd(&queue->ring, efd);
+	if (err) {
+		XNVME_DEBUG("FAILED: io_uring_register_eventfd(), err: %d", err);
+		close(efd);
+		return err;
+	}
+
+	queue->efd = efd;
+
+	return efd;
+}
+
 int
 xnvme_be_linux_liburing_poke(struct xnvme_queue *q, uint32_t max)
 {
 	struct xnvme_queue_liburing *queue = (void *)q;
-	struct io_uring_cqe *cqe;
-	struct xnvme_cmd_ctx *ctx;
+	struct io_uring_cqe *cqes[XNVME_QUEUE_IOU_CQE_BATCH_MAX];
+	struct xnvme_cmd_ctx *ctxs[XNVME_QUEUE_IOU_CQE_BATCH_MAX];
 	unsigned completed;
-	int err;
 
 	max = max ? max : queue->base.outstanding;
 	max = max > queue->base.outstanding ? queue->base.outstanding : max;
@@ -213,41 +515,161 @@ xnvme_be_linux_liburing_poke(struct xnvme_queue *q, uint32_t max)
 	}
 
 	completed = 0;
-	for (uint32_t i = 0; i < max; i++) {
-		err = io_uring_peek_cqe(&queue->ring, &cqe);
-		if (err == -EAGAIN) {
-			return completed;
+	while (completed < max) {
+		unsigned nreap = XNVME_MIN(max - completed, XNVME_QUEUE_IOU_CQE_BATCH_MAX);
+		unsigned ncqes, nctxs;
+
+		ncqes = io_uring_peek_batch_cqe(&queue->ring, cqes, nreap);
+		if (!ncqes) {
+			break;
 		}
 
-		ctx = io_uring_cqe_get_data(cqe);
+		nctxs = 0;
+		for (unsigned i = 0; i < ncqes; ++i) {
+			struct io_uring_cqe *cqe = cqes[i];
+			struct xnvme_cmd_ctx *ctx = io_uring_cqe_get_data(cqe);
+
+			// Linked timeouts and cancellations complete without a command-context, as
+			// does the internal timeout of a timed wait without IORING_FEAT_EXT_ARG
+			if (!ctx || (cqe->user_data == LIBURING_UDATA_TIMEOUT)) {
+				continue;
+			}
+
+			ctx->cpl.result = cqe->res;
+			if (cqe->res < 0) {
+				ctx->cpl.result = 0;
+				ctx->cpl.status.sc = -cqe->res;
+				ctx->cpl.status.sct = XNVME_STATUS_CODE_TYPE_VENDOR;
+			}
 
-#ifdef XNVME_DEBUG_ENABLED
-		if (!ctx) {
-			XNVME_DEBUG("-{[THIS SHOULD NOT HAPPEN]}-");
-			XNVME_DEBUG("cqe->user_data is NULL! => NO REQ!");
-			XNVME_DEBUG("cqe->res: %d", cqe->res);
-			XNVME_DEBUG("cqe->flags: %u", cqe->flags);
-			return -EIO;
+			ctxs[nctxs++] = ctx;
 		}
-#endif
 
-		ctx->cpl.result = cqe->res;
-		if (cqe->res < 0) {
-			ctx->cpl.result = 0;
-			ctx->cpl.status.sc = -cqe->res;
-			ctx->cpl.status.sct = XNVME_STATUS_CODE_TYPE_VENDOR;
+		// Release the entire batch of CQEs with a single CQ-head update, before invoking
+		// callbacks, such that a callback re-poking the queue does not see them again
+		io_uring_cq_advance(&queue->ring, ncqes);
+		queue->base.outstanding -= nctxs;
+
+		for (unsigned i = 0; i < nctxs; ++i) {
+			ctxs[i]->async.cb(ctxs[i], ctxs[i]->async.cb_arg);
 		}
 
-		queue->base.outstanding--;
+		completed += nctxs;
+	}
 
-		io_uring_cqe_seen(&queue->ring, cqe);
+	return completed;
+}
 
-		ctx->async.cb(ctx, ctx->async.cb_arg);
+struct io_uring_sqe *
+xnvme_be_linux_liburing_get_sqe(struct xnvme_queue_liburing *queue, struct xnvme_cmd_ctx *ctx)
+{
+	// A command with a deadline takes a second SQE for its linked timeout
+	unsigned nsqes = _ring_deadline(queue, ctx) ? 2 : 1;
+	struct io_uring_sqe *sqe = NULL;
 
-		completed++;
+	if (io_uring_sq_space_left(&queue->ring) >= nsqes) {
+		sqe = io_uring_get_sqe(&queue->ring);
 	}
+	if (!sqe && queue->batching) {
+		int err = io_uring_submit(&queue->ring);
 
-	return completed;
+		if (err < 0) {
+			XNVME_DEBUG("FAILED: io_uring_submit(), err: %d", err);
+			return NULL;
+		}
+		if (io_uring_sq_space_left(&queue->ring) >= nsqes) {
+			sqe = io_uring_get_sqe(&queue->ring);
+		}
+	}
+
+	return sqe;
+}
+
+void
+xnvme_be_linux_liburing_link_timeout(struct xnvme_queue_liburing *queue, struct io_uring_sqe *sqe,
+				     struct xnvme_cmd_ctx *ctx)
+{
+	struct xnvme_queue_deadline *deadline = _ring_deadline(queue, ctx);
+	struct io_uring_sqe *tsqe;
+
+	if (!deadline) {
+		return;
+	}
+
+	// Reserved by xnvme_be_linux_liburing_get_sqe(), thus, only NULL when SQPOLL falls behind
+	tsqe = io_uring_get_sqe(&queue->ring);
+	if (!tsqe) {
+		return;
+	}
+
+	sqe->flags |= IOSQE_IO_LINK;
+	io_uring_prep_link_timeout(tsqe, (struct __kernel_timespec *)deadline, IORING_TIMEOUT_ABS);
+	io_uring_sqe_set_data(tsqe, NULL);
+}
+
+int
+xnvme_be_linux_liburing_cancel(struct xnvme_cmd_ctx *ctx)
+{
+	struct xnvme_queue_liburing *queue = (void *)ctx->async.queue;
+	struct io_uring_sqe *sqe;
+	int err;
+
+	if (!_ring_has_cqes(queue, XNVME_QUEUE_IOU_CQES_PER_CMD)) {
+		XNVME_DEBUG("FAILED: the CQ cannot hold the CQE of the cancellation");
+		return -ENOTSUP;
+	}
+
+	sqe = xnvme_be_linux_liburing_get_sqe(queue, NULL);
+	if (!sqe) {
+		return -EAGAIN;
+	}
+	io_uring_prep_cancel64(sqe, (uint64_t)(uintptr_t)ctx, 0);
+	io_uring_sqe_set_data(sqe, NULL);
+
+	// Submitted right away, along with any batched SQEs, possibly that of the command itself
+	err = io_uring_submit(&queue->ring);
+	if (err < 0) {
+		XNVME_DEBUG("FAILED: io_uring_submit(), err: %d", err);
+		return err;
+	}
+
+	return 0;
+}
+
+int
+xnvme_be_linux_liburing_wait_cqes(struct xnvme_queue *q, uint32_t min, uint64_t timeout_ns)
+{
+	struct xnvme_queue_liburing *queue = (void *)q;
+	struct __kernel_timespec ts = {
+		.tv_sec = timeout_ns / 1000000000ULL,
+		.tv_nsec = timeout_ns % 1000000000ULL,
+	};
+	struct io_uring_cqe *cqe = NULL;
+	int err;
+
+	// Submits anything pending from batching, then sleeps in io_uring_enter() until 'min'
+	// CQEs are available; the CQEs are left on the ring for the caller to reap
+	err = io_uring_submit_and_wait_timeout(&queue->ring, &cqe, min, timeout_ns ? &ts : NULL,
+					       NULL);
+	if ((err < 0) && (err != -ETIME) && (err != -EINTR)) {
+		XNVME_DEBUG("FAILED: io_uring_submit_and_wait_timeout(), err: %d", err);
+		return err;
+	}
+
+	return 0;
+}
+
+int
+xnvme_be_linux_liburing_wait(struct xnvme_queue *q, uint32_t min, uint64_t timeout_ns)
+{
+	int err;
+
+	err = xnvme_be_linux_liburing_wait_cqes(q, min, timeout_ns);
+	if (err) {
+		return err;
+	}
+
+	return xnvme_be_linux_liburing_poke(q, 0);
 }
 
 int
@@ -260,6 +682,7 @@ xnvme_be_linux_liburing_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbu
 	struct io_uring_sqe *sqe = NULL;
 
 	int opcode = IORING_OP_NOP;
+	int buf_index = -1;
 	int err = 0;
 
 	if (mbuf || mbuf_nbytes) {
@@ -288,7 +711,15 @@ xnvme_be_linux_liburing_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbu
 		return -ENOSYS;
 	}
 
-	sqe = io_uring_get_sqe(&queue->ring);
+	if (queue->bufs) {
+		buf_index = _bufs_lookup(queue, dbuf, dbuf_nbytes);
+		if (buf_index >= 0) {
+			opcode = (opcode == IORING_OP_READ) ? IORING_OP_READ_FIXED
+							    : IORING_OP_WRITE_FIXED;
+		}
+	}
+
+	sqe = xnvme_be_linux_liburing_get_sqe(queue, ctx);
 	if (!sqe) {
 		return -EAGAIN;
 	}
@@ -297,15 +728,18 @@ xnvme_be_linux_liburing_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbu
 	sqe->addr = (unsigned long)dbuf;
 	sqe->len = dbuf_nbytes;
 	sqe->off = ctx->cmd.nvm.slba << ssw;
-	sqe->flags = queue->poll_sq ? IOSQE_FIXED_FILE : 0;
+	sqe->flags = queue->fixed_file ? IOSQE_FIXED_FILE : 0;
 	sqe->ioprio = 0;
 	// NOTE: we only ever register a single file, the raw device, so the
 	// provided index will always be 0
-	sqe->fd = queue->poll_sq ? 0 : state->fd;
+	sqe->fd = queue->fixed_file ? 0 : state->fd;
 	sqe->rw_flags = 0;
+	sqe->buf_index = buf_index < 0 ? 0 : buf_index;
 	sqe->user_data = (unsigned long)ctx;
 	// sqe->__pad2[0] = sqe->__pad2[1] = sqe->__pad2[2] = 0;
 
+	xnvme_be_linux_liburing_link_timeout(queue, sqe, ctx);
+
 	if (queue->batching) {
 		goto exit;
 	}
@@ -344,16 +778,14 @@ xnvme_be_linux_liburing_cmd_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, s
 		return -ENOTSUP;
 	}
 
-	sqe = io_uring_get_sqe(&queue->ring);
+	sqe = xnvme_be_linux_liburing_get_sqe(queue, ctx);
 	if (!sqe) {
 		return -EAGAIN;
 	}
 
-	sqe->flags = queue->poll_sq ? IOSQE_FIXED_FILE : 0;
-
 	// NOTE: we only ever register a single file, the raw device, so the
 	// provided index will always be 0
-	fd = queue->poll_sq ? 0 : state->fd;
+	fd = queue->fixed_file ? 0 : state->fd;
 
 	switch (ctx->cmd.common.opcode) {
 	case XNVME_SPEC_NVM_OPC_WRITE:
@@ -375,7 +807,10 @@ xnvme_be_linux_liburing_cmd_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, s
 		return -ENOSYS;
 	}
 
+	// Assigned after io_uring_prep_{readv,writev}() as these reset the flags
+	sqe->flags = queue->fixed_file ? IOSQE_FIXED_FILE : 0;
 	io_uring_sqe_set_data(sqe, ctx);
+	xnvme_be_linux_liburing_link_timeout(queue, sqe, ctx);
 
 	if (queue->batching) {
 		goto exit;
@@ -400,10 +835,11 @@ struct xnvme_be_async g_xnvme_be_linux_async_liburing = {
 	.cmd_io = xnvme_be_linux_liburing_cmd_io,
 	.cmd_iov = xnvme_be_linux_liburing_cmd_iov,
 	.poke = xnvme_be_linux_liburing_poke,
-	.wait = xnvme_be_nosys_queue_wait,
+	.wait = xnvme_be_linux_liburing_wait,
 	.init = xnvme_be_linux_liburing_init,
 	.term = xnvme_be_linux_liburing_term,
-	.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd,
+	.get_completion_fd = xnvme_be_linux_liburing_get_completion_fd,
+	.cancel = xnvme_be_linux_liburing_cancel,
 #else
 	.cmd_io = xnvme_be_nosys_queue_cmd_io,
 	.cmd_iov = xnvme_be_nosys_queue_cmd_iov,
@@ -412,5 +848,6 @@ struct xnvme_be_async g_xnvme_be_linux_async_liburing = {
 	.init = xnvme_be_nosys_queue_init,
 	.term = xnvme_be_nosys_queue_term,
 	.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd,
+	.cancel = xnvme_be_nosys_queue_cancel,
 #endif
 };
@@ -65,10 +65,9 @@ int
 xnvme_be_linux_ucmd_poke(struct xnvme_queue *q, uint32_t max)
 {
 	struct xnvme_queue_liburing *queue = (void *)q;
-	struct io_uring_cqe *cqe;
-	struct xnvme_cmd_ctx *ctx;
+	struct io_uring_cqe *cqes[XNVME_QUEUE_IOU_CQE_BATCH_MAX];
+	struct xnvme_cmd_ctx *ctxs[XNVME_QUEUE_IOU_CQE_BATCH_MAX];
 	unsigned completed;
-	int err;
 
 	max = max ? max : queue->base.outstanding;
 	max = max > queue->base.outstanding ? queue->base.outstanding : max;
@@ -82,43 +81,64 @@ xnvme_be_linux_ucmd_poke(struct xnvme_queue *q, uint32_t max)
 	}
 
 	completed = 0;
-	for (uint32_t i = 0; i < max; i++) {
-		err = io_uring_peek_cqe(&queue->ring, &cqe);
-		if (err == -EAGAIN) {
-			return completed;
+	while (completed < max) {
+		unsigned nreap = XNVME_MIN(max - completed, XNVME_QUEUE_IOU_CQE_BATCH_MAX);
+		unsigned ncqes, nctxs;
+
+		ncqes = io_uring_peek_batch_cqe(&queue->ring, cqes, nreap);
+		if (!ncqes) {
+			break;
 		}
 
-		ctx = io_uring_cqe_get_data(cqe);
+		nctxs = 0;
+		for (unsigned i = 0; i < ncqes; ++i) {
+			struct io_uring_cqe *cqe = cqes[i];
+			struct xnvme_cmd_ctx *ctx = io_uring_cqe_get_data(cqe);
+			int err;
+
+			// Linked timeouts and cancellations complete without a command-context, as
+			// does the internal timeout of a timed wait without IORING_FEAT_EXT_ARG
+			if (!ctx || (cqe->user_data == LIBURING_UDATA_TIMEOUT)) {
+				continue;
+			}
 
-#ifdef XNVME_DEBUG_ENABLED
-		if (!ctx) {
-			XNVME_DEBUG("-{[THIS SHOULD NOT HAPPEN]}-");
-			XNVME_DEBUG("cqe->user_data is NULL! => NO REQ!");
-			XNVME_DEBUG("cqe->res: %d", cqe->res);
-			XNVME_DEBUG("cqe->flags: %u", cqe->flags);
-			return -EIO;
+			ctx->cpl.result = cqe->big_cqe[0];
+
+			/** IO64-quirky-handling: this is also for NVME_URING_CMD_IO_VEC */
+			err = xnvme_be_linux_nvme_map_cpl(ctx, NVME_URING_CMD_IO, cqe->res);
+			if (err) {
+				XNVME_DEBUG("FAILED: xnvme_be_linux_nvme_map_cpl(), err: %d", err);
+				return err;
+			}
+
+			ctxs[nctxs++] = ctx;
 		}
-#endif
 
-		ctx->cpl.result = cqe->big_cqe[0];
+		// See xnvme_be_linux_liburing_poke() on advancing prior to callback-invocation
+		io_uring_cq_advance(&queue->ring, ncqes);
+		queue->base.outstanding -= nctxs;
 
-		/** IO64-quirky-handling: this is also for NVME_URING_CMD_IO_VEC */
-		err = xnvme_be_linux_nvme_map_cpl(ctx, NVME_URING_CMD_IO, cqe->res);
-		if (err) {
-			XNVME_DEBUG("FAILED: xnvme_be_linux_nvme_map_cpl(), err: %d", err);
-			return err;
+		for (unsigned i = 0; i < nctxs; ++i) {
+			ctxs[i]->async.cb(ctxs[i], ctxs[i]->async.cb_arg);
 		}
 
-		queue->base.outstanding--;
+		completed += nctxs;
+	}
 
-		io_uring_cqe_seen(&queue->ring, cqe);
+	return completed;
+}
 
-		ctx->async.cb(ctx, ctx->async.cb_arg);
+int
+xnvme_be_linux_ucmd_wait(struct xnvme_queue *q, uint32_t min, uint64_t timeout_ns)
+{
+	int err;
 
-		completed++;
+	err = xnvme_be_linux_liburing_wait_cqes(q, min, timeout_ns);
+	if (err) {
+		return err;
 	}
 
-	return completed;
+	return xnvme_be_linux_ucmd_poke(q, 0);
 }
 
 #else
@@ -128,6 +148,13 @@ xnvme_be_linux_ucmd_poke(struct xnvme_queue *q, uint32_t max)
 	XNVME_DEBUG("FAILED: not supported, built on system without NVME_URING_CMD_IO");
 	return xnvme_be_nosys_queue_poke(q, max);
 }
+
+int
+xnvme_be_linux_ucmd_wait(struct xnvme_queue *q, uint32_t min, uint64_t timeout_ns)
+{
+	XNVME_DEBUG("FAILED: not supported, built on system without NVME_URING_CMD_IO");
+	return xnvme_be_nosys_queue_wait(q, min, timeout_ns);
+}
 #endif
 
 #ifdef NVME_URING_CMD_IO
@@ -140,17 +167,17 @@ xnvme_be_linux_ucmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes
 	struct io_uring_sqe *sqe = NULL;
 	int err = 0;
 
-	sqe = io_uring_get_sqe(&queue->ring);
+	sqe = xnvme_be_linux_liburing_get_sqe(queue, ctx);
 	if (!sqe) {
 		return -EAGAIN;
 	}
 
 	sqe->opcode = IORING_OP_URING_CMD;
 	sqe->off = NVME_URING_CMD_IO;
-	sqe->flags = queue->poll_sq ? IOSQE_FIXED_FILE : 0;
+	sqe->flags = queue->fixed_file ? IOSQE_FIXED_FILE : 0;
 	// NOTE: we only ever register a single file, the raw device, so the
 	// provided index will always be 0
-	sqe->fd = queue->poll_sq ? 0 : state->fd;
+	sqe->fd = queue->fixed_file ? 0 : state->fd;
 	sqe->user_data = (unsigned long)ctx;
 
 	ctx->cmd.common.dptr.lnx_ioctl.data = (uint64_t)dbuf;
@@ -160,6 +187,7 @@ xnvme_be_linux_ucmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes
 	ctx->cmd.common.dptr.lnx_ioctl.metadata_len = mbuf_nbytes;
 
 	memcpy(&sqe->addr3, &ctx->cmd.common, 64);
+	xnvme_be_linux_liburing_link_timeout(queue, sqe, ctx);
 
 	if (queue->batching) {
 		goto exit;
@@ -196,17 +224,17 @@ xnvme_be_linux_ucmd_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, size_t dv
 	struct io_uring_sqe *sqe = NULL;
 	int err = 0;
 
-	sqe = io_uring_get_sqe(&queue->ring);
+	sqe = xnvme_be_linux_liburing_get_sqe(queue, ctx);
 	if (!sqe) {
 		return -EAGAIN;
 	}
 
 	sqe->opcode = IORING_OP_URING_CMD;
 	sqe->off = NVME_URING_CMD_IO_VEC;
-	sqe->flags = queue->poll_sq ? IOSQE_FIXED_FILE : 0;
+	sqe->flags = queue->fixed_file ? IOSQE_FIXED_FILE : 0;
 	// NOTE: we only ever register a single file, the raw device, so the
 	// provided index will always be 0
-	sqe->fd = queue->poll_sq ? 0 : state->fd;
+	sqe->fd = queue->fixed_file ? 0 : state->fd;
 	sqe->user_data = (unsigned long)ctx;
 
 	ctx->cmd.common.dptr.lnx_ioctl.data = (uint64_t)dvec;
@@ -216,6 +244,7 @@ xnvme_be_linux_ucmd_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, size_t dv
 	ctx->cmd.common.dptr.lnx_ioctl.metadata_len = mbuf_nbytes;
 
 	memcpy(&sqe->addr3, &ctx->cmd.common, 64);
+	xnvme_be_linux_liburing_link_timeout(queue, sqe, ctx);
 
 	if (queue->batching) {
 		goto exit;
@@ -249,10 +278,11 @@ struct xnvme_be_async g_xnvme_be_linux_async_ucmd = {
 	.cmd_io = xnvme_be_linux_ucmd_io,
 	.cmd_iov = xnvme_be_linux_ucmd_iov,
 	.poke = xnvme_be_linux_ucmd_poke,
-	.wait = xnvme_be_nosys_queue_wait,
+	.wait = xnvme_be_linux_ucmd_wait,
 	.init = xnvme_be_linux_ucmd_init,
 	.term = xnvme_be_linux_liburing_term,
-	.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd,
+	.get_completion_fd = xnvme_be_linux_liburing_get_completion_fd,
+	.cancel = xnvme_be_linux_liburing_cancel,
 #else
 	.cmd_io = xnvme_be_nosys_queue_cmd_io,
 	.cmd_iov = xnvme_be_nosys_queue_cmd_iov,
@@ -261,5 +291,6 @@ struct xnvme_be_async g_xnvme_be_linux_async_ucmd = {
 	.init = xnvme_be_nosys_queue_init,
 	.term = xnvme_be_nosys_queue_term,
 	.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd,
+	.cancel = xnvme_be_nosys_queue_cancel,
 #endif
 };
@@ -13,10 +13,12 @@
 #include <dirent.h>
 #include <paths.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <sys/sysmacros.h>
 #include <linux/fs.h>
 #include <linux/version.h>
 #include <xnvme_dev.h>
@@ -35,6 +37,55 @@ _be_linux_state_term(struct xnvme_be_linux_state *state)
 	state->fd = 0;
 }
 
+/**
+ * Returns the NUMA node of the device backing the given file, or -1 when it is unknown
+ *
+ * The sysfs directory of the device is found via its device-number, for a regular file that of the
+ * block device holding it. From there the hierarchy is walked towards the root, until a parent,
+ * usually the PCIe function of the controller, has a 'numa_node' attribute.
+ */
+static int
+_linux_numa_node(const struct stat *dev_stat)
+{
+	char path[PATH_MAX] = {0};
+	char sysfs[PATH_MAX];
+	bool is_chr = S_ISCHR(dev_stat->st_mode);
+	bool is_dev = is_chr || S_ISBLK(dev_stat->st_mode);
+	dev_t devno = is_dev ? dev_stat->st_rdev : dev_stat->st_dev;
+
+	snprintf(sysfs, sizeof(sysfs), "/sys/dev/%s/%u:%u", is_chr ? "char" : "block",
+		 major(devno), minor(devno));
+	if (!realpath(sysfs, path)) {
+		XNVME_DEBUG("INFO: realpath(%s), errno: %d", sysfs, errno);
+		return -1;
+	}
+
+	while (strlen(path) > strlen("/sys/devices")) {
+		char *sep;
+		FILE *fp;
+		int node;
+
+		if (snprintf(sysfs, sizeof(sysfs), "%s/numa_node", path) < (int)sizeof(sysfs) &&
+		    (fp = fopen(sysfs, "r"))) {
+			if (fscanf(fp, "%d", &node) != 1) {
+				node = -1;
+			}
+			fclose(fp);
+
+			XNVME_DEBUG("INFO: %s: %d", sysfs, node);
+			return node;
+		}
+
+		sep = strrchr(path, '/');
+		if (!sep) {
+			break;
+		}
+		*sep = '\0';
+	}
+
+	return -1;
+}
+
 int
 xnvme_be_linux_dev_open(struct xnvme_dev *dev)
 {
@@ -165,7 +216,15 @@ xnvme_be_linux_dev_open(struct xnvme_dev *dev)
 
 	state->poll_io = opts->poll_io;
 	state->poll_sq = opts->poll_sq;
+	state->defer_taskrun = opts->defer_taskrun;
+	state->coop_taskrun = opts->coop_taskrun;
+	state->submit_all = opts->submit_all;
+	state->register_ring_fd = opts->register_ring_fd;
+	state->register_files = opts->register_files;
+
+	dev->numa_node = _linux_numa_node(&dev_stat);
 
+	XNVME_DEBUG("INFO: open() : dev->numa_node: %d", dev->numa_node);
 	XNVME_DEBUG("INFO: open() : dev->state.poll_io: %d", state->poll_io);
 	XNVME_DEBUG("INFO: open() : dev->state.poll_sq: %d", state->poll_sq);
 
@@ -6,26 +6,80 @@
 #include <xnvme_be_nosys.h>
 #ifdef XNVME_BE_LINUX_ENABLED
 #include <xnvme_dev.h>
+#include <xnvme_numa.h>
 #include <errno.h>
 
 #include <fcntl.h>
+#include <pthread.h>
 #include <sys/mman.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <sys/queue.h>
 #include <linux/limits.h>
 
-struct huge_alloc {
-	char path[PATH_MAX];
-	int fd;
-	void *addr;
-	size_t len;
+/**
+ * Buffers are sub-allocated from arenas, hugetlbfs files which are mapped once and never unmapped.
+ * An arena is split into chunks of the size of a hugepage, and a chunk is either free, a slab of
+ * equally sized blocks of a size-class, or part of a run of chunks backing a single large buffer.
+ *
+ * The size-classes are the powers of two from HUGE_CLS_MIN_NBYTES up to half a chunk, a block is
+ * thus aligned to its size, larger buffers are backed by a run of whole chunks. The chunk of a
+ * buffer is found via a hash-table on the chunk-number, that is, the address shifted by the
+ * hugepage-size, such that free and realloc are constant-time.
+ */
+#define HUGE_CLS_MIN_SHIFT 12
+#define HUGE_CLS_NMAX      20
+#define HUGE_ARENA_NCHUNKS 16 ///< Chunks per arena, unless a large buffer needs more
+
+enum huge_chunk_state {
+	HUGE_CHUNK_FREE  = 0,
+	HUGE_CHUNK_SLAB  = 1,
+	HUGE_CHUNK_LARGE = 2, ///< The first chunk of a run backing a large buffer
+	HUGE_CHUNK_TAIL  = 3, ///< The remaining chunks of a run
+};
+
+struct huge_chunk {
+	uint8_t *addr;
+	struct huge_arena *arena;
+	uint32_t idx;     ///< Index of the chunk in its arena
+	uint32_t state;   ///< One of enum huge_chunk_state
+	uint32_t cls;     ///< Size-class of the slab
+	uint32_t nused;   ///< Number of allocated blocks in the slab
+	uint32_t nchunks; ///< Length of the run, for HUGE_CHUNK_LARGE
+	size_t bump;      ///< Offset of the first block in the slab which has never been allocated
+	void *free;       ///< Free-list of the slab, linked through the freed blocks
+
+	TAILQ_ENTRY(huge_chunk) link; ///< In the free chunks, or the partial slabs of a size-class
+};
+
+struct huge_arena {
+	uint8_t *addr;
+	uint32_t nchunks;
+
+	SLIST_ENTRY(huge_arena) link;
 
-	SLIST_ENTRY(huge_alloc) link;
+	struct huge_chunk chunks[];
 };
 
-SLIST_HEAD(huge_alloc_slist, huge_alloc);
-static struct huge_alloc_slist huge_alloc_head;
+TAILQ_HEAD(huge_chunk_tailq, huge_chunk);
+
+static struct {
+	pthread_mutex_t mutex;
+
+	char path[PATH_MAX];
+	size_t chunk_nbytes; ///< Hugepage size, 0 until setup
+	uint32_t chunk_shift;
+	uint32_t ncls;
+
+	struct huge_chunk_tailq partial[HUGE_CLS_NMAX]; ///< Slabs with a free block, by size-class
+	struct huge_chunk_tailq free;
+
+	SLIST_HEAD(, huge_arena) arenas;
+
+	struct huge_chunk **map; ///< Open-addressing hash-table of chunks by chunk-number
+	size_t map_nslots;       ///< Power of two, at least twice the number of chunks
+	size_t map_nchunks;
+} g_huge = {.mutex = PTHREAD_MUTEX_INITIALIZER};
 
 static size_t
 get_hugepage_size()
@@ -35,6 +89,10 @@ get_hugepage_size()
 	size_t hugepage_size = 0;
 
 	fp = fopen("/proc/meminfo", "r");
+	if (!fp) {
+		XNVME_DEBUG("FAILED: fopen(/proc/meminfo), errno: %d", errno);
+		return 0;
+	}
 
 	while (fgets(line, 128, fp)) {
 		if (sscanf(line, "Hugepagesize: %16lu kB", &hugepage_size)) {
@@ -57,6 +115,9 @@ verify_hugetlbfs_path(char *path)
 	FILE *fp;
 
 	fp = fopen("/proc/mounts", "r");
+	if (!fp) {
+		return 0;
+	}
 
 	strncpy(search_str, path, sizeof(search_str) - 1);
 	search_str[PATH_MAX - 1] = '\0';
@@ -72,70 +133,432 @@ verify_hugetlbfs_path(char *path)
 	return 0;
 }
 
-void *
-xnvme_be_linux_mem_hugepage_buf_alloc(const struct xnvme_dev *XNVME_UNUSED(dev), size_t nbytes,
-				      uint64_t *XNVME_UNUSED(phys))
+/**
+ * Setup the allocator on first use; must be called with the mutex held
+ */
+static int
+_huge_setup(void)
 {
-	void *buf;
-	int hugepage_fd;
-	struct huge_alloc *entry;
-	size_t hugepage_size;
 	char *env_hugepage_path;
-	char hugepage_path[PATH_MAX] = {'\0'};
+	size_t hugepage_size;
+
+	if (g_huge.chunk_nbytes) {
+		return 0;
+	}
 
 	env_hugepage_path = getenv("XNVME_HUGETLB_PATH");
 	if (env_hugepage_path == NULL) {
 		XNVME_DEBUG("ERROR: XNVME_HUGETLB_PATH env var not defined");
-		errno = ENOMEM;
-		return NULL;
+		return -ENOMEM;
 	}
 
-	strncpy(hugepage_path, env_hugepage_path, sizeof(hugepage_path) - 1);
+	strncpy(g_huge.path, env_hugepage_path, sizeof(g_huge.path) - 1);
 
-	if (!verify_hugetlbfs_path(hugepage_path)) {
-		XNVME_DEBUG("WARNING: Hugetlbfs is not mounted at: %s", hugepage_path);
+	if (!verify_hugetlbfs_path(g_huge.path)) {
+		XNVME_DEBUG("WARNING: Hugetlbfs is not mounted at: %s", g_huge.path);
 	}
 
 	hugepage_size = get_hugepage_size();
-	if (!hugepage_size) {
+	if (!hugepage_size || (hugepage_size & (hugepage_size - 1)) ||
+	    (hugepage_size < (2ULL << HUGE_CLS_MIN_SHIFT))) {
 		XNVME_DEBUG("Hugepage size not valid: %lu", hugepage_size);
-		errno = ENOMEM;
+		return -ENOMEM;
+	}
+
+	g_huge.chunk_shift = __builtin_ctzll(hugepage_size);
+	g_huge.ncls = g_huge.chunk_shift - HUGE_CLS_MIN_SHIFT;
+	if (g_huge.ncls > HUGE_CLS_NMAX) {
+		g_huge.ncls = HUGE_CLS_NMAX;
+	}
+	for (uint32_t cls = 0; cls < HUGE_CLS_NMAX; ++cls) {
+		TAILQ_INIT(&g_huge.partial[cls]);
+	}
+	TAILQ_INIT(&g_huge.free);
+	SLIST_INIT(&g_huge.arenas);
+
+	g_huge.chunk_nbytes = hugepage_size;
+
+	return 0;
+}
+
+static inline size_t
+_huge_map_slot(uintptr_t chunkno)
+{
+	return (size_t)((chunkno * 0x9E3779B97F4A7C15ULL) >> 20) & (g_huge.map_nslots - 1);
+}
+
+static void
+_huge_map_insert(struct huge_chunk **map, struct huge_chunk *chunk)
+{
+	size_t slot = _huge_map_slot((uintptr_t)chunk->addr >> g_huge.chunk_shift);
+
+	while (map[slot]) {
+		slot = (slot + 1) & (g_huge.map_nslots - 1);
+	}
+	map[slot] = chunk;
+}
+
+static struct huge_chunk *
+_huge_map_lookup(const void *buf)
+{
+	uintptr_t chunkno = (uintptr_t)buf >> g_huge.chunk_shift;
+
+	if (!g_huge.map_nslots) {
 		return NULL;
 	}
 
-	// nbytes has to be a multiple of alignment. Therefore, we round up to the nearest
-	// multiple.
-	nbytes = (1 + ((nbytes - 1) / hugepage_size)) * (hugepage_size);
+	for (size_t slot = _huge_map_slot(chunkno);; slot = (slot + 1) & (g_huge.map_nslots - 1)) {
+		struct huge_chunk *chunk = g_huge.map[slot];
 
-	// Map a Huge page
-	strncat(hugepage_path, "/xnvme_XXXXXX", sizeof(hugepage_path) - strlen(hugepage_path) - 1);
-	hugepage_fd = mkstemp(hugepage_path);
-	if (hugepage_fd == -1) {
-		XNVME_DEBUG("Failed to open hugepage file. %s", hugepage_path);
-		errno = ENOMEM;
+		if (!chunk) {
+			return NULL;
+		}
+		if (((uintptr_t)chunk->addr >> g_huge.chunk_shift) == chunkno) {
+			return chunk;
+		}
+	}
+}
+
+/**
+ * Make room in the hash-table for 'nchunks' more chunks, re-hashing into a larger table if needed
+ */
+static int
+_huge_map_reserve(size_t nchunks)
+{
+	struct huge_chunk **map;
+	struct huge_arena *arena;
+	size_t nslots = g_huge.map_nslots ? g_huge.map_nslots : 64;
+
+	while (nslots < 2 * (g_huge.map_nchunks + nchunks)) {
+		nslots <<= 1;
+	}
+	if (nslots == g_huge.map_nslots) {
+		return 0;
+	}
+
+	map = calloc(nslots, sizeof(*map));
+	if (!map) {
+		XNVME_DEBUG("FAILED: calloc(map)");
+		return -ENOMEM;
+	}
+
+	free(g_huge.map);
+	g_huge.map = map;
+	g_huge.map_nslots = nslots;
+
+	SLIST_FOREACH(arena, &g_huge.arenas, link) {
+		for (uint32_t i = 0; i < arena->nchunks; ++i) {
+			_huge_map_insert(g_huge.map, &arena->chunks[i]);
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Map an arena of 'nchunks' hugepages, the file backing it is removed right away, as the mapping
+ * keeps the hugepages. The arena is placed at a hugepage-aligned address, which hugetlbfs does by
+ * itself, this ensures it regardless of the filesystem.
+ */
+static struct huge_arena *
+_huge_arena_map(uint32_t nchunks)
+{
+	size_t nbytes = (size_t)nchunks << g_huge.chunk_shift;
+	char path[PATH_MAX] = {'\0'};
+	struct huge_arena *arena;
+	uint8_t *rsvd, *addr;
+	size_t head;
+	int fd;
+
+	if (_huge_map_reserve(nchunks)) {
+		return NULL;
+	}
+
+	arena = calloc(1, sizeof(*arena) + nchunks * sizeof(*arena->chunks));
+	if (!arena) {
+		XNVME_DEBUG("FAILED: calloc(arena)");
 		return NULL;
 	}
 
-	if (ftruncate(hugepage_fd, nbytes)) {
-		XNVME_DEBUG("Failed to truncate hugepage file. %s, %lu", hugepage_path, nbytes);
-		perror("hugetlb ftruncate()");
+	if (snprintf(path, sizeof(path), "%s/xnvme_XXXXXX", g_huge.path) >= (int)sizeof(path)) {
+		XNVME_DEBUG("FAILED: path too long: %s", g_huge.path);
+		free(arena);
 		return NULL;
 	}
+	fd = mkstemp(path);
+	if (fd == -1) {
+		XNVME_DEBUG("Failed to open hugepage file. %s", path);
+		free(arena);
+		return NULL;
+	}
+
+	if (ftruncate(fd, nbytes)) {
+		XNVME_DEBUG("Failed to truncate hugepage file. %s, %lu", path, nbytes);
+		goto failed;
+	}
+
+	rsvd = mmap(NULL, nbytes + g_huge.chunk_nbytes, PROT_NONE,
+		    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (rsvd == MAP_FAILED) {
+		XNVME_DEBUG("FAILED: mmap(rsvd), errno: %d", errno);
+		goto failed;
+	}
+	head = (g_huge.chunk_nbytes - ((uintptr_t)rsvd & (g_huge.chunk_nbytes - 1))) &
+	       (g_huge.chunk_nbytes - 1);
 
-	buf = mmap(NULL, nbytes, PROT_READ | PROT_WRITE, MAP_SHARED, hugepage_fd, 0);
-	if (buf == MAP_FAILED) {
+	addr = mmap(rsvd + head, nbytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+	if (addr == MAP_FAILED) {
 		XNVME_DEBUG("mmap failed on hugepage file");
+		munmap(rsvd, nbytes + g_huge.chunk_nbytes);
+		goto failed;
+	}
+	if (head) {
+		munmap(rsvd, head);
+	}
+	munmap(addr + nbytes, g_huge.chunk_nbytes - head);
+
+	close(fd);
+	unlink(path);
+
+	arena->addr = addr;
+	arena->nchunks = nchunks;
+	SLIST_INSERT_HEAD(&g_huge.arenas, arena, link);
+
+	for (uint32_t i = 0; i < nchunks; ++i) {
+		struct huge_chunk *chunk = &arena->chunks[i];
+
+		chunk->addr = addr + ((size_t)i << g_huge.chunk_shift);
+		chunk->arena = arena;
+		chunk->idx = i;
+		chunk->state = HUGE_CHUNK_FREE;
+
+		TAILQ_INSERT_TAIL(&g_huge.free, chunk, link);
+		_huge_map_insert(g_huge.map, chunk);
+	}
+	g_huge.map_nchunks += nchunks;
+
+	return arena;
+
+failed:
+	close(fd);
+	unlink(path);
+	free(arena);
+
+	return NULL;
+}
+
+/**
+ * Find a run of 'nchunks' free chunks in the given arena
+ */
+static struct huge_chunk *
+_huge_arena_find_run(struct huge_arena *arena, uint32_t nchunks)
+{
+	uint32_t run = 0;
+
+	for (uint32_t i = 0; i < arena->nchunks; ++i) {
+		run = (arena->chunks[i].state == HUGE_CHUNK_FREE) ? run + 1 : 0;
+		if (run == nchunks) {
+			return &arena->chunks[i + 1 - nchunks];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Take a run of 'nchunks' free chunks, mapping another arena when none is available, and prefer
+ * the given NUMA node for the hugepages of the run which are not yet faulted in
+ */
+static struct huge_chunk *
+_huge_chunks_get(uint32_t nchunks, int node)
+{
+	struct huge_chunk *first = NULL;
+	struct huge_arena *arena;
+
+	if (nchunks == 1) {
+		first = TAILQ_FIRST(&g_huge.free);
+	} else {
+		SLIST_FOREACH(arena, &g_huge.arenas, link) {
+			first = _huge_arena_find_run(arena, nchunks);
+			if (first) {
+				break;
+			}
+		}
+	}
+
+	if (!first) {
+		arena = _huge_arena_map(nchunks > HUGE_ARENA_NCHUNKS ? nchunks
+								     : HUGE_ARENA_NCHUNKS);
+		if (!arena) {
+			return NULL;
+		}
+		first = &arena->chunks[0];
+	}
+
+	for (uint32_t i = 0; i < nchunks; ++i) {
+		struct huge_chunk *chunk = first + i;
+
+		TAILQ_REMOVE(&g_huge.free, chunk, link);
+		chunk->state = HUGE_CHUNK_TAIL;
+	}
+
+	if (node >= 0) {
+		xnvme_numa_bind_mem(first->addr, (size_t)nchunks << g_huge.chunk_shift, node);
+	}
+
+	return first;
+}
+
+static void
+_huge_chunks_put(struct huge_chunk *first, uint32_t nchunks)
+{
+	for (uint32_t i = 0; i < nchunks; ++i) {
+		struct huge_chunk *chunk = first + i;
+
+		chunk->state = HUGE_CHUNK_FREE;
+		TAILQ_INSERT_HEAD(&g_huge.free, chunk, link);
+	}
+}
+
+static inline size_t
+_huge_cls_nbytes(uint32_t cls)
+{
+	return (size_t)1 << (cls + HUGE_CLS_MIN_SHIFT);
+}
+
+static inline bool
+_huge_slab_is_full(struct huge_chunk *chunk)
+{
+	return !chunk->free && (chunk->bump == g_huge.chunk_nbytes);
+}
+
+static void *
+_huge_slab_alloc(uint32_t cls, int node)
+{
+	struct huge_chunk *chunk = TAILQ_FIRST(&g_huge.partial[cls]);
+	void *buf;
+
+	if (!chunk) {
+		chunk = _huge_chunks_get(1, node);
+		if (!chunk) {
+			return NULL;
+		}
+		chunk->state = HUGE_CHUNK_SLAB;
+		chunk->cls = cls;
+		chunk->nused = 0;
+		chunk->bump = 0;
+		chunk->free = NULL;
+		TAILQ_INSERT_HEAD(&g_huge.partial[cls], chunk, link);
+	}
+
+	if (chunk->free) {
+		buf = chunk->free;
+		chunk->free = *(void **)buf;
+	} else {
+		buf = chunk->addr + chunk->bump;
+		chunk->bump += _huge_cls_nbytes(cls);
+	}
+	chunk->nused += 1;
+
+	if (_huge_slab_is_full(chunk)) {
+		TAILQ_REMOVE(&g_huge.partial[cls], chunk, link);
+	}
+
+	return buf;
+}
+
+static void
+_huge_slab_free(struct huge_chunk *chunk, void *buf)
+{
+	bool was_full = _huge_slab_is_full(chunk);
+
+	*(void **)buf = chunk->free;
+	chunk->free = buf;
+	chunk->nused -= 1;
+
+	if (!chunk->nused) {
+		TAILQ_REMOVE(&g_huge.partial[chunk->cls], chunk, link);
+		_huge_chunks_put(chunk, 1);
+	} else if (was_full) {
+		TAILQ_INSERT_HEAD(&g_huge.partial[chunk->cls], chunk, link);
+	}
+}
+
+/**
+ * Lookup the chunk of a buffer returned by the allocator, NULL when it is not one
+ */
+static struct huge_chunk *
+_huge_buf_chunk(void *buf)
+{
+	struct huge_chunk *chunk = _huge_map_lookup(buf);
+
+	if (!chunk) {
+		return NULL;
+	}
+
+	switch (chunk->state) {
+	case HUGE_CHUNK_SLAB:
+		if (((uint8_t *)buf - chunk->addr) & (_huge_cls_nbytes(chunk->cls) - 1)) {
+			return NULL;
+		}
+		return chunk;
+	case HUGE_CHUNK_LARGE:
+		return ((uint8_t *)buf == chunk->addr) ? chunk : NULL;
+	default:
 		return NULL;
 	}
+}
+
+/**
+ * Usable size of the buffer, that is, the size of its block or run
+ */
+static size_t
+_huge_buf_nbytes(struct huge_chunk *chunk)
+{
+	if (chunk->state == HUGE_CHUNK_SLAB) {
+		return _huge_cls_nbytes(chunk->cls);
+	}
+
+	return (size_t)chunk->nchunks << g_huge.chunk_shift;
+}
+
+void *
+xnvme_be_linux_mem_hugepage_buf_alloc(const struct xnvme_dev *dev, size_t nbytes,
+				      uint64_t *XNVME_UNUSED(phys))
+{
+	int node = dev ? dev->numa_node : -1;
+	void *buf = NULL;
+
+	pthread_mutex_lock(&g_huge.mutex);
+
+	if (_huge_setup()) {
+		goto exit;
+	}
+
+	if (nbytes <= _huge_cls_nbytes(g_huge.ncls - 1)) {
+		uint32_t cls = 0;
+
+		if (nbytes > _huge_cls_nbytes(0)) {
+			cls = (64 - __builtin_clzll(nbytes - 1)) - HUGE_CLS_MIN_SHIFT;
+		}
+		buf = _huge_slab_alloc(cls, node);
+	} else {
+		uint32_t nchunks = (nbytes + g_huge.chunk_nbytes - 1) >> g_huge.chunk_shift;
+		struct huge_chunk *chunk = _huge_chunks_get(nchunks, node);
+
+		if (chunk) {
+			chunk->state = HUGE_CHUNK_LARGE;
+			chunk->nchunks = nchunks;
+			buf = chunk->addr;
+		}
+	}
+
+exit:
+	pthread_mutex_unlock(&g_huge.mutex);
 
-	// Appending allocated hugepage to linked-list for use during free
-	entry = malloc(sizeof(struct huge_alloc));
-	entry->fd = hugepage_fd;
-	strncpy(entry->path, hugepage_path, sizeof(entry->path) - 1);
-	entry->path[sizeof(entry->path) - 1] = '\0';
-	entry->addr = buf;
-	entry->len = nbytes;
-	SLIST_INSERT_HEAD(&huge_alloc_head, entry, link);
+	if (!buf) {
+		errno = ENOMEM;
+	}
 
 	return buf;
 }
@@ -143,31 +566,64 @@ xnvme_be_linux_mem_hugepage_buf_alloc(const struct xnvme_dev *XNVME_UNUSED(dev),
 void
 xnvme_be_linux_mem_hugepage_buf_free(const struct xnvme_dev *XNVME_UNUSED(dev), void *buf)
 {
-	struct huge_alloc *entry;
+	struct huge_chunk *chunk;
 
 	if (!buf) {
 		return;
 	}
 
-	// Iterate through linked-list to find the entry from *buf
-	entry = SLIST_FIRST(&huge_alloc_head);
-	while (entry != NULL) {
-		if (entry->addr == buf) {
-			break;
-		}
-		entry = SLIST_NEXT(entry, link);
+	pthread_mutex_lock(&g_huge.mutex);
+
+	chunk = _huge_buf_chunk(buf);
+	if (!chunk) {
+		XNVME_DEBUG("FAILED: buf: %p, not allocated by hugepage", buf);
+	} else if (chunk->state == HUGE_CHUNK_SLAB) {
+		_huge_slab_free(chunk, buf);
+	} else {
+		_huge_chunks_put(chunk, chunk->nchunks);
+	}
+
+	pthread_mutex_unlock(&g_huge.mutex);
+}
+
+void *
+xnvme_be_linux_mem_hugepage_buf_realloc(const struct xnvme_dev *dev, void *buf, size_t nbytes,
+					uint64_t *phys)
+{
+	struct huge_chunk *chunk;
+	size_t buf_nbytes = 0;
+	void *new_buf;
+
+	if (!buf) {
+		return xnvme_be_linux_mem_hugepage_buf_alloc(dev, nbytes, phys);
+	}
+
+	pthread_mutex_lock(&g_huge.mutex);
+	chunk = _huge_buf_chunk(buf);
+	if (chunk) {
+		buf_nbytes = _huge_buf_nbytes(chunk);
+	}
+	pthread_mutex_unlock(&g_huge.mutex);
+
+	if (!chunk) {
+		XNVME_DEBUG("FAILED: buf: %p, not allocated by hugepage", buf);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	// Shrinking, or growing within the block or run, is done in place
+	if (nbytes <= buf_nbytes) {
+		return buf;
 	}
 
-	if (!entry) {
-		XNVME_DEBUG("huge_alloc_table_reset: Entry %p not found!", buf);
+	new_buf = xnvme_be_linux_mem_hugepage_buf_alloc(dev, nbytes, phys);
+	if (!new_buf) {
+		return NULL;
 	}
+	memcpy(new_buf, buf, buf_nbytes);
+	xnvme_be_linux_mem_hugepage_buf_free(dev, buf);
 
-	// Clean up all the files, buffers etc. for the hugepage
-	munmap(buf, entry->len);
-	close(entry->fd);
-	remove(entry->path);
-	SLIST_REMOVE(&huge_alloc_head, entry, huge_alloc, link);
-	free(entry);
+	return new_buf;
 }
 
 #endif
@@ -176,7 +632,7 @@ struct xnvme_be_mem g_xnvme_be_linux_mem_hugepage = {
 	.id = "hugepage",
 #ifdef XNVME_BE_LINUX_ENABLED
 	.buf_alloc = xnvme_be_linux_mem_hugepage_buf_alloc,
-	.buf_realloc = xnvme_be_nosys_buf_realloc,
+	.buf_realloc = xnvme_be_linux_mem_hugepage_buf_realloc,
 	.buf_free = xnvme_be_linux_mem_hugepage_buf_free,
 	.buf_vtophys = xnvme_be_nosys_buf_vtophys,
 	.mem_map = xnvme_be_nosys_mem_map,
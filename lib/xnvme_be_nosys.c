@@ -85,7 +85,8 @@ xnvme_be_nosys_queue_poke(struct xnvme_queue *XNVME_UNUSED(queue), uint32_t XNVM
 }
 
 int
-xnvme_be_nosys_queue_wait(struct xnvme_queue *XNVME_UNUSED(queue))
+xnvme_be_nosys_queue_wait(struct xnvme_queue *XNVME_UNUSED(queue), uint32_t XNVME_UNUSED(min),
+			  uint64_t XNVME_UNUSED(timeout_ns))
 {
 	XNVME_DEBUG("FAILED: not implemented(possibly intentional)");
 	return -ENOSYS;
@@ -112,6 +113,13 @@ xnvme_be_nosys_queue_get_completion_fd(struct xnvme_queue *XNVME_UNUSED(queue))
 	return -ENOSYS;
 }
 
+int
+xnvme_be_nosys_queue_cancel(struct xnvme_cmd_ctx *XNVME_UNUSED(ctx))
+{
+	XNVME_DEBUG("FAILED: not implemented(possibly intentional)");
+	return -ENOSYS;
+}
+
 void *
 xnvme_be_nosys_buf_alloc(const struct xnvme_dev *XNVME_UNUSED(dev), size_t XNVME_UNUSED(nbytes),
 			 uint64_t *XNVME_UNUSED(phys))
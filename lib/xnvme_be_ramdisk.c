@@ -34,6 +34,14 @@ static struct xnvme_be_mixin g_xnvme_be_mixin_ramdisk[] = {
 	},
 #endif
 
+	{
+		.mtype = XNVME_BE_ASYNC,
+		.name = "ramdisk",
+		.descr = "Use memory for Asynchronous I/O, processed inline at submission",
+		.async = &g_xnvme_be_ramdisk_async,
+		.check_support = xnvme_be_supported,
+	},
+
 	{
 		.mtype = XNVME_BE_ASYNC,
 		.name = "nil",
@@ -36,12 +36,9 @@ _idfy_ctrlr_iocs_fs(struct xnvme_dev *XNVME_UNUSED(dev), void *dbuf)
 static int
 _idfy_ns_iocs_fs(struct xnvme_dev *dev, void *dbuf)
 {
+	struct xnvme_be_ramdisk_state *state = (void *)dev->be.state;
 	struct xnvme_spec_fs_idfy_ns *ns = dbuf;
-
-	size_t ramdisk_size = xnvme_be_ramdisk_dev_get_size(dev);
-	if (!ramdisk_size) {
-		return -1;
-	}
+	size_t ramdisk_size = state->nbytes;
 
 	ns->nsze = ramdisk_size;
 	ns->ncap = ramdisk_size;
@@ -53,6 +50,35 @@ _idfy_ns_iocs_fs(struct xnvme_dev *dev, void *dbuf)
 	return 0;
 }
 
+static int
+_idfy_ctrlr_iocs_zoned(struct xnvme_dev *XNVME_UNUSED(dev), void *dbuf)
+{
+	struct xnvme_spec_znd_idfy_ctrlr *ctrlr = dbuf;
+
+	ctrlr->zasl = 0; ///< Append is limited by mdts only
+
+	return 0;
+}
+
+static int
+_idfy_ns_iocs_zoned(struct xnvme_dev *dev, void *dbuf)
+{
+	struct xnvme_be_ramdisk_state *state = (void *)dev->be.state;
+	struct xnvme_spec_znd_idfy_ns *ns = dbuf;
+
+	ns->zoc.val = 0;
+	ns->ozcs.val = 0;
+
+	// Both are 0's based values, where all bits set means no limit
+	ns->mar = state->znd->mar ? state->znd->mar - 1 : 0xFFFFFFFF;
+	ns->mor = state->znd->mor ? state->znd->mor - 1 : 0xFFFFFFFF;
+
+	ns->lbafe[0].zsze = state->znd->zsze;
+	ns->lbafe[0].zdes = 0;
+
+	return 0;
+}
+
 static int
 _idfy_ctrlr(struct xnvme_dev *XNVME_UNUSED(dev), void *dbuf)
 {
@@ -68,14 +94,10 @@ _idfy_ctrlr(struct xnvme_dev *XNVME_UNUSED(dev), void *dbuf)
 static int
 _idfy_ns(struct xnvme_dev *dev, void *dbuf)
 {
+	struct xnvme_be_ramdisk_state *state = (void *)dev->be.state;
 	struct xnvme_spec_idfy_ns *ns = dbuf;
-	size_t ramdisk_size;
-	const size_t lba_size = 512;
-
-	ramdisk_size = xnvme_be_ramdisk_dev_get_size(dev);
-	if (!ramdisk_size) {
-		return -1;
-	}
+	const size_t ramdisk_size = state->nbytes;
+	const size_t lba_size = XNVME_BE_RAMDISK_LBA_NBYTES;
 
 	ns->nsze = ramdisk_size / lba_size;
 	ns->ncap = ramdisk_size / lba_size;
@@ -98,6 +120,8 @@ _idfy_ns(struct xnvme_dev *dev, void *dbuf)
 static int
 _idfy(struct xnvme_cmd_ctx *ctx, void *dbuf)
 {
+	struct xnvme_be_ramdisk_state *state = (void *)ctx->dev->be.state;
+
 	switch (ctx->cmd.idfy.cns) {
 	case XNVME_SPEC_IDFY_NS:
 		return _idfy_ns(ctx->dev, dbuf);
@@ -110,6 +134,12 @@ _idfy(struct xnvme_cmd_ctx *ctx, void *dbuf)
 		case XNVME_SPEC_CSI_FS:
 			return _idfy_ns_iocs_fs(ctx->dev, dbuf);
 
+		case XNVME_SPEC_CSI_ZONED:
+			if (!state->znd) {
+				break;
+			}
+			return _idfy_ns_iocs_zoned(ctx->dev, dbuf);
+
 		default:
 			break;
 		}
@@ -120,6 +150,12 @@ _idfy(struct xnvme_cmd_ctx *ctx, void *dbuf)
 		case XNVME_SPEC_CSI_FS:
 			return _idfy_ctrlr_iocs_fs(ctx->dev, dbuf);
 
+		case XNVME_SPEC_CSI_ZONED:
+			if (!state->znd) {
+				break;
+			}
+			return _idfy_ctrlr_iocs_zoned(ctx->dev, dbuf);
+
 		default:
 			break;
 		}
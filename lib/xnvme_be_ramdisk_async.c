@@ -0,0 +1,234 @@
+// SPDX-FileCopyrightText: Samsung Electronics Co., Ltd
+//
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef _XOPEN_SOURCE
+#define _XOPEN_SOURCE 700
+#endif
+#include <libxnvme.h>
+#include <xnvme_be.h>
+#include <xnvme_be_nosys.h>
+#ifdef XNVME_BE_RAMDISK_ENABLED
+#include <errno.h>
+#include <xnvme_queue.h>
+#include <xnvme_dev.h>
+#include <xnvme_be_ramdisk.h>
+#ifdef XNVME_BE_LINUX_ENABLED
+#include <unistd.h>
+#include <sys/eventfd.h>
+#endif
+
+/**
+ * Commands are executed inline, at submission, and their command-contexts are stored in a
+ * completion-ring, which is reaped when the queue is poked. Since the ring holds every
+ * command-context of the queue, then it never fills up.
+ */
+struct xnvme_queue_ramdisk {
+	struct xnvme_queue_base base;
+
+	struct xnvme_cmd_ctx **cq; ///< Completion-ring
+
+	uint32_t mask; ///< Ring-size minus one, the ring-size is a power of two >= capacity
+	uint32_t head;
+	uint32_t tail;
+
+	int efd; ///< Completion eventfd, created on demand
+
+	uint8_t _rsvd[208];
+};
+XNVME_STATIC_ASSERT(sizeof(struct xnvme_queue_ramdisk) == XNVME_BE_QUEUE_STATE_NBYTES,
+		    "Incorrect size")
+
+static int
+_ramdisk_async_term(struct xnvme_queue *q)
+{
+	struct xnvme_queue_ramdisk *queue = (void *)q;
+
+	free(queue->cq);
+	queue->cq = NULL;
+
+#ifdef XNVME_BE_LINUX_ENABLED
+	if (queue->efd >= 0) {
+		close(queue->efd);
+		queue->efd = -1;
+	}
+#endif
+
+	return 0;
+}
+
+static int
+_ramdisk_async_init(struct xnvme_queue *q, int XNVME_UNUSED(opts))
+{
+	struct xnvme_queue_ramdisk *queue = (void *)q;
+	uint32_t nslots = 1;
+
+	while (nslots < queue->base.capacity) {
+		nslots <<= 1;
+	}
+
+	queue->efd = -1;
+	queue->mask = nslots - 1;
+	queue->head = 0;
+	queue->tail = 0;
+
+	queue->cq = calloc(nslots, sizeof(*queue->cq));
+	if (!queue->cq) {
+		XNVME_DEBUG("FAILED: calloc(cq)");
+		return -errno;
+	}
+
+	return 0;
+}
+
+static int
+_ramdisk_async_poke(struct xnvme_queue *q, uint32_t max)
+{
+	struct xnvme_queue_ramdisk *queue = (void *)q;
+	unsigned completed = 0;
+
+	max = max ? max : queue->base.outstanding;
+	max = max > queue->base.outstanding ? queue->base.outstanding : max;
+
+	while ((completed < max) && (queue->head != queue->tail)) {
+		struct xnvme_cmd_ctx *ctx = queue->cq[queue->head & queue->mask];
+
+		// Release the slot and the outstanding count before the callback, as the callback
+		// might re-submit and thus re-use the slot
+		queue->head += 1;
+		queue->base.outstanding -= 1;
+
+		ctx->async.cb(ctx, ctx->async.cb_arg);
+
+		++completed;
+	}
+
+	return completed;
+}
+
+static int
+_ramdisk_async_wait(struct xnvme_queue *q, uint32_t XNVME_UNUSED(min),
+		    uint64_t XNVME_UNUSED(timeout_ns))
+{
+	// Everything outstanding has already completed, so there is nothing to wait for
+	return _ramdisk_async_poke(q, 0);
+}
+
+/**
+ * Stores the completion of the command in the completion-ring, assigning the status from 'err'
+ * when the command failed before the completion was filled, and signals the completion eventfd
+ */
+static inline void
+_ramdisk_async_complete(struct xnvme_queue_ramdisk *queue, struct xnvme_cmd_ctx *ctx, int err)
+{
+	if (err) {
+		ctx->cpl.status.sc = ctx->cpl.status.sc ? ctx->cpl.status.sc : err;
+		XNVME_DEBUG("FAILED: xnvme_be_ramdisk_sync_cmd_io{v}(), err: %d", err);
+	}
+
+	queue->cq[queue->tail & queue->mask] = ctx;
+	queue->tail += 1;
+	queue->base.outstanding += 1;
+
+#ifdef XNVME_BE_LINUX_ENABLED
+	if (queue->efd >= 0) {
+		uint64_t val = 1;
+
+		if (write(queue->efd, &val, sizeof(val)) < 0) {
+			XNVME_DEBUG("FAILED: write(efd), errno: %d", errno);
+		}
+	}
+#endif
+}
+
+static int
+_ramdisk_async_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes, void *mbuf,
+		      size_t mbuf_nbytes)
+{
+	struct xnvme_queue_ramdisk *queue = (void *)ctx->async.queue;
+	int err;
+
+	if (queue->base.outstanding == queue->base.capacity) {
+		XNVME_DEBUG("FAILED: queue is full");
+		return -EBUSY;
+	}
+
+	err = xnvme_be_ramdisk_sync_cmd_io(ctx, dbuf, dbuf_nbytes, mbuf, mbuf_nbytes);
+
+	_ramdisk_async_complete(queue, ctx, err);
+
+	return 0;
+}
+
+static int
+_ramdisk_async_cmd_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, size_t dvec_cnt,
+		       size_t dvec_nbytes, void *mbuf, size_t mbuf_nbytes)
+{
+	struct xnvme_queue_ramdisk *queue = (void *)ctx->async.queue;
+	int err;
+
+	if (queue->base.outstanding == queue->base.capacity) {
+		XNVME_DEBUG("FAILED: queue is full");
+		return -EBUSY;
+	}
+
+	err = xnvme_be_ramdisk_sync_cmd_iov(ctx, dvec, dvec_cnt, dvec_nbytes, mbuf, mbuf_nbytes);
+
+	_ramdisk_async_complete(queue, ctx, err);
+
+	return 0;
+}
+
+#ifdef XNVME_BE_LINUX_ENABLED
+static int
+_ramdisk_async_get_completion_fd(struct xnvme_queue *q)
+{
+	struct xnvme_queue_ramdisk *queue = (void *)q;
+	uint64_t val = queue->tail - queue->head;
+
+	if (queue->efd >= 0) {
+		return queue->efd;
+	}
+
+	queue->efd = eventfd(0, EFD_CLOEXEC);
+	if (queue->efd < 0) {
+		XNVME_DEBUG("FAILED: eventfd(), errno: %d", errno);
+		return -errno;
+	}
+
+	if (val && (write(queue->efd, &val, sizeof(val)) < 0)) {
+		XNVME_DEBUG("FAILED: write(efd), errno: %d", errno);
+	}
+
+	return queue->efd;
+}
+#endif
+
+#endif
+
+struct xnvme_be_async g_xnvme_be_ramdisk_async = {
+	.id = "ramdisk",
+#ifdef XNVME_BE_RAMDISK_ENABLED
+	.cmd_io = _ramdisk_async_cmd_io,
+	.cmd_iov = _ramdisk_async_cmd_iov,
+	.poke = _ramdisk_async_poke,
+	.wait = _ramdisk_async_wait,
+	.init = _ramdisk_async_init,
+	.term = _ramdisk_async_term,
+#ifdef XNVME_BE_LINUX_ENABLED
+	.get_completion_fd = _ramdisk_async_get_completion_fd,
+#else
+	.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd,
+#endif
+	.cancel = xnvme_be_nosys_queue_cancel,
+#else
+	.cmd_io = xnvme_be_nosys_queue_cmd_io,
+	.cmd_iov = xnvme_be_nosys_queue_cmd_iov,
+	.poke = xnvme_be_nosys_queue_poke,
+	.wait = xnvme_be_nosys_queue_wait,
+	.init = xnvme_be_nosys_queue_init,
+	.term = xnvme_be_nosys_queue_term,
+	.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd,
+	.cancel = xnvme_be_nosys_queue_cancel,
+#endif
+};
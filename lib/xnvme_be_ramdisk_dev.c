@@ -2,6 +2,9 @@
 //
 // SPDX-License-Identifier: BSD-3-Clause
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 #ifndef _XOPEN_SOURCE
 #define _XOPEN_SOURCE 700
 #endif
@@ -9,12 +12,30 @@
 #include <xnvme_be.h>
 #include <xnvme_be_nosys.h>
 #ifdef XNVME_BE_RAMDISK_ENABLED
+#include <ctype.h>
 #include <errno.h>
+#include <stdint.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <xnvme_be_ramdisk.h>
 #include <xnvme_dev.h>
-#include <xnvme_be_cbi.h>
+#ifdef XNVME_BE_LINUX_ENABLED
+#include <sys/mman.h>
+#endif
+
+// Environment variable used to have the memory of the ramdisk populated when opening it
+static const char *g_prefault_env = "XNVME_BE_RAMDISK_PREFAULT";
+
+static const struct {
+	const char *postfix;
+	size_t nbytes;
+} g_ramdisk_units[] = {
+	{"KB", 1ULL << 10},
+	{"MB", 1ULL << 20},
+	{"GB", 1ULL << 30},
+	{"TB", 1ULL << 40},
+	{"LBA", XNVME_BE_RAMDISK_LBA_NBYTES},
+};
 
 void
 xnvme_be_ramdisk_dev_close(struct xnvme_dev *dev)
@@ -27,8 +48,18 @@ xnvme_be_ramdisk_dev_close(struct xnvme_dev *dev)
 
 	state = (void *)dev->be.state;
 	if (state->ramdisk) {
+#ifdef XNVME_BE_LINUX_ENABLED
+		if (state->fd >= 0) {
+			munmap(state->ramdisk, state->map_nbytes);
+			close(state->fd);
+		} else {
+			free(state->ramdisk);
+		}
+#else
 		free(state->ramdisk);
+#endif
 	}
+	xnvme_be_ramdisk_znd_term(state);
 
 	memset(&dev->be, 0, sizeof(dev->be));
 }
@@ -36,16 +67,130 @@ xnvme_be_ramdisk_dev_close(struct xnvme_dev *dev)
 size_t
 xnvme_be_ramdisk_dev_get_size(struct xnvme_dev *dev)
 {
-	const struct xnvme_ident *ident = &dev->ident;
-	char *gb_marker;
+	const char *uri = dev->ident.uri;
+	unsigned long long count;
+	char *postfix = NULL;
 
-	gb_marker = strrchr(ident->uri, 'G');
-	if (!gb_marker || (gb_marker && strcmp(gb_marker, "GB"))) {
-		XNVME_DEBUG("FAILED: Invalid URI. Only postfix of 'GB' allowed: %s", ident->uri);
+	if (!isdigit((unsigned char)uri[0])) {
+		XNVME_DEBUG("FAILED: Invalid URI, expected: <N>{KB,MB,GB,TB,LBA}: %s", uri);
 		return 0;
 	}
 
-	return (size_t)atoi(ident->uri) * 1024 * 1024 * 1024;
+	errno = 0;
+	count = strtoull(uri, &postfix, 10);
+	if (errno || !count) {
+		XNVME_DEBUG("FAILED: Invalid URI, count: %llu, errno: %d", count, errno);
+		return 0;
+	}
+
+	// The unit is optionally followed by options, e.g. ':zoned'
+	for (size_t i = 0; i < sizeof(g_ramdisk_units) / sizeof(*g_ramdisk_units); ++i) {
+		size_t len = strlen(g_ramdisk_units[i].postfix);
+
+		if (strncmp(postfix, g_ramdisk_units[i].postfix, len) ||
+		    (postfix[len] && (postfix[len] != ':'))) {
+			continue;
+		}
+		if (count > SIZE_MAX / g_ramdisk_units[i].nbytes) {
+			XNVME_DEBUG("FAILED: Invalid URI, size overflows: %s", uri);
+			return 0;
+		}
+
+		return (size_t)count * g_ramdisk_units[i].nbytes;
+	}
+
+	XNVME_DEBUG("FAILED: Invalid URI, expected: <N>{KB,MB,GB,TB,LBA}: %s", uri);
+	return 0;
+}
+
+#ifdef XNVME_BE_LINUX_ENABLED
+/**
+ * Back the ramdisk by a memfd, preferably on hugetlbfs, otherwise on shmem with transparent
+ * hugepages requested; the memory is zero-filled and, unless 'prefault' is set, populated on
+ * first touch
+ */
+static int
+_ramdisk_memfd_alloc(struct xnvme_be_ramdisk_state *state, bool prefault)
+{
+	const int flags = MAP_SHARED | (prefault ? MAP_POPULATE : 0);
+	const size_t hugepage_nbytes = 1ULL << 21;
+	void *ramdisk;
+	int fd = -1;
+
+#ifdef MFD_HUGETLB
+	fd = memfd_create("xnvme_ramdisk", MFD_CLOEXEC | MFD_HUGETLB);
+	if (fd >= 0) {
+		state->map_nbytes = (state->nbytes + hugepage_nbytes - 1) & ~(hugepage_nbytes - 1);
+
+		// mmap() fails when not enough hugepages are available, then fall back to shmem
+		ramdisk = MAP_FAILED;
+		if (!ftruncate(fd, state->map_nbytes)) {
+			ramdisk = mmap(NULL, state->map_nbytes, PROT_READ | PROT_WRITE, flags, fd,
+				       0);
+		}
+		if (ramdisk != MAP_FAILED) {
+			state->ramdisk = ramdisk;
+			state->fd = fd;
+			return 0;
+		}
+		XNVME_DEBUG("INFO: no hugetlbfs backing, errno: %d", errno);
+		close(fd);
+	}
+#endif
+
+	fd = memfd_create("xnvme_ramdisk", MFD_CLOEXEC);
+	if (fd < 0) {
+		XNVME_DEBUG("FAILED: memfd_create(), errno: %d", errno);
+		return -errno;
+	}
+
+	state->map_nbytes = state->nbytes;
+	ramdisk = MAP_FAILED;
+	if (!ftruncate(fd, state->map_nbytes)) {
+		ramdisk = mmap(NULL, state->map_nbytes, PROT_READ | PROT_WRITE, flags, fd, 0);
+	}
+	if (ramdisk == MAP_FAILED) {
+		int err = -errno;
+
+		XNVME_DEBUG("FAILED: ftruncate()/mmap(), err: %d", err);
+		close(fd);
+		return err;
+	}
+
+#ifdef MADV_HUGEPAGE
+	if (madvise(ramdisk, state->map_nbytes, MADV_HUGEPAGE)) {
+		XNVME_DEBUG("INFO: madvise(MADV_HUGEPAGE), errno: %d", errno);
+	}
+#endif
+
+	state->ramdisk = ramdisk;
+	state->fd = fd;
+
+	return 0;
+}
+#endif
+
+static int
+_ramdisk_alloc(struct xnvme_be_ramdisk_state *state, bool prefault)
+{
+	state->fd = -1;
+	state->map_nbytes = 0;
+
+#ifdef XNVME_BE_LINUX_ENABLED
+	if (!_ramdisk_memfd_alloc(state, prefault)) {
+		return 0;
+	}
+#endif
+
+	state->ramdisk = calloc(1, state->nbytes);
+	if (!state->ramdisk) {
+		return -errno;
+	}
+	if (prefault) {
+		memset(state->ramdisk, 0, state->nbytes);
+	}
+
+	return 0;
 }
 
 int
@@ -53,17 +198,38 @@ xnvme_be_ramdisk_dev_open(struct xnvme_dev *dev)
 {
 	struct xnvme_be_ramdisk_state *state = (void *)dev->be.state;
 	struct xnvme_opts *opts = &dev->opts;
+	const char *uri_opts;
+	char *env;
+	bool prefault;
+	int err;
 
-	size_t ramdisk_size = xnvme_be_ramdisk_dev_get_size(dev);
-	if (!ramdisk_size) {
+	state->nbytes = xnvme_be_ramdisk_dev_get_size(dev);
+	if (!state->nbytes) {
+		return -EINVAL;
+	}
+	if (state->nbytes % XNVME_BE_RAMDISK_LBA_NBYTES) {
+		XNVME_DEBUG("FAILED: size: %zu, is not a multiple of the LBA size", state->nbytes);
 		return -EINVAL;
 	}
 
-	state->ramdisk = malloc(ramdisk_size);
-	if (!state->ramdisk) {
-		XNVME_DEBUG("FAILED: Unable to allocate ramdisk: uri=%s, state->ramdisk=%p",
-			    dev->ident.uri, state->ramdisk);
-		return -errno;
+	state->znd = NULL;
+	uri_opts = strchr(dev->ident.uri, ':');
+	if (uri_opts) {
+		err = xnvme_be_ramdisk_znd_init(state, uri_opts + 1);
+		if (err) {
+			XNVME_DEBUG("FAILED: xnvme_be_ramdisk_znd_init(), err: %d", err);
+			return err;
+		}
+	}
+
+	prefault = (env = getenv(g_prefault_env)) && atoi(env);
+
+	err = _ramdisk_alloc(state, prefault);
+	if (err) {
+		XNVME_DEBUG("FAILED: Unable to allocate ramdisk: uri=%s, err: %d", dev->ident.uri,
+			    err);
+		xnvme_be_ramdisk_znd_term(state);
+		return err;
 	}
 
 	if (!opts->admin) {
@@ -73,7 +239,7 @@ xnvme_be_ramdisk_dev_open(struct xnvme_dev *dev)
 		dev->be.sync = g_xnvme_be_ramdisk_sync;
 	}
 	if (!opts->async) {
-		dev->be.async = g_xnvme_be_cbi_async_thrpool;
+		dev->be.async = g_xnvme_be_ramdisk_async;
 	}
 
 	dev->ident.dtype = XNVME_DEV_TYPE_RAMDISK;
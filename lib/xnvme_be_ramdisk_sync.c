@@ -14,6 +14,65 @@
 #include <xnvme_dev.h>
 #include <xnvme_be_ramdisk.h>
 
+/**
+ * Check that [offset, offset + nbytes) is within the ramdisk, as the size of the ramdisk is given
+ * by the user, via the URI, then commands addressing beyond it must not reach memcpy()
+ */
+static inline int
+_ramdisk_check_bounds(struct xnvme_be_ramdisk_state *state, uint64_t offset, size_t nbytes)
+{
+	if ((offset > state->nbytes) || (nbytes > state->nbytes - offset)) {
+		XNVME_DEBUG("FAILED: offset: %zu, nbytes: %zu, out of bounds", offset, nbytes);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/**
+ * In zoned mode, then writes must be at the write pointer of the zone, or appended to it; check
+ * the write and advance the write pointer. On success, 'slba' is assigned the LBA at which the
+ * data of the command is to be written
+ */
+static int
+_ramdisk_znd_write(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes, uint64_t *slba)
+{
+	struct xnvme_spec_nvm_scopy_fmt_zero *ranges = dbuf;
+	const uint64_t ssw = ctx->dev->geo.ssw;
+	uint64_t nlb = 0;
+
+	switch (ctx->cmd.common.opcode) {
+	case XNVME_SPEC_NVM_OPC_WRITE:
+		nlb = (uint64_t)ctx->cmd.nvm.nlb + 1;
+		if (dbuf_nbytes != (nlb << ssw)) {
+			XNVME_DEBUG("FAILED: dbuf_nbytes: %zu != nlb: %" PRIu64, dbuf_nbytes, nlb);
+			return -EINVAL;
+		}
+		return xnvme_be_ramdisk_znd_write(ctx, ctx->cmd.nvm.slba, nlb, false, slba);
+
+	case XNVME_SPEC_NVM_OPC_WRITE_ZEROES:
+		nlb = (uint64_t)ctx->cmd.nvm.nlb + 1;
+		return xnvme_be_ramdisk_znd_write(ctx, ctx->cmd.nvm.slba, nlb, false, slba);
+
+	case XNVME_SPEC_ZND_OPC_APPEND:
+		nlb = (uint64_t)ctx->cmd.znd.append.nlb + 1;
+		if (dbuf_nbytes != (nlb << ssw)) {
+			XNVME_DEBUG("FAILED: dbuf_nbytes: %zu != nlb: %" PRIu64, dbuf_nbytes, nlb);
+			return -EINVAL;
+		}
+		return xnvme_be_ramdisk_znd_write(ctx, ctx->cmd.znd.append.zslba, nlb, true, slba);
+
+	case XNVME_SPEC_NVM_OPC_SCOPY:
+		for (int i = 0; i <= ctx->cmd.scopy.nr; i++) {
+			nlb += (uint64_t)ranges[i].nlb + 1;
+		}
+		return xnvme_be_ramdisk_znd_write(ctx, ctx->cmd.scopy.sdlba, nlb, false, slba);
+
+	default:
+		return 0;
+	}
+}
+
 int
 xnvme_be_ramdisk_sync_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes, void *mbuf,
 			     size_t mbuf_nbytes)
@@ -22,6 +81,7 @@ xnvme_be_ramdisk_sync_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_
 	struct xnvme_spec_nvm_scopy_fmt_zero *ranges = dbuf;
 	size_t sdlba_offset = 0;
 	const uint64_t ssw = ctx->dev->geo.ssw;
+	uint64_t slba = ctx->cmd.nvm.slba;
 	char *offset = state->ramdisk;
 	int err = 0;
 
@@ -32,7 +92,50 @@ xnvme_be_ramdisk_sync_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_
 
 	switch (ctx->cmd.common.opcode) {
 	case XNVME_SPEC_NVM_OPC_WRITE:
-		memcpy(offset + (ctx->cmd.nvm.slba << ssw), dbuf, dbuf_nbytes);
+	case XNVME_SPEC_NVM_OPC_READ:
+	case XNVME_SPEC_NVM_OPC_COMPARE:
+		err = _ramdisk_check_bounds(state, ctx->cmd.nvm.slba << ssw, dbuf_nbytes);
+		break;
+	case XNVME_SPEC_NVM_OPC_WRITE_ZEROES:
+		err = _ramdisk_check_bounds(state, ctx->cmd.nvm.slba << ssw,
+					    (ctx->cmd.nvm.nlb + 1) * ctx->dev->geo.lba_nbytes);
+		break;
+	case XNVME_SPEC_FS_OPC_WRITE:
+	case XNVME_SPEC_FS_OPC_READ:
+		err = _ramdisk_check_bounds(state, ctx->cmd.nvm.slba, dbuf_nbytes);
+		break;
+	case XNVME_SPEC_ZND_OPC_APPEND:
+		if (!state->znd) {
+			XNVME_DEBUG("FAILED: append without zoned mode");
+			err = -ENOSYS;
+		}
+		break;
+	}
+	if (err) {
+		return err;
+	}
+
+	if (state->znd) {
+		switch (ctx->cmd.common.opcode) {
+		case XNVME_SPEC_ZND_OPC_MGMT_SEND:
+			return xnvme_be_ramdisk_znd_mgmt_send(ctx);
+
+		case XNVME_SPEC_ZND_OPC_MGMT_RECV:
+			return xnvme_be_ramdisk_znd_mgmt_recv(ctx, dbuf, dbuf_nbytes);
+
+		default:
+			err = _ramdisk_znd_write(ctx, dbuf, dbuf_nbytes, &slba);
+			if (err) {
+				return err;
+			}
+			break;
+		}
+	}
+
+	switch (ctx->cmd.common.opcode) {
+	case XNVME_SPEC_NVM_OPC_WRITE:
+	case XNVME_SPEC_ZND_OPC_APPEND:
+		memcpy(offset + (slba << ssw), dbuf, dbuf_nbytes);
 		break;
 
 	case XNVME_SPEC_NVM_OPC_READ:
@@ -40,7 +143,7 @@ xnvme_be_ramdisk_sync_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_
 		break;
 
 	case XNVME_SPEC_NVM_OPC_WRITE_ZEROES:
-		memset(offset + (ctx->cmd.nvm.slba << ssw), 0,
+		memset(offset + (slba << ssw), 0,
 		       (ctx->cmd.nvm.nlb + 1) * ctx->dev->geo.lba_nbytes);
 		break;
 
@@ -88,11 +191,13 @@ xnvme_be_ramdisk_sync_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_
 
 int
 xnvme_be_ramdisk_sync_cmd_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, size_t dvec_cnt,
-			      size_t XNVME_UNUSED(dvec_nbytes), void *mbuf, size_t mbuf_nbytes)
+			      size_t dvec_nbytes, void *mbuf, size_t mbuf_nbytes)
 {
 	struct xnvme_be_ramdisk_state *state = (void *)ctx->dev->be.state;
 	const uint64_t ssw = ctx->dev->geo.ssw;
+	uint64_t slba = ctx->cmd.nvm.slba;
 	char *offset = state->ramdisk;
+	int err = 0;
 
 	if (mbuf || mbuf_nbytes) {
 		XNVME_DEBUG("FAILED: mbuf or mbuf_nbytes provided");
@@ -101,9 +206,41 @@ xnvme_be_ramdisk_sync_cmd_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, siz
 
 	switch (ctx->cmd.common.opcode) {
 	case XNVME_SPEC_NVM_OPC_WRITE:
+	case XNVME_SPEC_NVM_OPC_READ:
+		err = _ramdisk_check_bounds(state, ctx->cmd.nvm.slba << ssw, dvec_nbytes);
+		break;
+	case XNVME_SPEC_FS_OPC_WRITE:
+	case XNVME_SPEC_FS_OPC_READ:
+		err = _ramdisk_check_bounds(state, ctx->cmd.nvm.slba, dvec_nbytes);
+		break;
+	case XNVME_SPEC_ZND_OPC_APPEND:
+		if (!state->znd) {
+			XNVME_DEBUG("FAILED: append without zoned mode");
+			err = -ENOSYS;
+		}
+		break;
+	}
+	if (err) {
+		return err;
+	}
+
+	if (state->znd) {
+		switch (ctx->cmd.common.opcode) {
+		case XNVME_SPEC_NVM_OPC_WRITE:
+		case XNVME_SPEC_ZND_OPC_APPEND:
+			err = _ramdisk_znd_write(ctx, NULL, dvec_nbytes, &slba);
+			if (err) {
+				return err;
+			}
+			break;
+		}
+	}
+
+	switch (ctx->cmd.common.opcode) {
+	case XNVME_SPEC_NVM_OPC_WRITE:
+	case XNVME_SPEC_ZND_OPC_APPEND:
 		for (size_t i = 0; i < dvec_cnt; ++i) {
-			memcpy(offset + (ctx->cmd.nvm.slba << ssw), dvec[i].iov_base,
-			       dvec[i].iov_len);
+			memcpy(offset + (slba << ssw), dvec[i].iov_base, dvec[i].iov_len);
 			offset += dvec[i].iov_len;
 		}
 		break;
@@ -0,0 +1,461 @@
+// SPDX-FileCopyrightText: Samsung Electronics Co., Ltd
+//
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef _XOPEN_SOURCE
+#define _XOPEN_SOURCE 700
+#endif
+#include <libxnvme.h>
+#include <xnvme_be.h>
+#ifdef XNVME_BE_RAMDISK_ENABLED
+#include <ctype.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <xnvme_dev.h>
+#include <xnvme_be_ramdisk.h>
+
+#define XNVME_BE_RAMDISK_ZND_ZSZE_DEF 0x10000
+
+#define XNVME_BE_RAMDISK_SCT_GENERIC 0x0
+#define XNVME_BE_RAMDISK_SCT_CSPEC 0x1
+#define XNVME_BE_RAMDISK_SC_INVALID_FIELD 0x2
+#define XNVME_BE_RAMDISK_SC_LBA_RANGE 0x80
+
+/**
+ * Zone state selected by the zone-receive-action-specific-field, indexed by the field
+ */
+static const uint8_t g_znd_sf_state[] = {
+	[XNVME_SPEC_ZND_CMD_MGMT_RECV_SF_ALL] = 0x0,
+	[XNVME_SPEC_ZND_CMD_MGMT_RECV_SF_EMPTY] = XNVME_SPEC_ZND_STATE_EMPTY,
+	[XNVME_SPEC_ZND_CMD_MGMT_RECV_SF_IOPEN] = XNVME_SPEC_ZND_STATE_IOPEN,
+	[XNVME_SPEC_ZND_CMD_MGMT_RECV_SF_EOPEN] = XNVME_SPEC_ZND_STATE_EOPEN,
+	[XNVME_SPEC_ZND_CMD_MGMT_RECV_SF_CLOSED] = XNVME_SPEC_ZND_STATE_CLOSED,
+	[XNVME_SPEC_ZND_CMD_MGMT_RECV_SF_FULL] = XNVME_SPEC_ZND_STATE_FULL,
+	[XNVME_SPEC_ZND_CMD_MGMT_RECV_SF_RONLY] = XNVME_SPEC_ZND_STATE_RONLY,
+	[XNVME_SPEC_ZND_CMD_MGMT_RECV_SF_OFFLINE] = XNVME_SPEC_ZND_STATE_OFFLINE,
+};
+
+static inline int
+_znd_status(struct xnvme_cmd_ctx *ctx, uint8_t sct, uint8_t sc)
+{
+	ctx->cpl.status.sct = sct;
+	ctx->cpl.status.sc = sc;
+
+	return -EIO;
+}
+
+static inline bool
+_znd_is_open(uint8_t zs)
+{
+	return (zs == XNVME_SPEC_ZND_STATE_IOPEN) || (zs == XNVME_SPEC_ZND_STATE_EOPEN);
+}
+
+static inline bool
+_znd_is_active(uint8_t zs)
+{
+	return _znd_is_open(zs) || (zs == XNVME_SPEC_ZND_STATE_CLOSED);
+}
+
+/**
+ * Transition the zone into the given state, accounting for the open and active resources
+ */
+static inline void
+_znd_set_state(struct xnvme_be_ramdisk_znd *znd, struct xnvme_spec_znd_descr *zone, uint8_t zs)
+{
+	znd->nopen -= _znd_is_open(zone->zs);
+	znd->nactive -= _znd_is_active(zone->zs);
+
+	zone->zs = zs;
+
+	znd->nopen += _znd_is_open(zone->zs);
+	znd->nactive += _znd_is_active(zone->zs);
+}
+
+/**
+ * Check that the resources are available for opening the given zone; when the open-limit is
+ * reached, then an implicitly opened zone is closed to make room, as a controller would
+ *
+ * @return 0 when the zone can be opened, otherwise the command-specific status-code
+ */
+static int
+_znd_open_check(struct xnvme_be_ramdisk_znd *znd, struct xnvme_spec_znd_descr *zone)
+{
+	if (_znd_is_open(zone->zs)) {
+		return 0;
+	}
+	if ((zone->zs == XNVME_SPEC_ZND_STATE_EMPTY) && znd->mar && (znd->nactive >= znd->mar)) {
+		return XNVME_SPEC_ZND_SC_TOO_MANY_ACTIVE;
+	}
+	if (!znd->mor || (znd->nopen < znd->mor)) {
+		return 0;
+	}
+
+	for (uint32_t zidx = 0; zidx < znd->nzones; ++zidx) {
+		if (znd->zones[zidx].zs == XNVME_SPEC_ZND_STATE_IOPEN) {
+			_znd_set_state(znd, &znd->zones[zidx], XNVME_SPEC_ZND_STATE_CLOSED);
+			return 0;
+		}
+	}
+
+	return XNVME_SPEC_ZND_SC_TOO_MANY_OPEN;
+}
+
+int
+xnvme_be_ramdisk_znd_write(struct xnvme_cmd_ctx *ctx, uint64_t slba, uint64_t nlb, bool append,
+			   uint64_t *wslba)
+{
+	struct xnvme_be_ramdisk_state *state = (void *)ctx->dev->be.state;
+	struct xnvme_be_ramdisk_znd *znd = state->znd;
+	struct xnvme_spec_znd_descr *zone;
+	uint8_t sc = 0;
+
+	if (slba / znd->zsze >= znd->nzones) {
+		XNVME_DEBUG("FAILED: slba: 0x%" PRIx64 ", out of range", slba);
+		return _znd_status(ctx, XNVME_BE_RAMDISK_SCT_GENERIC, XNVME_BE_RAMDISK_SC_LBA_RANGE);
+	}
+	zone = &znd->zones[slba / znd->zsze];
+
+	if (append && (slba != zone->zslba)) {
+		XNVME_DEBUG("FAILED: zslba: 0x%" PRIx64 ", is not the start of a zone", slba);
+		return _znd_status(ctx, XNVME_BE_RAMDISK_SCT_GENERIC,
+				   XNVME_BE_RAMDISK_SC_INVALID_FIELD);
+	}
+
+	pthread_mutex_lock(&znd->mutex);
+
+	switch (zone->zs) {
+	case XNVME_SPEC_ZND_STATE_FULL:
+		sc = XNVME_SPEC_ZND_SC_IS_FULL;
+		break;
+	case XNVME_SPEC_ZND_STATE_RONLY:
+		sc = XNVME_SPEC_ZND_SC_IS_READONLY;
+		break;
+	case XNVME_SPEC_ZND_STATE_OFFLINE:
+		sc = XNVME_SPEC_ZND_SC_IS_OFFLINE;
+		break;
+	default:
+		if (!append && (slba != zone->wp)) {
+			sc = XNVME_SPEC_ZND_SC_INVALID_WRITE;
+		} else if (zone->wp + nlb > zone->zslba + zone->zcap) {
+			sc = XNVME_SPEC_ZND_SC_BOUNDARY_ERROR;
+		} else {
+			sc = _znd_open_check(znd, zone);
+		}
+		break;
+	}
+	if (sc) {
+		pthread_mutex_unlock(&znd->mutex);
+		XNVME_DEBUG("FAILED: zslba: 0x%" PRIx64 ", zs: 0x%x, sc: 0x%x", zone->zslba,
+			    zone->zs, sc);
+		return _znd_status(ctx, XNVME_BE_RAMDISK_SCT_CSPEC, sc);
+	}
+
+	if (!_znd_is_open(zone->zs)) {
+		_znd_set_state(znd, zone, XNVME_SPEC_ZND_STATE_IOPEN);
+	}
+	*wslba = zone->wp;
+	zone->wp += nlb;
+	if (zone->wp == zone->zslba + zone->zcap) {
+		_znd_set_state(znd, zone, XNVME_SPEC_ZND_STATE_FULL);
+	}
+
+	pthread_mutex_unlock(&znd->mutex);
+
+	if (append) {
+		ctx->cpl.result = *wslba;
+	}
+
+	return 0;
+}
+
+/**
+ * Whether a zone in state 'zs' is affected by the given action when 'select_all' is set
+ */
+static bool
+_znd_selected(uint8_t zsa, uint8_t zs)
+{
+	switch (zsa) {
+	case XNVME_SPEC_ZND_CMD_MGMT_SEND_CLOSE:
+		return _znd_is_open(zs);
+	case XNVME_SPEC_ZND_CMD_MGMT_SEND_FINISH:
+		return _znd_is_active(zs);
+	case XNVME_SPEC_ZND_CMD_MGMT_SEND_OPEN:
+		return zs == XNVME_SPEC_ZND_STATE_CLOSED;
+	case XNVME_SPEC_ZND_CMD_MGMT_SEND_RESET:
+		return _znd_is_active(zs) || (zs == XNVME_SPEC_ZND_STATE_FULL);
+	case XNVME_SPEC_ZND_CMD_MGMT_SEND_OFFLINE:
+		return zs == XNVME_SPEC_ZND_STATE_RONLY;
+	default:
+		return false;
+	}
+}
+
+/**
+ * Carry out the zone send action on the given zone
+ *
+ * @return 0 on success, otherwise the command-specific status-code
+ */
+static int
+_znd_action(struct xnvme_be_ramdisk_state *state, struct xnvme_spec_znd_descr *zone, uint8_t zsa)
+{
+	struct xnvme_be_ramdisk_znd *znd = state->znd;
+	int sc;
+
+	switch (zsa) {
+	case XNVME_SPEC_ZND_CMD_MGMT_SEND_CLOSE:
+		if (_znd_is_open(zone->zs)) {
+			_znd_set_state(znd, zone, XNVME_SPEC_ZND_STATE_CLOSED);
+			return 0;
+		}
+		return zone->zs == XNVME_SPEC_ZND_STATE_CLOSED ? 0 : XNVME_SPEC_ZND_SC_INVALID_TRANS;
+
+	case XNVME_SPEC_ZND_CMD_MGMT_SEND_FINISH:
+		if (_znd_is_active(zone->zs) || (zone->zs == XNVME_SPEC_ZND_STATE_EMPTY)) {
+			zone->wp = zone->zslba + zone->zcap;
+			_znd_set_state(znd, zone, XNVME_SPEC_ZND_STATE_FULL);
+			return 0;
+		}
+		return zone->zs == XNVME_SPEC_ZND_STATE_FULL ? 0 : XNVME_SPEC_ZND_SC_INVALID_TRANS;
+
+	case XNVME_SPEC_ZND_CMD_MGMT_SEND_OPEN:
+		if (_znd_is_active(zone->zs) || (zone->zs == XNVME_SPEC_ZND_STATE_EMPTY)) {
+			sc = _znd_open_check(znd, zone);
+			if (!sc) {
+				_znd_set_state(znd, zone, XNVME_SPEC_ZND_STATE_EOPEN);
+			}
+			return sc;
+		}
+		return XNVME_SPEC_ZND_SC_INVALID_TRANS;
+
+	case XNVME_SPEC_ZND_CMD_MGMT_SEND_RESET:
+		if (_znd_is_active(zone->zs) || (zone->zs == XNVME_SPEC_ZND_STATE_FULL)) {
+			// Reads of a reset zone return zeroes, clear what was written
+			memset((char *)state->ramdisk + zone->zslba * XNVME_BE_RAMDISK_LBA_NBYTES, 0,
+			       (zone->wp - zone->zslba) * XNVME_BE_RAMDISK_LBA_NBYTES);
+			zone->wp = zone->zslba;
+			_znd_set_state(znd, zone, XNVME_SPEC_ZND_STATE_EMPTY);
+			return 0;
+		}
+		return zone->zs == XNVME_SPEC_ZND_STATE_EMPTY ? 0 : XNVME_SPEC_ZND_SC_INVALID_TRANS;
+
+	case XNVME_SPEC_ZND_CMD_MGMT_SEND_OFFLINE:
+		if (zone->zs == XNVME_SPEC_ZND_STATE_RONLY) {
+			_znd_set_state(znd, zone, XNVME_SPEC_ZND_STATE_OFFLINE);
+			return 0;
+		}
+		return zone->zs == XNVME_SPEC_ZND_STATE_OFFLINE ? 0
+								: XNVME_SPEC_ZND_SC_INVALID_TRANS;
+	}
+
+	return XNVME_SPEC_ZND_SC_INVALID_ZONE_OP;
+}
+
+int
+xnvme_be_ramdisk_znd_mgmt_send(struct xnvme_cmd_ctx *ctx)
+{
+	struct xnvme_be_ramdisk_state *state = (void *)ctx->dev->be.state;
+	struct xnvme_be_ramdisk_znd *znd = state->znd;
+	const uint64_t slba = ctx->cmd.znd.mgmt_send.slba;
+	const uint8_t zsa = ctx->cmd.znd.mgmt_send.zsa;
+	int sc = 0;
+
+	switch (zsa) {
+	case XNVME_SPEC_ZND_CMD_MGMT_SEND_CLOSE:
+	case XNVME_SPEC_ZND_CMD_MGMT_SEND_FINISH:
+	case XNVME_SPEC_ZND_CMD_MGMT_SEND_OPEN:
+	case XNVME_SPEC_ZND_CMD_MGMT_SEND_RESET:
+	case XNVME_SPEC_ZND_CMD_MGMT_SEND_OFFLINE:
+		break;
+
+	default:
+		XNVME_DEBUG("FAILED: unsupported zsa: 0x%x", zsa);
+		return _znd_status(ctx, XNVME_BE_RAMDISK_SCT_GENERIC,
+				   XNVME_BE_RAMDISK_SC_INVALID_FIELD);
+	}
+
+	if (ctx->cmd.znd.mgmt_send.select_all) {
+		pthread_mutex_lock(&znd->mutex);
+		for (uint32_t zidx = 0; (zidx < znd->nzones) && !sc; ++zidx) {
+			if (_znd_selected(zsa, znd->zones[zidx].zs)) {
+				sc = _znd_action(state, &znd->zones[zidx], zsa);
+			}
+		}
+		pthread_mutex_unlock(&znd->mutex);
+	} else {
+		if ((slba % znd->zsze) || (slba / znd->zsze >= znd->nzones)) {
+			XNVME_DEBUG("FAILED: slba: 0x%" PRIx64 ", is not the start of a zone", slba);
+			return _znd_status(ctx, XNVME_BE_RAMDISK_SCT_GENERIC,
+					   XNVME_BE_RAMDISK_SC_INVALID_FIELD);
+		}
+
+		pthread_mutex_lock(&znd->mutex);
+		sc = _znd_action(state, &znd->zones[slba / znd->zsze], zsa);
+		pthread_mutex_unlock(&znd->mutex);
+	}
+	if (sc) {
+		XNVME_DEBUG("FAILED: slba: 0x%" PRIx64 ", zsa: 0x%x, sc: 0x%x", slba, zsa, sc);
+		return _znd_status(ctx, XNVME_BE_RAMDISK_SCT_CSPEC, sc);
+	}
+
+	return 0;
+}
+
+int
+xnvme_be_ramdisk_znd_mgmt_recv(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes)
+{
+	struct xnvme_be_ramdisk_state *state = (void *)ctx->dev->be.state;
+	struct xnvme_be_ramdisk_znd *znd = state->znd;
+	struct xnvme_spec_znd_report_hdr *hdr = dbuf;
+	struct xnvme_spec_znd_descr *descrs = (void *)(hdr + 1);
+	const uint64_t slba = ctx->cmd.znd.mgmt_recv.slba;
+	const uint8_t zrasf = ctx->cmd.znd.mgmt_recv.zrasf;
+	const bool partial = ctx->cmd.znd.mgmt_recv.partial;
+	size_t nbytes = ((size_t)ctx->cmd.znd.mgmt_recv.ndwords + 1) * 4;
+	uint64_t nmatched = 0, nreported = 0, nreported_max;
+
+	nbytes = nbytes < dbuf_nbytes ? nbytes : dbuf_nbytes;
+
+	if ((ctx->cmd.znd.mgmt_recv.zra != XNVME_SPEC_ZND_CMD_MGMT_RECV_ACTION_REPORT) ||
+	    (zrasf >= sizeof(g_znd_sf_state)) || !dbuf || (nbytes < sizeof(*hdr))) {
+		XNVME_DEBUG("FAILED: zra: 0x%x, zrasf: 0x%x, nbytes: %zu",
+			    ctx->cmd.znd.mgmt_recv.zra, zrasf, nbytes);
+		return _znd_status(ctx, XNVME_BE_RAMDISK_SCT_GENERIC,
+				   XNVME_BE_RAMDISK_SC_INVALID_FIELD);
+	}
+	if (slba / znd->zsze >= znd->nzones) {
+		XNVME_DEBUG("FAILED: slba: 0x%" PRIx64 ", out of range", slba);
+		return _znd_status(ctx, XNVME_BE_RAMDISK_SCT_GENERIC, XNVME_BE_RAMDISK_SC_LBA_RANGE);
+	}
+
+	nreported_max = (nbytes - sizeof(*hdr)) / sizeof(*descrs);
+	memset(dbuf, 0, nbytes);
+
+	pthread_mutex_lock(&znd->mutex);
+	for (uint64_t zidx = slba / znd->zsze; zidx < znd->nzones; ++zidx) {
+		if (zrasf && (znd->zones[zidx].zs != g_znd_sf_state[zrasf])) {
+			continue;
+		}
+
+		if (nreported < nreported_max) {
+			descrs[nreported++] = znd->zones[zidx];
+		} else if (partial) {
+			break;
+		}
+		++nmatched;
+	}
+	pthread_mutex_unlock(&znd->mutex);
+
+	hdr->nzones = partial ? nreported : nmatched;
+
+	return 0;
+}
+
+void
+xnvme_be_ramdisk_znd_term(struct xnvme_be_ramdisk_state *state)
+{
+	if (!state->znd) {
+		return;
+	}
+
+	pthread_mutex_destroy(&state->znd->mutex);
+	free(state->znd);
+	state->znd = NULL;
+}
+
+int
+xnvme_be_ramdisk_znd_init(struct xnvme_be_ramdisk_state *state, const char *opts)
+{
+	char buf[XNVME_IDENT_URI_LEN] = {0};
+	uint64_t zsze = XNVME_BE_RAMDISK_ZND_ZSZE_DEF, zcap = 0, mor = 0, mar = 0;
+	struct xnvme_be_ramdisk_znd *znd;
+	char *saveptr = NULL;
+	uint64_t nzones;
+	char *tok;
+	int err;
+
+	strncpy(buf, opts, sizeof(buf) - 1);
+
+	tok = strtok_r(buf, ":", &saveptr);
+	if (!tok || strcmp(tok, "zoned")) {
+		XNVME_DEBUG("FAILED: Invalid URI option: %s, expected: zoned", opts);
+		return -EINVAL;
+	}
+
+	while ((tok = strtok_r(NULL, ":", &saveptr))) {
+		char *val = strchr(tok, '=');
+		char *end = NULL;
+		uint64_t num;
+
+		if (!val || !isdigit((unsigned char)val[1])) {
+			XNVME_DEBUG("FAILED: Invalid URI option: %s, expected: <key>=<N>", tok);
+			return -EINVAL;
+		}
+		*val++ = '\0';
+
+		errno = 0;
+		num = strtoull(val, &end, 0);
+		if (errno || *end) {
+			XNVME_DEBUG("FAILED: Invalid URI option: %s=%s", tok, val);
+			return -EINVAL;
+		}
+
+		if (!strcmp(tok, "zsze")) {
+			zsze = num;
+		} else if (!strcmp(tok, "zcap")) {
+			zcap = num;
+		} else if (!strcmp(tok, "mor")) {
+			mor = num;
+		} else if (!strcmp(tok, "mar")) {
+			mar = num;
+		} else {
+			XNVME_DEBUG("FAILED: Unknown URI option: %s", tok);
+			return -EINVAL;
+		}
+	}
+
+	zcap = zcap ? zcap : zsze;
+	mor = (mar && (!mor || (mor > mar))) ? mar : mor;
+	nzones = zsze ? (state->nbytes / XNVME_BE_RAMDISK_LBA_NBYTES) / zsze : 0;
+
+	if (!zsze || (zcap > zsze) || !nzones || (nzones > UINT32_MAX) || (mar > nzones)) {
+		XNVME_DEBUG("FAILED: zsze: %" PRIu64 ", zcap: %" PRIu64 ", nzones: %" PRIu64
+			    ", mar: %" PRIu64,
+			    zsze, zcap, nzones, mar);
+		return -EINVAL;
+	}
+
+	znd = calloc(1, sizeof(*znd) + nzones * sizeof(*znd->zones));
+	if (!znd) {
+		XNVME_DEBUG("FAILED: calloc(), errno: %d", errno);
+		return -errno;
+	}
+	err = pthread_mutex_init(&znd->mutex, NULL);
+	if (err) {
+		XNVME_DEBUG("FAILED: pthread_mutex_init(), err: %d", err);
+		free(znd);
+		return -err;
+	}
+
+	znd->zsze = zsze;
+	znd->zcap = zcap;
+	znd->nzones = nzones;
+	znd->mor = mor;
+	znd->mar = mar;
+
+	for (uint32_t zidx = 0; zidx < znd->nzones; ++zidx) {
+		struct xnvme_spec_znd_descr *zone = &znd->zones[zidx];
+
+		zone->zt = XNVME_SPEC_ZND_TYPE_SEQWR;
+		zone->zs = XNVME_SPEC_ZND_STATE_EMPTY;
+		zone->zcap = zcap;
+		zone->zslba = zidx * zsze;
+		zone->wp = zone->zslba;
+	}
+
+	state->znd = znd;
+	state->nbytes = nzones * zsze * XNVME_BE_RAMDISK_LBA_NBYTES;
+
+	return 0;
+}
+#endif
@@ -250,6 +250,7 @@ struct xnvme_be_async g_xnvme_be_vfio_async = {
 	.init = xnvme_be_vfio_queue_init,
 	.term = xnvme_be_vfio_queue_term,
 	.get_completion_fd = xnvme_be_vfio_queue_get_completion_fd,
+	.cancel = xnvme_be_nosys_queue_cancel,
 #else
 	.cmd_io = xnvme_be_nosys_queue_cmd_io,
 	.cmd_iov = xnvme_be_nosys_queue_cmd_iov,
@@ -258,5 +259,6 @@ struct xnvme_be_async g_xnvme_be_vfio_async = {
 	.init = xnvme_be_nosys_queue_init,
 	.term = xnvme_be_nosys_queue_term,
 	.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd,
+	.cancel = xnvme_be_nosys_queue_cancel,
 #endif
 };
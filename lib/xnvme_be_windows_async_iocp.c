@@ -240,6 +240,7 @@ struct xnvme_be_async g_xnvme_be_windows_async_iocp = {
 	.init = _windows_async_iocp_init,
 	.term = _windows_async_iocp_term,
 	.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd,
+	.cancel = xnvme_be_nosys_queue_cancel,
 #else
 	.cmd_io = xnvme_be_nosys_queue_cmd_io,
 	.poke = xnvme_be_nosys_queue_poke,
@@ -247,5 +248,6 @@ struct xnvme_be_async g_xnvme_be_windows_async_iocp = {
 	.init = xnvme_be_nosys_queue_init,
 	.term = xnvme_be_nosys_queue_term,
 	.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd,
+	.cancel = xnvme_be_nosys_queue_cancel,
 #endif
 };
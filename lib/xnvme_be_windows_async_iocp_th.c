@@ -334,6 +334,7 @@ struct xnvme_be_async g_xnvme_be_windows_async_iocp_th = {
 	.init = _windows_async_iocp_th_init,
 	.term = _windows_async_iocp_th_term,
 	.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd,
+	.cancel = xnvme_be_nosys_queue_cancel,
 #else
 	.cmd_io = xnvme_be_nosys_queue_cmd_io,
 	.poke = xnvme_be_nosys_queue_poke,
@@ -341,5 +342,6 @@ struct xnvme_be_async g_xnvme_be_windows_async_iocp_th = {
 	.init = xnvme_be_nosys_queue_init,
 	.term = xnvme_be_nosys_queue_term,
 	.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd,
+	.cancel = xnvme_be_nosys_queue_cancel,
 #endif
 };
@@ -217,6 +217,7 @@ struct xnvme_be_async g_xnvme_be_windows_async_ioring = {
 	.init = xnvme_be_windows_ioring_init,
 	.term = xnvme_be_windows_ioring_term,
 	.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd,
+	.cancel = xnvme_be_nosys_queue_cancel,
 #else
 	.cmd_io = xnvme_be_nosys_queue_cmd_io,
 	.poke = xnvme_be_nosys_queue_poke,
@@ -224,5 +225,6 @@ struct xnvme_be_async g_xnvme_be_windows_async_ioring = {
 	.init = xnvme_be_nosys_queue_init,
 	.term = xnvme_be_nosys_queue_term,
 	.get_completion_fd = xnvme_be_nosys_queue_get_completion_fd,
+	.cancel = xnvme_be_nosys_queue_cancel,
 #endif
 };
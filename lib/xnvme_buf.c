@@ -8,6 +8,120 @@
 #include <libxnvme.h>
 #include <xnvme_dev.h>
 #include <xnvme_be.h>
+#include <xnvme_buf.h>
+
+int
+xnvme_buf_registry_init(struct xnvme_dev *dev)
+{
+	struct xnvme_buf_registry *reg;
+	int err;
+
+	reg = calloc(1, sizeof(*reg));
+	if (!reg) {
+		XNVME_DEBUG("FAILED: calloc(registry), err: %s", strerror(errno));
+		return -errno;
+	}
+
+	err = pthread_mutex_init(&reg->mutex, NULL);
+	if (err) {
+		XNVME_DEBUG("FAILED: pthread_mutex_init(), err: %d", err);
+		free(reg);
+		return -err;
+	}
+
+	dev->bufreg = reg;
+
+	return 0;
+}
+
+void
+xnvme_buf_registry_term(struct xnvme_dev *dev)
+{
+	if (!dev->bufreg) {
+		return;
+	}
+
+	pthread_mutex_destroy(&dev->bufreg->mutex);
+	free(dev->bufreg);
+	dev->bufreg = NULL;
+}
+
+uint64_t
+xnvme_buf_registry_snapshot(struct xnvme_buf_registry *reg, struct iovec *slots)
+{
+	uint64_t gen;
+
+	pthread_mutex_lock(&reg->mutex);
+	memcpy(slots, reg->slots, sizeof(reg->slots));
+	gen = reg->gen;
+	pthread_mutex_unlock(&reg->mutex);
+
+	return gen;
+}
+
+bool
+xnvme_buf_registry_contains(struct xnvme_buf_registry *reg, const void *buf)
+{
+	bool found = false;
+
+	pthread_mutex_lock(&reg->mutex);
+	for (int i = 0; !found && (i < XNVME_BUF_REGISTRY_NSLOTS); ++i) {
+		found = reg->slots[i].iov_base == buf;
+	}
+	pthread_mutex_unlock(&reg->mutex);
+
+	return found;
+}
+
+/**
+ * Insert the given buffer into a vacant slot; a full registry is not an error, the buffer is then
+ * just not eligible for fixed-buffer I/O
+ */
+static void
+buf_registry_add(const struct xnvme_dev *dev, void *buf, size_t nbytes)
+{
+	struct xnvme_buf_registry *reg = dev->bufreg;
+
+	if (!(reg && buf) || nbytes > XNVME_BUF_REGISTRY_SLOT_NBYTES_MAX) {
+		return;
+	}
+
+	pthread_mutex_lock(&reg->mutex);
+	for (int i = 0; i < XNVME_BUF_REGISTRY_NSLOTS; ++i) {
+		if (reg->slots[i].iov_base) {
+			continue;
+		}
+
+		reg->slots[i].iov_base = buf;
+		reg->slots[i].iov_len = nbytes;
+		__atomic_add_fetch(&reg->gen, 1, __ATOMIC_RELEASE);
+		break;
+	}
+	pthread_mutex_unlock(&reg->mutex);
+}
+
+static void
+buf_registry_remove(const struct xnvme_dev *dev, void *buf)
+{
+	struct xnvme_buf_registry *reg = dev->bufreg;
+
+	if (!(reg && buf)) {
+		return;
+	}
+
+	pthread_mutex_lock(&reg->mutex);
+	for (int i = 0; i < XNVME_BUF_REGISTRY_NSLOTS; ++i) {
+		if (reg->slots[i].iov_base != buf) {
+			continue;
+		}
+
+		reg->slots[i].iov_base = NULL;
+		reg->slots[i].iov_len = 0;
+		__atomic_add_fetch(&reg->gen, 1, __ATOMIC_RELEASE);
+		break;
+	}
+	pthread_mutex_unlock(&reg->mutex);
+}
 
 void *
 xnvme_buf_virt_alloc(size_t alignment, size_t nbytes)
@@ -48,18 +162,31 @@ xnvme_buf_virt_free(void *buf)
 void *
 xnvme_buf_phys_alloc(const struct xnvme_dev *dev, size_t nbytes, uint64_t *phys)
 {
-	return dev->be.mem.buf_alloc(dev, nbytes, phys);
+	void *buf = dev->be.mem.buf_alloc(dev, nbytes, phys);
+
+	buf_registry_add(dev, buf, nbytes);
+
+	return buf;
 }
 
 void *
 xnvme_buf_phys_realloc(const struct xnvme_dev *dev, void *buf, size_t nbytes, uint64_t *phys)
 {
-	return dev->be.mem.buf_realloc(dev, buf, nbytes, phys);
+	void *rbuf = dev->be.mem.buf_realloc(dev, buf, nbytes, phys);
+
+	if (rbuf) {
+		buf_registry_remove(dev, buf);
+		buf_registry_add(dev, rbuf, nbytes);
+	}
+
+	return rbuf;
 }
 
 void
 xnvme_buf_phys_free(const struct xnvme_dev *dev, void *buf)
 {
+	buf_registry_remove(dev, buf);
+
 	dev->be.mem.buf_free(dev, buf);
 }
 
@@ -72,13 +199,13 @@ xnvme_buf_vtophys(const struct xnvme_dev *dev, void *buf, uint64_t *phys)
 void *
 xnvme_buf_alloc(const struct xnvme_dev *dev, size_t nbytes)
 {
-	return dev->be.mem.buf_alloc(dev, nbytes, NULL);
+	return xnvme_buf_phys_alloc(dev, nbytes, NULL);
 }
 
 void *
 xnvme_buf_realloc(const struct xnvme_dev *dev, void *buf, size_t nbytes)
 {
-	return dev->be.mem.buf_realloc(dev, buf, nbytes, NULL);
+	return xnvme_buf_phys_realloc(dev, buf, nbytes, NULL);
 }
 
 void
@@ -0,0 +1,261 @@
+// SPDX-FileCopyrightText: Samsung Electronics Co., Ltd
+//
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <stdint.h>
+#include <errno.h>
+#include <libxnvme.h>
+#include <xnvme_buf.h>
+#include <xnvme_dev.h>
+#include <xnvme_stack.h>
+
+#define XNVME_BUF_POOL_EMPTY XNVME_STACK_EMPTY
+
+/**
+ * The buffers of a pool are slices of a single allocation made with xnvme_buf_alloc(), thus, when
+ * the device is opened with 'register_buffers', then the whole pool occupies a single slot of the
+ * buffer-registry and every buffer of the pool is eligible for fixed-buffer I/O.
+ *
+ * Free buffers are kept on a lock-free stack of buffer-indices, linked via 'next', with the top in
+ * 'head', see xnvme_stack_push() and xnvme_stack_pop().
+ */
+struct xnvme_buf_pool {
+	const struct xnvme_dev *dev;
+	uint8_t *base;
+	size_t buf_nbytes;
+	size_t stride; ///< Distance between two buffers, the buffer-size rounded up to alignment
+	uint32_t nbufs;
+
+	uint64_t head __attribute__((aligned(64))); ///< Tag in the upper, index in the lower 32 bits
+
+	uint32_t next[] __attribute__((aligned(64)));
+};
+
+struct xnvme_buf_pool_cache {
+	struct xnvme_buf_pool *pool;
+	uint32_t capacity;
+	uint32_t nbufs;
+	uint32_t idx[];
+};
+
+/**
+ * Push the 'first' to 'last' buffer-indices, which are already linked via 'next', onto the stack
+ */
+static inline void
+_pool_push(struct xnvme_buf_pool *pool, uint32_t first, uint32_t last)
+{
+	xnvme_stack_push(&pool->head, pool->next, first, last);
+}
+
+/**
+ * Pop up to 'max' buffer-indices off the stack into 'idx'
+ *
+ * @return The number of buffer-indices popped
+ */
+static inline uint32_t
+_pool_pop(struct xnvme_buf_pool *pool, uint32_t *idx, uint32_t max)
+{
+	return xnvme_stack_pop(&pool->head, pool->next, idx, max);
+}
+
+static inline void *
+_pool_buf(struct xnvme_buf_pool *pool, uint32_t idx)
+{
+	return pool->base + (size_t)idx * pool->stride;
+}
+
+/**
+ * Returns the index of the given buffer, or XNVME_BUF_POOL_EMPTY when it is not one of the pool
+ */
+static inline uint32_t
+_pool_idx(struct xnvme_buf_pool *pool, void *buf)
+{
+	uintptr_t offset = (uintptr_t)buf - (uintptr_t)pool->base;
+
+	if (((uintptr_t)buf < (uintptr_t)pool->base) || (offset % pool->stride) ||
+	    (offset / pool->stride >= pool->nbufs)) {
+		return XNVME_BUF_POOL_EMPTY;
+	}
+
+	return offset / pool->stride;
+}
+
+struct xnvme_buf_pool *
+xnvme_buf_pool_create(const struct xnvme_dev *dev, size_t buf_nbytes, uint32_t nbufs)
+{
+	struct xnvme_buf_pool *pool;
+	size_t align = 0x1000;
+
+	if (!(buf_nbytes && nbufs && nbufs < XNVME_BUF_POOL_EMPTY)) {
+		XNVME_DEBUG("FAILED: invalid buf_nbytes: %zu or nbufs: %u", buf_nbytes, nbufs);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	// Small buffers are packed at their size, rounded to a power of two, of at least 512 bytes
+	if (buf_nbytes < align) {
+		for (align = 512; align < buf_nbytes; align <<= 1) {
+			;
+		}
+	}
+
+	pool = xnvme_buf_virt_alloc(64, sizeof(*pool) + nbufs * sizeof(*pool->next));
+	if (!pool) {
+		XNVME_DEBUG("FAILED: xnvme_buf_virt_alloc(pool), errno: %d", errno);
+		return NULL;
+	}
+	memset(pool, 0, sizeof(*pool));
+	pool->dev = dev;
+	pool->buf_nbytes = buf_nbytes;
+	pool->stride = ((buf_nbytes + align - 1) / align) * align;
+	pool->nbufs = nbufs;
+
+	pool->base = xnvme_buf_alloc(dev, pool->stride * nbufs);
+	if (!pool->base) {
+		int err = errno ? errno : ENOMEM;
+
+		XNVME_DEBUG("FAILED: xnvme_buf_alloc(%zu), errno: %d", pool->stride * nbufs, err);
+		xnvme_buf_virt_free(pool);
+		errno = err;
+		return NULL;
+	}
+	if (dev->bufreg && !xnvme_buf_registry_contains(dev->bufreg, pool->base)) {
+		XNVME_DEBUG("INFO: pool not registered, nbytes: %zu > %llu, or registry full",
+			    pool->stride * nbufs, XNVME_BUF_REGISTRY_SLOT_NBYTES_MAX);
+	}
+
+	for (uint32_t i = 0; i < nbufs; ++i) {
+		pool->next[i] = (i + 1 < nbufs) ? i + 1 : XNVME_BUF_POOL_EMPTY;
+	}
+	pool->head = 0;
+
+	return pool;
+}
+
+void
+xnvme_buf_pool_destroy(struct xnvme_buf_pool *pool)
+{
+	if (!pool) {
+		return;
+	}
+
+	xnvme_buf_free(pool->dev, pool->base);
+	xnvme_buf_virt_free(pool);
+}
+
+size_t
+xnvme_buf_pool_buf_nbytes(const struct xnvme_buf_pool *pool)
+{
+	return pool->buf_nbytes;
+}
+
+void *
+xnvme_buf_pool_get(struct xnvme_buf_pool *pool)
+{
+	uint32_t idx;
+
+	if (!_pool_pop(pool, &idx, 1)) {
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	return _pool_buf(pool, idx);
+}
+
+void
+xnvme_buf_pool_put(struct xnvme_buf_pool *pool, void *buf)
+{
+	uint32_t idx = _pool_idx(pool, buf);
+
+	if (idx == XNVME_BUF_POOL_EMPTY) {
+		XNVME_DEBUG("FAILED: buf: %p, is not from pool: %p", buf, (void *)pool);
+		return;
+	}
+
+	_pool_push(pool, idx, idx);
+}
+
+struct xnvme_buf_pool_cache *
+xnvme_buf_pool_cache_create(struct xnvme_buf_pool *pool, uint32_t capacity)
+{
+	struct xnvme_buf_pool_cache *cache;
+
+	if (capacity < 2) {
+		XNVME_DEBUG("FAILED: invalid capacity: %u", capacity);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	cache = calloc(1, sizeof(*cache) + capacity * sizeof(*cache->idx));
+	if (!cache) {
+		XNVME_DEBUG("FAILED: calloc(cache), errno: %d", errno);
+		return NULL;
+	}
+	cache->pool = pool;
+	cache->capacity = capacity;
+
+	return cache;
+}
+
+/**
+ * Return the 'nbufs' buffers at the top of the cache to the pool, linking them into a single push
+ */
+static void
+_cache_flush(struct xnvme_buf_pool_cache *cache, uint32_t nbufs)
+{
+	struct xnvme_buf_pool *pool = cache->pool;
+	uint32_t *idx = &cache->idx[cache->nbufs - nbufs];
+
+	if (!nbufs) {
+		return;
+	}
+
+	for (uint32_t i = 0; i + 1 < nbufs; ++i) {
+		__atomic_store_n(&pool->next[idx[i]], idx[i + 1], __ATOMIC_RELAXED);
+	}
+	_pool_push(pool, idx[0], idx[nbufs - 1]);
+
+	cache->nbufs -= nbufs;
+}
+
+void
+xnvme_buf_pool_cache_destroy(struct xnvme_buf_pool_cache *cache)
+{
+	if (!cache) {
+		return;
+	}
+
+	_cache_flush(cache, cache->nbufs);
+	free(cache);
+}
+
+void *
+xnvme_buf_pool_cache_get(struct xnvme_buf_pool_cache *cache)
+{
+	if (!cache->nbufs) {
+		cache->nbufs = _pool_pop(cache->pool, cache->idx, cache->capacity / 2);
+		if (!cache->nbufs) {
+			errno = ENOMEM;
+			return NULL;
+		}
+	}
+
+	return _pool_buf(cache->pool, cache->idx[--cache->nbufs]);
+}
+
+void
+xnvme_buf_pool_cache_put(struct xnvme_buf_pool_cache *cache, void *buf)
+{
+	uint32_t idx = _pool_idx(cache->pool, buf);
+
+	if (idx == XNVME_BUF_POOL_EMPTY) {
+		XNVME_DEBUG("FAILED: buf: %p, is not from pool: %p", buf, (void *)cache->pool);
+		return;
+	}
+
+	if (cache->nbufs == cache->capacity) {
+		_cache_flush(cache, cache->capacity / 2);
+	}
+
+	cache->idx[cache->nbufs++] = idx;
+}
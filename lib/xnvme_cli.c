@@ -862,6 +862,36 @@ static struct xnvme_cli_opt_attr xnvme_cli_opts[] = {
 		.name = "sdlba",
 		.descr = "Starting Destination Logical Block Address",
 	},
+	{
+		.opt = XNVME_CLI_OPT_NUMA_NODE,
+		.vtype = XNVME_CLI_OPT_VTYPE_NUM,
+		.name = "numa_node",
+		.descr = "NUMA node of buffers and threads; default: that of the device",
+	},
+	{
+		.opt = XNVME_CLI_OPT_DEFER_TASKRUN,
+		.vtype = XNVME_CLI_OPT_VTYPE_NUM,
+		.name = "defer_taskrun",
+		.descr = "For async=io_uring, defer task-work to the submitting thread",
+	},
+	{
+		.opt = XNVME_CLI_OPT_COOP_TASKRUN,
+		.vtype = XNVME_CLI_OPT_VTYPE_NUM,
+		.name = "coop_taskrun",
+		.descr = "For async=io_uring, run task-work cooperatively",
+	},
+	{
+		.opt = XNVME_CLI_OPT_SUBMIT_ALL,
+		.vtype = XNVME_CLI_OPT_VTYPE_NUM,
+		.name = "submit_all",
+		.descr = "For async=io_uring, submit all of a batch despite errors",
+	},
+	{
+		.opt = XNVME_CLI_OPT_REGISTER_RING_FD,
+		.vtype = XNVME_CLI_OPT_VTYPE_NUM,
+		.name = "register_ring_fd",
+		.descr = "For async=io_uring, register the ring file-descriptor",
+	},
 	{
 		.opt = XNVME_CLI_OPT_END,
 		.vtype = XNVME_CLI_OPT_VTYPE_NUM,
@@ -1521,6 +1551,21 @@ xnvme_cli_assign_arg(struct xnvme_cli *cli, struct xnvme_cli_opt_attr *opt_attr,
 	case XNVME_CLI_OPT_SDLBA:
 		args->sdlba = num;
 		break;
+	case XNVME_CLI_OPT_NUMA_NODE:
+		args->numa_node = num;
+		break;
+	case XNVME_CLI_OPT_DEFER_TASKRUN:
+		args->defer_taskrun = arg ? num : 0;
+		break;
+	case XNVME_CLI_OPT_COOP_TASKRUN:
+		args->coop_taskrun = arg ? num : 0;
+		break;
+	case XNVME_CLI_OPT_SUBMIT_ALL:
+		args->submit_all = arg ? num : 0;
+		break;
+	case XNVME_CLI_OPT_REGISTER_RING_FD:
+		args->register_ring_fd = arg ? num : 0;
+		break;
 	case XNVME_CLI_OPT_POSA_TITLE:
 	case XNVME_CLI_OPT_NON_POSA_TITLE:
 	case XNVME_CLI_OPT_ORCH_TITLE:
@@ -1922,10 +1967,23 @@ xnvme_cli_to_opts(const struct xnvme_cli *cli, struct xnvme_opts *opts)
 	opts->register_buffers = cli->given[XNVME_CLI_OPT_REGISTER_BUFFERS]
 					 ? cli->args.register_buffers
 					 : opts->register_buffers;
+	opts->defer_taskrun = cli->given[XNVME_CLI_OPT_DEFER_TASKRUN] ? cli->args.defer_taskrun
+								      : opts->defer_taskrun;
+	opts->coop_taskrun = cli->given[XNVME_CLI_OPT_COOP_TASKRUN] ? cli->args.coop_taskrun
+								    : opts->coop_taskrun;
+	opts->submit_all =
+		cli->given[XNVME_CLI_OPT_SUBMIT_ALL] ? cli->args.submit_all : opts->submit_all;
+	opts->register_ring_fd = cli->given[XNVME_CLI_OPT_REGISTER_RING_FD]
+					 ? cli->args.register_ring_fd
+					 : opts->register_ring_fd;
 
 	opts->css.value = cli->given[XNVME_CLI_OPT_CSS] ? cli->args.css.value : opts->css.value;
 	opts->css.given = cli->given[XNVME_CLI_OPT_CSS] ? cli->args.css.given : opts->css.given;
 
+	opts->numa_node.value =
+		cli->given[XNVME_CLI_OPT_NUMA_NODE] ? cli->args.numa_node : opts->numa_node.value;
+	opts->numa_node.given = cli->given[XNVME_CLI_OPT_NUMA_NODE] ? 1 : opts->numa_node.given;
+
 	opts->use_cmb_sqs =
 		cli->given[XNVME_CLI_OPT_USE_CMB_SQS] ? cli->args.use_cmb_sqs : opts->use_cmb_sqs;
 	opts->shm_id = cli->given[XNVME_CLI_OPT_SHM_ID] ? cli->args.shm_id : opts->shm_id;
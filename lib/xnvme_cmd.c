@@ -51,11 +51,19 @@ xnvme_cmd_pass(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes, void *
 
 	switch (cmd_opts & XNVME_CMD_MASK_IOMD) {
 	case XNVME_CMD_ASYNC:
+		if (ctx->async.queue->base.shared) {
+			return xnvme_queue_shared_cmd_io(ctx, dbuf, dbuf_nbytes, mbuf,
+							 mbuf_nbytes);
+		}
+		if (ctx->async.queue->base.backlog) {
+			return xnvme_queue_backlog_cmd_io(ctx, dbuf, dbuf_nbytes, mbuf,
+							  mbuf_nbytes);
+		}
 		if (ctx->async.queue->base.outstanding == ctx->async.queue->base.capacity) {
 			XNVME_DEBUG("FAILED: queue is full; returning -EBUSY");
 			return -EBUSY;
 		}
-		return ctx->dev->be.async.cmd_io(ctx, dbuf, dbuf_nbytes, mbuf, mbuf_nbytes);
+		return xnvme_queue_submit_io(ctx, dbuf, dbuf_nbytes, mbuf, mbuf_nbytes);
 
 	case XNVME_CMD_SYNC:
 		return ctx->dev->be.sync.cmd_io(ctx, dbuf, dbuf_nbytes, mbuf, mbuf_nbytes);
@@ -94,12 +102,19 @@ xnvme_cmd_pass_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, size_t dvec_cn
 
 	switch (cmd_opts & XNVME_CMD_MASK_IOMD) {
 	case XNVME_CMD_ASYNC:
+		if (ctx->async.queue->base.shared) {
+			return xnvme_queue_shared_cmd_iov(ctx, dvec, dvec_cnt, dvec_nbytes, mbuf,
+							  mbuf_nbytes);
+		}
+		if (ctx->async.queue->base.backlog) {
+			return xnvme_queue_backlog_cmd_iov(ctx, dvec, dvec_cnt, dvec_nbytes, mbuf,
+							   mbuf_nbytes);
+		}
 		if (ctx->async.queue->base.outstanding == ctx->async.queue->base.capacity) {
 			XNVME_DEBUG("FAILED: queue is full; returning -EBUSY");
 			return -EBUSY;
 		}
-		return ctx->dev->be.async.cmd_iov(ctx, dvec, dvec_cnt, dvec_nbytes, mbuf,
-						  mbuf_nbytes);
+		return xnvme_queue_submit_iov(ctx, dvec, dvec_cnt, dvec_nbytes, mbuf, mbuf_nbytes);
 	case XNVME_CMD_SYNC:
 		return ctx->dev->be.sync.cmd_iov(ctx, dvec, dvec_cnt, dvec_nbytes, mbuf,
 						 mbuf_nbytes);
@@ -109,6 +124,29 @@ xnvme_cmd_pass_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, size_t dvec_cn
 	}
 }
 
+int
+xnvme_cmd_cancel(struct xnvme_cmd_ctx *ctx)
+{
+	bool flagged;
+	int err;
+
+	if (!(ctx->opts & XNVME_CMD_ASYNC)) {
+		XNVME_DEBUG("FAILED: only async. commands can be cancelled");
+		return -EINVAL;
+	}
+
+	// Flagged up-front, as a backend may complete the command from within cancel(), and
+	// withdrawn when the cancellation fails, as the command then completes on its own
+	flagged = xnvme_queue_timeout_expire(ctx, ECANCELED);
+
+	err = ctx->dev->be.async.cancel(ctx);
+	if (err && flagged) {
+		xnvme_queue_timeout_unexpire(ctx);
+	}
+
+	return err;
+}
+
 int
 xnvme_cmd_pass_admin(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes, void *mbuf,
 		     size_t mbuf_nbytes)
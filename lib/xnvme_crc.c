@@ -5,12 +5,24 @@
  */
 
 #include <libxnvme.h>
+#include <pthread.h>
+#include <xnvme_endian.h>
+
+/*
+ * Without ISA-L, carry-less multiplication is used when the CPU supports it, with the
+ * table-driven implementations as the fallback
+ */
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define XNVME_CRC_X86_PCLMUL
+#include <immintrin.h>
+#endif
 
 /*
  * Use Intelligent Storage Acceleration Library for line speed CRC
  */
 
 #ifdef XNVME_BE_LINUX_LIBISAL_ENABLED
+#include <isa-l/crc64.h>
 #include <isa-l/crc.h>
 
 uint16_t
@@ -19,6 +31,14 @@ xnvme_crc16_t10dif(uint16_t init_crc, const void *buf, size_t len)
 	return (crc16_t10dif(init_crc, buf, len));
 }
 
+void
+xnvme_crc16_t10dif_mb(uint16_t *crcs, const void *const *bufs, size_t len, uint32_t nbufs)
+{
+	for (uint32_t i = 0; i < nbufs; ++i) {
+		crcs[i] = crc16_t10dif(crcs[i], bufs[i], len);
+	}
+}
+
 #else
 static const uint16_t crc_table_fast[16][256] = {
 	{0x0000u, 0x8BB7u, 0x9CD9u, 0x176Eu, 0xB205u, 0x39B2u, 0x2EDCu, 0xA56Bu, 0xEFBDu, 0x640Au,
@@ -472,10 +492,216 @@ crc16_table_t10dif(uint16_t init_crc, const void *buf, size_t len)
 	return crc;
 }
 
+#ifdef XNVME_CRC_X86_PCLMUL
+/**
+ * Reverse the byte-order, such that the first byte in memory is the most significant
+ */
+__attribute__((target("pclmul,ssse3"))) static inline __m128i
+crc16_pclmul_bswap(__m128i x)
+{
+	const __m128i mask = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+	return _mm_shuffle_epi8(x, mask);
+}
+
+__attribute__((target("pclmul,ssse3"))) static inline __m128i
+crc16_pclmul_load(const uint8_t *data)
+{
+	return crc16_pclmul_bswap(_mm_loadu_si128((const void *)data));
+}
+
+/**
+ * Multiply the upper and lower 64 bits of 'x' by the upper and lower constant of 'k', that is,
+ * fold 'x' forward over the distance given by the constants
+ */
+__attribute__((target("pclmul,ssse3"))) static inline __m128i
+crc16_pclmul_fold(__m128i x, __m128i k)
+{
+	return _mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x11), _mm_clmulepi64_si128(x, k, 0x00));
+}
+
+/**
+ * CRC16 T10-DIF by carry-less multiplication, folding four 16-byte lanes in parallel, and
+ * reducing the result by table. The input is byte-swapped such that the polynomial of each lane
+ * has the first byte of the lane as its most significant, the folding constants, for a distance
+ * of 'd' bits, are then {x^(d+64) mod P, x^d mod P} with P = 0x18BB7.
+ */
+__attribute__((target("pclmul,ssse3"))) static uint16_t
+crc16_pclmul_t10dif(uint16_t init_crc, const void *buf, size_t len)
+{
+	const uint8_t *data = buf;
+	__m128i x0, x1, x2, x3, k;
+	uint8_t rem[16];
+
+	if (len < 64) {
+		return crc16_table_t10dif(init_crc, buf, len);
+	}
+
+	x0 = crc16_pclmul_load(data + 0);
+	x1 = crc16_pclmul_load(data + 16);
+	x2 = crc16_pclmul_load(data + 32);
+	x3 = crc16_pclmul_load(data + 48);
+
+	// The initial CRC is equivalent to the xor of it onto the first two bytes of the message
+	x0 = _mm_xor_si128(x0, _mm_set_epi64x((long long)((uint64_t)init_crc << 48), 0));
+
+	data += 64;
+	len -= 64;
+
+	k = _mm_set_epi64x(0xdd31, 0x1069); // x^576, x^512
+	for (; len >= 64; data += 64, len -= 64) {
+		x0 = _mm_xor_si128(crc16_pclmul_fold(x0, k), crc16_pclmul_load(data + 0));
+		x1 = _mm_xor_si128(crc16_pclmul_fold(x1, k), crc16_pclmul_load(data + 16));
+		x2 = _mm_xor_si128(crc16_pclmul_fold(x2, k), crc16_pclmul_load(data + 32));
+		x3 = _mm_xor_si128(crc16_pclmul_fold(x3, k), crc16_pclmul_load(data + 48));
+	}
+
+	// Fold the lanes onto the last one: x^448, x^384 / x^320, x^256 / x^192, x^128
+	x3 = _mm_xor_si128(x3, crc16_pclmul_fold(x0, _mm_set_epi64x(0x4a84, 0x84da)));
+	x3 = _mm_xor_si128(x3, crc16_pclmul_fold(x1, _mm_set_epi64x(0x7acc, 0x857d)));
+	x3 = _mm_xor_si128(x3, crc16_pclmul_fold(x2, _mm_set_epi64x(0x1faa, 0xa010)));
+
+	k = _mm_set_epi64x(0x1faa, 0xa010); // x^192, x^128
+	for (; len >= 16; data += 16, len -= 16) {
+		x3 = _mm_xor_si128(crc16_pclmul_fold(x3, k), crc16_pclmul_load(data));
+	}
+
+	// The CRC of the folded lane, in message byte-order, continued over the remaining bytes
+	_mm_storeu_si128((void *)rem, crc16_pclmul_bswap(x3));
+
+	return crc_update_fast(crc_update_fast(0, rem, sizeof(rem)), data, len);
+}
+#endif
+
+static uint16_t
+crc16_t10dif_resolve(uint16_t init_crc, const void *buf, size_t len);
+
+static uint16_t (*g_crc16_t10dif)(uint16_t, const void *, size_t) = crc16_t10dif_resolve;
+
+/**
+ * Select the implementation supported by the CPU, on first use
+ */
+static uint16_t
+crc16_t10dif_resolve(uint16_t init_crc, const void *buf, size_t len)
+{
+	uint16_t (*fn)(uint16_t, const void *, size_t) = crc16_table_t10dif;
+
+#ifdef XNVME_CRC_X86_PCLMUL
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3")) {
+		fn = crc16_pclmul_t10dif;
+	}
+#endif
+	__atomic_store_n(&g_crc16_t10dif, fn, __ATOMIC_RELAXED);
+
+	return fn(init_crc, buf, len);
+}
+
 uint16_t
 xnvme_crc16_t10dif(uint16_t init_crc, const void *buf, size_t len)
 {
-	return (crc16_table_t10dif(init_crc, buf, len));
+	return __atomic_load_n(&g_crc16_t10dif, __ATOMIC_RELAXED)(init_crc, buf, len);
+}
+
+static void
+crc16_table_t10dif_mb(uint16_t *crcs, const void *const *bufs, size_t len, uint32_t nbufs)
+{
+	for (uint32_t i = 0; i < nbufs; ++i) {
+		crcs[i] = crc16_table_t10dif(crcs[i], bufs[i], len);
+	}
+}
+
+#ifdef XNVME_CRC_X86_PCLMUL
+__attribute__((target("pclmul,ssse3"))) static inline __m128i
+crc16_pclmul_seed(const uint8_t *data, uint16_t init_crc)
+{
+	return _mm_xor_si128(crc16_pclmul_load(data),
+			     _mm_set_epi64x((long long)((uint64_t)init_crc << 48), 0));
+}
+
+__attribute__((target("pclmul,ssse3"))) static inline uint16_t
+crc16_pclmul_reduce(__m128i x, const uint8_t *data, size_t len)
+{
+	uint8_t rem[16];
+
+	_mm_storeu_si128((void *)rem, crc16_pclmul_bswap(x));
+
+	return crc_update_fast(crc_update_fast(0, rem, sizeof(rem)), data, len);
+}
+
+/**
+ * CRC16 T10-DIF of four equally sized buffers, interleaving the buffers as the four lanes of the
+ * folding, such that short buffers, e.g. the blocks of a command, keep the multiplier as busy as
+ * a single long buffer does, and without folding the lanes onto each other at the end
+ */
+__attribute__((target("pclmul,ssse3"))) static void
+crc16_pclmul_t10dif_x4(uint16_t *crcs, const void *const *bufs, size_t len)
+{
+	const __m128i k = _mm_set_epi64x(0x1faa, 0xa010); // x^192, x^128
+	const uint8_t *d0 = bufs[0], *d1 = bufs[1], *d2 = bufs[2], *d3 = bufs[3];
+	__m128i x0, x1, x2, x3;
+	size_t off;
+
+	x0 = crc16_pclmul_seed(d0, crcs[0]);
+	x1 = crc16_pclmul_seed(d1, crcs[1]);
+	x2 = crc16_pclmul_seed(d2, crcs[2]);
+	x3 = crc16_pclmul_seed(d3, crcs[3]);
+
+	for (off = 16; off + 16 <= len; off += 16) {
+		x0 = _mm_xor_si128(crc16_pclmul_fold(x0, k), crc16_pclmul_load(d0 + off));
+		x1 = _mm_xor_si128(crc16_pclmul_fold(x1, k), crc16_pclmul_load(d1 + off));
+		x2 = _mm_xor_si128(crc16_pclmul_fold(x2, k), crc16_pclmul_load(d2 + off));
+		x3 = _mm_xor_si128(crc16_pclmul_fold(x3, k), crc16_pclmul_load(d3 + off));
+	}
+
+	crcs[0] = crc16_pclmul_reduce(x0, d0 + off, len - off);
+	crcs[1] = crc16_pclmul_reduce(x1, d1 + off, len - off);
+	crcs[2] = crc16_pclmul_reduce(x2, d2 + off, len - off);
+	crcs[3] = crc16_pclmul_reduce(x3, d3 + off, len - off);
+}
+
+__attribute__((target("pclmul,ssse3"))) static void
+crc16_pclmul_t10dif_mb(uint16_t *crcs, const void *const *bufs, size_t len, uint32_t nbufs)
+{
+	uint32_t i = 0;
+
+	if (len >= 16) {
+		for (; i + 4 <= nbufs; i += 4) {
+			crc16_pclmul_t10dif_x4(&crcs[i], &bufs[i], len);
+		}
+	}
+	for (; i < nbufs; ++i) {
+		crcs[i] = crc16_pclmul_t10dif(crcs[i], bufs[i], len);
+	}
+}
+#endif
+
+static void
+crc16_t10dif_mb_resolve(uint16_t *crcs, const void *const *bufs, size_t len, uint32_t nbufs);
+
+static void (*g_crc16_t10dif_mb)(uint16_t *, const void *const *, size_t,
+				 uint32_t) = crc16_t10dif_mb_resolve;
+
+static void
+crc16_t10dif_mb_resolve(uint16_t *crcs, const void *const *bufs, size_t len, uint32_t nbufs)
+{
+	void (*fn)(uint16_t *, const void *const *, size_t, uint32_t) = crc16_table_t10dif_mb;
+
+#ifdef XNVME_CRC_X86_PCLMUL
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3")) {
+		fn = crc16_pclmul_t10dif_mb;
+	}
+#endif
+	__atomic_store_n(&g_crc16_t10dif_mb, fn, __ATOMIC_RELAXED);
+
+	fn(crcs, bufs, len, nbufs);
+}
+
+void
+xnvme_crc16_t10dif_mb(uint16_t *crcs, const void *const *bufs, size_t len, uint32_t nbufs)
+{
+	__atomic_load_n(&g_crc16_t10dif_mb, __ATOMIC_RELAXED)(crcs, bufs, len, nbufs);
 }
 #endif
 
@@ -580,8 +806,268 @@ crc64_refl_base(uint64_t seed, const uint8_t *buf, uint64_t len)
 	return ~crc;
 }
 
+#ifdef XNVME_BE_LINUX_LIBISAL_CRC64_ENABLED
 uint64_t
 xnvme_crc64_nvme(const void *buf, size_t len, uint64_t crc)
 {
-	return crc64_refl_base(crc, (const uint8_t *)buf, len);
+	return crc64_rocksoft_refl(crc, buf, len);
 }
+
+void
+xnvme_crc64_nvme_mb(uint64_t *crcs, const void *const *bufs, size_t len, uint32_t nbufs)
+{
+	for (uint32_t i = 0; i < nbufs; ++i) {
+		crcs[i] = crc64_rocksoft_refl(crcs[i], bufs[i], len);
+	}
+}
+
+#else
+/**
+ * Slice-by-8 tables, derived from crc64_refl_table on first use, these are the fallback when the
+ * CPU does not support carry-less multiplication, and otherwise reduce the folded lane
+ */
+static uint64_t crc64_refl_table_slice[8][256];
+static pthread_once_t crc64_refl_table_slice_once = PTHREAD_ONCE_INIT;
+
+static void
+crc64_refl_table_slice_init(void)
+{
+	for (int i = 0; i < 256; ++i) {
+		crc64_refl_table_slice[0][i] = crc64_refl_table[i];
+	}
+	for (int k = 1; k < 8; ++k) {
+		for (int i = 0; i < 256; ++i) {
+			uint64_t crc = crc64_refl_table_slice[k - 1][i];
+
+			crc64_refl_table_slice[k][i] = crc64_refl_table[(uint8_t)crc] ^ (crc >> 8);
+		}
+	}
+}
+
+static uint64_t
+crc64_refl_slice8(uint64_t seed, const void *buf, size_t len)
+{
+	const uint64_t(*t)[256] = (const uint64_t(*)[256])crc64_refl_table_slice;
+	const uint8_t *data = buf;
+	uint64_t crc = ~seed;
+
+	for (; len >= 8; data += 8, len -= 8) {
+		crc ^= xnvme_from_le64(data);
+		crc = t[7][(uint8_t)crc] ^ t[6][(uint8_t)(crc >> 8)] ^
+		      t[5][(uint8_t)(crc >> 16)] ^ t[4][(uint8_t)(crc >> 24)] ^
+		      t[3][(uint8_t)(crc >> 32)] ^ t[2][(uint8_t)(crc >> 40)] ^
+		      t[1][(uint8_t)(crc >> 48)] ^ t[0][crc >> 56];
+	}
+
+	return crc64_refl_base(~crc, data, len);
+}
+
+#ifdef XNVME_CRC_X86_PCLMUL
+/**
+ * Multiply the lower and upper 64 bits of 'x' by the lower and upper constant of 'k', that is,
+ * fold 'x' forward over the distance given by the constants
+ */
+__attribute__((target("pclmul"))) static inline __m128i
+crc64_pclmul_fold(__m128i x, __m128i k)
+{
+	return _mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00), _mm_clmulepi64_si128(x, k, 0x11));
+}
+
+__attribute__((target("pclmul"))) static inline __m128i
+crc64_pclmul_k(uint64_t lo, uint64_t hi)
+{
+	return _mm_set_epi64x((long long)hi, (long long)lo);
+}
+
+__attribute__((target("pclmul"))) static inline __m128i
+crc64_pclmul_load(const uint8_t *data)
+{
+	return _mm_loadu_si128((const void *)data);
+}
+
+/**
+ * CRC64-NVMe by carry-less multiplication, folding four 16-byte lanes in parallel, and reducing
+ * the result by table. The CRC is bit-reflected, thus, the lanes are loaded as is, and as the
+ * product of two reflected operands is off by one bit, then the folding constants, for a
+ * distance of 'd' bits, are the reflections of {x^(d+63) mod P, x^(d-1) mod P}.
+ */
+__attribute__((target("pclmul"))) static uint64_t
+crc64_pclmul_nvme(uint64_t seed, const void *buf, size_t len)
+{
+	const uint8_t *data = buf;
+	__m128i x0, x1, x2, x3, k;
+	uint8_t rem[16];
+
+	if (len < 64) {
+		return crc64_refl_slice8(seed, data, len);
+	}
+
+	x0 = crc64_pclmul_load(data + 0);
+	x1 = crc64_pclmul_load(data + 16);
+	x2 = crc64_pclmul_load(data + 32);
+	x3 = crc64_pclmul_load(data + 48);
+
+	// The initial CRC is equivalent to the xor of it onto the first eight bytes of the message
+	x0 = _mm_xor_si128(x0, _mm_set_epi64x(0, (long long)~seed));
+
+	data += 64;
+	len -= 64;
+
+	k = crc64_pclmul_k(0x0c32cdb31e18a84a, 0x62242240ace5045a); // d = 512
+	for (; len >= 64; data += 64, len -= 64) {
+		x0 = _mm_xor_si128(crc64_pclmul_fold(x0, k), crc64_pclmul_load(data + 0));
+		x1 = _mm_xor_si128(crc64_pclmul_fold(x1, k), crc64_pclmul_load(data + 16));
+		x2 = _mm_xor_si128(crc64_pclmul_fold(x2, k), crc64_pclmul_load(data + 32));
+		x3 = _mm_xor_si128(crc64_pclmul_fold(x3, k), crc64_pclmul_load(data + 48));
+	}
+
+	// Fold the lanes onto the last one: d = 384, 256 and 128
+	k = crc64_pclmul_k(0xbdd7ac0ee1a4a0f0, 0xa3ffdc1fe8e82a8b);
+	x3 = _mm_xor_si128(x3, crc64_pclmul_fold(x0, k));
+	k = crc64_pclmul_k(0xb0bc2e589204f500, 0xe1e0bb9d45d7a44c);
+	x3 = _mm_xor_si128(x3, crc64_pclmul_fold(x1, k));
+	k = crc64_pclmul_k(0xeadc41fd2ba3d420, 0x21e9761e252621ac);
+	x3 = _mm_xor_si128(x3, crc64_pclmul_fold(x2, k));
+
+	for (; len >= 16; data += 16, len -= 16) {
+		x3 = _mm_xor_si128(crc64_pclmul_fold(x3, k), crc64_pclmul_load(data));
+	}
+
+	// The CRC of the folded lane, continued over the remaining bytes
+	_mm_storeu_si128((void *)rem, x3);
+
+	return crc64_refl_slice8(crc64_refl_slice8(~0ULL, rem, sizeof(rem)), data, len);
+}
+#endif
+
+static uint64_t
+crc64_nvme_resolve(uint64_t seed, const void *buf, size_t len);
+
+static uint64_t (*g_crc64_nvme)(uint64_t, const void *, size_t) = crc64_nvme_resolve;
+
+/**
+ * Select the implementation supported by the CPU, on first use
+ */
+static uint64_t
+crc64_nvme_resolve(uint64_t seed, const void *buf, size_t len)
+{
+	uint64_t (*fn)(uint64_t, const void *, size_t) = crc64_refl_slice8;
+
+#ifdef XNVME_CRC_X86_PCLMUL
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("pclmul")) {
+		fn = crc64_pclmul_nvme;
+	}
+#endif
+	pthread_once(&crc64_refl_table_slice_once, crc64_refl_table_slice_init);
+	__atomic_store_n(&g_crc64_nvme, fn, __ATOMIC_RELEASE);
+
+	return fn(seed, buf, len);
+}
+
+uint64_t
+xnvme_crc64_nvme(const void *buf, size_t len, uint64_t crc)
+{
+	return __atomic_load_n(&g_crc64_nvme, __ATOMIC_ACQUIRE)(crc, buf, len);
+}
+
+static void
+crc64_refl_slice8_mb(uint64_t *crcs, const void *const *bufs, size_t len, uint32_t nbufs)
+{
+	for (uint32_t i = 0; i < nbufs; ++i) {
+		crcs[i] = crc64_refl_slice8(crcs[i], bufs[i], len);
+	}
+}
+
+#ifdef XNVME_CRC_X86_PCLMUL
+__attribute__((target("pclmul"))) static inline __m128i
+crc64_pclmul_seed(const uint8_t *data, uint64_t seed)
+{
+	return _mm_xor_si128(crc64_pclmul_load(data), _mm_set_epi64x(0, (long long)~seed));
+}
+
+__attribute__((target("pclmul"))) static inline uint64_t
+crc64_pclmul_reduce(__m128i x, const uint8_t *data, size_t len)
+{
+	uint8_t rem[16];
+
+	_mm_storeu_si128((void *)rem, x);
+
+	return crc64_refl_slice8(crc64_refl_slice8(~0ULL, rem, sizeof(rem)), data, len);
+}
+
+/**
+ * CRC64-NVMe of four equally sized buffers, interleaving the buffers as the four lanes of the
+ * folding, see crc16_pclmul_t10dif_x4()
+ */
+__attribute__((target("pclmul"))) static void
+crc64_pclmul_nvme_x4(uint64_t *crcs, const void *const *bufs, size_t len)
+{
+	const __m128i k = crc64_pclmul_k(0xeadc41fd2ba3d420, 0x21e9761e252621ac); // d = 128
+	const uint8_t *d0 = bufs[0], *d1 = bufs[1], *d2 = bufs[2], *d3 = bufs[3];
+	__m128i x0, x1, x2, x3;
+	size_t off;
+
+	x0 = crc64_pclmul_seed(d0, crcs[0]);
+	x1 = crc64_pclmul_seed(d1, crcs[1]);
+	x2 = crc64_pclmul_seed(d2, crcs[2]);
+	x3 = crc64_pclmul_seed(d3, crcs[3]);
+
+	for (off = 16; off + 16 <= len; off += 16) {
+		x0 = _mm_xor_si128(crc64_pclmul_fold(x0, k), crc64_pclmul_load(d0 + off));
+		x1 = _mm_xor_si128(crc64_pclmul_fold(x1, k), crc64_pclmul_load(d1 + off));
+		x2 = _mm_xor_si128(crc64_pclmul_fold(x2, k), crc64_pclmul_load(d2 + off));
+		x3 = _mm_xor_si128(crc64_pclmul_fold(x3, k), crc64_pclmul_load(d3 + off));
+	}
+
+	crcs[0] = crc64_pclmul_reduce(x0, d0 + off, len - off);
+	crcs[1] = crc64_pclmul_reduce(x1, d1 + off, len - off);
+	crcs[2] = crc64_pclmul_reduce(x2, d2 + off, len - off);
+	crcs[3] = crc64_pclmul_reduce(x3, d3 + off, len - off);
+}
+
+__attribute__((target("pclmul"))) static void
+crc64_pclmul_nvme_mb(uint64_t *crcs, const void *const *bufs, size_t len, uint32_t nbufs)
+{
+	uint32_t i = 0;
+
+	if (len >= 16) {
+		for (; i + 4 <= nbufs; i += 4) {
+			crc64_pclmul_nvme_x4(&crcs[i], &bufs[i], len);
+		}
+	}
+	for (; i < nbufs; ++i) {
+		crcs[i] = crc64_pclmul_nvme(crcs[i], bufs[i], len);
+	}
+}
+#endif
+
+static void
+crc64_nvme_mb_resolve(uint64_t *crcs, const void *const *bufs, size_t len, uint32_t nbufs);
+
+static void (*g_crc64_nvme_mb)(uint64_t *, const void *const *, size_t,
+			       uint32_t) = crc64_nvme_mb_resolve;
+
+static void
+crc64_nvme_mb_resolve(uint64_t *crcs, const void *const *bufs, size_t len, uint32_t nbufs)
+{
+	void (*fn)(uint64_t *, const void *const *, size_t, uint32_t) = crc64_refl_slice8_mb;
+
+#ifdef XNVME_CRC_X86_PCLMUL
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("pclmul")) {
+		fn = crc64_pclmul_nvme_mb;
+	}
+#endif
+	pthread_once(&crc64_refl_table_slice_once, crc64_refl_table_slice_init);
+	__atomic_store_n(&g_crc64_nvme_mb, fn, __ATOMIC_RELEASE);
+
+	fn(crcs, bufs, len, nbufs);
+}
+
+void
+xnvme_crc64_nvme_mb(uint64_t *crcs, const void *const *bufs, size_t len, uint32_t nbufs)
+{
+	__atomic_load_n(&g_crc64_nvme_mb, __ATOMIC_ACQUIRE)(crcs, bufs, len, nbufs);
+}
+#endif
@@ -5,6 +5,7 @@
 #include <errno.h>
 #include <libxnvme.h>
 #include <xnvme_be.h>
+#include <xnvme_buf.h>
 #include <xnvme_cmd.h>
 #include <xnvme_dev.h>
 #include <xnvme_geo.h>
@@ -548,6 +549,12 @@ xnvme_dev_get_opts(const struct xnvme_dev *dev)
 	return &dev->opts;
 }
 
+int
+xnvme_dev_get_numa_node(const struct xnvme_dev *dev)
+{
+	return dev->numa_node;
+}
+
 uint64_t
 xnvme_dev_get_ssw(const struct xnvme_dev *dev)
 {
@@ -605,6 +612,21 @@ xnvme_dev_open(const char *dev_uri, struct xnvme_opts *opts)
 		return NULL;
 	}
 
+	if (opts->numa_node.given) {
+		dev->numa_node = opts->numa_node.value;
+	}
+
+	if (opts->register_buffers) {
+		err = xnvme_buf_registry_init(dev);
+		if (err) {
+			XNVME_DEBUG("FAILED: xnvme_buf_registry_init(), err: %d", err);
+			dev->be.dev.dev_close(dev);
+			errno = -err;
+			free(dev);
+			return NULL;
+		}
+	}
+
 	return dev;
 }
 
@@ -616,6 +638,7 @@ xnvme_dev_close(struct xnvme_dev *dev)
 	}
 
 	dev->be.dev.dev_close(dev);
+	xnvme_buf_registry_term(dev);
 	free(dev);
 }
 
@@ -628,6 +651,7 @@ xnvme_dev_alloc(struct xnvme_dev **dev)
 		return -errno;
 	}
 	memset(*dev, 0, sizeof(**dev));
+	(*dev)->numa_node = -1;
 
 	return 0;
 }
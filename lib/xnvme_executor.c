@@ -0,0 +1,657 @@
+// SPDX-FileCopyrightText: Samsung Electronics Co., Ltd
+//
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/queue.h>
+#include <libxnvme.h>
+#include <xnvme_be.h>
+#include <xnvme_dev.h>
+#include <xnvme_numa.h>
+
+///< Time a worker with commands in flight waits for a completion, before looking for tasks again
+#define XNVME_EXECUTOR_WAIT_NS 100000ULL
+
+///< Initial and maximum time a worker backs off, after failing to reap completions
+#define XNVME_EXECUTOR_BACKOFF_NS_MIN 10000ULL
+#define XNVME_EXECUTOR_BACKOFF_NS_MAX 10000000ULL
+
+///< Number of consecutive reaping failures after which a stopping worker abandons its queue
+#define XNVME_EXECUTOR_NFAILURES_MAX 16
+
+///< Transfer size of the commands of an I/O job, when the device does not report an MDTS
+#define XNVME_EXECUTOR_CHUNK_NBYTES_DEF (128 * 1024)
+
+struct xnvme_executor_job;
+
+/**
+ * A closure, or one command of an I/O job
+ */
+struct xnvme_executor_task {
+	struct xnvme_executor_job *job; ///< NULL for a closure
+	xnvme_executor_fn fn;
+	void *arg; ///< Argument of the closure, or payload of the command
+	uint64_t slba;
+	uint32_t nblocks;
+
+	TAILQ_ENTRY(xnvme_executor_task) link;
+};
+
+/**
+ * An I/O job, allocated along with its tasks, and freed by the completion of its last task
+ */
+struct xnvme_executor_job {
+	struct xnvme_executor *exec;
+	uint8_t opcode;
+	uint32_t nsid;
+	xnvme_executor_cb cb;
+	void *cb_arg;
+
+	uint32_t nremaining; ///< Number of tasks not yet completed
+	int err;             ///< Error of the first failing task
+
+	struct xnvme_executor_task tasks[];
+};
+
+/**
+ * The deque of a worker is guarded by its mutex; the owner takes tasks from the head, and thieves
+ * take them from the tail, thus, each ends up with a contiguous part of an I/O job.
+ */
+struct xnvme_executor_worker {
+	struct xnvme_executor *exec;
+	struct xnvme_queue *queue;
+	pthread_t thread;
+	uint32_t id;
+	int err;     ///< Result of the queue-initialization
+	bool active; ///< Whether the worker has commands in flight, and thus is counted by 'nactive'
+
+	uint32_t nfailures; ///< Consecutive failures to reap completions, parking the worker
+
+	pthread_mutex_t mutex;
+	TAILQ_HEAD(xnvme_executor_tasks, xnvme_executor_task) tasks;
+	uint32_t ntasks;
+} __attribute__((aligned(64)));
+
+struct xnvme_executor {
+	struct xnvme_dev *dev;
+	uint32_t qdepth;
+	uint32_t chunk_nblocks; ///< Maximum number of blocks per command of an I/O job
+
+	uint32_t next;     ///< Worker receiving the next submission, round-robin
+	uint64_t nqueued;  ///< Number of tasks in the deques
+	uint64_t npending; ///< Number of tasks submitted and not yet completed
+	uint32_t nactive;  ///< Number of workers with commands in flight
+	int err;           ///< First failure to reap completions, see xnvme_executor_drain()
+
+	pthread_mutex_t mutex;
+	pthread_cond_t work; ///< Signaled when tasks are queued, and on stop
+	pthread_cond_t idle; ///< Signaled when workers start, and when all work has completed
+	uint32_t nstarted;
+	bool stop;
+
+	uint32_t nworkers;
+	struct xnvme_executor_worker workers[];
+};
+
+static void
+_executor_idle_check(struct xnvme_executor *exec)
+{
+	if (__atomic_load_n(&exec->npending, __ATOMIC_ACQUIRE) ||
+	    __atomic_load_n(&exec->nactive, __ATOMIC_ACQUIRE)) {
+		return;
+	}
+
+	pthread_mutex_lock(&exec->mutex);
+	pthread_cond_broadcast(&exec->idle);
+	pthread_mutex_unlock(&exec->mutex);
+}
+
+static void
+_executor_task_done(struct xnvme_executor *exec)
+{
+	if (!__atomic_sub_fetch(&exec->npending, 1, __ATOMIC_ACQ_REL)) {
+		_executor_idle_check(exec);
+	}
+}
+
+/**
+ * Account for whether the worker has commands in flight, this is done before a task is completed,
+ * such that the executor is never seen idle while a closure has commands in flight
+ */
+static void
+_executor_worker_update_active(struct xnvme_executor_worker *worker)
+{
+	struct xnvme_executor *exec = worker->exec;
+	bool active = xnvme_queue_get_outstanding(worker->queue) > 0;
+
+	if (active == worker->active) {
+		return;
+	}
+	worker->active = active;
+
+	if (active) {
+		__atomic_add_fetch(&exec->nactive, 1, __ATOMIC_ACQ_REL);
+	} else if (!__atomic_sub_fetch(&exec->nactive, 1, __ATOMIC_ACQ_REL)) {
+		_executor_idle_check(exec);
+	}
+}
+
+static void
+_executor_job_task_done(struct xnvme_executor_task *task, int err)
+{
+	struct xnvme_executor_job *job = task->job;
+	struct xnvme_executor *exec = job->exec;
+
+	if (err) {
+		int expected = 0;
+
+		__atomic_compare_exchange_n(&job->err, &expected, err, false, __ATOMIC_RELAXED,
+					    __ATOMIC_RELAXED);
+	}
+
+	if (!__atomic_sub_fetch(&job->nremaining, 1, __ATOMIC_ACQ_REL)) {
+		if (job->cb) {
+			job->cb(__atomic_load_n(&job->err, __ATOMIC_RELAXED), job->cb_arg);
+		}
+		free(job);
+	}
+
+	_executor_task_done(exec);
+}
+
+static void
+_executor_cmd_cb(struct xnvme_cmd_ctx *ctx, void *cb_arg)
+{
+	struct xnvme_executor_task *task = cb_arg;
+	int err = xnvme_cmd_ctx_cpl_status(ctx) ? -EIO : 0;
+
+	if (err) {
+		XNVME_DEBUG("FAILED: slba: 0x%" PRIx64 ", sct: 0x%x, sc: 0x%x", task->slba,
+			    ctx->cpl.status.sct, ctx->cpl.status.sc);
+	}
+
+	xnvme_queue_put_cmd_ctx(ctx->async.queue, ctx);
+
+	_executor_job_task_done(task, err);
+}
+
+static void
+_executor_run(struct xnvme_executor_worker *worker, struct xnvme_executor_task *task)
+{
+	struct xnvme_executor_job *job = task->job;
+	struct xnvme_cmd_ctx *ctx;
+	int err;
+
+	if (!job) {
+		task->fn(worker->queue, task->arg);
+		free(task);
+
+		_executor_worker_update_active(worker);
+		_executor_task_done(worker->exec);
+		return;
+	}
+
+	ctx = xnvme_queue_get_cmd_ctx(worker->queue);
+	if (!ctx) {
+		err = -errno;
+		XNVME_DEBUG("FAILED: xnvme_queue_get_cmd_ctx(), err: %d", err);
+		_executor_job_task_done(task, err);
+		return;
+	}
+	ctx->async.cb = _executor_cmd_cb;
+	ctx->async.cb_arg = task;
+
+	if (job->opcode == XNVME_SPEC_NVM_OPC_WRITE) {
+		err = xnvme_nvm_write(ctx, job->nsid, task->slba, task->nblocks - 1, task->arg, NULL);
+	} else {
+		err = xnvme_nvm_read(ctx, job->nsid, task->slba, task->nblocks - 1, task->arg, NULL);
+	}
+	if (err) {
+		XNVME_DEBUG("FAILED: xnvme_nvm_{read,write}(), err: %d", err);
+		xnvme_queue_put_cmd_ctx(worker->queue, ctx);
+		_executor_job_task_done(task, err);
+		return;
+	}
+
+	_executor_worker_update_active(worker);
+}
+
+/**
+ * Move half of the tasks, at least one, from the tail of the deque of 'victim' to that of 'thief',
+ * returning one of them
+ */
+static struct xnvme_executor_task *
+_executor_steal(struct xnvme_executor_worker *thief, struct xnvme_executor_worker *victim)
+{
+	struct xnvme_executor_tasks stolen = TAILQ_HEAD_INITIALIZER(stolen);
+	struct xnvme_executor_task *task;
+	uint32_t nstolen;
+
+	if (!__atomic_load_n(&victim->ntasks, __ATOMIC_RELAXED)) {
+		return NULL;
+	}
+
+	// The deques are not locked together, as two workers might be stealing from each other
+	pthread_mutex_lock(&victim->mutex);
+	nstolen = (victim->ntasks + 1) / 2;
+	for (uint32_t i = 0; i < nstolen; ++i) {
+		task = TAILQ_LAST(&victim->tasks, xnvme_executor_tasks);
+		TAILQ_REMOVE(&victim->tasks, task, link);
+		TAILQ_INSERT_HEAD(&stolen, task, link);
+	}
+	__atomic_store_n(&victim->ntasks, victim->ntasks - nstolen, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&victim->mutex);
+
+	if (!nstolen) {
+		return NULL;
+	}
+
+	task = TAILQ_FIRST(&stolen);
+	TAILQ_REMOVE(&stolen, task, link);
+	if (nstolen > 1) {
+		pthread_mutex_lock(&thief->mutex);
+		while (!TAILQ_EMPTY(&stolen)) {
+			struct xnvme_executor_task *entry = TAILQ_FIRST(&stolen);
+
+			TAILQ_REMOVE(&stolen, entry, link);
+			TAILQ_INSERT_TAIL(&thief->tasks, entry, link);
+		}
+		__atomic_store_n(&thief->ntasks, thief->ntasks + nstolen - 1, __ATOMIC_RELAXED);
+		pthread_mutex_unlock(&thief->mutex);
+	}
+
+	return task;
+}
+
+/**
+ * Take a task from the head of the deque of the worker, or, when it is empty, steal one
+ */
+static struct xnvme_executor_task *
+_executor_take(struct xnvme_executor_worker *worker)
+{
+	struct xnvme_executor *exec = worker->exec;
+	struct xnvme_executor_task *task = NULL;
+
+	if (!__atomic_load_n(&exec->nqueued, __ATOMIC_ACQUIRE)) {
+		return NULL;
+	}
+
+	if (__atomic_load_n(&worker->ntasks, __ATOMIC_RELAXED)) {
+		pthread_mutex_lock(&worker->mutex);
+		task = TAILQ_FIRST(&worker->tasks);
+		if (task) {
+			TAILQ_REMOVE(&worker->tasks, task, link);
+			__atomic_store_n(&worker->ntasks, worker->ntasks - 1, __ATOMIC_RELAXED);
+		}
+		pthread_mutex_unlock(&worker->mutex);
+	}
+
+	for (uint32_t i = 1; !task && (i < exec->nworkers); ++i) {
+		task = _executor_steal(worker, &exec->workers[(worker->id + i) % exec->nworkers]);
+	}
+
+	if (task) {
+		__atomic_sub_fetch(&exec->nqueued, 1, __ATOMIC_ACQ_REL);
+	}
+
+	return task;
+}
+
+static void
+_executor_push(struct xnvme_executor *exec, struct xnvme_executor_worker *worker,
+	       struct xnvme_executor_task *tasks, uint32_t ntasks)
+{
+	pthread_mutex_lock(&worker->mutex);
+	for (uint32_t i = 0; i < ntasks; ++i) {
+		TAILQ_INSERT_TAIL(&worker->tasks, &tasks[i], link);
+	}
+	__atomic_store_n(&worker->ntasks, worker->ntasks + ntasks, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&worker->mutex);
+
+	__atomic_add_fetch(&exec->nqueued, ntasks, __ATOMIC_ACQ_REL);
+
+	pthread_mutex_lock(&exec->mutex);
+	pthread_cond_broadcast(&exec->work);
+	pthread_mutex_unlock(&exec->mutex);
+}
+
+/**
+ * Record a failure of the worker to reap completions, and wake up xnvme_executor_drain() to report
+ * it; the worker then backs off, exponentially, up to XNVME_EXECUTOR_BACKOFF_NS_MAX
+ */
+static void
+_executor_worker_fail(struct xnvme_executor_worker *worker, int err)
+{
+	struct xnvme_executor *exec = worker->exec;
+	uint64_t backoff_ns = XNVME_EXECUTOR_BACKOFF_NS_MAX;
+	struct timespec ts;
+	int expected = 0;
+
+	XNVME_DEBUG("FAILED: reaping completions, worker: %u, err: %d", worker->id, err);
+
+	if (worker->nfailures < 32) {
+		backoff_ns = XNVME_MIN_U64(XNVME_EXECUTOR_BACKOFF_NS_MIN << worker->nfailures,
+					   XNVME_EXECUTOR_BACKOFF_NS_MAX);
+	}
+	worker->nfailures += 1;
+
+	pthread_mutex_lock(&exec->mutex);
+	__atomic_compare_exchange_n(&exec->err, &expected, err, false, __ATOMIC_RELAXED,
+				    __ATOMIC_RELAXED);
+	pthread_cond_broadcast(&exec->idle);
+	pthread_mutex_unlock(&exec->mutex);
+
+	ts.tv_sec = backoff_ns / 1000000000ULL;
+	ts.tv_nsec = backoff_ns % 1000000000ULL;
+	nanosleep(&ts, NULL);
+}
+
+/**
+ * Fail the tasks left in the deques, on behalf of a worker abandoning its queue
+ */
+static void
+_executor_worker_abandon(struct xnvme_executor_worker *worker, int err)
+{
+	struct xnvme_executor_task *task;
+
+	XNVME_DEBUG("FAILED: abandoning queue, worker: %u, outstanding: %u", worker->id,
+		    xnvme_queue_get_outstanding(worker->queue));
+
+	while ((task = _executor_take(worker))) {
+		if (task->job) {
+			_executor_job_task_done(task, err);
+			continue;
+		}
+		free(task);
+		_executor_task_done(worker->exec);
+	}
+}
+
+static void *
+_executor_worker_loop(void *arg)
+{
+	struct xnvme_executor_worker *worker = arg;
+	struct xnvme_executor *exec = worker->exec;
+	int err;
+
+	err = xnvme_queue_init(exec->dev, exec->qdepth, 0, &worker->queue);
+	if (err) {
+		XNVME_DEBUG("FAILED: xnvme_queue_init(), err: %d", err);
+	}
+
+	pthread_mutex_lock(&exec->mutex);
+	worker->err = err;
+	exec->nstarted += 1;
+	pthread_cond_broadcast(&exec->idle);
+	pthread_mutex_unlock(&exec->mutex);
+
+	if (err) {
+		return NULL;
+	}
+
+	for (;;) {
+		struct xnvme_executor_task *task = NULL;
+		bool stop;
+
+		// A parked worker takes no tasks, leaving its deque to the other workers
+		if (!worker->nfailures &&
+		    (xnvme_queue_get_outstanding(worker->queue) < exec->qdepth)) {
+			task = _executor_take(worker);
+		}
+		if (task) {
+			_executor_run(worker, task);
+			continue;
+		}
+
+		if (xnvme_queue_get_outstanding(worker->queue)) {
+			err = xnvme_queue_poke(worker->queue, 0);
+			if (!err) {
+				err = xnvme_queue_wait_timeout(worker->queue, 1, XNVME_EXECUTOR_WAIT_NS);
+			}
+			if (err < 0) {
+				_executor_worker_fail(worker, err);
+			} else {
+				worker->nfailures = 0;
+			}
+			_executor_worker_update_active(worker);
+
+			if ((worker->nfailures >= XNVME_EXECUTOR_NFAILURES_MAX) &&
+			    __atomic_load_n(&exec->stop, __ATOMIC_ACQUIRE)) {
+				_executor_worker_abandon(worker, err);
+				break;
+			}
+			continue;
+		}
+
+		// Nothing in flight and nothing to take; sleep until tasks are queued
+		pthread_mutex_lock(&exec->mutex);
+		while (!exec->stop && !__atomic_load_n(&exec->nqueued, __ATOMIC_ACQUIRE)) {
+			pthread_cond_wait(&exec->work, &exec->mutex);
+		}
+		stop = exec->stop && !__atomic_load_n(&exec->nqueued, __ATOMIC_ACQUIRE);
+		pthread_mutex_unlock(&exec->mutex);
+
+		if (stop) {
+			break;
+		}
+	}
+
+	xnvme_queue_term(worker->queue);
+
+	return NULL;
+}
+
+static void
+_executor_stop(struct xnvme_executor *exec, uint32_t nthreads)
+{
+	pthread_mutex_lock(&exec->mutex);
+	__atomic_store_n(&exec->stop, true, __ATOMIC_RELEASE);
+	pthread_cond_broadcast(&exec->work);
+	pthread_mutex_unlock(&exec->mutex);
+
+	for (uint32_t i = 0; i < nthreads; ++i) {
+		pthread_join(exec->workers[i].thread, NULL);
+	}
+	for (uint32_t i = 0; i < exec->nworkers; ++i) {
+		pthread_mutex_destroy(&exec->workers[i].mutex);
+	}
+	pthread_cond_destroy(&exec->idle);
+	pthread_cond_destroy(&exec->work);
+	pthread_mutex_destroy(&exec->mutex);
+
+	free(exec);
+}
+
+struct xnvme_executor *
+xnvme_executor_create(struct xnvme_dev *dev, uint32_t nworkers, uint32_t qdepth)
+{
+	const struct xnvme_geo *geo;
+	struct xnvme_executor *exec;
+	uint64_t chunk_nbytes;
+	uint32_t nthreads;
+	int err = 0;
+
+	if (!dev || !nworkers || !qdepth) {
+		XNVME_DEBUG("FAILED: !dev || !nworkers || !qdepth");
+		errno = EINVAL;
+		return NULL;
+	}
+	geo = xnvme_dev_get_geo(dev);
+
+	exec = calloc(1, sizeof(*exec) + nworkers * sizeof(*exec->workers));
+	if (!exec) {
+		XNVME_DEBUG("FAILED: calloc(exec), errno: %d", errno);
+		return NULL;
+	}
+	exec->dev = dev;
+	exec->qdepth = qdepth;
+	exec->nworkers = nworkers;
+
+	chunk_nbytes = geo->mdts_nbytes ? geo->mdts_nbytes : XNVME_EXECUTOR_CHUNK_NBYTES_DEF;
+	exec->chunk_nblocks = XNVME_MIN_U64(chunk_nbytes / geo->lba_nbytes, UINT16_MAX + 1);
+	exec->chunk_nblocks = XNVME_MAX(exec->chunk_nblocks, 1);
+
+	pthread_mutex_init(&exec->mutex, NULL);
+	pthread_cond_init(&exec->work, NULL);
+	pthread_cond_init(&exec->idle, NULL);
+	for (uint32_t i = 0; i < nworkers; ++i) {
+		struct xnvme_executor_worker *worker = &exec->workers[i];
+
+		worker->exec = exec;
+		worker->id = i;
+		pthread_mutex_init(&worker->mutex, NULL);
+		TAILQ_INIT(&worker->tasks);
+	}
+
+	for (nthreads = 0; nthreads < nworkers; ++nthreads) {
+		struct xnvme_executor_worker *worker = &exec->workers[nthreads];
+
+		err = pthread_create(&worker->thread, NULL, _executor_worker_loop, worker);
+		if (err) {
+			XNVME_DEBUG("FAILED: pthread_create(), err: %d", err);
+			err = -err;
+			break;
+		}
+		if (dev->numa_node >= 0) {
+			xnvme_numa_bind_thread(worker->thread, dev->numa_node);
+		}
+	}
+
+	pthread_mutex_lock(&exec->mutex);
+	while (exec->nstarted < nthreads) {
+		pthread_cond_wait(&exec->idle, &exec->mutex);
+	}
+	pthread_mutex_unlock(&exec->mutex);
+
+	for (uint32_t i = 0; !err && (i < nthreads); ++i) {
+		err = exec->workers[i].err;
+	}
+	if (err) {
+		_executor_stop(exec, nthreads);
+		errno = -err;
+		return NULL;
+	}
+
+	return exec;
+}
+
+int
+xnvme_executor_drain(struct xnvme_executor *exec)
+{
+	int err;
+
+	pthread_mutex_lock(&exec->mutex);
+	while (!exec->err && (__atomic_load_n(&exec->npending, __ATOMIC_ACQUIRE) ||
+			      __atomic_load_n(&exec->nactive, __ATOMIC_ACQUIRE))) {
+		pthread_cond_wait(&exec->idle, &exec->mutex);
+	}
+	err = __atomic_exchange_n(&exec->err, 0, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&exec->mutex);
+
+	return err;
+}
+
+void
+xnvme_executor_destroy(struct xnvme_executor *exec)
+{
+	if (!exec) {
+		return;
+	}
+
+	xnvme_executor_drain(exec);
+	_executor_stop(exec, exec->nworkers);
+}
+
+int
+xnvme_executor_submit(struct xnvme_executor *exec, xnvme_executor_fn fn, void *arg)
+{
+	struct xnvme_executor_task *task;
+	uint32_t wid;
+
+	if (!fn) {
+		XNVME_DEBUG("FAILED: !fn");
+		return -EINVAL;
+	}
+
+	task = calloc(1, sizeof(*task));
+	if (!task) {
+		XNVME_DEBUG("FAILED: calloc(task), errno: %d", errno);
+		return -ENOMEM;
+	}
+	task->fn = fn;
+	task->arg = arg;
+
+	__atomic_add_fetch(&exec->npending, 1, __ATOMIC_ACQ_REL);
+
+	wid = __atomic_fetch_add(&exec->next, 1, __ATOMIC_RELAXED) % exec->nworkers;
+	_executor_push(exec, &exec->workers[wid], task, 1);
+
+	return 0;
+}
+
+int
+xnvme_executor_submit_io(struct xnvme_executor *exec, uint8_t opcode, uint32_t nsid, uint64_t slba,
+			 uint64_t nblocks, void *dbuf, xnvme_executor_cb cb, void *cb_arg)
+{
+	const struct xnvme_geo *geo = xnvme_dev_get_geo(exec->dev);
+	struct xnvme_executor_job *job;
+	uint64_t ntasks;
+	uint32_t wid;
+
+	if ((opcode != XNVME_SPEC_NVM_OPC_READ) && (opcode != XNVME_SPEC_NVM_OPC_WRITE)) {
+		XNVME_DEBUG("FAILED: unsupported opcode: 0x%x", opcode);
+		return -EINVAL;
+	}
+	if (!nblocks || !dbuf) {
+		XNVME_DEBUG("FAILED: !nblocks || !dbuf");
+		return -EINVAL;
+	}
+
+	ntasks = (nblocks + exec->chunk_nblocks - 1) / exec->chunk_nblocks;
+	if (ntasks > UINT32_MAX) {
+		XNVME_DEBUG("FAILED: nblocks: %" PRIu64 ", is too large", nblocks);
+		return -EINVAL;
+	}
+
+	job = calloc(1, sizeof(*job) + ntasks * sizeof(*job->tasks));
+	if (!job) {
+		XNVME_DEBUG("FAILED: calloc(job), errno: %d", errno);
+		return -ENOMEM;
+	}
+	job->exec = exec;
+	job->opcode = opcode;
+	job->nsid = nsid;
+	job->cb = cb;
+	job->cb_arg = cb_arg;
+	job->nremaining = ntasks;
+
+	for (uint64_t i = 0; i < ntasks; ++i) {
+		struct xnvme_executor_task *task = &job->tasks[i];
+		uint64_t offset = i * exec->chunk_nblocks;
+
+		task->job = job;
+		task->slba = slba + offset;
+		task->nblocks = XNVME_MIN_U64(nblocks - offset, exec->chunk_nblocks);
+		task->arg = (uint8_t *)dbuf + offset * geo->lba_nbytes;
+	}
+
+	__atomic_add_fetch(&exec->npending, ntasks, __ATOMIC_ACQ_REL);
+
+	// The job is split into a contiguous slice per worker, starting with the next in line
+	wid = __atomic_fetch_add(&exec->next, 1, __ATOMIC_RELAXED);
+	for (uint32_t i = 0; i < exec->nworkers; ++i) {
+		uint64_t first = ntasks * i / exec->nworkers;
+		uint64_t last = ntasks * (i + 1) / exec->nworkers;
+
+		if (first == last) {
+			continue;
+		}
+
+		_executor_push(exec, &exec->workers[(wid + i) % exec->nworkers], &job->tasks[first],
+			       last - first);
+	}
+
+	return 0;
+}
@@ -0,0 +1,161 @@
+// SPDX-FileCopyrightText: Samsung Electronics Co., Ltd
+//
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <errno.h>
+#include <stdint.h>
+#include <libxnvme.h>
+#include <xnvme_be.h>
+#include <xnvme_numa.h>
+#ifdef XNVME_BE_LINUX_ENABLED
+#include <sched.h>
+#include <stdio.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define XNVME_NUMA_MPOL_PREFERRED 1 ///< MPOL_PREFERRED from <linux/mempolicy.h>
+#define XNVME_NUMA_MPOL_MF_MOVE (1 << 1) ///< MPOL_MF_MOVE from <linux/mempolicy.h>
+
+/**
+ * Parse the 'cpulist' of the given NUMA node, e.g. "0-3,8-11", into 'cpus'
+ */
+static int
+_numa_node_cpus(int node, cpu_set_t *cpus)
+{
+	char path[128];
+	char list[4096] = {0};
+	char *tok, *saveptr = NULL;
+	FILE *fp;
+
+	if ((node < 0) || (node >= XNVME_NUMA_NODES_MAX)) {
+		return -EINVAL;
+	}
+
+	snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+	fp = fopen(path, "r");
+	if (!fp) {
+		XNVME_DEBUG("FAILED: fopen(%s), errno: %d", path, errno);
+		return -errno;
+	}
+	if (!fgets(list, sizeof(list), fp)) {
+		fclose(fp);
+		return -EIO;
+	}
+	fclose(fp);
+
+	CPU_ZERO(cpus);
+	for (tok = strtok_r(list, ",\n", &saveptr); tok; tok = strtok_r(NULL, ",\n", &saveptr)) {
+		unsigned int first, last;
+
+		switch (sscanf(tok, "%u-%u", &first, &last)) {
+		case 1:
+			last = first;
+			break;
+		case 2:
+			break;
+		default:
+			return -EINVAL;
+		}
+
+		for (unsigned int cpu = first; (cpu <= last) && (cpu < CPU_SETSIZE); ++cpu) {
+			CPU_SET(cpu, cpus);
+		}
+	}
+
+	return CPU_COUNT(cpus) ? 0 : -ENOENT;
+}
+
+int
+xnvme_numa_bind_mem(void *addr, size_t nbytes, int node)
+{
+	unsigned long nodemask[XNVME_NUMA_NODES_MAX / (8 * sizeof(unsigned long))] = {0};
+	const int nbits = 8 * sizeof(*nodemask);
+	long pagesize = sysconf(_SC_PAGESIZE);
+	uintptr_t start, end;
+
+	if ((node < 0) || (node >= XNVME_NUMA_NODES_MAX) || (pagesize <= 0)) {
+		return -EINVAL;
+	}
+
+	start = ((uintptr_t)addr + pagesize - 1) & ~((uintptr_t)pagesize - 1);
+	end = ((uintptr_t)addr + nbytes) & ~((uintptr_t)pagesize - 1);
+	if (start >= end) {
+		return 0;
+	}
+
+	nodemask[node / nbits] = 1UL << (node % nbits);
+
+	// The kernel uses one bit less than 'maxnode', hence the + 1
+	if (syscall(SYS_mbind, start, end - start, XNVME_NUMA_MPOL_PREFERRED, nodemask,
+		    XNVME_NUMA_NODES_MAX + 1, XNVME_NUMA_MPOL_MF_MOVE)) {
+		XNVME_DEBUG("FAILED: mbind(node: %d), errno: %d", node, errno);
+		return -errno;
+	}
+
+	return 0;
+}
+
+int
+xnvme_numa_bind_thread(pthread_t thread, int node)
+{
+	cpu_set_t cpus;
+	int err;
+
+	err = _numa_node_cpus(node, &cpus);
+	if (err) {
+		return err;
+	}
+
+	err = pthread_setaffinity_np(thread, sizeof(cpus), &cpus);
+	if (err) {
+		XNVME_DEBUG("FAILED: pthread_setaffinity_np(node: %d), err: %d", node, err);
+		return -err;
+	}
+
+	return 0;
+}
+
+int
+xnvme_numa_node_cpu(int node)
+{
+	cpu_set_t cpus;
+	int err;
+
+	err = _numa_node_cpus(node, &cpus);
+	if (err) {
+		return err;
+	}
+
+	for (int cpu = CPU_SETSIZE - 1; cpu >= 0; --cpu) {
+		if (CPU_ISSET(cpu, &cpus)) {
+			return cpu;
+		}
+	}
+
+	return -ENOENT;
+}
+
+#else
+
+int
+xnvme_numa_bind_mem(void *XNVME_UNUSED(addr), size_t XNVME_UNUSED(nbytes), int XNVME_UNUSED(node))
+{
+	return -ENOSYS;
+}
+
+int
+xnvme_numa_bind_thread(pthread_t XNVME_UNUSED(thread), int XNVME_UNUSED(node))
+{
+	return -ENOSYS;
+}
+
+int
+xnvme_numa_node_cpu(int XNVME_UNUSED(node))
+{
+	return -ENOSYS;
+}
+
+#endif
@@ -71,10 +71,22 @@ xnvme_opts_yaml(FILE *stream, const struct xnvme_opts *opts, int indent, const c
 			opts->register_files, sep);
 	wrtn += fprintf(stream, "%*sregister_buffers: %" PRIu8 "%s", indent, "",
 			opts->register_buffers, sep);
+	wrtn += fprintf(stream, "%*sdefer_taskrun: %" PRIu8 "%s", indent, "", opts->defer_taskrun,
+			sep);
+	wrtn += fprintf(stream, "%*scoop_taskrun: %" PRIu8 "%s", indent, "", opts->coop_taskrun,
+			sep);
+	wrtn += fprintf(stream, "%*ssubmit_all: %" PRIu8 "%s", indent, "", opts->submit_all, sep);
+	wrtn += fprintf(stream, "%*sregister_ring_fd: %" PRIu8 "%s", indent, "",
+			opts->register_ring_fd, sep);
 
 	wrtn += fprintf(stream, "%*scss.given: %" PRIu32 "%s", indent, "", opts->css.given, sep);
 	wrtn += fprintf(stream, "%*scss.value: 0x%" PRIx32 "%s", indent, "", opts->css.value, sep);
 
+	wrtn += fprintf(stream, "%*snuma_node.given: %" PRIu32 "%s", indent, "",
+			opts->numa_node.given, sep);
+	wrtn += fprintf(stream, "%*snuma_node.value: %" PRIu32 "%s", indent, "",
+			opts->numa_node.value, sep);
+
 	wrtn += fprintf(stream, "%*suse_cmb_sqs: 0x%" PRIx32 "%s", indent, "", opts->use_cmb_sqs,
 			sep);
 	wrtn += fprintf(stream, "%*sshm_id: 0x%" PRIx32 "%s", indent, "", opts->shm_id, sep);
@@ -99,21 +99,6 @@ xnvme_pi_get_guard(struct xnvme_pif *pif, enum xnvme_spec_nvm_ns_pif pi_format)
 	return guard;
 }
 
-static inline uint64_t
-xnvme_pi_generate_guard(uint64_t guard_seed, void *buf, size_t buf_len,
-			enum xnvme_spec_nvm_ns_pif pi_format)
-{
-	uint64_t guard;
-
-	if (pi_format == XNVME_SPEC_NVM_NS_16B_GUARD) {
-		guard = (uint64_t)xnvme_crc16_t10dif((uint16_t)guard_seed, buf, buf_len);
-	} else {
-		guard = xnvme_crc64_nvme(buf, buf_len, guard_seed);
-	}
-
-	return guard;
-}
-
 static inline void
 xnvme_pi_set_apptag(struct xnvme_pif *pif, uint16_t app_tag, enum xnvme_spec_nvm_ns_pif pi_format)
 {
@@ -138,12 +123,6 @@ xnvme_pi_get_apptag(struct xnvme_pif *pif, enum xnvme_spec_nvm_ns_pif pi_format)
 	return app_tag;
 }
 
-static inline bool
-xnvme_pi_apptag_ignore(struct xnvme_pif *pif, enum xnvme_spec_nvm_ns_pif pi_format)
-{
-	return xnvme_pi_get_apptag(pif, pi_format) == XNVME_APPTAG_IGNORE;
-}
-
 static inline void
 xnvme_pi_set_reftag(struct xnvme_pif *pif, uint64_t ref_tag, enum xnvme_spec_nvm_ns_pif pi_format)
 {
@@ -171,30 +150,6 @@ xnvme_pi_get_reftag(struct xnvme_pif *pif, enum xnvme_spec_nvm_ns_pif pi_format)
 	return ref_tag;
 }
 
-static inline bool
-xnvme_pi_reftag_match(struct xnvme_pif *pif, uint64_t ref_tag,
-		      enum xnvme_spec_nvm_ns_pif pi_format)
-{
-	uint64_t _ref_tag;
-	bool match;
-
-	_ref_tag = xnvme_pi_get_reftag(pif, pi_format);
-
-	if (pi_format == XNVME_SPEC_NVM_NS_16B_GUARD) {
-		match = (_ref_tag == (ref_tag & XNVME_REFTAG_MASK_16));
-	} else {
-		match = (_ref_tag == (ref_tag & XNVME_REFTAG_MASK_64));
-	}
-
-	return match;
-}
-
-static inline bool
-xnvme_pi_reftag_ignore(struct xnvme_pif *pif, enum xnvme_spec_nvm_ns_pif pi_format)
-{
-	return xnvme_pi_reftag_match(pif, XNVME_REFTAG_MASK_32, pi_format);
-}
-
 int
 xnvme_pi_ctx_init(struct xnvme_pi_ctx *ctx, uint32_t block_size, uint32_t md_size,
 		  bool md_interleave, bool pi_loc, enum xnvme_pi_type pi_type, uint32_t pi_flags,
@@ -252,184 +207,239 @@ xnvme_pi_ctx_init(struct xnvme_pi_ctx *ctx, uint32_t block_size, uint32_t md_siz
 	return 0;
 }
 
-void
-xnvme_pi_generate(struct xnvme_pi_ctx *ctx, uint8_t *data_buf, uint8_t *md_buf,
-		  uint32_t num_blocks)
+/**
+ * Number of blocks handled per pass; the guards of a pass are computed as interleaved CRC streams
+ * and the tags of a pass are compared without branching on the individual blocks
+ */
+#define XNVME_PI_BATCH 16
+
+static inline struct xnvme_pif *
+xnvme_pi_get_pif(struct xnvme_pi_ctx *ctx, uint8_t *data_buf, uint8_t *md_buf, uint32_t block)
 {
-	struct xnvme_pif *pif;
-	uint32_t offset_blocks = 0;
-	uint64_t guard;
-	uint64_t ref_tag;
+	if (ctx->md_interleave) {
+		return (void *)(data_buf + (size_t)block * ctx->block_size + ctx->guard_interval);
+	}
 
-	while (offset_blocks < num_blocks) {
-		guard = 0;
+	return (void *)(md_buf + (size_t)block * ctx->md_size + ctx->guard_interval);
+}
 
-		if (ctx->pi_flags & XNVME_PI_FLAGS_GUARD_CHECK) {
-			if (ctx->md_interleave) {
-				guard = xnvme_pi_generate_guard(0, data_buf, ctx->guard_interval,
-								ctx->pi_format);
-			} else {
-				guard = xnvme_pi_generate_guard(0, data_buf, ctx->block_size,
-								ctx->pi_format);
-				guard = xnvme_pi_generate_guard(guard, md_buf, ctx->guard_interval,
-								ctx->pi_format);
-			}
+static inline uint64_t
+xnvme_pi_reftag_mask(enum xnvme_spec_nvm_ns_pif pi_format)
+{
+	if (pi_format == XNVME_SPEC_NVM_NS_16B_GUARD) {
+		return XNVME_REFTAG_MASK_16;
+	}
+
+	return XNVME_REFTAG_MASK_64;
+}
+
+/**
+ * Compute the guards of 'nblocks' consecutive blocks, at most XNVME_PI_BATCH
+ */
+static void
+xnvme_pi_generate_guards(struct xnvme_pi_ctx *ctx, uint8_t *data_buf, uint8_t *md_buf,
+			 uint32_t nblocks, uint64_t *guards)
+{
+	size_t data_len = ctx->md_interleave ? ctx->guard_interval : ctx->block_size;
+	size_t md_len = ctx->md_interleave ? 0 : ctx->guard_interval;
+	const void *data_bufs[XNVME_PI_BATCH];
+	const void *md_bufs[XNVME_PI_BATCH];
+
+	for (uint32_t i = 0; i < nblocks; ++i) {
+		data_bufs[i] = data_buf + (size_t)i * ctx->block_size;
+		md_bufs[i] = md_buf + (size_t)i * ctx->md_size;
+	}
+
+	if (ctx->pi_format == XNVME_SPEC_NVM_NS_16B_GUARD) {
+		uint16_t crcs[XNVME_PI_BATCH] = {0};
+
+		xnvme_crc16_t10dif_mb(crcs, data_bufs, data_len, nblocks);
+		if (md_len) {
+			xnvme_crc16_t10dif_mb(crcs, md_bufs, md_len, nblocks);
+		}
+		for (uint32_t i = 0; i < nblocks; ++i) {
+			guards[i] = crcs[i];
+		}
+	} else {
+		for (uint32_t i = 0; i < nblocks; ++i) {
+			guards[i] = 0;
 		}
 
-		if (ctx->md_interleave) {
-			pif = (struct xnvme_pif *)(data_buf + ctx->guard_interval);
-		} else {
-			pif = (struct xnvme_pif *)(md_buf + ctx->guard_interval);
+		xnvme_crc64_nvme_mb(guards, data_bufs, data_len, nblocks);
+		if (md_len) {
+			xnvme_crc64_nvme_mb(guards, md_bufs, md_len, nblocks);
 		}
+	}
+}
+
+void
+xnvme_pi_generate(struct xnvme_pi_ctx *ctx, uint8_t *data_buf, uint8_t *md_buf,
+		  uint32_t num_blocks)
+{
+	uint64_t guards[XNVME_PI_BATCH];
+
+	for (uint32_t offset_blocks = 0; offset_blocks < num_blocks;) {
+		uint32_t nblocks = num_blocks - offset_blocks;
+
+		nblocks = nblocks < XNVME_PI_BATCH ? nblocks : XNVME_PI_BATCH;
 
 		if (ctx->pi_flags & XNVME_PI_FLAGS_GUARD_CHECK) {
-			xnvme_pi_set_guard(pif, guard, ctx->pi_format);
+			xnvme_pi_generate_guards(ctx, data_buf, md_buf, nblocks, guards);
 		}
 
-		if (ctx->pi_flags & XNVME_PI_FLAGS_APPTAG_CHECK) {
-			xnvme_pi_set_apptag(pif, ctx->app_tag, ctx->pi_format);
-		}
+		for (uint32_t i = 0; i < nblocks; ++i) {
+			struct xnvme_pif *pif = xnvme_pi_get_pif(ctx, data_buf, md_buf, i);
+
+			if (ctx->pi_flags & XNVME_PI_FLAGS_GUARD_CHECK) {
+				xnvme_pi_set_guard(pif, guards[i], ctx->pi_format);
+			}
 
-		if (ctx->pi_flags & XNVME_PI_FLAGS_REFTAG_CHECK) {
-			if (ctx->pi_type != XNVME_PI_TYPE3) {
-				ref_tag = ctx->init_ref_tag + offset_blocks;
-			} else {
-				ref_tag = ctx->init_ref_tag;
+			if (ctx->pi_flags & XNVME_PI_FLAGS_APPTAG_CHECK) {
+				xnvme_pi_set_apptag(pif, ctx->app_tag, ctx->pi_format);
 			}
 
-			xnvme_pi_set_reftag(pif, ref_tag, ctx->pi_format);
+			if (ctx->pi_flags & XNVME_PI_FLAGS_REFTAG_CHECK) {
+				uint64_t ref_tag = ctx->init_ref_tag;
+
+				if (ctx->pi_type != XNVME_PI_TYPE3) {
+					ref_tag += offset_blocks + i;
+				}
+
+				xnvme_pi_set_reftag(pif, ref_tag, ctx->pi_format);
+			}
 		}
 
-		data_buf += ctx->block_size;
+		data_buf += (size_t)nblocks * ctx->block_size;
 		if (!ctx->md_interleave) {
-			md_buf += ctx->md_size;
+			md_buf += (size_t)nblocks * ctx->md_size;
 		}
-		offset_blocks++;
+		offset_blocks += nblocks;
 	}
 }
 
-int
-xnvme_pi_verify(struct xnvme_pi_ctx *ctx, uint8_t *data_buf, uint8_t *md_buf, uint32_t num_blocks)
+/**
+ * Fill in 'err' with the first failing check of a block, in the order: guard, app tag, ref tag
+ */
+static void
+xnvme_pi_verify_fill_err(struct xnvme_pi_err *err, uint32_t block, uint8_t failed,
+			 uint64_t guard, uint64_t _guard, uint16_t app_tag, uint16_t _app_tag,
+			 uint64_t ref_tag, uint64_t _ref_tag)
 {
-	struct xnvme_pif *pif;
-	uint32_t offset_blocks = 0;
-	uint64_t _guard, guard = 0;
-	uint16_t _app_tag;
-	uint64_t ref_tag;
+	err->block = block;
+
+	if (failed & XNVME_PI_FLAGS_GUARD_CHECK) {
+		err->field = XNVME_PI_FLAGS_GUARD_CHECK;
+		err->expected = guard;
+		err->actual = _guard;
+		XNVME_DEBUG("Failed to compare Guard: block=%" PRIu32 ", Expected=%" PRIx64
+			    ", Actual=%" PRIx64,
+			    block, guard, _guard);
+	} else if (failed & XNVME_PI_FLAGS_APPTAG_CHECK) {
+		err->field = XNVME_PI_FLAGS_APPTAG_CHECK;
+		err->expected = app_tag;
+		err->actual = _app_tag;
+		XNVME_DEBUG("Failed to compare App Tag: block=%" PRIu32 ", Expected=%x, Actual=%x",
+			    block, app_tag, _app_tag);
+	} else {
+		err->field = XNVME_PI_FLAGS_REFTAG_CHECK;
+		err->expected = ref_tag;
+		err->actual = _ref_tag;
+		XNVME_DEBUG("Failed to compare Ref Tag: block=%" PRIu32 ", Expected=%" PRIx64
+			    ", Actual=%" PRIx64,
+			    block, ref_tag, _ref_tag);
+	}
+}
 
-	while (offset_blocks < num_blocks) {
-		if (ctx->pi_flags & XNVME_PI_FLAGS_GUARD_CHECK) {
-			if (ctx->md_interleave) {
-				guard = xnvme_pi_generate_guard(0, data_buf, ctx->guard_interval,
-								ctx->pi_format);
-			} else {
-				guard = xnvme_pi_generate_guard(0, data_buf, ctx->block_size,
-								ctx->pi_format);
-				guard = xnvme_pi_generate_guard(guard, md_buf, ctx->guard_interval,
-								ctx->pi_format);
-			}
+int
+xnvme_pi_verify_report(struct xnvme_pi_ctx *ctx, uint8_t *data_buf, uint8_t *md_buf,
+		       uint32_t num_blocks, struct xnvme_pi_err *err)
+{
+	const uint64_t ref_mask = xnvme_pi_reftag_mask(ctx->pi_format);
+	const uint16_t app_tag = ctx->app_tag & ctx->apptag_mask;
+	const bool check_guard = ctx->pi_flags & XNVME_PI_FLAGS_GUARD_CHECK;
+	const bool check_apptag = ctx->pi_flags & XNVME_PI_FLAGS_APPTAG_CHECK;
+	/* For Type 3, computed Reference Tag remains unchanged. Hence ignore the Reference Tag
+	 * field.
+	 */
+	const bool check_reftag = (ctx->pi_flags & XNVME_PI_FLAGS_REFTAG_CHECK) &&
+				  (ctx->pi_type == XNVME_PI_TYPE1 ||
+				   ctx->pi_type == XNVME_PI_TYPE2);
+	/* If Type 1 or 2 is used, then all PI checks of a block are disabled when its Application
+	 * Tag is 0xFFFF. If Type 3 is used, then all reference tag bits must also be set.
+	 */
+	const bool ignorable = ctx->pi_type == XNVME_PI_TYPE1 || ctx->pi_type == XNVME_PI_TYPE2 ||
+			       ctx->pi_type == XNVME_PI_TYPE3;
+	const bool ignore_reftag = ctx->pi_type == XNVME_PI_TYPE3;
+	uint64_t guards[XNVME_PI_BATCH] = {0}, _guards[XNVME_PI_BATCH];
+	uint64_t ref_tags[XNVME_PI_BATCH], _ref_tags[XNVME_PI_BATCH];
+	uint16_t _app_tags[XNVME_PI_BATCH];
+	uint8_t failed[XNVME_PI_BATCH];
+	struct xnvme_pi_err _err;
+
+	for (uint32_t offset_blocks = 0; offset_blocks < num_blocks;) {
+		uint32_t nblocks = num_blocks - offset_blocks;
+		uint8_t any = 0;
+
+		nblocks = nblocks < XNVME_PI_BATCH ? nblocks : XNVME_PI_BATCH;
+
+		if (check_guard) {
+			xnvme_pi_generate_guards(ctx, data_buf, md_buf, nblocks, guards);
 		}
 
-		if (ctx->md_interleave) {
-			pif = (struct xnvme_pif *)(data_buf + ctx->guard_interval);
-		} else {
-			pif = (struct xnvme_pif *)(md_buf + ctx->guard_interval);
-		}
+		// Gather the fields, such that the comparison below is over contiguous arrays
+		for (uint32_t i = 0; i < nblocks; ++i) {
+			struct xnvme_pif *pif = xnvme_pi_get_pif(ctx, data_buf, md_buf, i);
 
-		switch (ctx->pi_type) {
-		case XNVME_PI_TYPE1:
-		case XNVME_PI_TYPE2:
-			/* If Type 1 or 2 is used, then all PI checks are disabled when
-			 * the Application Tag is 0xFFFF.
-			 */
-			if (xnvme_pi_apptag_ignore(pif, ctx->pi_format)) {
-				return 0;
-			}
-			break;
-		case XNVME_PI_TYPE3:
-			/* If Type 3 is used, then all PI checks are disabled when the
-			 * Application Tag is 0xFFFF and all Reference Tag bits set.
+			_guards[i] = check_guard ? xnvme_pi_get_guard(pif, ctx->pi_format) : 0;
+			_app_tags[i] = xnvme_pi_get_apptag(pif, ctx->pi_format);
+			_ref_tags[i] = xnvme_pi_get_reftag(pif, ctx->pi_format);
+
+			/* For type 1 and 2, the reference tag is incremented for each
+			 * subsequent logical block.
 			 */
-			if (xnvme_pi_apptag_ignore(pif, ctx->pi_format) &&
-			    xnvme_pi_reftag_ignore(pif, ctx->pi_format)) {
-				return 0;
-			}
-			break;
-		default:
-			break;
+			ref_tags[i] = (ctx->init_ref_tag + offset_blocks + i) & ref_mask;
 		}
 
-		/* For type 1 and 2, the reference tag is incremented for each
-		 * subsequent logical block. For type 3, the reference tag
-		 * remains the same as the initial reference tag.
-		 */
-		if (ctx->pi_type != XNVME_PI_TYPE3) {
-			ref_tag = ctx->init_ref_tag + offset_blocks;
-		} else {
-			ref_tag = ctx->init_ref_tag;
-		}
+		// Branch-free over the blocks, such that the compiler is free to vectorize it
+		for (uint32_t i = 0; i < nblocks; ++i) {
+			uint8_t ignore = ignorable & (_app_tags[i] == XNVME_APPTAG_IGNORE) &
+					 (!ignore_reftag | (_ref_tags[i] == ref_mask));
+			uint8_t fields = 0;
 
-		if (ctx->pi_flags & XNVME_PI_FLAGS_GUARD_CHECK) {
-			/* Compare the PI Guard field to the CRC computed over the logical
-			 * block data.
-			 */
-			_guard = xnvme_pi_get_guard(pif, ctx->pi_format);
-			if (_guard != guard) {
-				XNVME_DEBUG("Failed to compare Guard: LBA=%" PRIu64 ","
-					    "  Expected=%lx, Actual=%lx\n",
-					    ref_tag, _guard, guard);
-				return -1;
-			}
-		}
+			fields |= (_guards[i] != guards[i]) * XNVME_PI_FLAGS_GUARD_CHECK;
+			fields |= (check_apptag & ((_app_tags[i] & ctx->apptag_mask) != app_tag)) *
+				  XNVME_PI_FLAGS_APPTAG_CHECK;
+			fields |= (check_reftag & (_ref_tags[i] != ref_tags[i])) *
+				  XNVME_PI_FLAGS_REFTAG_CHECK;
 
-		if (ctx->pi_flags & XNVME_PI_FLAGS_APPTAG_CHECK) {
-			/* Compare unmasked bits in the PI Application Tag field to the
-			 * passed Application Tag.
-			 */
-			_app_tag = xnvme_pi_get_apptag(pif, ctx->pi_format);
-			if ((_app_tag & ctx->apptag_mask) != (ctx->app_tag & ctx->apptag_mask)) {
-				XNVME_DEBUG("Failed to compare App Tag: LBA=%" PRIu64 ","
-					    "  Expected=%x, Actual=%x\n",
-					    ref_tag, (ctx->app_tag & ctx->apptag_mask),
-					    (_app_tag & ctx->apptag_mask));
-				return -1;
-			}
+			failed[i] = ignore ? 0 : fields;
+			any |= failed[i];
 		}
 
-		if (ctx->pi_flags & XNVME_PI_FLAGS_REFTAG_CHECK) {
-			switch (ctx->pi_type) {
-			case XNVME_PI_TYPE1:
-			case XNVME_PI_TYPE2:
-				/* Compare the PI Reference Tag field to the passed Reference Tag.
-				 * The passed Reference Tag will be the least significant 4 bytes
-				 * or 8 bytes (depending on the PI format)
-				 * of the LBA when Type 1 is used, and application specific value
-				 * if Type 2 is used.
-				 */
-				if (!xnvme_pi_reftag_match(pif, ref_tag, ctx->pi_format)) {
-					XNVME_DEBUG("Failed to compare Ref Tag: LBA=%" PRIu64 ","
-						    " Expected=%lx, Actual=%lx\n",
-						    ref_tag, ref_tag,
-						    xnvme_pi_get_reftag(pif, ctx->pi_format));
-					return -1;
-				}
-				break;
-			case XNVME_PI_TYPE3:
-				/* For Type 3, computed Reference Tag remains unchanged.
-				 * Hence ignore the Reference Tag field.
-				 */
-				break;
-			default:
-				break;
+		for (uint32_t i = 0; any && i < nblocks; ++i) {
+			if (!failed[i]) {
+				continue;
 			}
+
+			xnvme_pi_verify_fill_err(err ? err : &_err, offset_blocks + i, failed[i],
+						 guards[i], _guards[i], app_tag,
+						 _app_tags[i] & ctx->apptag_mask, ref_tags[i],
+						 _ref_tags[i]);
+			return -EIO;
 		}
 
-		data_buf += ctx->block_size;
+		data_buf += (size_t)nblocks * ctx->block_size;
 		if (!ctx->md_interleave) {
-			md_buf += ctx->md_size;
+			md_buf += (size_t)nblocks * ctx->md_size;
 		}
-		offset_blocks++;
+		offset_blocks += nblocks;
 	}
 
 	return 0;
 }
+
+int
+xnvme_pi_verify(struct xnvme_pi_ctx *ctx, uint8_t *data_buf, uint8_t *md_buf, uint32_t num_blocks)
+{
+	return xnvme_pi_verify_report(ctx, data_buf, md_buf, num_blocks, NULL);
+}
@@ -0,0 +1,371 @@
+// SPDX-FileCopyrightText: Samsung Electronics Co., Ltd
+//
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <errno.h>
+#include <time.h>
+#ifndef WIN32
+#include <poll.h>
+#include <unistd.h>
+#endif
+#include <libxnvme.h>
+#include <xnvme_be.h>
+#include <xnvme_queue.h>
+
+#define XNVME_POLL_GROUP_FD_UNKNOWN -2
+
+// Longest wait on a busy queue without a completion fd, before the other queues are served
+#define XNVME_POLL_GROUP_WAIT_SLICE_NS 100000ULL
+
+struct xnvme_poll_group_entry {
+	struct xnvme_queue *queue;
+	int fd; ///< Completion fd of the queue, -1 when it has none, obtained on first wait
+};
+
+/**
+ * The queues are kept in a dense array, a removed queue is replaced by the last one, such that
+ * poking the group is a walk of 'nqueues' entries starting at 'next'.
+ */
+struct xnvme_poll_group {
+	uint32_t capacity;
+	uint32_t nqueues;
+	uint32_t next; ///< Entry at which the next poke starts
+
+#ifndef WIN32
+	struct pollfd *pfds;
+#endif
+	struct xnvme_poll_group_entry entries[];
+};
+
+static inline bool
+_group_entry_is_busy(struct xnvme_poll_group_entry *entry)
+{
+	struct xnvme_queue *queue = entry->queue;
+
+	return xnvme_queue_get_outstanding(queue) || xnvme_queue_backlog_len(queue) ||
+	       xnvme_queue_shared_len(queue);
+}
+
+struct xnvme_poll_group *
+xnvme_poll_group_create(uint32_t capacity)
+{
+	struct xnvme_poll_group *group;
+
+	if (!capacity) {
+		XNVME_DEBUG("FAILED: invalid capacity: %u", capacity);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	group = calloc(1, sizeof(*group) + capacity * sizeof(*group->entries));
+	if (!group) {
+		XNVME_DEBUG("FAILED: calloc(group), errno: %d", errno);
+		return NULL;
+	}
+#ifndef WIN32
+	group->pfds = calloc(capacity, sizeof(*group->pfds));
+	if (!group->pfds) {
+		XNVME_DEBUG("FAILED: calloc(pfds), errno: %d", errno);
+		free(group);
+		errno = ENOMEM;
+		return NULL;
+	}
+#endif
+	group->capacity = capacity;
+
+	return group;
+}
+
+void
+xnvme_poll_group_destroy(struct xnvme_poll_group *group)
+{
+	if (!group) {
+		return;
+	}
+
+#ifndef WIN32
+	free(group->pfds);
+#endif
+	free(group);
+}
+
+int
+xnvme_poll_group_add(struct xnvme_poll_group *group, struct xnvme_queue *queue)
+{
+	if (!queue) {
+		XNVME_DEBUG("FAILED: !queue");
+		return -EINVAL;
+	}
+	for (uint32_t i = 0; i < group->nqueues; ++i) {
+		if (group->entries[i].queue == queue) {
+			XNVME_DEBUG("FAILED: queue is already in the poll-group");
+			return -EEXIST;
+		}
+	}
+	if (group->nqueues == group->capacity) {
+		XNVME_DEBUG("FAILED: poll-group is full");
+		return -ENOSPC;
+	}
+
+	group->entries[group->nqueues].queue = queue;
+	group->entries[group->nqueues].fd = XNVME_POLL_GROUP_FD_UNKNOWN;
+	group->nqueues += 1;
+
+	return 0;
+}
+
+int
+xnvme_poll_group_remove(struct xnvme_poll_group *group, struct xnvme_queue *queue)
+{
+	for (uint32_t i = 0; i < group->nqueues; ++i) {
+		if (group->entries[i].queue != queue) {
+			continue;
+		}
+
+		group->nqueues -= 1;
+		group->entries[i] = group->entries[group->nqueues];
+		if (group->next >= group->nqueues) {
+			group->next = 0;
+		}
+
+		return 0;
+	}
+
+	XNVME_DEBUG("FAILED: queue is not in the poll-group");
+	return -ENOENT;
+}
+
+int
+xnvme_poll_group_poke(struct xnvme_poll_group *group, uint32_t budget)
+{
+	uint32_t acc = 0;
+
+	for (uint32_t i = 0; i < group->nqueues; ++i) {
+		uint32_t idx = (group->next + i) % group->nqueues;
+		struct xnvme_poll_group_entry *entry = &group->entries[idx];
+		int ret;
+
+		if (!_group_entry_is_busy(entry)) {
+			continue;
+		}
+
+		ret = xnvme_queue_poke(entry->queue, budget ? budget - acc : 0);
+		if (ret < 0) {
+			XNVME_DEBUG("FAILED: xnvme_queue_poke(), err: %d", ret);
+			group->next = (idx + 1) % group->nqueues;
+			return ret;
+		}
+		acc += ret;
+
+		if (budget && (acc >= budget)) {
+			group->next = (idx + 1) % group->nqueues;
+			return acc;
+		}
+	}
+
+	// Rotate the start, such that the first queue is not always the first to be poked
+	if (group->nqueues) {
+		group->next = (group->next + 1) % group->nqueues;
+	}
+
+	return acc;
+}
+
+#ifndef WIN32
+/**
+ * Sleep in poll() on the completion fds of the busy queues, until one of them is signaled or
+ * 'timeout_ns' has passed, 0 means no timeout
+ *
+ * A completion fd is obtained when its queue is first waited upon, at which point completions
+ * might already have been posted without signaling it, thus, the queues are poked again before
+ * sleeping on a newly obtained completion fd.
+ *
+ * @return 0 when slept, or returning without sleeping, -ENOTSUP when a busy queue has no
+ * completion fd, otherwise negative errno
+ */
+static int
+_group_poll(struct xnvme_poll_group *group, uint64_t timeout_ns)
+{
+	int timeout_ms = -1;
+	bool fresh = false;
+	nfds_t nfds = 0;
+	int ret;
+
+	for (uint32_t i = 0; i < group->nqueues; ++i) {
+		struct xnvme_poll_group_entry *entry = &group->entries[i];
+
+		if (!_group_entry_is_busy(entry)) {
+			continue;
+		}
+		if (entry->fd == XNVME_POLL_GROUP_FD_UNKNOWN) {
+			entry->fd = xnvme_queue_get_completion_fd(entry->queue);
+			entry->fd = entry->fd < 0 ? -1 : entry->fd;
+			fresh = true;
+		}
+		if (entry->fd < 0) {
+			return -ENOTSUP;
+		}
+
+		group->pfds[nfds].fd = entry->fd;
+		group->pfds[nfds].events = POLLIN;
+		group->pfds[nfds].revents = 0;
+		nfds += 1;
+	}
+	if (fresh) {
+		return 0;
+	}
+
+	// Round up, such that a sub-millisecond remainder does not spin
+	if (timeout_ns) {
+		timeout_ms = XNVME_MIN_U64((timeout_ns + 999999ULL) / 1000000ULL, INT32_MAX);
+	}
+
+	ret = poll(group->pfds, nfds, timeout_ms);
+	if (ret < 0) {
+		return errno == EINTR ? 0 : -errno;
+	}
+
+	// Consume the eventfd counters before the queues are poked, completions arriving thereafter
+	// signal the eventfd again
+	for (nfds_t i = 0; ret && (i < nfds); ++i) {
+		uint64_t val;
+
+		if (!(group->pfds[i].revents & POLLIN)) {
+			continue;
+		}
+		if (read(group->pfds[i].fd, &val, sizeof(val)) < 0) {
+			XNVME_DEBUG("FAILED: read(efd), errno: %d", errno);
+		}
+	}
+
+	return 0;
+}
+#endif
+
+/**
+ * Wait on a busy queue without a completion fd, for at most XNVME_POLL_GROUP_WAIT_SLICE_NS or
+ * 'timeout_ns' when sooner, such that the thread sleeps in the wait of the backend, rather than
+ * spinning on xnvme_poll_group_poke(), while the other queues are served in between slices
+ *
+ * @return On success, the number of completions processed is returned. On error, negative
+ * `errno` is returned.
+ */
+static int
+_group_wait_slice(struct xnvme_poll_group *group, uint32_t min, uint64_t timeout_ns)
+{
+	uint64_t slice = XNVME_POLL_GROUP_WAIT_SLICE_NS;
+
+	if (timeout_ns && (timeout_ns < slice)) {
+		slice = timeout_ns;
+	}
+
+	for (uint32_t i = 0; i < group->nqueues; ++i) {
+		struct xnvme_poll_group_entry *entry = &group->entries[(group->next + i) %
+									group->nqueues];
+
+		if ((entry->fd >= 0) || !_group_entry_is_busy(entry)) {
+			continue;
+		}
+
+		return xnvme_queue_wait_timeout(entry->queue, min, slice);
+	}
+
+	return 0;
+}
+
+int
+xnvme_poll_group_wait(struct xnvme_poll_group *group, uint32_t min_completions,
+		      uint64_t timeout_ns)
+{
+	uint64_t deadline = timeout_ns ? _xnvme_timer_clock_sample() + timeout_ns : 0;
+	uint32_t min = 0;
+	uint32_t acc = 0;
+
+	for (uint32_t i = 0; i < group->nqueues; ++i) {
+		struct xnvme_queue *queue = group->entries[i].queue;
+
+		min += xnvme_queue_get_outstanding(queue) + xnvme_queue_backlog_len(queue) +
+		       xnvme_queue_shared_len(queue);
+	}
+	if (min_completions && (min_completions < min)) {
+		min = min_completions;
+	}
+
+	while (acc < min) {
+		struct xnvme_poll_group_entry *busy = NULL;
+		uint64_t remaining = 0;
+		uint32_t nbusy = 0;
+		int ret;
+
+		ret = xnvme_poll_group_poke(group, 0);
+		if (ret < 0) {
+			return ret;
+		}
+		acc += ret;
+		if (acc >= min) {
+			break;
+		}
+
+		for (uint32_t i = 0; i < group->nqueues; ++i) {
+			if (_group_entry_is_busy(&group->entries[i])) {
+				busy = &group->entries[i];
+				nbusy += 1;
+			}
+		}
+		if (!nbusy) {
+			break;
+		}
+		if (deadline) {
+			uint64_t now = _xnvme_timer_clock_sample();
+
+			if (now >= deadline) {
+				break;
+			}
+			remaining = deadline - now;
+		}
+
+		if (nbusy == 1) {
+			ret = xnvme_queue_wait_timeout(busy->queue, min - acc, remaining);
+			if (ret < 0) {
+				XNVME_DEBUG("FAILED: xnvme_queue_wait_timeout(), err: %d", ret);
+				return ret;
+			}
+			acc += ret;
+			continue;
+		}
+
+#ifndef WIN32
+		// Wake up for the earliest command deadline, such that its watchdog runs
+		for (uint32_t i = 0; i < group->nqueues; ++i) {
+			uint64_t next = xnvme_queue_timeout_next(group->entries[i].queue);
+			uint64_t now;
+
+			if (!next) {
+				continue;
+			}
+			now = _xnvme_timer_clock_sample();
+			next = next > now ? next - now : 1;
+			remaining = (!remaining || (next < remaining)) ? next : remaining;
+		}
+
+		ret = _group_poll(group, remaining);
+		if (ret != -ENOTSUP) {
+			if (ret) {
+				XNVME_DEBUG("FAILED: poll(), err: %d", ret);
+				return ret;
+			}
+			continue;
+		}
+#endif
+
+		// A busy queue has no completion fd to poll(), or there is no poll() at all
+		ret = _group_wait_slice(group, min - acc, remaining);
+		if (ret < 0) {
+			XNVME_DEBUG("FAILED: _group_wait_slice(), err: %d", ret);
+			return ret;
+		}
+		acc += ret;
+	}
+
+	return acc;
+}
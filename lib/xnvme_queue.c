@@ -4,6 +4,7 @@
 
 #include <stdio.h>
 #include <errno.h>
+#include <time.h>
 #include <libxnvme.h>
 #include <xnvme_be.h>
 #include <xnvme_cmd.h>
@@ -25,6 +26,11 @@ xnvme_queue_term(struct xnvme_queue *queue)
 		XNVME_DEBUG("FAILED: backend queue-termination failed with err: %d", err);
 	}
 
+	xnvme_queue_pi_term(queue);
+	xnvme_queue_timeout_term(queue);
+	xnvme_queue_shared_term(queue);
+	xnvme_queue_backlog_term(queue);
+
 	free(queue);
 
 	return err;
@@ -36,9 +42,28 @@ callback_noop(struct xnvme_cmd_ctx *XNVME_UNUSED(ctx), void *XNVME_UNUSED(cb_arg
 	return;
 }
 
+/**
+ * Initialize the next entry of the pool-storage, taking the callback from the first entry
+ */
+static struct xnvme_cmd_ctx_entry *
+queue_ctx_init(struct xnvme_queue *queue)
+{
+	struct xnvme_cmd_ctx_entry *entry = &queue->pool_storage[queue->base.pool_ninit];
+
+	entry->dev = queue->base.dev;
+	entry->async.queue = queue;
+	entry->async.cb = queue->base.pool_ninit ? queue->pool_storage[0].async.cb : callback_noop;
+	entry->async.cb_arg = queue->base.pool_ninit ? queue->pool_storage[0].async.cb_arg : NULL;
+	entry->opts = XNVME_CMD_ASYNC;
+	entry->id = queue->base.pool_ninit++;
+
+	return entry;
+}
+
 int
-xnvme_queue_init(struct xnvme_dev *dev, uint16_t capacity, int opts, struct xnvme_queue **queue)
+xnvme_queue_init(struct xnvme_dev *dev, uint32_t capacity, int opts, struct xnvme_queue **queue)
 {
+	struct xnvme_cmd_ctx_entry *entry;
 	size_t queue_nbytes;
 	int err;
 
@@ -46,13 +71,16 @@ xnvme_queue_init(struct xnvme_dev *dev, uint16_t capacity, int opts, struct xnvm
 		XNVME_DEBUG("FAILED: !dev");
 		return -EINVAL;
 	}
-	if (!(xnvme_is_pow2(capacity) && (capacity < 4096))) {
+	if (!(xnvme_is_pow2(capacity) && (capacity <= XNVME_QUEUE_CAPACITY_MAX))) {
 		XNVME_DEBUG("EINVAL: capacity: %u", capacity);
 		return -EINVAL;
 	}
 
 	queue_nbytes = sizeof(**queue) + (capacity + 1) * sizeof(*((*queue)->pool_storage));
 
+	// The pool-storage is left untouched beyond the first entry, the remaining entries are
+	// initialized by xnvme_queue_get_cmd_ctx() on first use, thus, pages of the pool not
+	// touched by calloc() are placed, by first-touch, on the NUMA node of the thread using it
 	*queue = calloc(1, queue_nbytes);
 	if (!*queue) {
 		XNVME_DEBUG("FAILED: calloc(queue), err: %s", strerror(errno));
@@ -61,18 +89,10 @@ xnvme_queue_init(struct xnvme_dev *dev, uint16_t capacity, int opts, struct xnvm
 	(*queue)->base.capacity = capacity;
 	(*queue)->base.dev = dev;
 
+	// SLIST_INSERT_HEAD() evaluates the element more than once, thus, initialize it up front
+	entry = queue_ctx_init(*queue);
 	SLIST_INIT(&(*queue)->base.pool);
-
-	for (uint32_t i = 0; i <= (*queue)->base.capacity; ++i) {
-		(*queue)->pool_storage[i].dev = dev;
-		(*queue)->pool_storage[i].async.queue = *queue;
-		(*queue)->pool_storage[i].async.cb = callback_noop;
-		(*queue)->pool_storage[i].async.cb_arg = NULL;
-		(*queue)->pool_storage[i].opts = XNVME_CMD_ASYNC;
-		(*queue)->pool_storage[i].id = i;
-
-		SLIST_INSERT_HEAD(&(*queue)->base.pool, &((*queue)->pool_storage[i]), link);
-	}
+	SLIST_INSERT_HEAD(&(*queue)->base.pool, entry, link);
 
 	err = dev->be.async.init(*queue, opts);
 	if (err) {
@@ -88,24 +108,96 @@ xnvme_queue_init(struct xnvme_dev *dev, uint16_t capacity, int opts, struct xnvm
 int
 xnvme_queue_set_cb(struct xnvme_queue *queue, xnvme_queue_cb cb, void *cb_arg)
 {
-	for (uint32_t i = 0; i <= queue->base.capacity; ++i) {
+	for (uint32_t i = 0; i < queue->base.pool_ninit; ++i) {
 		queue->pool_storage[i].async.cb = cb;
 		queue->pool_storage[i].async.cb_arg = cb_arg;
 	}
+	xnvme_queue_backlog_set_cb(queue, cb, cb_arg);
 
 	return 0;
 }
 
 int
-xnvme_queue_poke(struct xnvme_queue *queue, uint32_t max)
+xnvme_queue_submit_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes, void *mbuf,
+		      size_t mbuf_nbytes)
+{
+	struct xnvme_queue *queue = ctx->async.queue;
+	bool armed = queue->base.timeout && xnvme_queue_timeout_arm(ctx);
+	int err;
+
+	if (queue->base.pi) {
+		err = xnvme_queue_pi_cmd_io(ctx, dbuf, dbuf_nbytes, mbuf, mbuf_nbytes);
+	} else {
+		err = ctx->dev->be.async.cmd_io(ctx, dbuf, dbuf_nbytes, mbuf, mbuf_nbytes);
+	}
+	if (err && armed) {
+		xnvme_queue_timeout_disarm(ctx);
+	}
+
+	return err;
+}
+
+int
+xnvme_queue_submit_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, size_t dvec_cnt,
+		       size_t dvec_nbytes, void *mbuf, size_t mbuf_nbytes)
+{
+	struct xnvme_queue *queue = ctx->async.queue;
+	bool armed = queue->base.timeout && xnvme_queue_timeout_arm(ctx);
+	int err;
+
+	if (queue->base.pi) {
+		err = xnvme_queue_pi_cmd_iov(ctx, dvec, dvec_cnt, dvec_nbytes, mbuf, mbuf_nbytes);
+	} else {
+		err = ctx->dev->be.async.cmd_iov(ctx, dvec, dvec_cnt, dvec_nbytes, mbuf,
+						 mbuf_nbytes);
+	}
+	if (err && armed) {
+		xnvme_queue_timeout_disarm(ctx);
+	}
+
+	return err;
+}
+
+void
+xnvme_queue_complete_err(struct xnvme_cmd_ctx *ctx, int err)
+{
+	ctx->cpl.status.sc = -err;
+	ctx->cpl.status.sct = XNVME_STATUS_CODE_TYPE_VENDOR;
+	ctx->async.cb(ctx, ctx->async.cb_arg);
+}
+
+static int
+queue_poke(struct xnvme_queue *queue, uint32_t max)
 {
+	if (queue->base.shared) {
+		xnvme_queue_shared_refill(queue);
+	}
+	if (queue->base.backlog) {
+		return xnvme_queue_backlog_poke(queue, max);
+	}
 	if (!queue->base.outstanding) {
 		return 0;
 	}
+	if (queue->base.pi) {
+		return xnvme_queue_pi_poke(queue, max);
+	}
 
 	return queue->base.dev->be.async.poke(queue, max);
 }
 
+int
+xnvme_queue_poke(struct xnvme_queue *queue, uint32_t max)
+{
+	int ret = queue_poke(queue, max);
+
+	// Cancellations requested by the watchdog are completed by a subsequent poke
+	if (queue->base.timeout) {
+		xnvme_queue_timeout_scan(queue);
+	}
+
+	return ret;
+}
+
 int
 xnvme_queue_wait(struct xnvme_queue *queue)
 {
@@ -119,7 +211,8 @@ xnvme_queue_drain(struct xnvme_queue *queue)
 {
 	int acc = 0;
 
-	while (queue->base.outstanding) {
+	while (queue->base.outstanding || xnvme_queue_backlog_len(queue) ||
+	       xnvme_queue_shared_len(queue)) {
 		int err;
 
 		err = xnvme_queue_poke(queue, 0);
@@ -134,6 +227,123 @@ xnvme_queue_drain(struct xnvme_queue *queue)
 	return acc;
 }
 
+/**
+ * Fallback for backends without a blocking wait; poke until 'min' completions are processed or
+ * the deadline has passed
+ */
+static int
+queue_wait_poke(struct xnvme_queue *queue, uint32_t min, uint64_t timeout_ns)
+{
+	uint64_t deadline = timeout_ns ? _xnvme_timer_clock_sample() + timeout_ns : 0;
+	int acc = 0;
+
+	while (queue->base.outstanding && (uint32_t)acc < min) {
+		int err;
+
+		err = xnvme_queue_poke(queue, 0);
+		if (err < 0) {
+			XNVME_DEBUG("FAILED: xnvme_queue_poke(), err: %d", err);
+			return err;
+		}
+		acc += err;
+
+		if (deadline && _xnvme_timer_clock_sample() >= deadline) {
+			break;
+		}
+	}
+
+	return acc;
+}
+
+/**
+ * Wait on the backend in slices ending no later than the earliest command deadline, such that the
+ * watchdog gets to cancel the commands outstanding past their deadline while waiting
+ */
+static int
+queue_wait_deadlines(struct xnvme_queue *queue, uint32_t min, uint64_t timeout_ns)
+{
+	uint64_t deadline = timeout_ns ? _xnvme_timer_clock_sample() + timeout_ns : 0;
+	int acc = 0;
+
+	while (queue->base.outstanding && (uint32_t)acc < min) {
+		uint64_t next = xnvme_queue_timeout_next(queue);
+		uint64_t now = _xnvme_timer_clock_sample();
+		uint64_t slice = 0;
+		int err;
+
+		if (deadline) {
+			if (now >= deadline) {
+				break;
+			}
+			slice = deadline - now;
+		}
+		if (next) {
+			// A deadline already passed gets the shortest wait, as 0 means no timeout
+			uint64_t left = next > now ? next - now : 1;
+
+			slice = slice ? XNVME_MIN_U64(slice, left) : left;
+		}
+
+		err = queue->base.dev->be.async.wait(queue, min - acc, slice);
+		if (err < 0) {
+			XNVME_DEBUG("FAILED: be.async.wait(), err: %d", err);
+			return err;
+		}
+		acc += err;
+
+		xnvme_queue_timeout_scan(queue);
+	}
+
+	return acc;
+}
+
+int
+xnvme_queue_wait_timeout(struct xnvme_queue *queue, uint32_t min_completions, uint64_t timeout_ns)
+{
+	uint32_t min;
+	int err;
+
+	if (queue->base.shared) {
+		xnvme_queue_shared_refill(queue);
+	}
+	if (queue->base.backlog) {
+		xnvme_queue_backlog_refill(queue);
+	}
+	if (!queue->base.outstanding) {
+		return 0;
+	}
+
+	min = queue->base.outstanding;
+	if (min_completions && min_completions < min) {
+		min = min_completions;
+	}
+
+	// The backend cannot wait for the commands held by the PI helpers
+	if (queue->base.pi) {
+		return queue_wait_poke(queue, min, timeout_ns);
+	}
+
+	if (queue->base.timeout) {
+		err = queue_wait_deadlines(queue, min, timeout_ns);
+	} else {
+		err = queue->base.dev->be.async.wait(queue, min, timeout_ns);
+	}
+	if (err == -ENOSYS) {
+		return queue_wait_poke(queue, min, timeout_ns);
+	}
+	if ((err >= 0) && queue->base.backlog) {
+		xnvme_queue_backlog_refill(queue);
+	}
+
+	return err;
+}
+
+int
+xnvme_queue_get_opts(struct xnvme_queue *queue)
+{
+	return queue->base.opts;
+}
+
 uint32_t
 xnvme_queue_get_capacity(struct xnvme_queue *queue)
 {
@@ -149,11 +359,19 @@ xnvme_queue_get_outstanding(struct xnvme_queue *queue)
 struct xnvme_cmd_ctx *
 xnvme_queue_get_cmd_ctx(struct xnvme_queue *queue)
 {
-	struct xnvme_cmd_ctx *ctx = (struct xnvme_cmd_ctx *)SLIST_FIRST(&queue->base.pool);
+	struct xnvme_cmd_ctx *ctx;
 
+	if (queue->base.shared) {
+		return xnvme_queue_shared_get_cmd_ctx(queue);
+	}
+
+	ctx = (struct xnvme_cmd_ctx *)SLIST_FIRST(&queue->base.pool);
 	if (!ctx) {
-		errno = ENOMEM;
-		return ctx;
+		if (queue->base.pool_ninit > queue->base.capacity) {
+			errno = ENOMEM;
+			return ctx;
+		}
+		return (struct xnvme_cmd_ctx *)queue_ctx_init(queue);
 	}
 
 	SLIST_REMOVE_HEAD(&queue->base.pool, link);
@@ -164,6 +382,11 @@ xnvme_queue_get_cmd_ctx(struct xnvme_queue *queue)
 int
 xnvme_queue_put_cmd_ctx(struct xnvme_queue *queue, struct xnvme_cmd_ctx *ctx)
 {
+	if (queue->base.shared) {
+		xnvme_queue_shared_put_cmd_ctx(queue, ctx);
+		return 0;
+	}
+
 	SLIST_INSERT_HEAD(&queue->base.pool, (struct xnvme_cmd_ctx_entry *)ctx, link);
 
 	return 0;
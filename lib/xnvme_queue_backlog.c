@@ -0,0 +1,276 @@
+// SPDX-FileCopyrightText: Samsung Electronics Co., Ltd
+//
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <errno.h>
+#include <libxnvme.h>
+#include <xnvme_be.h>
+#include <xnvme_cmd.h>
+#include <xnvme_dev.h>
+#include <xnvme_queue.h>
+
+/**
+ * Commands which did not fit in the queue are kept, in submission order, in a ring of 'nentries'
+ * slots, from which they are moved to the backend as completions free up room in the queue.
+ *
+ * The backlog extends the command-context pool of the queue with 'nentries' contexts, thus, a
+ * producer can have every context of the pool in flight, 'capacity' commands in the backend and
+ * the remainder in the backlog.
+ */
+struct xnvme_queue_backlog {
+	struct xnvme_queue_cmd *ring;
+	uint32_t mask; ///< Ring-size minus one, the ring-size is a power of two >= nentries
+	uint32_t head;
+	uint32_t tail;
+
+	uint32_t nentries;
+	struct xnvme_cmd_ctx_entry ctx_storage[];
+};
+
+/**
+ * Submit the given command to the backend, see xnvme_queue_submit_io()
+ */
+static int
+_backlog_submit(struct xnvme_queue_cmd *cmd)
+{
+	if (cmd->dvec) {
+		return xnvme_queue_submit_iov(cmd->ctx, cmd->dvec, cmd->dvec_cnt, cmd->dbuf_nbytes,
+					      cmd->mbuf, cmd->mbuf_nbytes);
+	}
+
+	return xnvme_queue_submit_io(cmd->ctx, cmd->dbuf, cmd->dbuf_nbytes, cmd->mbuf,
+				     cmd->mbuf_nbytes);
+}
+
+static inline bool
+_backlog_is_transient(int err)
+{
+	return (err == -EBUSY) || (err == -EAGAIN);
+}
+
+/**
+ * Submit the command directly when nothing is backlogged and the queue has room, otherwise, or
+ * when the backend is momentarily out of room, append it to the backlog
+ */
+static int
+_backlog_pass(struct xnvme_queue_cmd *cmd)
+{
+	struct xnvme_queue *queue = cmd->ctx->async.queue;
+	struct xnvme_queue_backlog *backlog = queue->base.backlog;
+
+	if ((backlog->head == backlog->tail) && (queue->base.outstanding < queue->base.capacity)) {
+		int err = _backlog_submit(cmd);
+
+		if (!_backlog_is_transient(err)) {
+			return err;
+		}
+	}
+
+	if ((backlog->tail - backlog->head) == backlog->nentries) {
+		XNVME_DEBUG("FAILED: queue and backlog are full; returning -EBUSY");
+		return -EBUSY;
+	}
+
+	backlog->ring[backlog->tail & backlog->mask] = *cmd;
+	backlog->tail += 1;
+
+	return 0;
+}
+
+int
+xnvme_queue_backlog_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes, void *mbuf,
+			   size_t mbuf_nbytes)
+{
+	struct xnvme_queue_cmd cmd = {
+		.ctx = ctx,
+		.dbuf = dbuf,
+		.dbuf_nbytes = dbuf_nbytes,
+		.mbuf = mbuf,
+		.mbuf_nbytes = mbuf_nbytes,
+	};
+
+	return _backlog_pass(&cmd);
+}
+
+int
+xnvme_queue_backlog_cmd_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, size_t dvec_cnt,
+			    size_t dvec_nbytes, void *mbuf, size_t mbuf_nbytes)
+{
+	struct xnvme_queue_cmd cmd = {
+		.ctx = ctx,
+		.dvec = dvec,
+		.dvec_cnt = dvec_cnt,
+		.dbuf_nbytes = dvec_nbytes,
+		.mbuf = mbuf,
+		.mbuf_nbytes = mbuf_nbytes,
+	};
+
+	return _backlog_pass(&cmd);
+}
+
+uint32_t
+xnvme_queue_backlog_refill(struct xnvme_queue *queue)
+{
+	struct xnvme_queue_backlog *backlog = queue->base.backlog;
+	uint32_t nsubmitted = 0;
+
+	while ((backlog->head != backlog->tail) &&
+	       (queue->base.outstanding < queue->base.capacity)) {
+		struct xnvme_queue_cmd *cmd = &backlog->ring[backlog->head & backlog->mask];
+		struct xnvme_cmd_ctx *ctx = cmd->ctx;
+		int err;
+
+		err = _backlog_submit(cmd);
+		if (_backlog_is_transient(err)) {
+			break;
+		}
+
+		// Release the slot before a callback, as the callback might submit again
+		backlog->head += 1;
+
+		if (err) {
+			XNVME_DEBUG("FAILED: submitting backlogged command, err: %d", err);
+			xnvme_queue_complete_err(ctx, err);
+			continue;
+		}
+
+		++nsubmitted;
+	}
+
+	return nsubmitted;
+}
+
+int
+xnvme_queue_backlog_poke(struct xnvme_queue *queue, uint32_t max)
+{
+	int completed = 0;
+
+	if (queue->base.outstanding) {
+		if (queue->base.pi) {
+			completed = xnvme_queue_pi_poke(queue, max);
+		} else {
+			completed = queue->base.dev->be.async.poke(queue, max);
+		}
+		if (completed < 0) {
+			return completed;
+		}
+	}
+
+	xnvme_queue_backlog_refill(queue);
+
+	return completed;
+}
+
+uint32_t
+xnvme_queue_backlog_len(struct xnvme_queue *queue)
+{
+	struct xnvme_queue_backlog *backlog = queue->base.backlog;
+
+	return backlog ? backlog->tail - backlog->head : 0;
+}
+
+uint32_t
+xnvme_queue_nctx(struct xnvme_queue *queue)
+{
+	uint32_t nctx = queue->base.capacity + 1;
+
+	return queue->base.backlog ? nctx + queue->base.backlog->nentries : nctx;
+}
+
+void
+xnvme_queue_backlog_set_cb(struct xnvme_queue *queue, xnvme_queue_cb cb, void *cb_arg)
+{
+	struct xnvme_queue_backlog *backlog = queue->base.backlog;
+
+	if (!backlog) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < backlog->nentries; ++i) {
+		backlog->ctx_storage[i].async.cb = cb;
+		backlog->ctx_storage[i].async.cb_arg = cb_arg;
+	}
+}
+
+void
+xnvme_queue_backlog_term(struct xnvme_queue *queue)
+{
+	struct xnvme_queue_backlog *backlog = queue->base.backlog;
+
+	if (!backlog) {
+		return;
+	}
+
+	free(backlog->ring);
+	free(backlog);
+
+	queue->base.backlog = NULL;
+}
+
+int
+xnvme_queue_set_backlog(struct xnvme_queue *queue, uint32_t nentries)
+{
+	struct xnvme_queue_backlog *backlog;
+	uint32_t nslots = 1;
+
+	if (queue->base.backlog) {
+		XNVME_DEBUG("FAILED: queue already has a backlog");
+		return -EEXIST;
+	}
+	if (queue->base.outstanding) {
+		XNVME_DEBUG("FAILED: queue has outstanding commands");
+		return -EBUSY;
+	}
+	if (queue->base.pi) {
+		XNVME_DEBUG("FAILED: the backlog must be set before the software PI stage");
+		return -EBUSY;
+	}
+	if (queue->base.shared) {
+		XNVME_DEBUG("FAILED: the backlog must be set before the shared submission mode");
+		return -EBUSY;
+	}
+	if (queue->base.timeout) {
+		XNVME_DEBUG("FAILED: the backlog must be set before timeouts");
+		return -EBUSY;
+	}
+	if (!nentries || (nentries > UINT32_MAX / 2 - queue->base.capacity)) {
+		XNVME_DEBUG("FAILED: invalid nentries: %u", nentries);
+		return -EINVAL;
+	}
+
+	while (nslots < nentries) {
+		nslots <<= 1;
+	}
+
+	backlog = calloc(1, sizeof(*backlog) + nentries * sizeof(*backlog->ctx_storage));
+	if (!backlog) {
+		XNVME_DEBUG("FAILED: calloc(backlog)");
+		return -errno;
+	}
+	backlog->ring = calloc(nslots, sizeof(*backlog->ring));
+	if (!backlog->ring) {
+		XNVME_DEBUG("FAILED: calloc(ring)");
+		free(backlog);
+		return -ENOMEM;
+	}
+	backlog->mask = nslots - 1;
+	backlog->nentries = nentries;
+
+	// The added command-contexts take the callback of the existing ones
+	for (uint32_t i = 0; i < nentries; ++i) {
+		struct xnvme_cmd_ctx_entry *entry = &backlog->ctx_storage[i];
+
+		entry->dev = queue->base.dev;
+		entry->async.queue = queue;
+		entry->async.cb = queue->pool_storage[0].async.cb;
+		entry->async.cb_arg = queue->pool_storage[0].async.cb_arg;
+		entry->opts = XNVME_CMD_ASYNC;
+		entry->id = queue->base.capacity + 1 + i;
+
+		SLIST_INSERT_HEAD(&queue->base.pool, entry, link);
+	}
+
+	queue->base.backlog = backlog;
+
+	return 0;
+}
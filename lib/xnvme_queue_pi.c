@@ -0,0 +1,499 @@
+// SPDX-FileCopyrightText: Samsung Electronics Co., Ltd
+//
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <errno.h>
+#include <pthread.h>
+#include <libxnvme.h>
+#include <xnvme_be.h>
+#include <xnvme_cmd.h>
+#include <xnvme_dev.h>
+#include <xnvme_queue.h>
+#include <xnvme_numa.h>
+
+struct xnvme_queue_pi_cmd {
+	struct xnvme_cmd_ctx *ctx;
+
+	void *dbuf;
+	void *mbuf;
+	size_t dbuf_nbytes;
+	size_t mbuf_nbytes;
+
+	xnvme_queue_cb cb; ///< The callback of the command, while interposed by the stage
+	void *cb_arg;
+
+	uint32_t failed; ///< The ::xnvme_pi_check_type failing verification, 0 when none did
+};
+
+/**
+ * Ring of commands, sized to hold every command-context of the queue, thus never full
+ */
+struct xnvme_queue_pi_ring {
+	struct xnvme_queue_pi_cmd **slots;
+	uint32_t head;
+	uint32_t tail;
+};
+
+/**
+ * The queue-owner pushes commands on 'work' and the helpers push them on 'done' once processed,
+ * both rings are guarded by 'mutex'. The queue-owner checks 'ndone' before taking the mutex, such
+ * that a poke without anything processed by the helpers does not contend with them.
+ */
+struct xnvme_queue_pi {
+	struct xnvme_pi_ctx pi;
+
+	struct xnvme_queue_pi_cmd *cmds; ///< One per command-context, indexed by its id
+
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	struct xnvme_queue_pi_ring work;
+	struct xnvme_queue_pi_ring done;
+	uint32_t ndone;
+	uint32_t mask; ///< Ring-size minus one, the ring-size is a power of two > capacity
+	bool stop;
+
+	uint32_t nthreads;
+	pthread_t threads[];
+};
+
+static inline void
+_pi_ring_push(struct xnvme_queue_pi *pi, struct xnvme_queue_pi_ring *ring,
+	      struct xnvme_queue_pi_cmd *cmd)
+{
+	ring->slots[ring->tail & pi->mask] = cmd;
+	ring->tail += 1;
+}
+
+static inline struct xnvme_queue_pi_cmd *
+_pi_ring_pop(struct xnvme_queue_pi *pi, struct xnvme_queue_pi_ring *ring)
+{
+	struct xnvme_queue_pi_cmd *cmd;
+
+	if (ring->head == ring->tail) {
+		return NULL;
+	}
+
+	cmd = ring->slots[ring->head & pi->mask];
+	ring->head += 1;
+
+	return cmd;
+}
+
+/**
+ * Put a popped command back in front of the ring, such that it is the next to be popped
+ */
+static inline void
+_pi_ring_unpop(struct xnvme_queue_pi *pi, struct xnvme_queue_pi_ring *ring,
+	       struct xnvme_queue_pi_cmd *cmd)
+{
+	ring->head -= 1;
+	ring->slots[ring->head & pi->mask] = cmd;
+}
+
+/**
+ * Generate the protection information of a WRITE, or verify that of a READ
+ *
+ * @return The ::xnvme_pi_check_type failing verification, 0 when none did
+ */
+static uint32_t
+_pi_stage_run(struct xnvme_queue_pi *pi, struct xnvme_queue_pi_cmd *cmd)
+{
+	struct xnvme_cmd_ctx *ctx = cmd->ctx;
+	struct xnvme_pi_ctx pi_ctx = pi->pi;
+	uint32_t nblocks = ctx->cmd.nvm.nlb + 1;
+	struct xnvme_pi_err err;
+
+	switch (pi_ctx.pi_type) {
+	case XNVME_PI_TYPE1:
+		pi_ctx.init_ref_tag = ctx->cmd.nvm.slba;
+		break;
+	case XNVME_PI_TYPE2:
+		pi_ctx.init_ref_tag = ctx->cmd.nvm.ilbrt;
+		if (pi_ctx.pi_format != XNVME_SPEC_NVM_NS_16B_GUARD) {
+			pi_ctx.init_ref_tag |= (uint64_t)(ctx->cmd.common.cdw03 & 0xffff) << 32;
+		}
+		break;
+	default:
+		break;
+	}
+
+	if (ctx->cmd.common.opcode == XNVME_SPEC_NVM_OPC_WRITE) {
+		xnvme_pi_generate(&pi_ctx, cmd->dbuf, cmd->mbuf, nblocks);
+		return 0;
+	}
+
+	if (xnvme_pi_verify_report(&pi_ctx, cmd->dbuf, cmd->mbuf, nblocks, &err)) {
+		return err.field;
+	}
+
+	return 0;
+}
+
+/**
+ * Assign the completion-status of a READ which failed verification
+ */
+static void
+_pi_stage_status(struct xnvme_cmd_ctx *ctx, uint32_t failed)
+{
+	switch (failed) {
+	case XNVME_PI_FLAGS_GUARD_CHECK:
+		ctx->cpl.status.sc = XNVME_STATUS_CODE_E2E_GUARD;
+		break;
+	case XNVME_PI_FLAGS_APPTAG_CHECK:
+		ctx->cpl.status.sc = XNVME_STATUS_CODE_E2E_APPTAG;
+		break;
+	case XNVME_PI_FLAGS_REFTAG_CHECK:
+		ctx->cpl.status.sc = XNVME_STATUS_CODE_E2E_REFTAG;
+		break;
+	default:
+		return;
+	}
+	ctx->cpl.status.sct = XNVME_STATUS_CODE_TYPE_MEDIA;
+}
+
+static void *
+_pi_worker(void *arg)
+{
+	struct xnvme_queue_pi *pi = arg;
+
+	pthread_mutex_lock(&pi->mutex);
+	for (;;) {
+		struct xnvme_queue_pi_cmd *cmd;
+
+		cmd = _pi_ring_pop(pi, &pi->work);
+		if (!cmd) {
+			if (pi->stop) {
+				break;
+			}
+			pthread_cond_wait(&pi->cond, &pi->mutex);
+			continue;
+		}
+		pthread_mutex_unlock(&pi->mutex);
+
+		cmd->failed = _pi_stage_run(pi, cmd);
+
+		pthread_mutex_lock(&pi->mutex);
+		_pi_ring_push(pi, &pi->done, cmd);
+		__atomic_add_fetch(&pi->ndone, 1, __ATOMIC_RELEASE);
+	}
+	pthread_mutex_unlock(&pi->mutex);
+
+	return NULL;
+}
+
+/**
+ * Hand the command to the helpers, it is accounted as outstanding until handed back by poke
+ */
+static void
+_pi_stage_defer(struct xnvme_queue *queue, struct xnvme_queue_pi_cmd *cmd)
+{
+	struct xnvme_queue_pi *pi = queue->base.pi;
+
+	queue->base.outstanding += 1;
+
+	pthread_mutex_lock(&pi->mutex);
+	_pi_ring_push(pi, &pi->work, cmd);
+	pthread_cond_signal(&pi->cond);
+	pthread_mutex_unlock(&pi->mutex);
+}
+
+static void
+_pi_read_cb(struct xnvme_cmd_ctx *ctx, void *cb_arg)
+{
+	struct xnvme_queue_pi_cmd *cmd = cb_arg;
+	struct xnvme_queue *queue = ctx->async.queue;
+	struct xnvme_queue_pi *pi = queue->base.pi;
+
+	ctx->async.cb = cmd->cb;
+	ctx->async.cb_arg = cmd->cb_arg;
+
+	if (xnvme_cmd_ctx_cpl_status(ctx)) {
+		ctx->async.cb(ctx, ctx->async.cb_arg);
+		return;
+	}
+
+	if (pi->nthreads) {
+		_pi_stage_defer(queue, cmd);
+		return;
+	}
+
+	_pi_stage_status(ctx, _pi_stage_run(pi, cmd));
+	ctx->async.cb(ctx, ctx->async.cb_arg);
+}
+
+/**
+ * Determine whether the given command passes through the stage, the bit 3 of 'prinfo' is PRACT
+ */
+static inline bool
+_pi_stage_applies(struct xnvme_cmd_ctx *ctx)
+{
+	uint8_t opcode = ctx->cmd.common.opcode;
+
+	if (opcode != XNVME_SPEC_NVM_OPC_WRITE && opcode != XNVME_SPEC_NVM_OPC_READ) {
+		return false;
+	}
+
+	return !(ctx->cmd.nvm.prinfo & 0x8);
+}
+
+int
+xnvme_queue_pi_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes, void *mbuf,
+		      size_t mbuf_nbytes)
+{
+	struct xnvme_queue *queue = ctx->async.queue;
+	struct xnvme_queue_pi *pi = queue->base.pi;
+	struct xnvme_queue_pi_cmd *cmd;
+	size_t nblocks;
+	int err;
+
+	if (!_pi_stage_applies(ctx)) {
+		return ctx->dev->be.async.cmd_io(ctx, dbuf, dbuf_nbytes, mbuf, mbuf_nbytes);
+	}
+
+	nblocks = (size_t)ctx->cmd.nvm.nlb + 1;
+	if ((dbuf_nbytes < nblocks * pi->pi.block_size) ||
+	    (!pi->pi.md_interleave && (mbuf_nbytes < nblocks * pi->pi.md_size))) {
+		XNVME_DEBUG("FAILED: buffers too small for nlb: %zu", nblocks - 1);
+		return -EINVAL;
+	}
+
+	cmd = &pi->cmds[((struct xnvme_cmd_ctx_entry *)ctx)->id];
+	cmd->ctx = ctx;
+	cmd->dbuf = dbuf;
+	cmd->mbuf = mbuf;
+	cmd->dbuf_nbytes = dbuf_nbytes;
+	cmd->mbuf_nbytes = mbuf_nbytes;
+	cmd->failed = 0;
+
+	if (ctx->cmd.common.opcode == XNVME_SPEC_NVM_OPC_READ) {
+		cmd->cb = ctx->async.cb;
+		cmd->cb_arg = ctx->async.cb_arg;
+		ctx->async.cb = _pi_read_cb;
+		ctx->async.cb_arg = cmd;
+
+		err = ctx->dev->be.async.cmd_io(ctx, dbuf, dbuf_nbytes, mbuf, mbuf_nbytes);
+		if (err) {
+			ctx->async.cb = cmd->cb;
+			ctx->async.cb_arg = cmd->cb_arg;
+		}
+		return err;
+	}
+
+	if (pi->nthreads) {
+		_pi_stage_defer(queue, cmd);
+		return 0;
+	}
+
+	_pi_stage_run(pi, cmd);
+
+	return ctx->dev->be.async.cmd_io(ctx, dbuf, dbuf_nbytes, mbuf, mbuf_nbytes);
+}
+
+int
+xnvme_queue_pi_cmd_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, size_t dvec_cnt,
+		       size_t dvec_nbytes, void *mbuf, size_t mbuf_nbytes)
+{
+	if (!_pi_stage_applies(ctx)) {
+		return ctx->dev->be.async.cmd_iov(ctx, dvec, dvec_cnt, dvec_nbytes, mbuf,
+						  mbuf_nbytes);
+	}
+
+	if (dvec_cnt != 1) {
+		XNVME_DEBUG("FAILED: software PI requires a single data-vector");
+		return -EINVAL;
+	}
+
+	return xnvme_queue_pi_cmd_io(ctx, dvec[0].iov_base, dvec[0].iov_len, mbuf, mbuf_nbytes);
+}
+
+/**
+ * Hand a WRITE, with its protection information generated, to the backend
+ *
+ * The command kept its slot of the queue while deferred, as taken by xnvme_cmd_pass() via the
+ * capacity and backlog stage, thus, the slot is handed over to the backend rather than the command
+ * passing that stage again, which would arm its timeout a second time. When the backend is out of
+ * room, then the command keeps its slot and is put back in front of the 'done' ring, to be retried
+ * by the next poke.
+ *
+ * @return On success, or when put back, 0 is returned. On error, negative `errno` is returned.
+ */
+static int
+_pi_stage_submit(struct xnvme_queue *queue, struct xnvme_queue_pi_cmd *cmd)
+{
+	struct xnvme_queue_pi *pi = queue->base.pi;
+	struct xnvme_cmd_ctx *ctx = cmd->ctx;
+	int err;
+
+	queue->base.outstanding -= 1;
+
+	err = ctx->dev->be.async.cmd_io(ctx, cmd->dbuf, cmd->dbuf_nbytes, cmd->mbuf,
+					cmd->mbuf_nbytes);
+	if ((err == -EBUSY) || (err == -EAGAIN)) {
+		queue->base.outstanding += 1;
+
+		pthread_mutex_lock(&pi->mutex);
+		_pi_ring_unpop(pi, &pi->done, cmd);
+		__atomic_add_fetch(&pi->ndone, 1, __ATOMIC_RELEASE);
+		pthread_mutex_unlock(&pi->mutex);
+	}
+
+	return err;
+}
+
+int
+xnvme_queue_pi_poke(struct xnvme_queue *queue, uint32_t max)
+{
+	struct xnvme_queue_pi *pi = queue->base.pi;
+	uint32_t ndone = __atomic_load_n(&pi->ndone, __ATOMIC_ACQUIRE);
+	uint32_t completed = 0;
+	int err;
+
+	max = max ? max : queue->base.outstanding;
+
+	// Bounded by what was done upon entry, as the helpers keep adding, and WRITEs are put back
+	for (uint32_t i = 0; (i < ndone) && (completed < max); ++i) {
+		struct xnvme_queue_pi_cmd *cmd;
+		struct xnvme_cmd_ctx *ctx;
+
+		pthread_mutex_lock(&pi->mutex);
+		cmd = _pi_ring_pop(pi, &pi->done);
+		__atomic_sub_fetch(&pi->ndone, 1, __ATOMIC_RELAXED);
+		pthread_mutex_unlock(&pi->mutex);
+
+		ctx = cmd->ctx;
+
+		if (ctx->cmd.common.opcode == XNVME_SPEC_NVM_OPC_WRITE) {
+			err = _pi_stage_submit(queue, cmd);
+			if ((err == -EBUSY) || (err == -EAGAIN)) {
+				break;
+			}
+			if (!err) {
+				continue;
+			}
+			XNVME_DEBUG("FAILED: be.async.cmd_io(), err: %d", err);
+			xnvme_queue_complete_err(ctx, err);
+		} else {
+			queue->base.outstanding -= 1;
+			_pi_stage_status(ctx, cmd->failed);
+			ctx->async.cb(ctx, ctx->async.cb_arg);
+		}
+
+		completed += 1;
+	}
+	if (completed >= max) {
+		return completed;
+	}
+
+	err = queue->base.outstanding ? queue->base.dev->be.async.poke(queue, max - completed) : 0;
+	if (err < 0) {
+		XNVME_DEBUG("FAILED: be.async.poke(), err: %d", err);
+		return err;
+	}
+
+	return completed + err;
+}
+
+void
+xnvme_queue_pi_term(struct xnvme_queue *queue)
+{
+	struct xnvme_queue_pi *pi = queue->base.pi;
+
+	if (!pi) {
+		return;
+	}
+
+	pthread_mutex_lock(&pi->mutex);
+	pi->stop = true;
+	pthread_cond_broadcast(&pi->cond);
+	pthread_mutex_unlock(&pi->mutex);
+
+	for (uint32_t i = 0; i < pi->nthreads; ++i) {
+		pthread_join(pi->threads[i], NULL);
+	}
+
+	pthread_cond_destroy(&pi->cond);
+	pthread_mutex_destroy(&pi->mutex);
+	free(pi->work.slots);
+	free(pi->done.slots);
+	free(pi->cmds);
+	free(pi);
+
+	queue->base.pi = NULL;
+}
+
+int
+xnvme_queue_set_pi(struct xnvme_queue *queue, const struct xnvme_pi_ctx *ctx, uint32_t nthreads)
+{
+	struct xnvme_queue_pi *pi;
+	uint32_t nslots = 1;
+	int err;
+
+	if (queue->base.outstanding) {
+		XNVME_DEBUG("FAILED: queue has outstanding commands");
+		return -EBUSY;
+	}
+
+	xnvme_queue_pi_term(queue);
+	if (!ctx) {
+		return 0;
+	}
+
+	while (nslots <= queue->base.capacity) {
+		nslots <<= 1;
+	}
+
+	pi = calloc(1, sizeof(*pi) + nthreads * sizeof(*pi->threads));
+	if (!pi) {
+		XNVME_DEBUG("FAILED: calloc(pi)");
+		return -errno;
+	}
+	pi->pi = *ctx;
+	pi->mask = nslots - 1;
+
+	pi->cmds = calloc(xnvme_queue_nctx(queue), sizeof(*pi->cmds));
+	pi->work.slots = calloc(nslots, sizeof(*pi->work.slots));
+	pi->done.slots = calloc(nslots, sizeof(*pi->done.slots));
+	if (!pi->cmds || !pi->work.slots || !pi->done.slots) {
+		XNVME_DEBUG("FAILED: calloc(cmds/slots)");
+		err = -ENOMEM;
+		goto failed;
+	}
+
+	err = -pthread_mutex_init(&pi->mutex, NULL);
+	if (err) {
+		XNVME_DEBUG("FAILED: pthread_mutex_init(), err: %d", err);
+		goto failed;
+	}
+	err = -pthread_cond_init(&pi->cond, NULL);
+	if (err) {
+		XNVME_DEBUG("FAILED: pthread_cond_init(), err: %d", err);
+		pthread_mutex_destroy(&pi->mutex);
+		goto failed;
+	}
+
+	queue->base.pi = pi;
+
+	for (; pi->nthreads < nthreads; ++pi->nthreads) {
+		err = -pthread_create(&pi->threads[pi->nthreads], NULL, _pi_worker, pi);
+		if (err) {
+			XNVME_DEBUG("FAILED: pthread_create(), err: %d", err);
+			xnvme_queue_pi_term(queue);
+			return err;
+		}
+		if (queue->base.dev->numa_node >= 0) {
+			int node = queue->base.dev->numa_node;
+
+			xnvme_numa_bind_thread(pi->threads[pi->nthreads], node);
+		}
+	}
+
+	return 0;
+
+failed:
+	free(pi->work.slots);
+	free(pi->done.slots);
+	free(pi->cmds);
+	free(pi);
+
+	return err;
+}
@@ -0,0 +1,295 @@
+// SPDX-FileCopyrightText: Samsung Electronics Co., Ltd
+//
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <errno.h>
+#include <libxnvme.h>
+#include <xnvme_be.h>
+#include <xnvme_cmd.h>
+#include <xnvme_dev.h>
+#include <xnvme_queue.h>
+#include <xnvme_stack.h>
+
+#define XNVME_QUEUE_SHARED_EMPTY XNVME_STACK_EMPTY
+
+struct xnvme_queue_shared_slot {
+	uint64_t seq; ///< Equals the position when free, the position plus one when staged
+	struct xnvme_queue_cmd cmd;
+};
+
+/**
+ * Producers stage commands on a bounded ring, where each slot carries a sequence number telling
+ * whether it is free for, or staged at, a given position; a producer claims a position with a
+ * compare-and-swap of 'tail', fills the slot, then publishes it via its sequence number. The
+ * poller, the single consumer, moves commands from 'head' to the backend.
+ *
+ * Every staged command holds a command-context, thus, a ring of at least as many slots as the
+ * queue has command-contexts never fills up.
+ *
+ * Free command-contexts are kept on a lock-free stack of context-identifiers, linked via 'next',
+ * with the top in 'top', see xnvme_stack_push() and xnvme_stack_pop().
+ */
+struct xnvme_queue_shared {
+	uint64_t tail __attribute__((aligned(64))); ///< Next position to be claimed by a producer
+	uint64_t head __attribute__((aligned(64))); ///< Next position to be consumed by the poller
+	uint64_t top __attribute__((aligned(64))); ///< Tag in the upper, identifier in the lower bits
+
+	struct xnvme_cmd_ctx **ctxs; ///< Command-contexts by identifier
+	uint32_t *next;
+	uint32_t nctx;
+	uint32_t mask;
+
+	struct xnvme_queue_shared_slot slots[] __attribute__((aligned(64)));
+};
+
+struct xnvme_cmd_ctx *
+xnvme_queue_shared_get_cmd_ctx(struct xnvme_queue *queue)
+{
+	struct xnvme_queue_shared *shared = queue->base.shared;
+	uint32_t id;
+
+	if (!xnvme_stack_pop(&shared->top, shared->next, &id, 1)) {
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	return shared->ctxs[id];
+}
+
+void
+xnvme_queue_shared_put_cmd_ctx(struct xnvme_queue *queue, struct xnvme_cmd_ctx *ctx)
+{
+	struct xnvme_queue_shared *shared = queue->base.shared;
+	uint32_t id = ((struct xnvme_cmd_ctx_entry *)ctx)->id;
+
+	xnvme_stack_push(&shared->top, shared->next, id, id);
+}
+
+static int
+_shared_stage(struct xnvme_queue_cmd *cmd)
+{
+	struct xnvme_queue_shared *shared = cmd->ctx->async.queue->base.shared;
+	struct xnvme_queue_shared_slot *slot;
+	uint64_t pos = __atomic_load_n(&shared->tail, __ATOMIC_RELAXED);
+
+	for (;;) {
+		int64_t diff;
+
+		slot = &shared->slots[pos & shared->mask];
+		diff = (int64_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+		if (!diff) {
+			if (__atomic_compare_exchange_n(&shared->tail, &pos, pos + 1, true,
+							__ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+				break;
+			}
+		} else if (diff < 0) {
+			XNVME_DEBUG("FAILED: staging ring is full; returning -EBUSY");
+			return -EBUSY;
+		} else {
+			pos = __atomic_load_n(&shared->tail, __ATOMIC_RELAXED);
+		}
+	}
+
+	slot->cmd = *cmd;
+	__atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+int
+xnvme_queue_shared_cmd_io(struct xnvme_cmd_ctx *ctx, void *dbuf, size_t dbuf_nbytes, void *mbuf,
+			  size_t mbuf_nbytes)
+{
+	struct xnvme_queue_cmd cmd = {
+		.ctx = ctx,
+		.dbuf = dbuf,
+		.dbuf_nbytes = dbuf_nbytes,
+		.mbuf = mbuf,
+		.mbuf_nbytes = mbuf_nbytes,
+	};
+
+	return _shared_stage(&cmd);
+}
+
+int
+xnvme_queue_shared_cmd_iov(struct xnvme_cmd_ctx *ctx, struct iovec *dvec, size_t dvec_cnt,
+			   size_t dvec_nbytes, void *mbuf, size_t mbuf_nbytes)
+{
+	struct xnvme_queue_cmd cmd = {
+		.ctx = ctx,
+		.dvec = dvec,
+		.dvec_cnt = dvec_cnt,
+		.dbuf_nbytes = dvec_nbytes,
+		.mbuf = mbuf,
+		.mbuf_nbytes = mbuf_nbytes,
+	};
+
+	return _shared_stage(&cmd);
+}
+
+/**
+ * Submit the given command as xnvme_cmd_pass() would for a queue without the shared mode
+ */
+static int
+_shared_submit(struct xnvme_queue_cmd *cmd)
+{
+	struct xnvme_cmd_ctx *ctx = cmd->ctx;
+	struct xnvme_queue *queue = ctx->async.queue;
+
+	if (queue->base.backlog) {
+		if (cmd->dvec) {
+			return xnvme_queue_backlog_cmd_iov(ctx, cmd->dvec, cmd->dvec_cnt,
+							   cmd->dbuf_nbytes, cmd->mbuf,
+							   cmd->mbuf_nbytes);
+		}
+		return xnvme_queue_backlog_cmd_io(ctx, cmd->dbuf, cmd->dbuf_nbytes, cmd->mbuf,
+						  cmd->mbuf_nbytes);
+	}
+	if (queue->base.outstanding == queue->base.capacity) {
+		return -EBUSY;
+	}
+
+	if (cmd->dvec) {
+		return xnvme_queue_submit_iov(ctx, cmd->dvec, cmd->dvec_cnt, cmd->dbuf_nbytes,
+					      cmd->mbuf, cmd->mbuf_nbytes);
+	}
+	return xnvme_queue_submit_io(ctx, cmd->dbuf, cmd->dbuf_nbytes, cmd->mbuf,
+				     cmd->mbuf_nbytes);
+}
+
+uint32_t
+xnvme_queue_shared_refill(struct xnvme_queue *queue)
+{
+	struct xnvme_queue_shared *shared = queue->base.shared;
+	uint32_t nmoved = 0;
+
+	for (;;) {
+		struct xnvme_queue_shared_slot *slot = &shared->slots[shared->head & shared->mask];
+		struct xnvme_cmd_ctx *ctx;
+		int err;
+
+		// Empty, or the producer of the slot has yet to publish it
+		if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != shared->head + 1) {
+			break;
+		}
+
+		err = _shared_submit(&slot->cmd);
+		if ((err == -EBUSY) || (err == -EAGAIN)) {
+			break;
+		}
+
+		// Release the slot before a callback, as the callback might submit again
+		ctx = slot->cmd.ctx;
+		__atomic_store_n(&slot->seq, shared->head + shared->mask + 1, __ATOMIC_RELEASE);
+		__atomic_store_n(&shared->head, shared->head + 1, __ATOMIC_RELAXED);
+
+		if (err) {
+			XNVME_DEBUG("FAILED: submitting staged command, err: %d", err);
+			xnvme_queue_complete_err(ctx, err);
+			continue;
+		}
+
+		++nmoved;
+	}
+
+	return nmoved;
+}
+
+uint32_t
+xnvme_queue_shared_len(struct xnvme_queue *queue)
+{
+	struct xnvme_queue_shared *shared = queue->base.shared;
+
+	if (!shared) {
+		return 0;
+	}
+
+	return __atomic_load_n(&shared->tail, __ATOMIC_ACQUIRE) -
+	       __atomic_load_n(&shared->head, __ATOMIC_RELAXED);
+}
+
+void
+xnvme_queue_shared_term(struct xnvme_queue *queue)
+{
+	struct xnvme_queue_shared *shared = queue->base.shared;
+
+	if (!shared) {
+		return;
+	}
+
+	free(shared->ctxs);
+	free(shared->next);
+	xnvme_buf_virt_free(shared);
+
+	queue->base.shared = NULL;
+}
+
+int
+xnvme_queue_set_shared(struct xnvme_queue *queue)
+{
+	struct xnvme_queue_shared *shared;
+	uint32_t nctx = xnvme_queue_nctx(queue);
+	uint32_t nslots = 1, ntaken = 0;
+	struct xnvme_cmd_ctx *ctx;
+
+	if (queue->base.shared) {
+		XNVME_DEBUG("FAILED: queue is already shared");
+		return -EEXIST;
+	}
+	if (queue->base.outstanding || xnvme_queue_backlog_len(queue)) {
+		XNVME_DEBUG("FAILED: queue has outstanding commands");
+		return -EBUSY;
+	}
+
+	while (nslots < nctx) {
+		nslots <<= 1;
+	}
+
+	shared = xnvme_buf_virt_alloc(64, sizeof(*shared) + nslots * sizeof(*shared->slots));
+	if (!shared) {
+		XNVME_DEBUG("FAILED: xnvme_buf_virt_alloc(shared), errno: %d", errno);
+		return -ENOMEM;
+	}
+	memset(shared, 0, sizeof(*shared));
+	shared->ctxs = calloc(nctx, sizeof(*shared->ctxs));
+	shared->next = calloc(nctx, sizeof(*shared->next));
+	if (!shared->ctxs || !shared->next) {
+		XNVME_DEBUG("FAILED: calloc(ctxs, next)");
+		free(shared->ctxs);
+		free(shared->next);
+		xnvme_buf_virt_free(shared);
+		return -ENOMEM;
+	}
+	shared->nctx = nctx;
+	shared->mask = nslots - 1;
+	for (uint32_t i = 0; i < nslots; ++i) {
+		shared->slots[i].seq = i;
+	}
+
+	// Take every command-context off the pool, initializing those not yet initialized
+	while ((ctx = xnvme_queue_get_cmd_ctx(queue))) {
+		shared->ctxs[((struct xnvme_cmd_ctx_entry *)ctx)->id] = ctx;
+		++ntaken;
+	}
+	if (ntaken != nctx) {
+		XNVME_DEBUG("FAILED: command-contexts in use: %u", nctx - ntaken);
+		for (uint32_t i = 0; i < nctx; ++i) {
+			if (shared->ctxs[i]) {
+				xnvme_queue_put_cmd_ctx(queue, shared->ctxs[i]);
+			}
+		}
+		free(shared->ctxs);
+		free(shared->next);
+		xnvme_buf_virt_free(shared);
+		return -EBUSY;
+	}
+
+	for (uint32_t i = 0; i < nctx; ++i) {
+		shared->next[i] = (i + 1 < nctx) ? i + 1 : XNVME_QUEUE_SHARED_EMPTY;
+	}
+	shared->top = 0;
+
+	queue->base.shared = shared;
+
+	return 0;
+}
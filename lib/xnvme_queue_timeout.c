@@ -0,0 +1,272 @@
+// SPDX-FileCopyrightText: Samsung Electronics Co., Ltd
+//
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <errno.h>
+#include <time.h>
+#include <libxnvme.h>
+#include <xnvme_be.h>
+#include <xnvme_cmd.h>
+#include <xnvme_dev.h>
+#include <xnvme_queue.h>
+
+struct xnvme_queue_timeout_cmd {
+	struct xnvme_queue_deadline ts; ///< The deadline, as handed to backends timing natively
+	uint64_t deadline_ns;           ///< 0 when the command has no deadline
+
+	uint64_t timeout_ns; ///< Override of the default, see xnvme_cmd_ctx_set_timeout()
+	bool override;
+	bool armed;
+
+	int status; ///< Status to complete with, see xnvme_queue_timeout_expire(), 0 when none
+
+	struct xnvme_cmd_ctx *ctx;
+	xnvme_queue_cb cb; ///< The callback of the command, while interposed by the stage
+	void *cb_arg;
+};
+
+/**
+ * A command is armed upon submission to the backend, interposing its callback, and disarmed upon
+ * completion; the deadline of every armed command is kept in 'cmds', indexed by the identifier of
+ * its command-context, and the earliest one in 'next_ns', such that the watchdog only walks the
+ * commands once a deadline has passed.
+ */
+struct xnvme_queue_timeout {
+	uint64_t timeout_ns; ///< Default timeout, 0 for none
+	uint64_t next_ns;    ///< Earliest deadline, possibly of a command since completed, 0 for none
+
+	uint32_t nctx;
+	struct xnvme_queue_timeout_cmd cmds[];
+};
+
+static inline struct xnvme_queue_timeout_cmd *
+_timeout_cmd(struct xnvme_cmd_ctx *ctx)
+{
+	return &ctx->async.queue->base.timeout->cmds[((struct xnvme_cmd_ctx_entry *)ctx)->id];
+}
+
+static inline void
+_timeout_reset(struct xnvme_queue_timeout_cmd *cmd)
+{
+	cmd->ctx->async.cb = cmd->cb;
+	cmd->ctx->async.cb_arg = cmd->cb_arg;
+	cmd->deadline_ns = 0;
+	cmd->status = 0;
+	cmd->armed = false;
+}
+
+/**
+ * A command failing past its deadline, without having been flagged, was cancelled by a backend
+ * timing it natively, e.g. by an io_uring linked timeout completing it with -ECANCELED
+ */
+static void
+_timeout_cb(struct xnvme_cmd_ctx *ctx, void *cb_arg)
+{
+	struct xnvme_queue_timeout_cmd *cmd = cb_arg;
+	int status = cmd->status;
+
+	if (!status && cmd->deadline_ns && xnvme_cmd_ctx_cpl_status(ctx) &&
+	    (_xnvme_timer_clock_sample() >= cmd->deadline_ns)) {
+		status = ETIMEDOUT;
+	}
+	if (status) {
+		ctx->cpl.status.sc = status;
+		ctx->cpl.status.sct = XNVME_STATUS_CODE_TYPE_VENDOR;
+	}
+
+	_timeout_reset(cmd);
+	cmd->override = false;
+
+	ctx->async.cb(ctx, ctx->async.cb_arg);
+}
+
+bool
+xnvme_queue_timeout_arm(struct xnvme_cmd_ctx *ctx)
+{
+	struct xnvme_queue_timeout *timeout = ctx->async.queue->base.timeout;
+	struct xnvme_queue_timeout_cmd *cmd;
+	uint64_t timeout_ns;
+
+	if (!timeout) {
+		return false;
+	}
+
+	cmd = _timeout_cmd(ctx);
+	timeout_ns = cmd->override ? cmd->timeout_ns : timeout->timeout_ns;
+
+	// An override of 0 is armed without a deadline, such that it is consumed upon completion
+	if (!timeout_ns && !cmd->override) {
+		return false;
+	}
+
+	cmd->ctx = ctx;
+	cmd->cb = ctx->async.cb;
+	cmd->cb_arg = ctx->async.cb_arg;
+	cmd->status = 0;
+	cmd->armed = true;
+	cmd->deadline_ns = timeout_ns ? _xnvme_timer_clock_sample() + timeout_ns : 0;
+	cmd->ts.tv_sec = cmd->deadline_ns / 1000000000ULL;
+	cmd->ts.tv_nsec = cmd->deadline_ns % 1000000000ULL;
+
+	ctx->async.cb = _timeout_cb;
+	ctx->async.cb_arg = cmd;
+
+	if (cmd->deadline_ns && (!timeout->next_ns || (cmd->deadline_ns < timeout->next_ns))) {
+		timeout->next_ns = cmd->deadline_ns;
+	}
+
+	return true;
+}
+
+void
+xnvme_queue_timeout_disarm(struct xnvme_cmd_ctx *ctx)
+{
+	// The override is kept, such that it applies when the command is submitted again
+	_timeout_reset(_timeout_cmd(ctx));
+}
+
+struct xnvme_queue_deadline *
+xnvme_queue_timeout_deadline(struct xnvme_cmd_ctx *ctx)
+{
+	struct xnvme_queue_timeout_cmd *cmd;
+
+	if (!ctx->async.queue->base.timeout) {
+		return NULL;
+	}
+
+	cmd = _timeout_cmd(ctx);
+
+	return (cmd->armed && cmd->deadline_ns) ? &cmd->ts : NULL;
+}
+
+bool
+xnvme_queue_timeout_expire(struct xnvme_cmd_ctx *ctx, int status)
+{
+	struct xnvme_queue_timeout_cmd *cmd;
+
+	if (!ctx->async.queue->base.timeout) {
+		return false;
+	}
+
+	cmd = _timeout_cmd(ctx);
+	if (!cmd->armed || cmd->status) {
+		return false;
+	}
+	cmd->status = status;
+
+	return true;
+}
+
+void
+xnvme_queue_timeout_unexpire(struct xnvme_cmd_ctx *ctx)
+{
+	struct xnvme_queue_timeout_cmd *cmd;
+
+	if (!ctx->async.queue->base.timeout) {
+		return;
+	}
+
+	cmd = _timeout_cmd(ctx);
+	if (cmd->armed) {
+		cmd->status = 0;
+	}
+}
+
+void
+xnvme_queue_timeout_scan(struct xnvme_queue *queue)
+{
+	struct xnvme_queue_timeout *timeout = queue->base.timeout;
+	uint64_t next = 0;
+	uint64_t now;
+
+	if (!timeout || !timeout->next_ns) {
+		return;
+	}
+	now = _xnvme_timer_clock_sample();
+	if (now < timeout->next_ns) {
+		return;
+	}
+
+	// Cancellation can complete commands, and their callbacks arm new ones, updating 'next_ns'
+	timeout->next_ns = 0;
+
+	for (uint32_t i = 0; i < timeout->nctx; ++i) {
+		struct xnvme_queue_timeout_cmd *cmd = &timeout->cmds[i];
+		int err;
+
+		// Flagged commands are left for the backend to complete
+		if (!cmd->armed || !cmd->deadline_ns || cmd->status) {
+			continue;
+		}
+		if (cmd->deadline_ns > now) {
+			next = (!next || (cmd->deadline_ns < next)) ? cmd->deadline_ns : next;
+			continue;
+		}
+
+		cmd->status = ETIMEDOUT;
+		err = queue->base.dev->be.async.cancel(cmd->ctx);
+		if (err) {
+			XNVME_DEBUG("INFO: be.async.cancel(), err: %d", err);
+		}
+	}
+
+	if (next && (!timeout->next_ns || (next < timeout->next_ns))) {
+		timeout->next_ns = next;
+	}
+}
+
+uint64_t
+xnvme_queue_timeout_next(struct xnvme_queue *queue)
+{
+	return queue->base.timeout ? queue->base.timeout->next_ns : 0;
+}
+
+void
+xnvme_queue_timeout_term(struct xnvme_queue *queue)
+{
+	free(queue->base.timeout);
+
+	queue->base.timeout = NULL;
+}
+
+int
+xnvme_queue_set_timeout(struct xnvme_queue *queue, uint64_t timeout_ns)
+{
+	struct xnvme_queue_timeout *timeout = queue->base.timeout;
+	uint32_t nctx = xnvme_queue_nctx(queue);
+
+	if (timeout) {
+		timeout->timeout_ns = timeout_ns;
+		return 0;
+	}
+
+	timeout = calloc(1, sizeof(*timeout) + nctx * sizeof(*timeout->cmds));
+	if (!timeout) {
+		XNVME_DEBUG("FAILED: calloc(timeout)");
+		return -errno;
+	}
+	timeout->timeout_ns = timeout_ns;
+	timeout->nctx = nctx;
+
+	queue->base.timeout = timeout;
+
+	return 0;
+}
+
+int
+xnvme_cmd_ctx_set_timeout(struct xnvme_cmd_ctx *ctx, uint64_t timeout_ns)
+{
+	struct xnvme_queue_timeout_cmd *cmd;
+
+	if (((ctx->opts & XNVME_CMD_MASK_IOMD) != XNVME_CMD_ASYNC) ||
+	    !ctx->async.queue->base.timeout) {
+		XNVME_DEBUG("FAILED: the queue of the command-context has no timeouts enabled");
+		return -EINVAL;
+	}
+
+	cmd = _timeout_cmd(ctx);
+	cmd->timeout_ns = timeout_ns;
+	cmd->override = true;
+
+	return 0;
+}
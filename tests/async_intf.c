@@ -3,9 +3,13 @@
 // SPDX-License-Identifier: BSD-3-Clause
 
 #include <errno.h>
+#ifndef WIN32
+#include <poll.h>
+#include <unistd.h>
+#endif
 #include <libxnvme.h>
 
-#define XNVME_TESTS_QDEPTH_MAX 512
+#define XNVME_TESTS_QDEPTH_MAX XNVME_QUEUE_CAPACITY_MAX
 #define XNVME_TESTS_NQUEUE_MAX 1024
 
 static int
@@ -94,6 +98,1142 @@ exit:
 	return err;
 }
 
+static void
+cb_wait_timeout(struct xnvme_cmd_ctx *ctx, void *cb_arg)
+{
+	uint32_t *ncompleted = cb_arg;
+
+	*ncompleted += 1;
+	xnvme_queue_put_cmd_ctx(ctx->async.queue, ctx);
+}
+
+static int
+test_wait_timeout(struct xnvme_cli *cli)
+{
+	struct xnvme_dev *dev = cli->args.dev;
+	const struct xnvme_geo *geo = xnvme_dev_get_geo(dev);
+	uint32_t nsid = xnvme_dev_get_nsid(dev);
+	uint64_t qd = cli->given[XNVME_CLI_OPT_QDEPTH] ? cli->args.qdepth : 16;
+	struct xnvme_queue *queue = NULL;
+	uint32_t ncompleted = 0;
+	void *buf = NULL;
+	int err;
+
+	if (!qd || qd > XNVME_TESTS_QDEPTH_MAX) {
+		XNVME_DEBUG("FAILED: qd(%zu) out-of-bounds for test", qd);
+		return -EINVAL;
+	}
+
+	buf = xnvme_buf_alloc(dev, qd * geo->lba_nbytes);
+	if (!buf) {
+		err = -errno;
+		xnvme_cli_perr("xnvme_buf_alloc()", err);
+		return err;
+	}
+
+	err = xnvme_queue_init(dev, qd, 0, &queue);
+	if (err) {
+		xnvme_cli_perr("xnvme_queue_init()", err);
+		goto exit;
+	}
+	xnvme_queue_set_cb(queue, cb_wait_timeout, &ncompleted);
+
+	// Nothing outstanding; must return immediately
+	err = xnvme_queue_wait_timeout(queue, 1, 1000);
+	if (err) {
+		xnvme_cli_perr("xnvme_queue_wait_timeout(empty)", err);
+		err = err < 0 ? err : -EIO;
+		goto exit;
+	}
+
+	for (uint64_t i = 0; i < qd; ++i) {
+		struct xnvme_cmd_ctx *ctx = xnvme_queue_get_cmd_ctx(queue);
+		char *payload = (char *)buf + i * geo->lba_nbytes;
+
+		err = xnvme_nvm_read(ctx, nsid, i, 0, payload, NULL);
+		if (err) {
+			xnvme_cli_perr("xnvme_nvm_read()", err);
+			xnvme_queue_put_cmd_ctx(queue, ctx);
+			goto exit;
+		}
+	}
+
+	err = xnvme_queue_wait_timeout(queue, 1, 0);
+	if (err < 1) {
+		xnvme_cli_perr("xnvme_queue_wait_timeout(1)", err);
+		err = err < 0 ? err : -EIO;
+		goto exit;
+	}
+
+	// A 'min_completions' of 0 waits for everything outstanding
+	err = xnvme_queue_wait_timeout(queue, 0, 0);
+	if (err < 0) {
+		xnvme_cli_perr("xnvme_queue_wait_timeout(0)", err);
+		goto exit;
+	}
+
+	if (xnvme_queue_get_outstanding(queue) || ncompleted != qd) {
+		xnvme_cli_pinf("FAILED: outstanding: %u, ncompleted: %u",
+			       xnvme_queue_get_outstanding(queue), ncompleted);
+		err = -EIO;
+		goto exit;
+	}
+	err = 0;
+
+exit:
+	xnvme_queue_term(queue);
+	xnvme_buf_free(dev, buf);
+
+	return err;
+}
+
+/**
+ * Submit 'qdepth' reads, then sleep in poll() on the completion fd of the queue until it is
+ * signaled, consume its counter, and reap via xnvme_queue_poke(), until all are completed
+ */
+static int
+test_completion_fd(struct xnvme_cli *cli)
+{
+#ifdef WIN32
+	(void)cli;
+	xnvme_cli_pinf("SKIPPED: poll() is not available");
+	return 0;
+#else
+	struct xnvme_dev *dev = cli->args.dev;
+	const struct xnvme_geo *geo = xnvme_dev_get_geo(dev);
+	uint32_t nsid = xnvme_dev_get_nsid(dev);
+	uint64_t qd = cli->given[XNVME_CLI_OPT_QDEPTH] ? cli->args.qdepth : 16;
+	struct xnvme_queue *queue = NULL;
+	uint32_t ncompleted = 0;
+	void *buf = NULL;
+	int efd, err;
+
+	if (!qd || qd > XNVME_TESTS_QDEPTH_MAX) {
+		XNVME_DEBUG("FAILED: qd(%zu) out-of-bounds for test", qd);
+		return -EINVAL;
+	}
+
+	buf = xnvme_buf_alloc(dev, qd * geo->lba_nbytes);
+	if (!buf) {
+		err = -errno;
+		xnvme_cli_perr("xnvme_buf_alloc()", err);
+		return err;
+	}
+
+	err = xnvme_queue_init(dev, qd, 0, &queue);
+	if (err) {
+		xnvme_cli_perr("xnvme_queue_init()", err);
+		goto exit;
+	}
+	xnvme_queue_set_cb(queue, cb_wait_timeout, &ncompleted);
+
+	efd = xnvme_queue_get_completion_fd(queue);
+	if (efd == -ENOSYS) {
+		xnvme_cli_pinf("SKIPPED: the async. interface has no completion fd");
+		err = 0;
+		goto exit;
+	}
+	if (efd < 0) {
+		err = efd;
+		xnvme_cli_perr("xnvme_queue_get_completion_fd()", err);
+		goto exit;
+	}
+	if (xnvme_queue_get_completion_fd(queue) != efd) {
+		xnvme_cli_pinf("FAILED: a different fd on the second request");
+		err = -EIO;
+		goto exit;
+	}
+
+	for (uint64_t i = 0; i < qd; ++i) {
+		struct xnvme_cmd_ctx *ctx = xnvme_queue_get_cmd_ctx(queue);
+		char *payload = (char *)buf + i * geo->lba_nbytes;
+
+		err = xnvme_nvm_read(ctx, nsid, i, 0, payload, NULL);
+		if (err) {
+			xnvme_cli_perr("xnvme_nvm_read()", err);
+			xnvme_queue_put_cmd_ctx(queue, ctx);
+			goto exit;
+		}
+	}
+
+	while (ncompleted < qd) {
+		struct pollfd pfd = {.fd = efd, .events = POLLIN};
+		uint64_t val;
+
+		// Outstanding commands must signal the fd, a missing signal shows as a timeout
+		err = poll(&pfd, 1, 10000);
+		if (err < 0) {
+			err = -errno;
+			xnvme_cli_perr("poll()", err);
+			goto exit;
+		}
+		if (!err) {
+			xnvme_cli_pinf("FAILED: fd not signaled, ncompleted: %u", ncompleted);
+			err = -ETIMEDOUT;
+			goto exit;
+		}
+		if (read(efd, &val, sizeof(val)) != sizeof(val)) {
+			err = -errno;
+			xnvme_cli_perr("read()", err);
+			goto exit;
+		}
+
+		err = xnvme_queue_poke(queue, 0);
+		if (err < 0) {
+			xnvme_cli_perr("xnvme_queue_poke()", err);
+			goto exit;
+		}
+	}
+
+	if (xnvme_queue_get_outstanding(queue)) {
+		xnvme_cli_pinf("FAILED: outstanding: %u", xnvme_queue_get_outstanding(queue));
+		err = -EIO;
+		goto exit;
+	}
+	err = 0;
+
+exit:
+	xnvme_queue_term(queue);
+	xnvme_buf_free(dev, buf);
+
+	return err;
+#endif
+}
+
+struct pi_cb_state {
+	uint32_t ncompleted;
+	uint32_t nfailed;
+	struct xnvme_spec_status status; ///< Status of the most recent failure
+};
+
+static void
+cb_pi(struct xnvme_cmd_ctx *ctx, void *cb_arg)
+{
+	struct pi_cb_state *state = cb_arg;
+
+	state->ncompleted += 1;
+	if (xnvme_cmd_ctx_cpl_status(ctx)) {
+		state->nfailed += 1;
+		state->status = ctx->cpl.status;
+	}
+	xnvme_queue_put_cmd_ctx(ctx->async.queue, ctx);
+}
+
+static int
+pi_submit(struct xnvme_queue *queue, uint32_t nsid, uint8_t opcode, uint64_t slba, uint16_t nlb,
+	  void *dbuf)
+{
+	struct xnvme_cmd_ctx *ctx = xnvme_queue_get_cmd_ctx(queue);
+	int err;
+
+	if (opcode == XNVME_SPEC_NVM_OPC_WRITE) {
+		err = xnvme_nvm_write(ctx, nsid, slba, nlb, dbuf, NULL);
+	} else {
+		err = xnvme_nvm_read(ctx, nsid, slba, nlb, dbuf, NULL);
+	}
+	if (err) {
+		xnvme_cli_perr("xnvme_nvm_{read,write}()", err);
+		xnvme_queue_put_cmd_ctx(queue, ctx);
+	}
+
+	return err;
+}
+
+/**
+ * Write and read back with software PI on the queue, with the PI interleaved in the last eight
+ * bytes of each block, then read blocks written without PI and expect them to fail verification
+ */
+static int
+test_pi(struct xnvme_cli *cli)
+{
+	struct xnvme_dev *dev = cli->args.dev;
+	const struct xnvme_geo *geo = xnvme_dev_get_geo(dev);
+	uint32_t nsid = xnvme_dev_get_nsid(dev);
+	uint64_t qd = cli->given[XNVME_CLI_OPT_QDEPTH] ? cli->args.qdepth : 16;
+	uint32_t nthreads = cli->given[XNVME_CLI_OPT_COUNT] ? cli->args.count : 0;
+	const uint16_t nlb = 1;
+	size_t cmd_nbytes = (nlb + 1) * geo->lba_nbytes;
+	struct pi_cb_state state = {0};
+	struct xnvme_queue *queue = NULL;
+	struct xnvme_pi_ctx pi_ctx;
+	uint8_t *buf = NULL;
+	int err;
+
+	if (!qd || qd > XNVME_TESTS_QDEPTH_MAX) {
+		XNVME_DEBUG("FAILED: qd(%zu) out-of-bounds for test", qd);
+		return -EINVAL;
+	}
+
+	xnvme_cli_pinf("qdepth: %zu, nthreads: %u", qd, nthreads);
+
+	err = xnvme_pi_ctx_init(&pi_ctx, geo->lba_nbytes, 8, true, false, XNVME_PI_TYPE1,
+				XNVME_PI_FLAGS_GUARD_CHECK | XNVME_PI_FLAGS_APPTAG_CHECK |
+					XNVME_PI_FLAGS_REFTAG_CHECK,
+				0, 0xFFFF, 0x1234, XNVME_SPEC_NVM_NS_16B_GUARD);
+	if (err) {
+		xnvme_cli_perr("xnvme_pi_ctx_init()", err);
+		return err;
+	}
+
+	buf = xnvme_buf_alloc(dev, qd * cmd_nbytes);
+	if (!buf) {
+		err = -errno;
+		xnvme_cli_perr("xnvme_buf_alloc()", err);
+		return err;
+	}
+
+	err = xnvme_queue_init(dev, qd, 0, &queue);
+	if (err) {
+		xnvme_cli_perr("xnvme_queue_init()", err);
+		goto exit;
+	}
+	xnvme_queue_set_cb(queue, cb_pi, &state);
+
+	err = xnvme_queue_set_pi(queue, &pi_ctx, nthreads);
+	if (err) {
+		xnvme_cli_perr("xnvme_queue_set_pi()", err);
+		goto exit;
+	}
+
+	xnvme_buf_fill(buf, qd * cmd_nbytes, "anum");
+	for (uint64_t i = 0; i < qd; ++i) {
+		err = pi_submit(queue, nsid, XNVME_SPEC_NVM_OPC_WRITE, i * (nlb + 1), nlb,
+				buf + i * cmd_nbytes);
+		if (err) {
+			goto exit;
+		}
+	}
+	err = xnvme_queue_drain(queue);
+	if (err < 0) {
+		xnvme_cli_perr("xnvme_queue_drain()", err);
+		goto exit;
+	}
+
+	memset(buf, 0, qd * cmd_nbytes);
+	for (uint64_t i = 0; i < qd; ++i) {
+		err = pi_submit(queue, nsid, XNVME_SPEC_NVM_OPC_READ, i * (nlb + 1), nlb,
+				buf + i * cmd_nbytes);
+		if (err) {
+			goto exit;
+		}
+	}
+	// Reaped one at a time, as a poke must not process more completions than asked for
+	while (xnvme_queue_get_outstanding(queue)) {
+		err = xnvme_queue_poke(queue, 1);
+		if (err < 0) {
+			xnvme_cli_perr("xnvme_queue_poke()", err);
+			goto exit;
+		}
+		if (err > 1) {
+			xnvme_cli_pinf("FAILED: xnvme_queue_poke(1) processed: %d", err);
+			err = -EIO;
+			goto exit;
+		}
+	}
+
+	if (state.ncompleted != 2 * qd || state.nfailed) {
+		xnvme_cli_pinf("FAILED: ncompleted: %u, nfailed: %u", state.ncompleted,
+			       state.nfailed);
+		err = -EIO;
+		goto exit;
+	}
+
+	// Zeroed blocks have a matching guard, but not a matching app tag
+	err = xnvme_queue_set_pi(queue, NULL, 0);
+	if (err) {
+		xnvme_cli_perr("xnvme_queue_set_pi(NULL)", err);
+		goto exit;
+	}
+	memset(buf, 0, cmd_nbytes);
+	err = pi_submit(queue, nsid, XNVME_SPEC_NVM_OPC_WRITE, 0, nlb, buf);
+	if (err) {
+		goto exit;
+	}
+	xnvme_queue_drain(queue);
+
+	err = xnvme_queue_set_pi(queue, &pi_ctx, nthreads);
+	if (err) {
+		xnvme_cli_perr("xnvme_queue_set_pi()", err);
+		goto exit;
+	}
+	err = pi_submit(queue, nsid, XNVME_SPEC_NVM_OPC_READ, 0, nlb, buf);
+	if (err) {
+		goto exit;
+	}
+	xnvme_queue_drain(queue);
+
+	if (state.nfailed != 1 || state.status.sct != XNVME_STATUS_CODE_TYPE_MEDIA ||
+	    state.status.sc != XNVME_STATUS_CODE_E2E_APPTAG) {
+		xnvme_cli_pinf("FAILED: nfailed: %u, sct: 0x%x, sc: 0x%x", state.nfailed,
+			       state.status.sct, state.status.sc);
+		err = -EIO;
+		goto exit;
+	}
+	err = 0;
+
+exit:
+	xnvme_queue_term(queue);
+	xnvme_buf_free(dev, buf);
+
+	return err;
+}
+
+static int
+pi_report_expect(struct xnvme_pi_ctx *pi_ctx, uint8_t *buf, uint32_t nblocks, uint32_t block,
+		 uint32_t field)
+{
+	struct xnvme_pi_err err = {0};
+	int ret;
+
+	ret = xnvme_pi_verify_report(pi_ctx, buf, NULL, nblocks, &err);
+	if ((ret != -EIO) || (err.block != block) || (err.field != field) ||
+	    (err.expected == err.actual)) {
+		xnvme_cli_pinf("FAILED: ret: %d, block: %u, field: %u, expected: 0x%" PRIx64
+			       ", actual: 0x%" PRIx64,
+			       ret, err.block, err.field, err.expected, err.actual);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+/**
+ * Generate PI over more blocks than are verified in a single batch, corrupt a field of a few
+ * blocks, and expect xnvme_pi_verify_report() to describe the first block failing verification
+ */
+static int
+test_pi_report(struct xnvme_cli *XNVME_UNUSED(cli))
+{
+	const uint32_t block_nbytes = 512, nblocks = 40;
+	struct xnvme_pi_ctx pi_ctx;
+	uint8_t *buf, *pif;
+	int err;
+
+	err = xnvme_pi_ctx_init(&pi_ctx, block_nbytes, 8, true, false, XNVME_PI_TYPE1,
+				XNVME_PI_FLAGS_GUARD_CHECK | XNVME_PI_FLAGS_APPTAG_CHECK |
+					XNVME_PI_FLAGS_REFTAG_CHECK,
+				0, 0xFFFF, 0x1234, XNVME_SPEC_NVM_NS_16B_GUARD);
+	if (err) {
+		xnvme_cli_perr("xnvme_pi_ctx_init()", err);
+		return err;
+	}
+
+	buf = xnvme_buf_virt_alloc(block_nbytes, nblocks * block_nbytes);
+	if (!buf) {
+		err = -errno;
+		xnvme_cli_perr("xnvme_buf_virt_alloc()", err);
+		return err;
+	}
+	xnvme_buf_fill(buf, nblocks * block_nbytes, "anum");
+	xnvme_pi_generate(&pi_ctx, buf, NULL, nblocks);
+
+	err = xnvme_pi_verify_report(&pi_ctx, buf, NULL, nblocks, NULL);
+	if (err) {
+		xnvme_cli_perr("xnvme_pi_verify_report()", err);
+		goto exit;
+	}
+
+	// The PI is the last eight bytes of each block: guard, app tag, then ref tag, big-endian
+	pif = buf + 37 * block_nbytes + block_nbytes - 8;
+	pif[7] ^= 0xFF;
+	pif = buf + 21 * block_nbytes + block_nbytes - 8;
+	pif[2] ^= 0xFF;
+
+	err = pi_report_expect(&pi_ctx, buf, nblocks, 21, XNVME_PI_FLAGS_APPTAG_CHECK);
+	if (err) {
+		goto exit;
+	}
+	pif[2] ^= 0xFF;
+	err = pi_report_expect(&pi_ctx, buf, nblocks, 37, XNVME_PI_FLAGS_REFTAG_CHECK);
+	if (err) {
+		goto exit;
+	}
+	buf[3 * block_nbytes] ^= 0xFF;
+	err = pi_report_expect(&pi_ctx, buf, nblocks, 3, XNVME_PI_FLAGS_GUARD_CHECK);
+	if (err) {
+		goto exit;
+	}
+
+	err = xnvme_pi_verify(&pi_ctx, buf, NULL, nblocks);
+	if (err != -EIO) {
+		xnvme_cli_pinf("FAILED: xnvme_pi_verify(), err: %d", err);
+		err = -EIO;
+		goto exit;
+	}
+	err = 0;
+
+exit:
+	xnvme_buf_virt_free(buf);
+
+	return err;
+}
+
+static void
+cb_backlog(struct xnvme_cmd_ctx *ctx, void *cb_arg)
+{
+	uint32_t *state = cb_arg;
+
+	state[0] += 1;
+	if (xnvme_cmd_ctx_cpl_status(ctx)) {
+		xnvme_cmd_ctx_pr(ctx, XNVME_PR_DEF);
+		state[1] += 1;
+	}
+	xnvme_queue_put_cmd_ctx(ctx->async.queue, ctx);
+}
+
+/**
+ * Submit 'qdepth' plus 'count' writes, then reads, without reaping in between, relying on the
+ * submission backlog to hold those not fitting in the queue, and verify the data read back
+ */
+static int
+test_backlog(struct xnvme_cli *cli)
+{
+	struct xnvme_dev *dev = cli->args.dev;
+	const struct xnvme_geo *geo = xnvme_dev_get_geo(dev);
+	uint32_t nsid = xnvme_dev_get_nsid(dev);
+	uint64_t qd = cli->given[XNVME_CLI_OPT_QDEPTH] ? cli->args.qdepth : 8;
+	uint32_t nentries = cli->given[XNVME_CLI_OPT_COUNT] ? cli->args.count : 3 * qd;
+	uint32_t ncmds = qd + nentries;
+	size_t buf_nbytes = (size_t)ncmds * geo->lba_nbytes;
+	struct xnvme_queue *queue = NULL;
+	uint32_t state[2] = {0}; ///< Number of completions, and of those, failed ones
+	uint8_t *wbuf = NULL, *rbuf = NULL;
+	int err;
+
+	if (!qd || qd > XNVME_TESTS_QDEPTH_MAX) {
+		XNVME_DEBUG("FAILED: qd(%zu) out-of-bounds for test", qd);
+		return -EINVAL;
+	}
+
+	xnvme_cli_pinf("qdepth: %zu, nentries: %u", qd, nentries);
+
+	wbuf = xnvme_buf_alloc(dev, buf_nbytes);
+	rbuf = xnvme_buf_alloc(dev, buf_nbytes);
+	if (!wbuf || !rbuf) {
+		err = -errno;
+		xnvme_cli_perr("xnvme_buf_alloc()", err);
+		goto exit;
+	}
+	xnvme_buf_fill(wbuf, buf_nbytes, "anum");
+	memset(rbuf, 0, buf_nbytes);
+
+	err = xnvme_queue_init(dev, qd, 0, &queue);
+	if (err) {
+		xnvme_cli_perr("xnvme_queue_init()", err);
+		goto exit;
+	}
+	err = xnvme_queue_set_backlog(queue, nentries);
+	if (err) {
+		xnvme_cli_perr("xnvme_queue_set_backlog()", err);
+		goto exit;
+	}
+	xnvme_queue_set_cb(queue, cb_backlog, state);
+
+	for (int rd = 0; rd < 2; ++rd) {
+		uint8_t *buf = rd ? rbuf : wbuf;
+
+		for (uint32_t i = 0; i < ncmds; ++i) {
+			struct xnvme_cmd_ctx *ctx = xnvme_queue_get_cmd_ctx(queue);
+			void *dbuf = buf + (size_t)i * geo->lba_nbytes;
+
+			if (!ctx) {
+				err = -errno;
+				xnvme_cli_perr("xnvme_queue_get_cmd_ctx()", err);
+				goto exit;
+			}
+
+			err = rd ? xnvme_nvm_read(ctx, nsid, i, 0, dbuf, NULL)
+				 : xnvme_nvm_write(ctx, nsid, i, 0, dbuf, NULL);
+			if (err) {
+				xnvme_cli_perr("xnvme_nvm_{read,write}()", err);
+				xnvme_queue_put_cmd_ctx(queue, ctx);
+				goto exit;
+			}
+		}
+		if (xnvme_queue_get_outstanding(queue) > qd) {
+			xnvme_cli_pinf("FAILED: outstanding: %u > qd: %zu",
+				       xnvme_queue_get_outstanding(queue), qd);
+			err = -EIO;
+			goto exit;
+		}
+
+		err = xnvme_queue_drain(queue);
+		if (err < 0) {
+			xnvme_cli_perr("xnvme_queue_drain()", err);
+			goto exit;
+		}
+	}
+
+	if (state[0] != 2 * ncmds || state[1]) {
+		xnvme_cli_pinf("FAILED: ncompleted: %u, nfailed: %u", state[0], state[1]);
+		err = -EIO;
+		goto exit;
+	}
+	if (memcmp(wbuf, rbuf, buf_nbytes)) {
+		xnvme_cli_pinf("FAILED: data read back does not match data written");
+		err = -EIO;
+		goto exit;
+	}
+	err = 0;
+
+exit:
+	xnvme_queue_term(queue);
+	xnvme_buf_free(dev, wbuf);
+	xnvme_buf_free(dev, rbuf);
+
+	return err;
+}
+
+/**
+ * Submit 'qdepth' reads on each of 'count' queues and reap them via a poll-group
+ */
+static int
+test_poll_group(struct xnvme_cli *cli)
+{
+	struct xnvme_dev *dev = cli->args.dev;
+	const struct xnvme_geo *geo = xnvme_dev_get_geo(dev);
+	uint32_t nsid = xnvme_dev_get_nsid(dev);
+	uint64_t qd = cli->given[XNVME_CLI_OPT_QDEPTH] ? cli->args.qdepth : 16;
+	uint64_t nqueues = cli->given[XNVME_CLI_OPT_COUNT] ? cli->args.count : 4;
+	struct xnvme_queue *queue[XNVME_TESTS_NQUEUE_MAX] = {0};
+	struct xnvme_poll_group *group = NULL;
+	uint32_t ncompleted = 0;
+	void *buf = NULL;
+	int err;
+
+	if (!qd || qd > XNVME_TESTS_QDEPTH_MAX) {
+		XNVME_DEBUG("FAILED: qd(%zu) out-of-bounds for test", qd);
+		return -EINVAL;
+	}
+	if (!nqueues || nqueues > XNVME_TESTS_NQUEUE_MAX) {
+		XNVME_DEBUG("FAILED: count(%zu) out-of-bounds for test", nqueues);
+		return -EINVAL;
+	}
+
+	xnvme_cli_pinf("qdepth: %zu, nqueues: %zu", qd, nqueues);
+
+	buf = xnvme_buf_alloc(dev, qd * geo->lba_nbytes);
+	if (!buf) {
+		err = -errno;
+		xnvme_cli_perr("xnvme_buf_alloc()", err);
+		return err;
+	}
+
+	group = xnvme_poll_group_create(nqueues);
+	if (!group) {
+		err = -errno;
+		xnvme_cli_perr("xnvme_poll_group_create()", err);
+		goto exit;
+	}
+
+	for (uint64_t qn = 0; qn < nqueues; ++qn) {
+		err = xnvme_queue_init(dev, qd, 0, &queue[qn]);
+		if (err) {
+			xnvme_cli_perr("xnvme_queue_init()", err);
+			goto exit;
+		}
+		xnvme_queue_set_cb(queue[qn], cb_wait_timeout, &ncompleted);
+
+		err = xnvme_poll_group_add(group, queue[qn]);
+		if (err) {
+			xnvme_cli_perr("xnvme_poll_group_add()", err);
+			goto exit;
+		}
+	}
+
+	err = xnvme_poll_group_add(group, queue[0]);
+	if (err != -EEXIST) {
+		xnvme_cli_pinf("FAILED: adding a queue twice, err: %d", err);
+		err = -EIO;
+		goto exit;
+	}
+
+	// Nothing outstanding; must return immediately
+	err = xnvme_poll_group_wait(group, 1, 1000);
+	if (err) {
+		xnvme_cli_perr("xnvme_poll_group_wait(empty)", err);
+		err = err < 0 ? err : -EIO;
+		goto exit;
+	}
+
+	for (uint64_t qn = 0; qn < nqueues; ++qn) {
+		for (uint64_t i = 0; i < qd; ++i) {
+			struct xnvme_cmd_ctx *ctx = xnvme_queue_get_cmd_ctx(queue[qn]);
+			char *payload = (char *)buf + i * geo->lba_nbytes;
+
+			err = xnvme_nvm_read(ctx, nsid, i, 0, payload, NULL);
+			if (err) {
+				xnvme_cli_perr("xnvme_nvm_read()", err);
+				xnvme_queue_put_cmd_ctx(queue[qn], ctx);
+				goto exit;
+			}
+		}
+	}
+
+	err = xnvme_poll_group_poke(group, 1);
+	if (err < 0 || err > 1) {
+		xnvme_cli_perr("xnvme_poll_group_poke(1)", err);
+		err = err < 0 ? err : -EIO;
+		goto exit;
+	}
+
+	// A 'min_completions' of 0 waits for everything outstanding
+	err = xnvme_poll_group_wait(group, 0, 0);
+	if (err < 0) {
+		xnvme_cli_perr("xnvme_poll_group_wait(0)", err);
+		goto exit;
+	}
+
+	for (uint64_t qn = 0; qn < nqueues; ++qn) {
+		if (xnvme_queue_get_outstanding(queue[qn])) {
+			xnvme_cli_pinf("FAILED: qn: %zu, outstanding: %u", qn,
+				       xnvme_queue_get_outstanding(queue[qn]));
+			err = -EIO;
+			goto exit;
+		}
+	}
+	if (ncompleted != qd * nqueues) {
+		xnvme_cli_pinf("FAILED: ncompleted: %u != %zu", ncompleted, qd * nqueues);
+		err = -EIO;
+		goto exit;
+	}
+
+	err = xnvme_poll_group_remove(group, queue[0]);
+	if (err) {
+		xnvme_cli_perr("xnvme_poll_group_remove()", err);
+		goto exit;
+	}
+	err = xnvme_poll_group_remove(group, queue[0]);
+	if (err != -ENOENT) {
+		xnvme_cli_pinf("FAILED: removing a queue twice, err: %d", err);
+		err = -EIO;
+		goto exit;
+	}
+	err = 0;
+
+exit:
+	xnvme_poll_group_destroy(group);
+	for (uint64_t qn = 0; qn < nqueues && queue[qn]; ++qn) {
+		xnvme_queue_term(queue[qn]);
+	}
+	xnvme_buf_free(dev, buf);
+
+	return err;
+}
+
+/**
+ * Stage 'qdepth' reads on each of 'count' shared queues and reap them via a poll-group, which
+ * must move the staged commands to the backend, as the queues have nothing outstanding
+ */
+static int
+test_poll_group_shared(struct xnvme_cli *cli)
+{
+	struct xnvme_dev *dev = cli->args.dev;
+	const struct xnvme_geo *geo = xnvme_dev_get_geo(dev);
+	uint32_t nsid = xnvme_dev_get_nsid(dev);
+	uint64_t qd = cli->given[XNVME_CLI_OPT_QDEPTH] ? cli->args.qdepth : 16;
+	uint64_t nqueues = cli->given[XNVME_CLI_OPT_COUNT] ? cli->args.count : 2;
+	struct xnvme_queue *queue[XNVME_TESTS_NQUEUE_MAX] = {0};
+	struct xnvme_poll_group *group = NULL;
+	uint32_t ncompleted = 0;
+	void *buf = NULL;
+	int err;
+
+	if (!qd || qd > XNVME_TESTS_QDEPTH_MAX) {
+		XNVME_DEBUG("FAILED: qd(%zu) out-of-bounds for test", qd);
+		return -EINVAL;
+	}
+	if (!nqueues || nqueues > XNVME_TESTS_NQUEUE_MAX) {
+		XNVME_DEBUG("FAILED: count(%zu) out-of-bounds for test", nqueues);
+		return -EINVAL;
+	}
+
+	xnvme_cli_pinf("qdepth: %zu, nqueues: %zu", qd, nqueues);
+
+	buf = xnvme_buf_alloc(dev, qd * geo->lba_nbytes);
+	if (!buf) {
+		err = -errno;
+		xnvme_cli_perr("xnvme_buf_alloc()", err);
+		return err;
+	}
+
+	group = xnvme_poll_group_create(nqueues);
+	if (!group) {
+		err = -errno;
+		xnvme_cli_perr("xnvme_poll_group_create()", err);
+		goto exit;
+	}
+
+	for (uint64_t qn = 0; qn < nqueues; ++qn) {
+		err = xnvme_queue_init(dev, qd, 0, &queue[qn]);
+		if (err) {
+			xnvme_cli_perr("xnvme_queue_init()", err);
+			goto exit;
+		}
+		xnvme_queue_set_cb(queue[qn], cb_wait_timeout, &ncompleted);
+
+		err = xnvme_queue_set_shared(queue[qn]);
+		if (err) {
+			xnvme_cli_perr("xnvme_queue_set_shared()", err);
+			goto exit;
+		}
+		err = xnvme_poll_group_add(group, queue[qn]);
+		if (err) {
+			xnvme_cli_perr("xnvme_poll_group_add()", err);
+			goto exit;
+		}
+	}
+
+	for (uint64_t qn = 0; qn < nqueues; ++qn) {
+		for (uint64_t i = 0; i < qd; ++i) {
+			struct xnvme_cmd_ctx *ctx = xnvme_queue_get_cmd_ctx(queue[qn]);
+			char *payload = (char *)buf + i * geo->lba_nbytes;
+
+			err = xnvme_nvm_read(ctx, nsid, i, 0, payload, NULL);
+			if (err) {
+				xnvme_cli_perr("xnvme_nvm_read()", err);
+				xnvme_queue_put_cmd_ctx(queue[qn], ctx);
+				goto exit;
+			}
+		}
+		if (xnvme_queue_get_outstanding(queue[qn])) {
+			xnvme_cli_pinf("FAILED: qn: %zu, commands not staged", qn);
+			err = -EIO;
+			goto exit;
+		}
+	}
+
+	// A 'min_completions' of 0 waits for everything outstanding, including staged commands
+	err = xnvme_poll_group_wait(group, 0, 0);
+	if (err < 0) {
+		xnvme_cli_perr("xnvme_poll_group_wait(0)", err);
+		goto exit;
+	}
+	if ((uint64_t)err != qd * nqueues || ncompleted != qd * nqueues) {
+		xnvme_cli_pinf("FAILED: err: %d, ncompleted: %u != %zu", err, ncompleted,
+			       qd * nqueues);
+		err = -EIO;
+		goto exit;
+	}
+	err = 0;
+
+exit:
+	xnvme_poll_group_destroy(group);
+	for (uint64_t qn = 0; qn < nqueues && queue[qn]; ++qn) {
+		xnvme_queue_term(queue[qn]);
+	}
+	xnvme_buf_free(dev, buf);
+
+	return err;
+}
+
+struct shared_state {
+	struct xnvme_queue *queue; ///< The shared queue, submitted to by the executor-workers
+	uint32_t nsid;
+	void *buf;
+	uint32_t nfailed;
+	uint32_t ncompleted;
+};
+
+static void
+cb_shared(struct xnvme_cmd_ctx *ctx, void *cb_arg)
+{
+	struct shared_state *state = cb_arg;
+
+	if (xnvme_cmd_ctx_cpl_status(ctx)) {
+		state->nfailed += 1;
+	}
+	state->ncompleted += 1;
+	xnvme_queue_put_cmd_ctx(ctx->async.queue, ctx);
+}
+
+/**
+ * Submit a read on the shared queue, from an executor-worker, ignoring the queue of the worker
+ */
+static void
+shared_submit(struct xnvme_queue *XNVME_UNUSED(queue), void *arg)
+{
+	struct shared_state *state = arg;
+	struct xnvme_cmd_ctx *ctx;
+	int err;
+
+	// Command-contexts are handed back by the owner upon completion
+	while (!(ctx = xnvme_queue_get_cmd_ctx(state->queue))) {
+		;
+	}
+
+	err = xnvme_nvm_read(ctx, state->nsid, 0, 0, state->buf, NULL);
+	if (err) {
+		__atomic_add_fetch(&state->nfailed, 1, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&state->ncompleted, 1, __ATOMIC_RELAXED);
+		xnvme_queue_put_cmd_ctx(state->queue, ctx);
+	}
+}
+
+/**
+ * Submit reads to a single shared queue from 'count' threads, while this thread pokes the queue
+ */
+static int
+test_shared(struct xnvme_cli *cli)
+{
+	struct xnvme_dev *dev = cli->args.dev;
+	const struct xnvme_geo *geo = xnvme_dev_get_geo(dev);
+	uint64_t qd = cli->given[XNVME_CLI_OPT_QDEPTH] ? cli->args.qdepth : 16;
+	uint32_t nthreads = cli->given[XNVME_CLI_OPT_COUNT] ? cli->args.count : 4;
+	uint32_t ncmds = 2000;
+	struct shared_state state = {.nsid = xnvme_dev_get_nsid(dev)};
+	struct xnvme_executor *exec = NULL;
+	int err;
+
+	if (!qd || qd > XNVME_TESTS_QDEPTH_MAX) {
+		XNVME_DEBUG("FAILED: qd(%zu) out-of-bounds for test", qd);
+		return -EINVAL;
+	}
+
+	xnvme_cli_pinf("qdepth: %zu, nthreads: %u, ncmds: %u", qd, nthreads, ncmds);
+
+	state.buf = xnvme_buf_alloc(dev, geo->lba_nbytes);
+	if (!state.buf) {
+		err = -errno;
+		xnvme_cli_perr("xnvme_buf_alloc()", err);
+		return err;
+	}
+
+	err = xnvme_queue_init(dev, qd, 0, &state.queue);
+	if (err) {
+		xnvme_cli_perr("xnvme_queue_init()", err);
+		goto exit;
+	}
+	xnvme_queue_set_cb(state.queue, cb_shared, &state);
+
+	err = xnvme_queue_set_shared(state.queue);
+	if (err) {
+		xnvme_cli_perr("xnvme_queue_set_shared()", err);
+		goto exit;
+	}
+	err = xnvme_queue_set_shared(state.queue);
+	if (err != -EEXIST) {
+		xnvme_cli_pinf("FAILED: setting the shared mode twice, err: %d", err);
+		err = -EIO;
+		goto exit;
+	}
+
+	exec = xnvme_executor_create(dev, nthreads, 1);
+	if (!exec) {
+		err = -errno;
+		xnvme_cli_perr("xnvme_executor_create()", err);
+		goto exit;
+	}
+	for (uint32_t i = 0; i < ncmds; ++i) {
+		err = xnvme_executor_submit(exec, shared_submit, &state);
+		if (err) {
+			xnvme_cli_perr("xnvme_executor_submit()", err);
+			goto exit;
+		}
+	}
+
+	while (__atomic_load_n(&state.ncompleted, __ATOMIC_RELAXED) < ncmds) {
+		err = xnvme_queue_poke(state.queue, 0);
+		if (err < 0) {
+			xnvme_cli_perr("xnvme_queue_poke()", err);
+			goto exit;
+		}
+	}
+
+	if (state.nfailed || xnvme_queue_get_outstanding(state.queue)) {
+		xnvme_cli_pinf("FAILED: nfailed: %u, outstanding: %u", state.nfailed,
+			       xnvme_queue_get_outstanding(state.queue));
+		err = -EIO;
+		goto exit;
+	}
+	err = 0;
+
+exit:
+	xnvme_executor_destroy(exec);
+	xnvme_queue_term(state.queue);
+	xnvme_buf_free(dev, state.buf);
+
+	return err;
+}
+
+struct timeout_cmd {
+	bool completed;
+	bool timely;  ///< Completed by the first poke, or without a deadline
+	int canceled; ///< The return value of xnvme_cmd_cancel(), 1 when not cancelled
+	int err;      ///< The return value of xnvme_cmd_ctx_cpl_status()
+	struct xnvme_spec_status status;
+};
+
+static void
+cb_timeout(struct xnvme_cmd_ctx *ctx, void *cb_arg)
+{
+	struct timeout_cmd *cmd = cb_arg;
+
+	cmd->completed = true;
+	cmd->err = xnvme_cmd_ctx_cpl_status(ctx);
+	cmd->status = ctx->cpl.status;
+	xnvme_queue_put_cmd_ctx(ctx->async.queue, ctx);
+}
+
+static inline bool
+timeout_cmd_is(struct timeout_cmd *cmd, int sc)
+{
+	return (cmd->status.sct == XNVME_STATUS_CODE_TYPE_VENDOR) && (cmd->status.sc == sc);
+}
+
+/**
+ * Submit 'qdepth' reads, with timeouts disabled, and cancel every other one; then submit them with
+ * a timeout of a nanosecond, except for the last one, which overrides it, and verify that those
+ * not completed by the first poke complete as timed out
+ */
+static int
+test_timeout(struct xnvme_cli *cli)
+{
+	struct xnvme_dev *dev = cli->args.dev;
+	const struct xnvme_geo *geo = xnvme_dev_get_geo(dev);
+	uint32_t nsid = xnvme_dev_get_nsid(dev);
+	uint64_t qd = cli->given[XNVME_CLI_OPT_QDEPTH] ? cli->args.qdepth : 16;
+	struct xnvme_queue *queue = NULL;
+	struct timeout_cmd *cmds = NULL;
+	struct xnvme_cmd_ctx *ctx;
+	void *buf = NULL;
+	int err;
+
+	if (!qd || qd > XNVME_TESTS_QDEPTH_MAX) {
+		XNVME_DEBUG("FAILED: qd(%zu) out-of-bounds for test", qd);
+		return -EINVAL;
+	}
+
+	cmds = calloc(qd, sizeof(*cmds));
+	buf = xnvme_buf_alloc(dev, qd * geo->lba_nbytes);
+	if (!cmds || !buf) {
+		err = -ENOMEM;
+		xnvme_cli_perr("calloc()/xnvme_buf_alloc()", err);
+		goto exit;
+	}
+
+	err = xnvme_queue_init(dev, qd, 0, &queue);
+	if (err) {
+		xnvme_cli_perr("xnvme_queue_init()", err);
+		goto exit;
+	}
+
+	ctx = xnvme_queue_get_cmd_ctx(queue);
+	err = xnvme_cmd_ctx_set_timeout(ctx, 1);
+	xnvme_queue_put_cmd_ctx(queue, ctx);
+	if (err != -EINVAL) {
+		xnvme_cli_pinf("FAILED: set_timeout() without timeouts, err: %d", err);
+		err = -EIO;
+		goto exit;
+	}
+
+	for (uint64_t i = 0; i < qd; ++i) {
+		ctx = xnvme_queue_get_cmd_ctx(queue);
+		xnvme_cmd_ctx_set_cb(ctx, cb_timeout, &cmds[i]);
+		memset(&ctx->cpl, 0, sizeof(ctx->cpl));
+
+		err = xnvme_nvm_read(ctx, nsid, i, 0, (char *)buf + i * geo->lba_nbytes, NULL);
+		if (err) {
+			xnvme_cli_perr("xnvme_nvm_read()", err);
+			xnvme_queue_put_cmd_ctx(queue, ctx);
+			goto exit;
+		}
+		cmds[i].canceled = (i % 2) ? xnvme_cmd_cancel(ctx) : 1;
+	}
+
+	err = xnvme_queue_drain(queue);
+	if (err < 0) {
+		xnvme_cli_perr("xnvme_queue_drain()", err);
+		goto exit;
+	}
+
+	// Whether a command can be cancelled is up to the backend, its status must reflect it
+	for (uint64_t i = 0; i < qd; ++i) {
+		struct timeout_cmd *cmd = &cmds[i];
+
+		if ((cmd->canceled < 0) && (cmd->canceled != -EALREADY) &&
+		    (cmd->canceled != -ENOSYS)) {
+			xnvme_cli_pinf("FAILED: cmd: %zu, xnvme_cmd_cancel(), err: %d", i,
+				       cmd->canceled);
+			err = -EIO;
+			goto exit;
+		}
+		if (!cmd->completed ||
+		    (cmd->canceled ? cmd->err : !timeout_cmd_is(cmd, ECANCELED))) {
+			xnvme_cli_pinf("FAILED: cmd: %zu, canceled: %d, sct: 0x%x, sc: 0x%x", i,
+				       cmd->canceled, cmd->status.sct, cmd->status.sc);
+			err = -EIO;
+			goto exit;
+		}
+	}
+
+	err = xnvme_queue_set_timeout(queue, 1);
+	if (err) {
+		xnvme_cli_perr("xnvme_queue_set_timeout()", err);
+		goto exit;
+	}
+	err = xnvme_queue_set_backlog(queue, qd);
+	if (err != -EBUSY) {
+		xnvme_cli_pinf("FAILED: xnvme_queue_set_backlog() after timeouts, err: %d", err);
+		err = -EIO;
+		goto exit;
+	}
+
+	memset(cmds, 0, qd * sizeof(*cmds));
+	for (uint64_t i = 0; i < qd; ++i) {
+		ctx = xnvme_queue_get_cmd_ctx(queue);
+		xnvme_cmd_ctx_set_cb(ctx, cb_timeout, &cmds[i]);
+		memset(&ctx->cpl, 0, sizeof(ctx->cpl));
+		if (i == qd - 1) {
+			xnvme_cmd_ctx_set_timeout(ctx, 0);
+			cmds[i].timely = true;
+		}
+
+		err = xnvme_nvm_read(ctx, nsid, i, 0, (char *)buf + i * geo->lba_nbytes, NULL);
+		if (err) {
+			xnvme_cli_perr("xnvme_nvm_read()", err);
+			xnvme_queue_put_cmd_ctx(queue, ctx);
+			goto exit;
+		}
+	}
+
+	// Commands completed by this poke made it in time, the remainder is past its deadline
+	err = xnvme_queue_poke(queue, 1);
+	if (err < 0) {
+		xnvme_cli_perr("xnvme_queue_poke()", err);
+		goto exit;
+	}
+	for (uint64_t i = 0; i < qd; ++i) {
+		cmds[i].timely |= cmds[i].completed;
+	}
+
+	err = xnvme_queue_drain(queue);
+	if (err < 0) {
+		xnvme_cli_perr("xnvme_queue_drain()", err);
+		goto exit;
+	}
+
+	for (uint64_t i = 0; i < qd; ++i) {
+		struct timeout_cmd *cmd = &cmds[i];
+		bool timedout = timeout_cmd_is(cmd, ETIMEDOUT);
+
+		if (!cmd->completed || (cmd->timely ? cmd->err : !timedout)) {
+			xnvme_cli_pinf("FAILED: cmd: %zu, timely: %d, sct: 0x%x, sc: 0x%x", i,
+				       cmd->timely, cmd->status.sct, cmd->status.sc);
+			err = -EIO;
+			goto exit;
+		}
+	}
+	err = 0;
+
+exit:
+	xnvme_queue_term(queue);
+	xnvme_buf_free(dev, buf);
+	free(cmds);
+
+	return err;
+}
+
 //
 // Command-Line Interface (CLI) definition
 //
@@ -112,6 +1252,143 @@ static struct xnvme_cli_sub g_subs[] = {
 			{XNVME_CLI_OPT_QDEPTH, XNVME_CLI_LREQ},
 			{XNVME_CLI_OPT_CLEAR, XNVME_CLI_LFLG},
 
+			XNVME_CLI_ASYNC_OPTS,
+		},
+	},
+	{
+		"wait_timeout",
+		"Submit 'qdepth' reads and reap them via xnvme_queue_wait_timeout()",
+		"Submit 'qdepth' reads and reap them via xnvme_queue_wait_timeout()",
+		test_wait_timeout,
+		{
+			{XNVME_CLI_OPT_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_URI, XNVME_CLI_POSA},
+
+			{XNVME_CLI_OPT_NON_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_QDEPTH, XNVME_CLI_LOPT},
+
+			XNVME_CLI_ASYNC_OPTS,
+		},
+	},
+	{
+		"completion_fd",
+		"Reap reads after polling the completion fd of the queue",
+		"Reap reads after polling the completion fd of the queue",
+		test_completion_fd,
+		{
+			{XNVME_CLI_OPT_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_URI, XNVME_CLI_POSA},
+
+			{XNVME_CLI_OPT_NON_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_QDEPTH, XNVME_CLI_LOPT},
+
+			XNVME_CLI_ASYNC_OPTS,
+		},
+	},
+	{
+		"pi",
+		"Write and read with software PI on the queue, using 'count' helper threads",
+		"Write and read with software PI on the queue, using 'count' helper threads",
+		test_pi,
+		{
+			{XNVME_CLI_OPT_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_URI, XNVME_CLI_POSA},
+
+			{XNVME_CLI_OPT_NON_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_QDEPTH, XNVME_CLI_LOPT},
+			{XNVME_CLI_OPT_COUNT, XNVME_CLI_LOPT},
+
+			XNVME_CLI_ASYNC_OPTS,
+		},
+	},
+	{
+		"pi_report",
+		"Verify PI with corrupted fields, expecting the first failure reported",
+		"Verify PI with corrupted fields, expecting the first failure reported",
+		test_pi_report,
+		{
+			{XNVME_CLI_OPT_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_URI, XNVME_CLI_POSA},
+
+			XNVME_CLI_ASYNC_OPTS,
+		},
+	},
+	{
+		"backlog",
+		"Submit 'qdepth' plus 'count' commands via the submission backlog",
+		"Submit 'qdepth' plus 'count' commands via the submission backlog",
+		test_backlog,
+		{
+			{XNVME_CLI_OPT_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_URI, XNVME_CLI_POSA},
+
+			{XNVME_CLI_OPT_NON_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_QDEPTH, XNVME_CLI_LOPT},
+			{XNVME_CLI_OPT_COUNT, XNVME_CLI_LOPT},
+
+			XNVME_CLI_ASYNC_OPTS,
+		},
+	},
+	{
+		"poll_group",
+		"Submit 'qdepth' reads on each of 'count' queues and reap them via a poll-group",
+		"Submit 'qdepth' reads on each of 'count' queues and reap them via a poll-group",
+		test_poll_group,
+		{
+			{XNVME_CLI_OPT_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_URI, XNVME_CLI_POSA},
+
+			{XNVME_CLI_OPT_NON_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_QDEPTH, XNVME_CLI_LOPT},
+			{XNVME_CLI_OPT_COUNT, XNVME_CLI_LOPT},
+
+			XNVME_CLI_ASYNC_OPTS,
+		},
+	},
+	{
+		"poll_group_shared",
+		"Reap reads staged on each of 'count' shared queues via a poll-group",
+		"Reap reads staged on each of 'count' shared queues via a poll-group",
+		test_poll_group_shared,
+		{
+			{XNVME_CLI_OPT_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_URI, XNVME_CLI_POSA},
+
+			{XNVME_CLI_OPT_NON_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_QDEPTH, XNVME_CLI_LOPT},
+			{XNVME_CLI_OPT_COUNT, XNVME_CLI_LOPT},
+
+			XNVME_CLI_ASYNC_OPTS,
+		},
+	},
+	{
+		"shared",
+		"Submit to a shared queue from 'count' threads, polled by the main thread",
+		"Submit to a shared queue from 'count' threads, polled by the main thread",
+		test_shared,
+		{
+			{XNVME_CLI_OPT_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_URI, XNVME_CLI_POSA},
+
+			{XNVME_CLI_OPT_NON_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_QDEPTH, XNVME_CLI_LOPT},
+			{XNVME_CLI_OPT_COUNT, XNVME_CLI_LOPT},
+
+			XNVME_CLI_ASYNC_OPTS,
+		},
+	},
+	{
+		"timeout",
+		"Cancel commands and time them out on a queue of 'qdepth' entries",
+		"Cancel commands and time them out on a queue of 'qdepth' entries",
+		test_timeout,
+		{
+			{XNVME_CLI_OPT_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_URI, XNVME_CLI_POSA},
+
+			{XNVME_CLI_OPT_NON_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_QDEPTH, XNVME_CLI_LOPT},
+
 			XNVME_CLI_ASYNC_OPTS,
 		},
 	},
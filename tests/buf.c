@@ -81,6 +81,638 @@ test_virt_buf_alloc_free(struct xnvme_cli *cli)
 	return nerr ? -ENOMEM : 0;
 }
 
+///< Largest buffer of the size-class tests, 2^XNVME_TESTS_BUF_SHIFT_MAX + 1 bytes
+#define XNVME_TESTS_BUF_SHIFT_MAX 22
+
+static uint8_t
+buf_pattern(size_t offset, uint32_t seed)
+{
+	return (uint8_t)((offset * 31) + (offset >> 12) + seed);
+}
+
+static void
+buf_pattern_fill(uint8_t *buf, size_t from, size_t to, uint32_t seed)
+{
+	for (size_t ofz = from; ofz < to; ++ofz) {
+		buf[ofz] = buf_pattern(ofz, seed);
+	}
+}
+
+static bool
+buf_pattern_check(const uint8_t *buf, size_t nbytes, uint32_t seed)
+{
+	for (size_t ofz = 0; ofz < nbytes; ++ofz) {
+		if (buf[ofz] != buf_pattern(ofz, seed)) {
+			xnvme_cli_pinf("FAILED: buf: %p, ofz: %zu, seed: %u", (const void *)buf,
+				       ofz, seed);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Allocate 'count' buffers of each size around the powers of two, that is, at the boundaries of
+ * the size-classes of the allocators, fill them entirely, and check that no buffer overwrote
+ * another, then free them in an interleaved order such that blocks are re-used out of order
+ */
+static int
+test_buf_sizes(struct xnvme_cli *cli)
+{
+	struct xnvme_dev *dev = cli->args.dev;
+	uint32_t count = cli->args.count;
+	uint8_t **bufs;
+	int err = 0;
+
+	xnvme_cli_pinf("count: %u, nbytes: [1, 2^%d + 1]", count, XNVME_TESTS_BUF_SHIFT_MAX);
+
+	bufs = calloc(count, sizeof(*bufs));
+	if (!bufs) {
+		err = -errno;
+		xnvme_cli_perr("calloc()", err);
+		return err;
+	}
+
+	for (int shift = 0; !err && shift <= XNVME_TESTS_BUF_SHIFT_MAX; ++shift) {
+		for (int delta = -1; !err && delta <= 1; ++delta) {
+			size_t nbytes = ((size_t)1 << shift) + delta;
+
+			if (!nbytes || ((shift == 1) && (delta == -1))) {
+				continue;
+			}
+
+			for (uint32_t i = 0; i < count; ++i) {
+				bufs[i] = xnvme_buf_alloc(dev, nbytes);
+				if (!bufs[i]) {
+					err = -errno;
+					xnvme_cli_perr("xnvme_buf_alloc()", err);
+					xnvme_cli_pinf("nbytes: %zu, i: %u", nbytes, i);
+					break;
+				}
+				buf_pattern_fill(bufs[i], 0, nbytes, i);
+			}
+			for (uint32_t i = 0; !err && i < count; ++i) {
+				if (!buf_pattern_check(bufs[i], nbytes, i)) {
+					xnvme_cli_pinf("FAILED: nbytes: %zu, overwritten", nbytes);
+					err = -EIO;
+				}
+			}
+
+			for (uint32_t i = 1; i < count; i += 2) {
+				xnvme_buf_free(dev, bufs[i]);
+				bufs[i] = NULL;
+			}
+			for (uint32_t i = 0; i < count; i += 2) {
+				xnvme_buf_free(dev, bufs[i]);
+				bufs[i] = NULL;
+			}
+		}
+	}
+
+	free(bufs);
+
+	if (!err) {
+		xnvme_cli_pinf("LGMT: xnvme_buf_{alloc,free} across size-classes");
+	}
+
+	return err;
+}
+
+/**
+ * Grow a buffer, via xnvme_buf_realloc(), through every size-class and then shrink it back,
+ * checking that the contents are kept; a buffer of the same size is allocated along the way, such
+ * that the growth cannot always be done in place
+ */
+static int
+test_buf_realloc(struct xnvme_cli *cli)
+{
+	struct xnvme_dev *dev = cli->args.dev;
+	uint32_t count = cli->args.count;
+	uint8_t *buf = NULL, *other = NULL;
+	size_t nbytes = 0;
+	int err = 0;
+
+	xnvme_cli_pinf("count: %u, nbytes: [1, 2^%d + 1]", count, XNVME_TESTS_BUF_SHIFT_MAX);
+
+	for (uint32_t round = 0; round < count; ++round) {
+		for (int shift = 0; shift <= XNVME_TESTS_BUF_SHIFT_MAX; ++shift) {
+			size_t new_nbytes = ((size_t)1 << shift) + (round % 2);
+			uint8_t *new_buf;
+
+			new_buf = xnvme_buf_realloc(dev, buf, new_nbytes);
+			if (!new_buf) {
+				err = -errno;
+				xnvme_cli_perr("xnvme_buf_realloc()", err);
+				goto exit;
+			}
+			buf = new_buf;
+			if (!buf_pattern_check(buf, nbytes, round)) {
+				xnvme_cli_pinf("FAILED: growing from: %zu, to: %zu", nbytes,
+					       new_nbytes);
+				err = -EIO;
+				goto exit;
+			}
+			buf_pattern_fill(buf, nbytes, new_nbytes, round);
+			nbytes = new_nbytes;
+
+			xnvme_buf_free(dev, other);
+			other = xnvme_buf_alloc(dev, nbytes);
+			if (!other) {
+				err = -errno;
+				xnvme_cli_perr("xnvme_buf_alloc()", err);
+				goto exit;
+			}
+		}
+
+		for (int shift = XNVME_TESTS_BUF_SHIFT_MAX - 1; shift >= 0; --shift) {
+			uint8_t *new_buf = xnvme_buf_realloc(dev, buf, (size_t)1 << shift);
+
+			if (!new_buf) {
+				err = -errno;
+				xnvme_cli_perr("xnvme_buf_realloc()", err);
+				goto exit;
+			}
+			buf = new_buf;
+			nbytes = (size_t)1 << shift;
+			if (!buf_pattern_check(buf, nbytes, round)) {
+				xnvme_cli_pinf("FAILED: shrinking to %zu", nbytes);
+				err = -EIO;
+				goto exit;
+			}
+		}
+
+		xnvme_buf_free(dev, buf);
+		buf = NULL;
+		nbytes = 0;
+	}
+
+	xnvme_cli_pinf("LGMT: xnvme_buf_realloc()");
+
+exit:
+	xnvme_buf_free(dev, buf);
+	xnvme_buf_free(dev, other);
+
+	return err;
+}
+
+/**
+ * Allocate up to 'count' buffers of 'data-nbytes', which, given a large enough 'count', exhausts
+ * the memory of the allocator. Failing to allocate must then be reported with ENOMEM, and the
+ * memory must be re-usable: every other buffer is freed and allocated again, and, once all of them
+ * are freed, just as many are allocated again. A single size is used, such that the holes left by
+ * freed buffers fit those allocated again, regardless of fragmentation.
+ */
+static int
+test_buf_exhaust(struct xnvme_cli *cli)
+{
+	struct xnvme_dev *dev = cli->args.dev;
+	uint32_t count = cli->args.count;
+	size_t nbytes = cli->given[XNVME_CLI_OPT_DATA_NBYTES] ? cli->args.data_nbytes
+							       : (2 << 20) + 1;
+	uint32_t nbufs = 0;
+	uint8_t **bufs;
+	int err = 0;
+
+	bufs = calloc(count, sizeof(*bufs));
+	if (!bufs) {
+		err = -errno;
+		xnvme_cli_perr("calloc()", err);
+		return err;
+	}
+
+	for (nbufs = 0; nbufs < count; ++nbufs) {
+		bufs[nbufs] = xnvme_buf_alloc(dev, nbytes);
+		if (!bufs[nbufs]) {
+			err = -errno;
+			break;
+		}
+		bufs[nbufs][0] = 1;
+		bufs[nbufs][nbytes - 1] = 1;
+	}
+	xnvme_cli_pinf("count: %u, nbytes: %zu, nbufs: %u, exhausted: %s", count, nbytes, nbufs,
+		       nbufs < count ? "yes" : "no");
+	if (err && (err != -ENOMEM)) {
+		xnvme_cli_perr("FAILED: xnvme_buf_alloc() did not fail with ENOMEM", err);
+		goto exit;
+	}
+	err = 0;
+
+	for (int round = 0; round < 2; ++round) {
+		uint32_t step = round ? 1 : 2;
+
+		for (uint32_t i = 0; i < nbufs; i += step) {
+			xnvme_buf_free(dev, bufs[i]);
+			bufs[i] = NULL;
+		}
+		for (uint32_t i = 0; i < nbufs; i += step) {
+			bufs[i] = xnvme_buf_alloc(dev, nbytes);
+			if (!bufs[i]) {
+				err = -errno;
+				xnvme_cli_perr("xnvme_buf_alloc()", err);
+				xnvme_cli_pinf("FAILED: re-allocating buffer: %u of %u", i, nbufs);
+				goto exit;
+			}
+		}
+	}
+
+	xnvme_cli_pinf("LGMT: xnvme_buf_alloc() exhaustion and re-use");
+
+exit:
+	for (uint32_t i = 0; i < nbufs; ++i) {
+		xnvme_buf_free(dev, bufs[i]);
+	}
+	free(bufs);
+
+	return err;
+}
+
+/**
+ * Drain the pool, half directly and half via a cache, checking that every buffer is handed out
+ * exactly once and that the pool is exhausted thereafter, then return all of them and repeat
+ */
+static int
+test_buf_pool(struct xnvme_cli *cli)
+{
+	uint32_t nbufs = cli->args.count;
+	size_t buf_nbytes = 0x1000;
+	struct xnvme_buf_pool_cache *cache = NULL;
+	struct xnvme_buf_pool *pool;
+	uint8_t **bufs = NULL;
+	int err = 0;
+
+	xnvme_cli_pinf("nbufs: %u, buf_nbytes: %zu", nbufs, buf_nbytes);
+
+	pool = xnvme_buf_pool_create(cli->args.dev, buf_nbytes, nbufs);
+	if (!pool) {
+		err = -errno;
+		xnvme_cli_perr("xnvme_buf_pool_create()", err);
+		return err;
+	}
+	cache = xnvme_buf_pool_cache_create(pool, 8);
+	bufs = calloc(nbufs, sizeof(*bufs));
+	if (!(cache && bufs)) {
+		err = -ENOMEM;
+		xnvme_cli_perr("xnvme_buf_pool_cache_create() or calloc()", err);
+		goto exit;
+	}
+
+	for (int round = 0; round < 2; ++round) {
+		for (uint32_t i = 0; i < nbufs; ++i) {
+			if (i < nbufs / 2) {
+				bufs[i] = xnvme_buf_pool_get(pool);
+			} else {
+				bufs[i] = xnvme_buf_pool_cache_get(cache);
+			}
+			if (!bufs[i]) {
+				err = -errno;
+				xnvme_cli_perr("xnvme_buf_pool_{cache_}get()", err);
+				goto exit;
+			}
+			memset(bufs[i], 0, buf_nbytes);
+		}
+		for (uint32_t i = 0; i < nbufs; ++i) {
+			bufs[i][0] += 1;
+			bufs[i][buf_nbytes - 1] += 1;
+		}
+		for (uint32_t i = 0; i < nbufs; ++i) {
+			if ((bufs[i][0] != 1) || (bufs[i][buf_nbytes - 1] != 1)) {
+				xnvme_cli_pinf("FAILED: buffer: %u handed out more than once", i);
+				err = -EINVAL;
+				goto exit;
+			}
+		}
+
+		if (xnvme_buf_pool_get(pool) || xnvme_buf_pool_cache_get(cache)) {
+			xnvme_cli_pinf("FAILED: got a buffer from an exhausted pool");
+			err = -EINVAL;
+			goto exit;
+		}
+
+		for (uint32_t i = 0; i < nbufs; ++i) {
+			if (i % 3) {
+				xnvme_buf_pool_cache_put(cache, bufs[i]);
+			} else {
+				xnvme_buf_pool_put(pool, bufs[i]);
+			}
+			bufs[i] = NULL;
+		}
+	}
+
+	xnvme_cli_pinf("LGMT: xnvme_buf_pool_{get,put}");
+
+exit:
+	if (bufs) {
+		for (uint32_t i = 0; i < nbufs; ++i) {
+			if (bufs[i]) {
+				xnvme_buf_pool_put(pool, bufs[i]);
+			}
+		}
+	}
+	free(bufs);
+	xnvme_buf_pool_cache_destroy(cache);
+	xnvme_buf_pool_destroy(pool);
+
+	return err;
+}
+
+#define XNVME_TESTS_POOL_NTHREADS 4
+#define XNVME_TESTS_POOL_NITER    100000
+#define XNVME_TESTS_POOL_NHELD    4
+
+struct pool_state {
+	struct xnvme_buf_pool *pool;
+	uint32_t ntags;   ///< Source of the tags marking the owner of a buffer
+	uint32_t nfailed; ///< Number of buffers handed out while held by another closure
+	uint32_t nempty;  ///< Number of times the pool, or a cache, was exhausted
+};
+
+/**
+ * Take a buffer and mark it with the given tag, the mark of a buffer handed out twice is not clear
+ */
+static void *
+pool_take(struct pool_state *state, struct xnvme_buf_pool_cache *cache, uint32_t tag)
+{
+	uint32_t *buf = cache ? xnvme_buf_pool_cache_get(cache) : xnvme_buf_pool_get(state->pool);
+
+	if (!buf) {
+		__atomic_add_fetch(&state->nempty, 1, __ATOMIC_RELAXED);
+		return NULL;
+	}
+	if (__atomic_exchange_n(buf, tag, __ATOMIC_ACQ_REL)) {
+		__atomic_add_fetch(&state->nfailed, 1, __ATOMIC_RELAXED);
+	}
+
+	return buf;
+}
+
+/**
+ * Get and put buffers of the pool, directly and via a cache of the closure, holding a few of them
+ * at a time, such that the closures running on the executor-workers contend on the pool
+ */
+static void
+pool_get_put(struct xnvme_queue *XNVME_UNUSED(queue), void *arg)
+{
+	struct pool_state *state = arg;
+	uint32_t tag = __atomic_add_fetch(&state->ntags, 1, __ATOMIC_RELAXED);
+	struct xnvme_buf_pool_cache *cache;
+	uint32_t *held[XNVME_TESTS_POOL_NHELD] = {0};
+
+	cache = xnvme_buf_pool_cache_create(state->pool, 8);
+	if (!cache) {
+		__atomic_add_fetch(&state->nfailed, 1, __ATOMIC_RELAXED);
+		return;
+	}
+
+	for (uint32_t i = 0; i < XNVME_TESTS_POOL_NITER; ++i) {
+		uint32_t slot = i % XNVME_TESTS_POOL_NHELD;
+		bool via_cache = (i / XNVME_TESTS_POOL_NHELD) % 2;
+
+		if (held[slot]) {
+			if (__atomic_exchange_n(held[slot], 0, __ATOMIC_ACQ_REL) != tag) {
+				__atomic_add_fetch(&state->nfailed, 1, __ATOMIC_RELAXED);
+			}
+			if (via_cache) {
+				xnvme_buf_pool_cache_put(cache, held[slot]);
+			} else {
+				xnvme_buf_pool_put(state->pool, held[slot]);
+			}
+		}
+		held[slot] = pool_take(state, via_cache ? cache : NULL, tag);
+	}
+
+	for (uint32_t slot = 0; slot < XNVME_TESTS_POOL_NHELD; ++slot) {
+		if (held[slot]) {
+			__atomic_store_n(held[slot], 0, __ATOMIC_RELEASE);
+			xnvme_buf_pool_put(state->pool, held[slot]);
+		}
+	}
+	xnvme_buf_pool_cache_destroy(cache);
+}
+
+/**
+ * Get and put the buffers of a pool of 'count' buffers from several executor-workers at once,
+ * checking that no buffer is handed out twice, and that all are back in the pool thereafter
+ */
+static int
+test_buf_pool_mt(struct xnvme_cli *cli)
+{
+	struct xnvme_dev *dev = cli->args.dev;
+	uint32_t nbufs = cli->args.count;
+	uint32_t nthreads = XNVME_TESTS_POOL_NTHREADS;
+	uint32_t nclosures = nthreads * 4;
+	struct pool_state state = {0};
+	struct xnvme_executor *exec = NULL;
+	uint32_t **bufs = NULL;
+	int err;
+
+	xnvme_cli_pinf("nbufs: %u, nthreads: %u, nclosures: %u", nbufs, nthreads, nclosures);
+
+	state.pool = xnvme_buf_pool_create(dev, sizeof(uint32_t), nbufs);
+	bufs = calloc(nbufs, sizeof(*bufs));
+	if (!(state.pool && bufs)) {
+		err = -errno;
+		xnvme_cli_perr("xnvme_buf_pool_create() or calloc()", err);
+		goto exit;
+	}
+
+	// Clear the marks of all the buffers
+	for (uint32_t i = 0; i < nbufs; ++i) {
+		bufs[i] = xnvme_buf_pool_get(state.pool);
+		if (!bufs[i]) {
+			err = -errno;
+			xnvme_cli_perr("xnvme_buf_pool_get()", err);
+			goto exit;
+		}
+		*bufs[i] = 0;
+	}
+	for (uint32_t i = 0; i < nbufs; ++i) {
+		xnvme_buf_pool_put(state.pool, bufs[i]);
+		bufs[i] = NULL;
+	}
+
+	exec = xnvme_executor_create(dev, nthreads, 1);
+	if (!exec) {
+		err = -errno;
+		xnvme_cli_perr("xnvme_executor_create()", err);
+		goto exit;
+	}
+	for (uint32_t i = 0; i < nclosures; ++i) {
+		err = xnvme_executor_submit(exec, pool_get_put, &state);
+		if (err) {
+			xnvme_cli_perr("xnvme_executor_submit()", err);
+			goto exit;
+		}
+	}
+	err = xnvme_executor_drain(exec);
+	if (err) {
+		xnvme_cli_perr("xnvme_executor_drain()", err);
+		goto exit;
+	}
+
+	xnvme_cli_pinf("nfailed: %u, nempty: %u", state.nfailed, state.nempty);
+	if (state.nfailed) {
+		xnvme_cli_pinf("FAILED: buffers handed out more than once");
+		err = -EIO;
+		goto exit;
+	}
+
+	for (uint32_t i = 0; i < nbufs; ++i) {
+		bufs[i] = xnvme_buf_pool_get(state.pool);
+		if (!bufs[i] || *bufs[i]) {
+			xnvme_cli_pinf("FAILED: buffer: %u of %u, not back in the pool", i, nbufs);
+			err = -EIO;
+			goto exit;
+		}
+		*bufs[i] = 1;
+	}
+	if (xnvme_buf_pool_get(state.pool)) {
+		xnvme_cli_pinf("FAILED: got a buffer from an exhausted pool");
+		err = -EIO;
+		goto exit;
+	}
+
+	xnvme_cli_pinf("LGMT: xnvme_buf_pool_{get,put} from multiple threads");
+
+exit:
+	xnvme_executor_destroy(exec);
+	if (bufs) {
+		for (uint32_t i = 0; i < nbufs; ++i) {
+			if (bufs[i]) {
+				xnvme_buf_pool_put(state.pool, bufs[i]);
+			}
+		}
+	}
+	free(bufs);
+	xnvme_buf_pool_destroy(state.pool);
+
+	return err;
+}
+
+static void
+cb_registry(struct xnvme_cmd_ctx *ctx, void *cb_arg)
+{
+	uint32_t *nfailed = cb_arg;
+
+	if (xnvme_cmd_ctx_cpl_status(ctx)) {
+		xnvme_cmd_ctx_pr(ctx, XNVME_PR_DEF);
+		*nfailed += 1;
+	}
+	xnvme_queue_put_cmd_ctx(ctx->async.queue, ctx);
+}
+
+static int
+registry_io(struct xnvme_queue *queue, uint32_t nsid, uint8_t opcode, uint64_t slba, void *buf)
+{
+	struct xnvme_cmd_ctx *ctx = xnvme_queue_get_cmd_ctx(queue);
+	int err;
+
+	if (opcode == XNVME_SPEC_NVM_OPC_WRITE) {
+		err = xnvme_nvm_write(ctx, nsid, slba, 0, buf, NULL);
+	} else {
+		err = xnvme_nvm_read(ctx, nsid, slba, 0, buf, NULL);
+	}
+	if (err) {
+		xnvme_cli_perr("xnvme_nvm_{read,write}()", err);
+		xnvme_queue_put_cmd_ctx(queue, ctx);
+		return err;
+	}
+
+	err = xnvme_queue_drain(queue);
+
+	return err < 0 ? err : 0;
+}
+
+/**
+ * Allocate 'count' buffers, more than the buffer-registry has slots for, on a device opened with
+ * 'register_buffers'; allocation must not fail when the registry is full, and I/O must work on
+ * the registered as well as on the unregistered buffers. Then free and allocate half of them
+ * again, such that freed slots are reused, and repeat the I/O.
+ */
+static int
+test_buf_registry(struct xnvme_cli *cli)
+{
+	struct xnvme_dev *dev = cli->args.dev;
+	const struct xnvme_geo *geo = xnvme_dev_get_geo(dev);
+	uint32_t nsid = xnvme_dev_get_nsid(dev);
+	uint32_t nbufs = cli->args.count;
+	struct xnvme_queue *queue = NULL;
+	uint8_t **bufs = NULL;
+	uint32_t nfailed = 0;
+	int err;
+
+	xnvme_cli_pinf("nbufs: %u, register_buffers: %u", nbufs, cli->args.register_buffers);
+
+	bufs = calloc(nbufs, sizeof(*bufs));
+	if (!bufs) {
+		err = -errno;
+		xnvme_cli_perr("calloc()", err);
+		return err;
+	}
+
+	err = xnvme_queue_init(dev, 1, 0, &queue);
+	if (err) {
+		xnvme_cli_perr("xnvme_queue_init()", err);
+		goto exit;
+	}
+	xnvme_queue_set_cb(queue, cb_registry, &nfailed);
+
+	for (int round = 0; round < 2; ++round) {
+		for (uint32_t i = round ? nbufs / 2 : 0; i < nbufs; ++i) {
+			bufs[i] = xnvme_buf_alloc(dev, geo->lba_nbytes);
+			if (!bufs[i]) {
+				err = -errno;
+				xnvme_cli_perr("xnvme_buf_alloc()", err);
+				goto exit;
+			}
+		}
+
+		for (uint32_t i = 0; i < nbufs; ++i) {
+			memset(bufs[i], i + round, geo->lba_nbytes);
+			err = registry_io(queue, nsid, XNVME_SPEC_NVM_OPC_WRITE, i, bufs[i]);
+			if (err) {
+				goto exit;
+			}
+		}
+		for (uint32_t i = 0; i < nbufs; ++i) {
+			memset(bufs[i], 0, geo->lba_nbytes);
+			err = registry_io(queue, nsid, XNVME_SPEC_NVM_OPC_READ, i, bufs[i]);
+			if (err) {
+				goto exit;
+			}
+			if ((bufs[i][0] != (uint8_t)(i + round)) ||
+			    (bufs[i][geo->lba_nbytes - 1] != (uint8_t)(i + round))) {
+				xnvme_cli_pinf("FAILED: round: %d, buffer: %u", round, i);
+				err = -EIO;
+				goto exit;
+			}
+		}
+		if (nfailed) {
+			xnvme_cli_pinf("FAILED: round: %d, nfailed: %u", round, nfailed);
+			err = -EIO;
+			goto exit;
+		}
+
+		for (uint32_t i = nbufs / 2; !round && i < nbufs; ++i) {
+			xnvme_buf_free(dev, bufs[i]);
+			bufs[i] = NULL;
+		}
+	}
+
+	xnvme_cli_pinf("LGMT: xnvme_buf_{alloc,free} with a full buffer-registry");
+
+exit:
+	xnvme_queue_term(queue);
+	for (uint32_t i = 0; i < nbufs; ++i) {
+		if (bufs[i]) {
+			xnvme_buf_free(dev, bufs[i]);
+		}
+	}
+	free(bufs);
+
+	return err;
+}
+
 //
 // Command-Line Interface (CLI) definition
 //
@@ -115,6 +747,98 @@ static struct xnvme_cli_sub g_subs[] = {
 			XNVME_CLI_ADMIN_OPTS,
 		},
 	},
+	{
+		"buf_sizes",
+		"Allocate and free 'count' buffers of each size around the size-classes",
+		"Allocate and free 'count' buffers of each size around the size-classes",
+		test_buf_sizes,
+		{
+			{XNVME_CLI_OPT_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_URI, XNVME_CLI_POSA},
+
+			{XNVME_CLI_OPT_NON_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_COUNT, XNVME_CLI_LREQ},
+
+			XNVME_CLI_ADMIN_OPTS,
+		},
+	},
+	{
+		"buf_realloc",
+		"Grow and shrink a buffer across the size-classes, 'count' times",
+		"Grow and shrink a buffer across the size-classes, 'count' times",
+		test_buf_realloc,
+		{
+			{XNVME_CLI_OPT_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_URI, XNVME_CLI_POSA},
+
+			{XNVME_CLI_OPT_NON_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_COUNT, XNVME_CLI_LREQ},
+
+			XNVME_CLI_ADMIN_OPTS,
+		},
+	},
+	{
+		"buf_exhaust",
+		"Allocate up to 'count' buffers, until exhausted, and re-use them",
+		"Allocate up to 'count' buffers, until exhausted, and re-use them",
+		test_buf_exhaust,
+		{
+			{XNVME_CLI_OPT_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_URI, XNVME_CLI_POSA},
+
+			{XNVME_CLI_OPT_NON_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_COUNT, XNVME_CLI_LREQ},
+			{XNVME_CLI_OPT_DATA_NBYTES, XNVME_CLI_LOPT},
+
+			XNVME_CLI_ADMIN_OPTS,
+		},
+	},
+	{
+		"buf_pool",
+		"Get and put 'count' buffers of a pool, directly and via a cache",
+		"Get and put 'count' buffers of a pool, directly and via a cache",
+		test_buf_pool,
+		{
+			{XNVME_CLI_OPT_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_URI, XNVME_CLI_POSA},
+
+			{XNVME_CLI_OPT_NON_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_COUNT, XNVME_CLI_LREQ},
+
+			XNVME_CLI_ADMIN_OPTS,
+		},
+	},
+	{
+		"buf_pool_mt",
+		"Get and put buffers of a pool of 'count' buffers from multiple threads",
+		"Get and put buffers of a pool of 'count' buffers from multiple threads",
+		test_buf_pool_mt,
+		{
+			{XNVME_CLI_OPT_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_URI, XNVME_CLI_POSA},
+
+			{XNVME_CLI_OPT_NON_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_COUNT, XNVME_CLI_LREQ},
+
+			XNVME_CLI_ASYNC_OPTS,
+		},
+	},
+	{
+		"buf_registry",
+		"Allocate 'count' buffers, exceeding the buffer-registry, and do I/O on them",
+		"Allocate 'count' buffers, exceeding the buffer-registry, and do I/O on them",
+		test_buf_registry,
+		{
+			{XNVME_CLI_OPT_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_URI, XNVME_CLI_POSA},
+
+			{XNVME_CLI_OPT_NON_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_COUNT, XNVME_CLI_LREQ},
+			{XNVME_CLI_OPT_REGISTER_BUFFERS, XNVME_CLI_LOPT},
+
+			XNVME_CLI_ASYNC_OPTS,
+		},
+	},
 };
 
 static struct xnvme_cli g_cli = {
@@ -0,0 +1,273 @@
+// SPDX-FileCopyrightText: Samsung Electronics Co., Ltd
+//
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <errno.h>
+#include <libxnvme.h>
+
+#define XNVME_TESTS_NJOBS_MAX 64
+
+struct job_state {
+	uint32_t ncompleted;
+	uint32_t nfailed;
+};
+
+static void
+cb_job(int err, void *cb_arg)
+{
+	struct job_state *state = cb_arg;
+
+	if (err) {
+		__atomic_add_fetch(&state->nfailed, 1, __ATOMIC_RELAXED);
+	}
+	__atomic_add_fetch(&state->ncompleted, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * Write and read back a range as jobs of uneven sizes, such that static partitioning would leave
+ * workers idle, and compare the data
+ */
+static int
+test_verify(struct xnvme_cli *cli)
+{
+	struct xnvme_dev *dev = cli->args.dev;
+	const struct xnvme_geo *geo = xnvme_dev_get_geo(dev);
+	uint32_t nsid = xnvme_dev_get_nsid(dev);
+	uint32_t nworkers = cli->given[XNVME_CLI_OPT_COUNT] ? cli->args.count : 4;
+	uint32_t qd = cli->given[XNVME_CLI_OPT_QDEPTH] ? cli->args.qdepth : 8;
+	uint64_t job_nblocks[XNVME_TESTS_NJOBS_MAX];
+	struct xnvme_executor *exec = NULL;
+	struct job_state state = {0};
+	uint64_t nblocks = 0;
+	size_t buf_nbytes;
+	uint8_t *wbuf = NULL, *rbuf = NULL;
+	int err;
+
+	// Job sizes from a single block up to a few times the transfer size of the device
+	for (uint32_t i = 0; i < XNVME_TESTS_NJOBS_MAX; ++i) {
+		job_nblocks[i] = 1 + (i * i * 37) % 256;
+		nblocks += job_nblocks[i];
+	}
+	if (nblocks * geo->lba_nbytes > geo->tbytes) {
+		xnvme_cli_pinf("FAILED: device too small, nblocks: %zu", nblocks);
+		return -EINVAL;
+	}
+	buf_nbytes = nblocks * geo->lba_nbytes;
+
+	xnvme_cli_pinf("nworkers: %u, qdepth: %u, nblocks: %zu", nworkers, qd, nblocks);
+
+	wbuf = xnvme_buf_alloc(dev, buf_nbytes);
+	rbuf = xnvme_buf_alloc(dev, buf_nbytes);
+	if (!wbuf || !rbuf) {
+		err = -errno;
+		xnvme_cli_perr("xnvme_buf_alloc()", err);
+		goto exit;
+	}
+	xnvme_buf_fill(wbuf, buf_nbytes, "anum");
+	memset(rbuf, 0, buf_nbytes);
+
+	exec = xnvme_executor_create(dev, nworkers, qd);
+	if (!exec) {
+		err = -errno;
+		xnvme_cli_perr("xnvme_executor_create()", err);
+		goto exit;
+	}
+
+	for (int rd = 0; rd < 2; ++rd) {
+		uint8_t opcode = rd ? XNVME_SPEC_NVM_OPC_READ : XNVME_SPEC_NVM_OPC_WRITE;
+		uint8_t *buf = rd ? rbuf : wbuf;
+		uint64_t slba = 0;
+
+		for (uint32_t i = 0; i < XNVME_TESTS_NJOBS_MAX; ++i) {
+			err = xnvme_executor_submit_io(exec, opcode, nsid, slba, job_nblocks[i],
+						       buf + slba * geo->lba_nbytes, cb_job, &state);
+			if (err) {
+				xnvme_cli_perr("xnvme_executor_submit_io()", err);
+				goto exit;
+			}
+			slba += job_nblocks[i];
+		}
+
+		err = xnvme_executor_drain(exec);
+		if (err) {
+			xnvme_cli_perr("xnvme_executor_drain()", err);
+			goto exit;
+		}
+	}
+
+	if (state.ncompleted != 2 * XNVME_TESTS_NJOBS_MAX || state.nfailed) {
+		xnvme_cli_pinf("FAILED: ncompleted: %u, nfailed: %u", state.ncompleted,
+			       state.nfailed);
+		err = -EIO;
+		goto exit;
+	}
+	if (memcmp(wbuf, rbuf, buf_nbytes)) {
+		xnvme_cli_pinf("FAILED: data read back does not match data written");
+		err = -EIO;
+		goto exit;
+	}
+	err = 0;
+
+exit:
+	xnvme_executor_destroy(exec);
+	xnvme_buf_free(dev, wbuf);
+	xnvme_buf_free(dev, rbuf);
+
+	return err;
+}
+
+struct closure_state {
+	uint32_t nsid;
+	void *buf;
+	uint32_t nruns;
+	uint32_t ncompleted;
+	uint32_t nfailed;
+};
+
+static void
+cb_closure_cmd(struct xnvme_cmd_ctx *ctx, void *cb_arg)
+{
+	struct closure_state *state = cb_arg;
+
+	if (xnvme_cmd_ctx_cpl_status(ctx)) {
+		__atomic_add_fetch(&state->nfailed, 1, __ATOMIC_RELAXED);
+	}
+	__atomic_add_fetch(&state->ncompleted, 1, __ATOMIC_RELAXED);
+	xnvme_queue_put_cmd_ctx(ctx->async.queue, ctx);
+}
+
+/**
+ * Submit a read on the queue of the worker; completed by the worker after the closure returns
+ */
+static void
+closure_read(struct xnvme_queue *queue, void *arg)
+{
+	struct closure_state *state = arg;
+	struct xnvme_cmd_ctx *ctx;
+	int err;
+
+	__atomic_add_fetch(&state->nruns, 1, __ATOMIC_RELAXED);
+
+	ctx = xnvme_queue_get_cmd_ctx(queue);
+	if (!ctx) {
+		__atomic_add_fetch(&state->nfailed, 1, __ATOMIC_RELAXED);
+		return;
+	}
+	ctx->async.cb = cb_closure_cmd;
+	ctx->async.cb_arg = state;
+
+	err = xnvme_nvm_read(ctx, state->nsid, 0, 0, state->buf, NULL);
+	if (err) {
+		__atomic_add_fetch(&state->nfailed, 1, __ATOMIC_RELAXED);
+		xnvme_queue_put_cmd_ctx(queue, ctx);
+	}
+}
+
+static int
+test_closure(struct xnvme_cli *cli)
+{
+	struct xnvme_dev *dev = cli->args.dev;
+	const struct xnvme_geo *geo = xnvme_dev_get_geo(dev);
+	uint32_t nworkers = cli->given[XNVME_CLI_OPT_COUNT] ? cli->args.count : 4;
+	uint32_t qd = cli->given[XNVME_CLI_OPT_QDEPTH] ? cli->args.qdepth : 8;
+	uint32_t nclosures = 1000;
+	struct closure_state state = {.nsid = xnvme_dev_get_nsid(dev)};
+	struct xnvme_executor *exec = NULL;
+	int err;
+
+	xnvme_cli_pinf("nworkers: %u, qdepth: %u, nclosures: %u", nworkers, qd, nclosures);
+
+	// The closures all read into the same buffer; only the completions are of interest
+	state.buf = xnvme_buf_alloc(dev, geo->lba_nbytes);
+	if (!state.buf) {
+		err = -errno;
+		xnvme_cli_perr("xnvme_buf_alloc()", err);
+		return err;
+	}
+
+	exec = xnvme_executor_create(dev, nworkers, qd);
+	if (!exec) {
+		err = -errno;
+		xnvme_cli_perr("xnvme_executor_create()", err);
+		goto exit;
+	}
+
+	for (uint32_t i = 0; i < nclosures; ++i) {
+		err = xnvme_executor_submit(exec, closure_read, &state);
+		if (err) {
+			xnvme_cli_perr("xnvme_executor_submit()", err);
+			goto exit;
+		}
+	}
+
+	err = xnvme_executor_drain(exec);
+	if (err) {
+		xnvme_cli_perr("xnvme_executor_drain()", err);
+		goto exit;
+	}
+
+	if (state.nruns != nclosures || state.ncompleted != nclosures || state.nfailed) {
+		xnvme_cli_pinf("FAILED: nruns: %u, ncompleted: %u, nfailed: %u", state.nruns,
+			       state.ncompleted, state.nfailed);
+		err = -EIO;
+		goto exit;
+	}
+	err = 0;
+
+exit:
+	xnvme_executor_destroy(exec);
+	xnvme_buf_free(dev, state.buf);
+
+	return err;
+}
+
+//
+// Command-Line Interface (CLI) definition
+//
+static struct xnvme_cli_sub g_subs[] = {
+	{
+		"verify",
+		"Write and read back jobs of uneven sizes with 'count' workers",
+		"Write and read back jobs of uneven sizes with 'count' workers",
+		test_verify,
+		{
+			{XNVME_CLI_OPT_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_URI, XNVME_CLI_POSA},
+
+			{XNVME_CLI_OPT_NON_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_QDEPTH, XNVME_CLI_LOPT},
+			{XNVME_CLI_OPT_COUNT, XNVME_CLI_LOPT},
+
+			XNVME_CLI_ASYNC_OPTS,
+		},
+	},
+	{
+		"closure",
+		"Run closures submitting commands on the queues of 'count' workers",
+		"Run closures submitting commands on the queues of 'count' workers",
+		test_closure,
+		{
+			{XNVME_CLI_OPT_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_URI, XNVME_CLI_POSA},
+
+			{XNVME_CLI_OPT_NON_POSA_TITLE, XNVME_CLI_SKIP},
+			{XNVME_CLI_OPT_QDEPTH, XNVME_CLI_LOPT},
+			{XNVME_CLI_OPT_COUNT, XNVME_CLI_LOPT},
+
+			XNVME_CLI_ASYNC_OPTS,
+		},
+	},
+};
+
+static struct xnvme_cli g_cli = {
+	.title = "Test xNVMe executor",
+	.descr_short = "Test xNVMe executor",
+	.subs = g_subs,
+	.nsubs = sizeof g_subs / sizeof(*g_subs),
+};
+
+int
+main(int argc, char **argv)
+{
+	return xnvme_cli_run(&g_cli, argc, argv, XNVME_CLI_INIT_DEV_OPEN);
+}
@@ -502,6 +502,8 @@ static struct xnvme_cli_sub g_subs[] = {
 
 			{XNVME_CLI_OPT_NON_POSA_TITLE, XNVME_CLI_SKIP},
 			{XNVME_CLI_OPT_VEC_CNT, XNVME_CLI_LOPT},
+			{XNVME_CLI_OPT_REGISTER_FILES, XNVME_CLI_LOPT},
+			{XNVME_CLI_OPT_REGISTER_BUFFERS, XNVME_CLI_LOPT},
 
 			XNVME_CLI_ASYNC_OPTS,
 		},
@@ -703,9 +703,17 @@ sub_write_read_pi(struct xnvme_cli *cli)
 	}
 
 	if (!pract) {
-		err = xnvme_pi_verify(&pi_ctx, dbuf, mbuf, nlb + 1);
+		struct xnvme_pi_err pi_err = {0};
+
+		err = xnvme_pi_verify_report(&pi_ctx, dbuf, mbuf, nlb + 1, &pi_err);
 		if (err) {
-			xnvme_cli_perr("xnvme_pi_verify()", err);
+			xnvme_cli_perr("xnvme_pi_verify_report()", err);
+			if (err == -EIO) {
+				xnvme_cli_pinf("lba: 0x%016" PRIx64 ", field: 0x%x, "
+					       "expected: 0x%" PRIx64 ", actual: 0x%" PRIx64,
+					       slba + pi_err.block, pi_err.field, pi_err.expected,
+					       pi_err.actual);
+			}
 			err = err ? err : -EIO;
 			goto exit;
 		}